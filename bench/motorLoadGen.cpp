@@ -0,0 +1,186 @@
+/**
+ * @file motorLoadGen.cpp
+ * @brief 压测用合成电机数据发生器与定速 UDP 发送实现
+ * @author mafangniu
+ * @date 2025-04-28
+ */
+
+#include "motorLoadGen.h"
+#include "motorPacket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+MotorLoadGenerator::MotorLoadGenerator(const MotorLoadConfig &config)
+    : config_(config), rng_(config.seed), unit_(0.0, 1.0)
+{
+  if (config_.legacy)
+  {
+    config_.motor_count = MOTOR_COUNT;
+  }
+  config_.motor_count = std::max(1, std::min(config_.motor_count, MAX_MOTOR_COUNT));
+
+  std::memset(&frame_, 0, sizeof(frame_));
+  frame_.motor_count = static_cast<uint16_t>(config_.motor_count);
+  frame_.flags = config_.sender_stamp ? FRAME_FLAG_SENDER_STAMP : 0;
+  for (int i = 0; i < config_.motor_count; ++i)
+  {
+    InteractiveMotorData &m = frame_.motors[i];
+    m.mode = 1.0;
+    m.index = i;
+    m.kp_ = 20.0;
+    m.kd_ = 0.5;
+  }
+}
+
+size_t MotorLoadGenerator::next(double stamp, void *out, size_t capacity)
+{
+  // 错误注入：同一时间最多一个电机处于错误状态，持续 error_hold_frames 帧
+  if (error_remaining_ > 0 && --error_remaining_ == 0)
+  {
+    frame_.motors[error_motor_].error_ = 0.0;
+    error_motor_ = -1;
+  }
+  if (error_motor_ < 0 && config_.error_probability > 0.0 && unit_(rng_) < config_.error_probability)
+  {
+    error_motor_ = static_cast<int>(unit_(rng_) * config_.motor_count) % config_.motor_count;
+    error_remaining_ = std::max(1, config_.error_hold_frames);
+    frame_.motors[error_motor_].error_ = config_.error_code;
+    ++errors_injected_;
+  }
+
+  // 各电机相位错开的正弦运动，温度随时间缓慢变化
+  const double t = std::fmod(stamp, 3600.0);
+  for (int i = 0; i < config_.motor_count; ++i)
+  {
+    InteractiveMotorData &m = frame_.motors[i];
+    const double phase = 2.0 * M_PI * 0.5 * t + 0.3 * i;
+    m.pos_des_ = std::sin(phase);
+    m.vel_des_ = M_PI * std::cos(phase);
+    m.pos_ = m.pos_des_ + 0.01 * std::sin(7.0 * phase);
+    m.vel_ = m.vel_des_;
+    m.tau_ = m.kp_ * (m.pos_des_ - m.pos_) + m.kd_ * (m.vel_des_ - m.vel_);
+    m.ff_ = 0.0;
+    m.temperature_ = 40.0 + 5.0 * std::sin(0.01 * t + i);
+    m.mos_temperature_ = m.temperature_ + 3.0;
+  }
+  frame_.stamp = stamp;
+
+  size_t len = 0;
+  if (config_.legacy)
+  {
+    const size_t motor_bytes = sizeof(InteractiveMotorData) * MOTOR_COUNT;
+    len = motor_bytes + (config_.sender_stamp ? sizeof(double) : 0);
+    if (len > capacity)
+    {
+      return 0;
+    }
+    std::memcpy(out, frame_.motors, motor_bytes);
+    if (config_.sender_stamp)
+    {
+      std::memcpy(static_cast<char *>(out) + motor_bytes, &stamp, sizeof(double));
+    }
+  }
+  else if (config_.compact)
+  {
+    const bool force_keyframe = config_.keyframe_interval <= 1 || frame_.sequence % config_.keyframe_interval == 0;
+    len = encodeCompactMotorPacket(frame_, out, capacity, keyframe_, force_keyframe);
+  }
+  else
+  {
+    len = encodeMotorPacket(frame_, out, capacity);
+  }
+  if (len > 0)
+  {
+    ++frame_.sequence;
+  }
+  return len;
+}
+
+PacedSendResult sendPaced(int fd, const sockaddr_in &dest, MotorLoadGenerator &generator, double rate_hz, double duration_s,
+                          const std::atomic<bool> &stop, int max_burst, const std::function<void(uint64_t, double)> &progress)
+{
+  using clock = std::chrono::steady_clock;
+  PacedSendResult result;
+  if (rate_hz <= 0.0)
+  {
+    return result;
+  }
+  max_burst = std::max(1, max_burst);
+
+  // 发送缓冲和消息头一次性分配
+  std::vector<char> packets(static_cast<size_t>(max_burst) * MAX_MOTOR_PACKET_BYTES);
+  std::vector<struct iovec> iovecs(max_burst);
+  std::vector<struct mmsghdr> msgs(max_burst);
+  for (int i = 0; i < max_burst; ++i)
+  {
+    iovecs[i].iov_base = &packets[static_cast<size_t>(i) * MAX_MOTOR_PACKET_BYTES];
+    std::memset(&msgs[i], 0, sizeof(msgs[i]));
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = const_cast<sockaddr_in *>(&dest);
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+  }
+
+  const uint64_t frame_limit = duration_s > 0.0 ? static_cast<uint64_t>(duration_s * rate_hz) : UINT64_MAX;
+  const auto start = clock::now();
+  auto next_progress = start + std::chrono::seconds(1);
+
+  while (!stop.load(std::memory_order_relaxed) && result.sent < frame_limit)
+  {
+    // 按绝对时间表计算当前应已发出的帧数，未到期时睡到下一帧的发送时刻
+    const auto now = clock::now();
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+    const uint64_t due = std::min<uint64_t>(static_cast<uint64_t>(elapsed * rate_hz) + 1, frame_limit);
+    if (due <= result.sent)
+    {
+      std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(
+                                                std::chrono::duration<double>(static_cast<double>(result.sent) / rate_hz)));
+      continue;
+    }
+
+    const int count = static_cast<int>(std::min<uint64_t>(due - result.sent, static_cast<uint64_t>(max_burst)));
+    const double stamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (int i = 0; i < count; ++i)
+    {
+      iovecs[i].iov_len = generator.next(stamp, iovecs[i].iov_base, MAX_MOTOR_PACKET_BYTES);
+    }
+
+    // 已生成的帧必须全部发出（否则序号缺口会被误判为接收端丢包），ENOBUFS 等临时错误让出 CPU 后重试
+    int offset = 0;
+    while (offset < count)
+    {
+      const int sent = sendmmsg(fd, &msgs[offset], count - offset, 0);
+      if (sent < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        ++result.send_errors;
+        if (errno == ENOBUFS || errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          std::this_thread::yield();
+          continue;
+        }
+        result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        return result;
+      }
+      offset += sent;
+    }
+    result.sent += count;
+
+    if (progress && now >= next_progress)
+    {
+      progress(result.sent, elapsed);
+      next_progress += std::chrono::seconds(1);
+    }
+  }
+
+  result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+  return result;
+}
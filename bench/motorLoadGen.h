@@ -0,0 +1,107 @@
+/**
+ * @file motorLoadGen.h
+ * @brief 压测用合成电机数据发生器与定速 UDP 发送
+ * @author mafangniu
+ * @date 2025-04-28
+ *
+ * @details
+ * motor_udp_sender 和 motor_e2e_bench 共用：
+ * - MotorLoadGenerator 按帧生成与真实发送端相同布局的数据报（旧版裸结构体数组，带包头和序号的自描述数据报，或紧凑格式），
+ *   各电机位置/速度/力矩为正弦曲线，温度缓慢变化，并按设定概率注入持续若干帧的错误码，用于触发"仅错误记录"模式；
+ * - sendPaced() 按绝对时间表定速发送：每次把已到期的帧一次 sendmmsg() 发出，
+ *   睡眠抖动不会累积成速率偏差，高速率下也不会因单包系统调用成为瓶颈。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <netinet/in.h>
+#include <random>
+
+#include "motorData.h"
+#include "motorPacket.h"
+
+/**
+ * @brief 合成数据配置
+ */
+struct MotorLoadConfig
+{
+  int motor_count = MOTOR_COUNT;  ///< 每帧电机数（旧版数据报固定为 MOTOR_COUNT）
+  bool legacy = false;            ///< true 时发送不带包头的旧版数据报（没有序号，接收端无法统计序号缺口）
+  bool sender_stamp = true;       ///< 数据报末尾附带发送端时间戳
+  bool compact = false;           ///< 发送紧凑格式数据报（float32 + 整数字段，见 motorPacket.h），legacy 时忽略
+  int keyframe_interval = 1;      ///< 紧凑格式每隔多少帧发一个关键帧，其余为差分帧（1 表示只发关键帧）
+  double error_probability = 0.0; ///< 每帧开始注入一次错误的概率（已有错误持续期间不再注入）
+  double error_code = 1.0;        ///< 注入的错误码
+  int error_hold_frames = 50;     ///< 每次错误持续的帧数
+  uint32_t seed = 1;              ///< 随机数种子（错误注入的电机和时机可复现）
+};
+
+/**
+ * @class MotorLoadGenerator
+ * @brief 逐帧生成合成电机数据报
+ */
+class MotorLoadGenerator
+{
+public:
+  explicit MotorLoadGenerator(const MotorLoadConfig &config);
+
+  /**
+   * @brief 生成下一帧数据报（序号加 1）
+   * @param stamp    发送端时间戳（秒，Unix 时间），同时作为曲线的时间变量
+   * @param out      输出缓冲
+   * @param capacity 输出缓冲字节数（不小于 MAX_MOTOR_PACKET_BYTES 时总能容纳）
+   * @return 数据报字节数，缓冲不足时返回 0
+   */
+  size_t next(double stamp, void *out, size_t capacity);
+
+  /**
+   * @brief 下一帧将使用的序号
+   */
+  uint32_t nextSequence() const { return frame_.sequence; }
+
+  /**
+   * @brief 已注入的错误次数（每次持续 error_hold_frames 帧）
+   */
+  uint64_t errorsInjected() const { return errors_injected_; }
+
+  const MotorLoadConfig &config() const { return config_; }
+
+private:
+  MotorLoadConfig config_;
+  RawMotorFrame frame_;                          ///< 复用的帧（只在前 motor_count 个电机写入数据）
+  std::mt19937 rng_;                             ///< 错误注入随机数
+  std::uniform_real_distribution<double> unit_;  ///< [0, 1) 均匀分布
+  int error_motor_ = -1;                         ///< 当前处于错误状态的电机，-1 表示无
+  int error_remaining_ = 0;                      ///< 当前错误剩余帧数
+  uint64_t errors_injected_ = 0;                 ///< 已注入错误次数
+  CompactKeyframe keyframe_;                     ///< 紧凑格式发送端关键帧状态
+};
+
+/**
+ * @brief sendPaced() 的结果
+ */
+struct PacedSendResult
+{
+  uint64_t sent = 0;        ///< 成功发出的数据报数
+  uint64_t send_errors = 0; ///< sendmmsg() 返回错误的次数（ENOBUFS 等，重试后仍计入）
+  double seconds = 0.0;     ///< 实际发送耗时
+};
+
+/**
+ * @brief 以固定速率发送合成数据报
+ * @param fd          UDP socket
+ * @param dest        目的地址
+ * @param generator   数据发生器
+ * @param rate_hz     目标帧率
+ * @param duration_s  发送时长（秒），<= 0 表示一直发送直到 stop 置位
+ * @param stop        外部停止标志
+ * @param max_burst   一次 sendmmsg() 最多发送的帧数（落后于时间表时按此批量追赶）
+ * @param progress    可选的进度回调，约每秒调用一次（已发送帧数、已用时间）
+ * @return 发送结果
+ */
+PacedSendResult sendPaced(int fd, const sockaddr_in &dest, MotorLoadGenerator &generator, double rate_hz, double duration_s,
+                          const std::atomic<bool> &stop, int max_burst = 32,
+                          const std::function<void(uint64_t, double)> &progress = nullptr);
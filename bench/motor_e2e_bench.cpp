@@ -0,0 +1,547 @@
+/**
+ * @file motor_e2e_bench.cpp
+ * @brief 端到端压测：逐级提高帧率，找出无丢帧的最大可持续帧率
+ * @author mafangniu
+ * @date 2025-04-28
+ *
+ * @details
+ * 在一个进程内经本机回环跑完整的接收链路，与插件使用相同的模块和线程划分：
+ * - 发送线程：MotorLoadGenerator + sendPaced() 定速发送带序号的数据报；
+ * - 接收线程：openUdpSourceSocket() + epoll + recvmmsg(MSG_DONTWAIT) 批量接收，decodeMotorPacket() 解析，
+ *   SequenceTracker 统计序号缺口，SO_RXQ_OVFL 统计内核丢包，帧写入 SpscRing，可选提交到 AsyncLogWriter；
+ * - 发布线程：批量取出帧队列，按 pushRawFrameLocked() 的方式持锁解码并推送到 PlotData 曲线。
+ *
+ * 插件本身依赖 PlotJuggler 主程序（界面线程和 dataReceived 通知），因此这里没有实例化 DataStreamSample，
+ * 结果是接收链路的上限，不包括 PlotJuggler 重绘的开销。
+ *
+ * 每一级帧率发送 --step-seconds 秒，等待接收端取空后统计：发送帧数与接收帧数一致，
+ * 且没有序号缺口、内核丢包、帧队列丢帧和日志丢帧时视为无丢帧。第一次出现丢帧后在
+ * 最后一个无丢帧的帧率和该帧率之间二分 --refine 次。
+ *
+ * 用法：
+ *   motor_e2e_bench [--port 4915] [--motors 13] [--start-rate 1000] [--max-rate 1000000] [--factor 2]
+ *                   [--step-seconds 2] [--refine 4] [--batch 64] [--log none|text|binary] [--log-dir /tmp]
+ *                   [--compact] [--keyframe 1] [--rx-profile rcvbuf=4M]
+ *   --compact 发送紧凑格式数据报（--keyframe N 为每 N 帧一个关键帧），用于比较紧凑格式的解码开销。
+ *   --rx-profile 接收线程配置（格式见 rxThreadProfile.h，例如 rcvbuf=8M,cpu=3,fifo=80），
+ *   可配合 stress-ng 等负载程序比较不同配置下的内核丢包。
+ */
+
+#include <algorithm>
+#include <array>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "PlotJuggler/plotdata.h"
+
+#include "frameRing.h"
+#include "logWriter.h"
+#include "motorFields.h"
+#include "motorLoadGen.h"
+#include "motorPacket.h"
+#include "rxStats.h"
+#include "rxThreadProfile.h"
+#include "udpSources.h"
+
+using PJ::PlotData;
+
+/**
+ * @brief 压测配置
+ */
+struct E2EConfig
+{
+  uint16_t port = 4915;
+  int motor_count = MOTOR_COUNT;
+  double start_rate = 1000.0;
+  double max_rate = 1000000.0;
+  double factor = 2.0;
+  double step_seconds = 2.0;
+  int refine = 4;
+  int batch_size = 64;
+  std::string log_mode = "none"; // none / text / binary
+  std::string log_dir = "/tmp";
+  bool compact = false;  // 发送紧凑格式数据报
+  int keyframe_interval = 1;
+  RxThreadProfile rx_profile; // 接收线程配置（默认与插件相同）
+};
+
+/**
+ * @class ReceivePipeline
+ * @brief 接收线程 + 帧队列 + 发布线程（+ 可选日志写线程）
+ */
+class ReceivePipeline
+{
+public:
+  explicit ReceivePipeline(const E2EConfig &config)
+      : config_(config), ring_(2048), log_writer_(2048, 1)
+  {
+  }
+
+  ~ReceivePipeline() { stop(); }
+
+  bool start()
+  {
+    UdpSourceConfig source;
+    source.port = config_.port;
+    std::string error;
+    socket_fd_ = openUdpSourceSocket(source, &error);
+    if (socket_fd_ < 0)
+    {
+      std::cerr << "无法打开接收端口: " << error << std::endl;
+      return false;
+    }
+    if (!error.empty())
+    {
+      std::cerr << "⚠️ " << error << std::endl;
+    }
+    socket_report_ = applyRxSocketProfile(socket_fd_, config_.rx_profile);
+
+    for (int g = 0; g < config_.motor_count; ++g)
+    {
+      for (size_t f = 0; f < PLOTTED_FIELD_COUNT; ++f)
+      {
+        series_.push_back(&data_map_.addNumeric("Motor" + std::to_string(g + 1) + "/" + MOTOR_FIELDS[PLOTTED_FIELDS[f]].name)->second);
+      }
+    }
+
+    if (config_.log_mode != "none")
+    {
+      const bool binary = config_.log_mode == "binary";
+      log_file_ = config_.log_dir + "/motor_e2e_bench" + (binary ? ".bin" : ".txt");
+      removeLogFiles();
+      log_writer_.setFile(log_file_, binary ? AsyncLogWriter::Format::Binary : AsyncLogWriter::Format::Text);
+      log_writer_.start();
+    }
+
+    running_ = true;
+    receiver_ = std::thread([this]() { receiveLoop(); });
+    publisher_ = std::thread([this]() { publishLoop(); });
+    return true;
+  }
+
+  void stop()
+  {
+    if (!running_.exchange(false))
+    {
+      return;
+    }
+    receiver_.join();
+    publisher_.join();
+    log_writer_.stop();
+    close(socket_fd_);
+    socket_fd_ = -1;
+    removeLogFiles();
+  }
+
+  RxStatsCounters &stats() { return stats_; }
+  uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+  uint64_t logDropped() const { return config_.log_mode == "none" ? 0 : log_writer_.droppedFrames(); }
+
+private:
+  void removeLogFiles()
+  {
+    if (!log_file_.empty())
+    {
+      std::remove(log_file_.c_str());
+      std::remove((log_file_ + ".idx").c_str());
+    }
+  }
+
+  // 与 DataStreamSample::receiveUDPData() 相同的批量接收流程
+  void receiveLoop()
+  {
+    const int epoll_fd = epoll_create1(0);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd_, &ev);
+
+    const int batch_size = std::max(1, config_.batch_size);
+    const size_t CONTROL_BYTES = CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t));
+    std::vector<RawMotorFrame> frames(batch_size);
+    std::vector<char> packets(batch_size * MAX_MOTOR_PACKET_BYTES);
+    std::vector<struct iovec> iovecs(batch_size);
+    std::vector<struct mmsghdr> msgs(batch_size);
+    std::vector<char> control(batch_size * CONTROL_BYTES);
+    for (int i = 0; i < batch_size; ++i)
+    {
+      iovecs[i].iov_base = &packets[i * MAX_MOTOR_PACKET_BYTES];
+      iovecs[i].iov_len = MAX_MOTOR_PACKET_BYTES;
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const std::string thread_report = applyRxThreadProfile(config_.rx_profile);
+    std::cout << "接收线程: " << thread_report << (socket_report_.empty() ? "" : " | ") << socket_report_ << std::endl;
+
+    const bool logging = config_.log_mode != "none";
+    const int timeout_ms = config_.rx_profile.spin ? 0 : 100;
+    while (running_)
+    {
+      epoll_event event;
+      if (epoll_wait(epoll_fd, &event, 1, timeout_ms) <= 0)
+      {
+        continue;
+      }
+      while (true)
+      {
+        for (int i = 0; i < batch_size; ++i)
+        {
+          msgs[i].msg_hdr.msg_control = &control[i * CONTROL_BYTES];
+          msgs[i].msg_hdr.msg_controllen = CONTROL_BYTES;
+        }
+        const int received = recvmmsg(socket_fd_, msgs.data(), batch_size, MSG_DONTWAIT, nullptr);
+        if (received <= 0)
+        {
+          break;
+        }
+        const double wall_stamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        for (int m = 0; m < received; ++m)
+        {
+          RawMotorFrame &frame = frames[m];
+          const unsigned int len = msgs[m].msg_len;
+          const bool truncated = (msgs[m].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+          msgs[m].msg_hdr.msg_flags = 0;
+          for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[m].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msgs[m].msg_hdr, cmsg))
+          {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+              uint32_t kernel_drops = 0;
+              std::memcpy(&kernel_drops, CMSG_DATA(cmsg), sizeof(kernel_drops));
+              stats_.kernel_dropped.store(kernel_drops, std::memory_order_relaxed);
+            }
+          }
+          if (truncated || decodeMotorPacket(&packets[m * MAX_MOTOR_PACKET_BYTES], len, frame, &keyframe_) != MotorPacketStatus::Ok)
+          {
+            stats_.malformed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+          }
+          frame.source = 0;
+          frame.stamp = wall_stamp;
+          stats_.received.fetch_add(1, std::memory_order_relaxed);
+          sequence_tracker_.observe(frame.sequence, stats_);
+          if (!ring_.tryPush(frame))
+          {
+            stats_.plot_dropped.fetch_add(1, std::memory_order_relaxed);
+          }
+          if (logging)
+          {
+            log_writer_.submit(frame);
+          }
+        }
+        if (received < batch_size)
+        {
+          break;
+        }
+      }
+    }
+    close(epoll_fd);
+  }
+
+  // 与 DataStreamSample::publishPendingFrames() 相同：批量取出后持锁推送
+  void publishLoop()
+  {
+    std::vector<RawMotorFrame> batch(256);
+    std::array<double, PLOTTED_FIELD_COUNT> values;
+    uint64_t points_since_clear = 0;
+    while (running_)
+    {
+      const size_t count = ring_.drain(batch.data(), batch.size());
+      if (count == 0)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t i = 0; i < count; ++i)
+      {
+        const RawMotorFrame &frame = batch[i];
+        const int groups = std::min<int>(frame.motor_count, config_.motor_count);
+        for (int g = 0; g < groups; ++g)
+        {
+          decodePlottedFields(frame.motors[g], values.data());
+          for (size_t v = 0; v < PLOTTED_FIELD_COUNT; ++v)
+          {
+            series_[g * PLOTTED_FIELD_COUNT + v]->pushBack(PlotData::Point(frame.stamp, values[v]));
+          }
+        }
+      }
+      published_.fetch_add(count, std::memory_order_relaxed);
+
+      // 曲线长度有限（相当于 PlotJuggler 的缓冲时长），避免长时间压测占满内存
+      points_since_clear += count;
+      if (points_since_clear >= 1000000)
+      {
+        for (PlotData *plot : series_)
+        {
+          plot->clear();
+        }
+        points_since_clear = 0;
+      }
+    }
+  }
+
+  E2EConfig config_;
+  int socket_fd_ = -1;
+  std::string socket_report_; // socket 配置实际生效的设置
+  std::atomic<bool> running_{false};
+  std::thread receiver_;
+  std::thread publisher_;
+  SpscRing<RawMotorFrame> ring_;
+  SequenceTracker sequence_tracker_;
+  CompactKeyframe keyframe_;
+  RxStatsCounters stats_;
+  std::atomic<uint64_t> published_{0};
+  std::mutex mutex_; // 对应 PlotJuggler 的 dataMap 锁
+  PJ::PlotDataMapRef data_map_;
+  std::vector<PlotData *> series_;
+  AsyncLogWriter log_writer_;
+  std::string log_file_;
+};
+
+/**
+ * @brief 单级帧率的结果
+ */
+struct StepResult
+{
+  double target_rate = 0.0;
+  double achieved_rate = 0.0; ///< 发送端实际帧率
+  uint64_t sent = 0;
+  uint64_t received = 0;
+  uint64_t seq_lost = 0;
+  uint64_t kernel_dropped = 0;
+  uint64_t plot_dropped = 0;
+  uint64_t log_dropped = 0;
+
+  bool lossFree() const
+  {
+    return received == sent && seq_lost == 0 && kernel_dropped == 0 && plot_dropped == 0 && log_dropped == 0;
+  }
+  bool senderLimited() const { return achieved_rate < 0.95 * target_rate; }
+};
+
+/**
+ * @brief 以给定帧率发送一级，等待接收端取空后统计增量
+ */
+static StepResult runStep(ReceivePipeline &pipeline, int send_fd, const sockaddr_in &dest, MotorLoadGenerator &generator,
+                          const E2EConfig &config, double rate)
+{
+  RxStatsCounters &stats = pipeline.stats();
+  const uint64_t received0 = stats.received.load();
+  const uint64_t lost0 = stats.sequence_lost.load();
+  const uint64_t kernel0 = stats.kernel_dropped.load();
+  const uint64_t plot0 = stats.plot_dropped.load();
+  const uint64_t log0 = pipeline.logDropped();
+
+  std::atomic<bool> stop{false};
+  const PacedSendResult sent = sendPaced(send_fd, dest, generator, rate, config.step_seconds, stop, 64);
+
+  // 等待接收和发布都不再前进（最多 2 秒）
+  uint64_t last_received = UINT64_MAX;
+  uint64_t last_published = UINT64_MAX;
+  for (int i = 0; i < 40; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const uint64_t received = stats.received.load();
+    const uint64_t published = pipeline.published();
+    if (received == last_received && published == last_published)
+    {
+      break;
+    }
+    last_received = received;
+    last_published = published;
+  }
+
+  StepResult result;
+  result.target_rate = rate;
+  result.achieved_rate = sent.sent / std::max(1e-9, sent.seconds);
+  result.sent = sent.sent;
+  result.received = stats.received.load() - received0;
+  result.seq_lost = stats.sequence_lost.load() - lost0;
+  result.kernel_dropped = stats.kernel_dropped.load() - kernel0;
+  result.plot_dropped = stats.plot_dropped.load() - plot0;
+  result.log_dropped = pipeline.logDropped() - log0;
+  return result;
+}
+
+/**
+ * @brief 按显示宽度右对齐（中文字符占两列，std::setw 按字节计数无法对齐）
+ */
+static std::string padLeft(const std::string &text, int width)
+{
+  int columns = 0;
+  for (unsigned char c : text)
+  {
+    if (c < 0x80)
+      columns += 1;
+    else if ((c & 0xC0) != 0x80)
+      columns += 2; // UTF-8 多字节字符的首字节
+  }
+  return std::string(static_cast<size_t>(std::max(0, width - columns)), ' ') + text;
+}
+
+static void printStep(const StepResult &r)
+{
+  std::cout << std::fixed << std::setprecision(0) << std::setw(10) << r.target_rate << std::setw(12) << r.achieved_rate
+            << std::setw(12) << r.sent << std::setw(12) << r.received << std::setw(10) << r.seq_lost << std::setw(10)
+            << r.kernel_dropped << std::setw(10) << r.plot_dropped << std::setw(10) << r.log_dropped << "  "
+            << (r.senderLimited() ? "发送端受限" : (r.lossFree() ? "无丢帧" : "丢帧")) << std::endl;
+}
+
+static void printUsage(const char *prog)
+{
+  std::cerr << "用法: " << prog
+            << " [--port 4915] [--motors 13] [--start-rate 1000] [--max-rate 1000000] [--factor 2]\n"
+               "       [--step-seconds 2] [--refine 4] [--batch 64] [--log none|text|binary] [--log-dir /tmp]\n"
+               "       [--compact] [--keyframe 1] [--rx-profile rcvbuf=4M]"
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  E2EConfig config;
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--port") == 0 && has_value)
+      config.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+    else if (std::strcmp(argv[i], "--motors") == 0 && has_value)
+      config.motor_count = std::max(1, std::min(std::atoi(argv[++i]), MAX_MOTOR_COUNT));
+    else if (std::strcmp(argv[i], "--start-rate") == 0 && has_value)
+      config.start_rate = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--max-rate") == 0 && has_value)
+      config.max_rate = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--factor") == 0 && has_value)
+      config.factor = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--step-seconds") == 0 && has_value)
+      config.step_seconds = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--refine") == 0 && has_value)
+      config.refine = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--batch") == 0 && has_value)
+      config.batch_size = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--log") == 0 && has_value)
+      config.log_mode = argv[++i];
+    else if (std::strcmp(argv[i], "--log-dir") == 0 && has_value)
+      config.log_dir = argv[++i];
+    else if (std::strcmp(argv[i], "--compact") == 0)
+      config.compact = true;
+    else if (std::strcmp(argv[i], "--keyframe") == 0 && has_value)
+      config.keyframe_interval = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--rx-profile") == 0 && has_value)
+    {
+      std::string error;
+      if (!parseRxThreadProfile(argv[++i], config.rx_profile, &error))
+      {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (config.start_rate <= 0.0 || config.factor <= 1.0 || config.step_seconds <= 0.0 ||
+      (config.log_mode != "none" && config.log_mode != "text" && config.log_mode != "binary"))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  ReceivePipeline pipeline(config);
+  if (!pipeline.start())
+  {
+    return 1;
+  }
+
+  sockaddr_in dest;
+  std::memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(config.port);
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const int send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int sndbuf = 4 * 1024 * 1024;
+  setsockopt(send_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+  MotorLoadConfig load;
+  load.motor_count = config.motor_count;
+  load.error_probability = 0.001;
+  load.compact = config.compact;
+  load.keyframe_interval = config.keyframe_interval;
+  MotorLoadGenerator generator(load);
+
+  std::cout << "电机数 " << config.motor_count << "，每级 " << config.step_seconds << " 秒，日志 " << config.log_mode << std::endl;
+  std::cout << padLeft("目标帧率", 10) << padLeft("实际帧率", 12) << padLeft("发送", 12) << padLeft("接收", 12)
+            << padLeft("序号缺口", 10) << padLeft("内核丢弃", 10) << padLeft("队列丢弃", 10) << padLeft("日志丢弃", 10) << std::endl;
+
+  // 1. 按倍数逐级提高帧率，直到出现丢帧或发送端达不到目标帧率
+  double good = 0.0;
+  double bad = 0.0;
+  bool sender_limited = false;
+  for (double rate = config.start_rate; rate <= config.max_rate; rate *= config.factor)
+  {
+    const StepResult r = runStep(pipeline, send_fd, dest, generator, config, rate);
+    printStep(r);
+    if (r.senderLimited())
+    {
+      sender_limited = true;
+      break;
+    }
+    if (!r.lossFree())
+    {
+      bad = rate;
+      break;
+    }
+    good = rate;
+  }
+
+  // 2. 在最后一个无丢帧帧率和第一个丢帧帧率之间二分
+  for (int i = 0; i < config.refine && good > 0.0 && bad > 0.0; ++i)
+  {
+    const double rate = 0.5 * (good + bad);
+    const StepResult r = runStep(pipeline, send_fd, dest, generator, config, rate);
+    printStep(r);
+    if (r.senderLimited())
+    {
+      sender_limited = true;
+      break;
+    }
+    (r.lossFree() ? good : bad) = rate;
+  }
+
+  close(send_fd);
+  pipeline.stop();
+
+  if (good <= 0.0)
+  {
+    std::cout << "⚠️ 起始帧率 " << config.start_rate << " 帧/秒已出现丢帧" << std::endl;
+    return 2;
+  }
+  std::cout << "✅ 无丢帧的最大可持续帧率约 " << static_cast<uint64_t>(good) << " 帧/秒";
+  if (sender_limited)
+  {
+    std::cout << "（发送端已达上限，接收端实际上限可能更高）";
+  }
+  else if (bad <= 0.0)
+  {
+    std::cout << "（已达 --max-rate）";
+  }
+  std::cout << std::endl;
+  return 0;
+}
@@ -0,0 +1,410 @@
+/**
+ * @file motor_microbench.cpp
+ * @brief 接收/发布/日志各阶段的微基准
+ * @author mafangniu
+ * @date 2025-04-28
+ *
+ * @details
+ * 单线程测量插件热路径上各阶段处理一帧（13 个电机，除特别标注）的耗时，用于评估优化效果和发现回退：
+ * - decode/...：decodeMotorPacket() 解析数据报（原始 / 紧凑关键帧 / 紧凑差分帧）+ decodePlottedFields() 取出绘图字段
+ *   （接收线程与发布线程的解码）；
+ * - push/...：按 pushRawFrameLocked() 的方式把一帧推送到 13 个电机启用字段的 PlotData 曲线（默认字段 / 只有 Pos / 全部字段）；
+ * - derived/...：computeDerivedSignals() 计算一帧所有电机的派生量（跟踪误差、功率、PD 力矩，发布线程）；
+ * - alarm/...：MotorAlarmEngine 把一帧推入滑动窗口统计并按周期判断告警规则（发布线程）；
+ * - ring/...：RawMotorFrame 经 SpscRing 入队、出队（接收线程 -> 发布线程）；
+ * - log/...：writeMotorFrame() 逐帧写入流、MotorTextFormatter 整批格式化（写线程的做法）、formatTimestampString() 帧标识、
+ *   BinaryLogFile::append() 二进制记录、SessionStoreFile::append() 列式会话记录。
+ *
+ * 每项先预热一轮，再重复 5 轮取最快一轮，输出每帧耗时和每秒帧数。
+ *
+ * 用法：
+ *   motor_microbench [--filter <名称子串>] [--scale <迭代次数倍数>]
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "PlotJuggler/plotdata.h"
+
+#include "binaryLog.h"
+#include "derivedSignals.h"
+#include "frameRing.h"
+#include "motorFields.h"
+#include "motorFieldSelection.h"
+#include "motorAlarms.h"
+#include "motorLoadGen.h"
+#include "motorPacket.h"
+#include "saveErrorLog.h"
+#include "sessionStore.h"
+#include "textLogFormat.h"
+
+using PJ::PlotData;
+
+static std::string g_filter;
+static double g_scale = 1.0;
+static volatile double g_sink = 0.0; // 防止被测代码被编译器整体优化掉
+
+/**
+ * @brief 运行一项基准
+ * @param name       名称（--filter 按子串匹配）
+ * @param iterations 每轮迭代次数（乘以 --scale）
+ * @param setup      每轮开始前调用（不计时），用于清空曲线、重置文件等
+ * @param body       被测代码，参数为迭代序号
+ */
+template <typename Setup, typename Body>
+static void runBench(const char *name, uint64_t iterations, Setup &&setup, Body &&body)
+{
+  if (!g_filter.empty() && std::string(name).find(g_filter) == std::string::npos)
+  {
+    return;
+  }
+  iterations = std::max<uint64_t>(1, static_cast<uint64_t>(iterations * g_scale));
+
+  double best_ns = 0.0;
+  for (int round = 0; round < 6; ++round) // 第 0 轮为预热
+  {
+    setup();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+      body(i);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    if (round == 1 || (round > 1 && ns < best_ns))
+    {
+      best_ns = ns;
+    }
+  }
+
+  std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10) << best_ns
+            << " ns/帧" << std::setw(14) << static_cast<uint64_t>(1e9 / best_ns) << " 帧/秒" << std::endl;
+}
+
+template <typename Body>
+static void runBench(const char *name, uint64_t iterations, Body &&body)
+{
+  runBench(name, iterations, []() {}, std::forward<Body>(body));
+}
+
+/**
+ * @brief 用压测发生器生成一个数据报
+ */
+static std::vector<char> makePacket(const MotorLoadConfig &config)
+{
+  MotorLoadGenerator generator(config);
+  std::vector<char> packet(MAX_MOTOR_PACKET_BYTES);
+  packet.resize(generator.next(1745800000.0, packet.data(), packet.size()));
+  return packet;
+}
+
+static void benchDecode()
+{
+  MotorLoadConfig legacy;
+  legacy.legacy = true;
+  MotorLoadConfig header;
+  MotorLoadConfig header_max;
+  header_max.motor_count = MAX_MOTOR_COUNT;
+  MotorLoadConfig compact;
+  compact.compact = true;
+  compact.keyframe_interval = 2; // 第 0 帧为关键帧，第 1 帧为差分帧
+
+  const std::vector<char> legacy_packet = makePacket(legacy);
+  const std::vector<char> header_packet = makePacket(header);
+  const std::vector<char> header_max_packet = makePacket(header_max);
+
+  // 紧凑格式：同一发生器连续生成关键帧和差分帧，解码差分帧前先解码一次关键帧
+  MotorLoadGenerator compact_generator(compact);
+  std::vector<char> compact_key_packet(MAX_MOTOR_PACKET_BYTES);
+  std::vector<char> compact_delta_packet(MAX_MOTOR_PACKET_BYTES);
+  compact_key_packet.resize(compact_generator.next(1745800000.0, compact_key_packet.data(), compact_key_packet.size()));
+  compact_delta_packet.resize(compact_generator.next(1745800000.001, compact_delta_packet.data(), compact_delta_packet.size()));
+  CompactKeyframe keyframe;
+
+  auto frame = std::make_unique<RawMotorFrame>();
+  std::array<double, PLOTTED_FIELD_COUNT> values;
+
+  auto decode = [&](const std::vector<char> &packet)
+  {
+    if (decodeMotorPacket(packet.data(), packet.size(), *frame, &keyframe) != MotorPacketStatus::Ok)
+    {
+      std::cerr << "数据报解析失败" << std::endl;
+      std::exit(1);
+    }
+    double sum = 0.0;
+    for (int m = 0; m < frame->motor_count; ++m)
+    {
+      decodePlottedFields(frame->motors[m], values.data());
+      sum += values[PLOTTED_ERROR_POSITION];
+    }
+    g_sink = sum;
+  };
+
+  runBench("decode/legacy_13", 2000000, [&](uint64_t) { decode(legacy_packet); });
+  runBench("decode/header_13", 2000000, [&](uint64_t) { decode(header_packet); });
+  runBench("decode/header_48", 500000, [&](uint64_t) { decode(header_max_packet); });
+  runBench("decode/compact_key_13", 2000000, [&](uint64_t) { decode(compact_key_packet); });
+  decode(compact_key_packet);
+  runBench("decode/compact_delta_13", 2000000, [&](uint64_t) { decode(compact_delta_packet); });
+  std::cout << "  （数据报字节数：原始 " << header_packet.size() << "，紧凑关键帧 " << compact_key_packet.size() << "，紧凑差分帧 "
+            << compact_delta_packet.size() << "）" << std::endl;
+}
+
+static void benchPush()
+{
+  // 与插件相同：[电机][字段] 曲线表，曲线指针预先取出，按启用的字段掩码推送（pushMotorsLocked()）
+  PJ::PlotDataMapRef data_map;
+  std::vector<PlotData *> series;
+  for (int g = 0; g < MOTOR_COUNT; ++g)
+  {
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      const std::string name = "Motor" + std::to_string(g + 1) + "/" + MOTOR_FIELDS[f].name;
+      series.push_back(&data_map.addNumeric(name)->second);
+    }
+  }
+
+  MotorLoadConfig config;
+  config.error_probability = 0.01;
+  MotorLoadGenerator generator(config);
+  auto frame = std::make_unique<RawMotorFrame>();
+  std::vector<char> packet(MAX_MOTOR_PACKET_BYTES);
+  const size_t len = generator.next(1745800000.0, packet.data(), packet.size());
+  decodeMotorPacket(packet.data(), len, *frame);
+
+  // 每轮清空曲线，避免内存随轮数增长（PlotJuggler 中由缓冲时长限制）
+  auto clear = [&]()
+  {
+    for (PlotData *plot : series)
+    {
+      plot->clear();
+    }
+  };
+  auto push = [&](uint32_t mask)
+  {
+    return [&, mask](uint64_t i)
+    {
+      const double stamp = 1745800000.0 + i * 1e-3; // 时间单调递增，与实时数据一致
+      uint8_t fields[MOTOR_FIELD_COUNT];
+      const int field_count = expandMotorFieldMask(mask, fields);
+      for (int g = 0; g < MOTOR_COUNT; ++g)
+      {
+        for (int k = 0; k < field_count; ++k)
+        {
+          series[g * MOTOR_FIELD_COUNT + fields[k]]->pushBack(PlotData::Point(stamp, motorFieldValue(frame->motors[g], fields[k])));
+        }
+      }
+    };
+  };
+  uint32_t pos_only = 0;
+  parseMotorFieldMask("Pos", pos_only);
+  runBench("push/plotdata_13", 200000, clear, push(DEFAULT_MOTOR_FIELD_MASK));
+  runBench("push/plotdata_13_pos_only", 200000, clear, push(pos_only));
+  runBench("push/plotdata_13_all_fields", 100000, clear, push(ALL_MOTOR_FIELD_MASK));
+  clear();
+}
+
+static void benchDerived()
+{
+  MotorLoadConfig config;
+  MotorLoadGenerator generator(config);
+  std::vector<char> packet(MAX_MOTOR_PACKET_BYTES);
+  auto frame = std::make_unique<RawMotorFrame>();
+  decodeMotorPacket(packet.data(), generator.next(1745800000.0, packet.data(), packet.size()), *frame);
+  for (int m = MOTOR_COUNT; m < MAX_MOTOR_COUNT; ++m)
+  {
+    frame->motors[m] = frame->motors[m % MOTOR_COUNT];
+  }
+
+  auto block = std::make_unique<DerivedSignalBlock>();
+  runBench("derived/compute_13", 5000000,
+           [&](uint64_t i)
+           {
+             frame->motors[0].pos_ = static_cast<double>(i) * 1e-6; // 每次输入不同，避免被提到循环外
+             computeDerivedSignals(frame->motors, MOTOR_COUNT, *block);
+             g_sink = block->values[DERIVED_PD_TORQUE][0];
+           });
+  runBench("derived/compute_48", 2000000,
+           [&](uint64_t i)
+           {
+             frame->motors[0].pos_ = static_cast<double>(i) * 1e-6;
+             computeDerivedSignals(frame->motors, MAX_MOTOR_COUNT, *block);
+             g_sink = block->values[DERIVED_PD_TORQUE][0];
+           });
+}
+
+static void benchAlarms()
+{
+  MotorLoadConfig config;
+  MotorLoadGenerator generator(config);
+  std::vector<char> packet(MAX_MOTOR_PACKET_BYTES);
+  auto frame = std::make_unique<RawMotorFrame>();
+  decodeMotorPacket(packet.data(), generator.next(1745800000.0, packet.data(), packet.size()), *frame);
+
+  // 温度阈值 + MOS 温度上升速率 + 力矩波动，三个字段的窗口，1kHz 帧时间
+  AlarmConfig alarms;
+  parseAlarmConfig("window=2,Temperatrue.max>70,Mos Temperature.slope>0.5,Torque.std>3", alarms);
+  MotorAlarmEngine engine;
+  runBench("alarm/observe_13_3rules", 2000000, [&]()
+           { engine.configure(alarms); },
+           [&](uint64_t i)
+           {
+             frame->stamp = 1745800000.0 + static_cast<double>(i) * 1e-3;
+             frame->motors[0].temperature_ = 40.0 + static_cast<double>(i % 1000) * 1e-3;
+             engine.observe(*frame);
+             if (engine.evaluateIfDue(frame->stamp))
+             {
+               g_sink = engine.activeMask(0);
+             }
+           });
+}
+
+static void benchRing()
+{
+  SpscRing<RawMotorFrame> ring(2048);
+  auto frame = std::make_unique<RawMotorFrame>();
+  std::memset(frame.get(), 0, sizeof(RawMotorFrame));
+  frame->motor_count = MOTOR_COUNT;
+
+  std::vector<RawMotorFrame> out(256);
+  runBench("ring/push_drain_256", 2000000,
+           [&](uint64_t i)
+           {
+             frame->sequence = static_cast<uint32_t>(i);
+             ring.tryPush(*frame);
+             if ((i & 255) == 255)
+             {
+               g_sink = static_cast<double>(ring.drain(out.data(), out.size()));
+             }
+           });
+  ring.drain(out.data(), out.size());
+}
+
+static void benchLog()
+{
+  MotorLoadConfig config;
+  MotorLoadGenerator generator(config);
+  std::vector<char> packet(MAX_MOTOR_PACKET_BYTES);
+  auto frame = std::make_unique<RawMotorFrame>();
+  decodeMotorPacket(packet.data(), generator.next(1745800000.0, packet.data(), packet.size()), *frame);
+  frame->stamp = 1745800000.0;
+
+  // 文本格式化：输出到内存流，与写线程相同的 std::fixed + 4 位精度，定期清空
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(4);
+  const std::string stamp_str = formatTimestampString(frame->stamp);
+  uint64_t text_bytes = 0;
+  runBench("log/text_format_13", 200000, [&]() { oss.str(std::string()); },
+           [&](uint64_t i)
+           {
+             writeMotorFrame(oss, frame->motors, frame->motor_count, stamp_str);
+             if ((i & 1023) == 1023)
+             {
+               text_bytes = static_cast<uint64_t>(oss.tellp());
+               oss.str(std::string());
+             }
+           });
+  if (text_bytes > 0)
+  {
+    std::cout << "  （文本日志约 " << text_bytes / 1024 << " 字节/帧）" << std::endl;
+  }
+
+  // 写线程的文本路径：连续格式化到复用缓冲（帧标识带微秒），约 1 MiB 清空一次（对应一次整块写入）
+  MotorTextFormatter formatter;
+  runBench("log/text_formatter_13", 500000, [&]() { formatter.clear(); },
+           [&](uint64_t i)
+           {
+             formatter.appendFrame(frame->motors, frame->motor_count, frame->stamp + static_cast<double>(i) * 1e-3);
+             if (formatter.size() >= (1 << 20))
+             {
+               g_sink = static_cast<double>(formatter.size());
+               formatter.clear();
+             }
+           });
+
+  runBench("log/timestamp_format", 500000,
+           [&](uint64_t i) { g_sink = static_cast<double>(formatTimestampString(1745800000.0 + static_cast<double>(i)).size()); });
+
+  // 二进制记录：写入 /tmp 下的临时文件，每 256 帧 flush 一次（与写线程每批 flush 一次相当）
+  const std::string bin_file = "/tmp/motor_microbench.bin";
+  BinaryLogFile bin;
+  runBench("log/binary_append_13", 500000,
+           [&]()
+           {
+             bin.close();
+             std::remove(bin_file.c_str());
+             std::remove((bin_file + ".idx").c_str());
+             bin.open(bin_file, MOTOR_COUNT);
+           },
+           [&](uint64_t i)
+           {
+             frame->stamp = 1745800000.0 + i * 1e-3;
+             bin.append(*frame);
+             if ((i & 255) == 255)
+             {
+               bin.flush();
+             }
+           });
+  bin.close();
+  std::remove(bin_file.c_str());
+  std::remove((bin_file + ".idx").c_str());
+
+  // 列式会话记录：按列写入 mmap 映射的块（含每 SESSION_CHUNK_ROWS 帧一次的预留、映射），每 256 帧 flush 一次
+  const std::string session_file = "/tmp/motor_microbench.arrow";
+  SessionStoreFile session;
+  runBench("log/session_append_13", 500000,
+           [&]()
+           {
+             session.close();
+             std::remove(session_file.c_str());
+             session.open(session_file, MOTOR_COUNT);
+           },
+           [&](uint64_t i)
+           {
+             frame->stamp = 1745800000.0 + i * 1e-3;
+             session.append(*frame);
+             if ((i & 255) == 255)
+             {
+               session.flush();
+             }
+           });
+  session.close();
+  std::remove(session_file.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+    {
+      g_filter = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+    {
+      g_scale = std::max(1e-3, std::atof(argv[++i]));
+    }
+    else
+    {
+      std::cerr << "用法: " << argv[0] << " [--filter <名称子串>] [--scale <迭代次数倍数>]" << std::endl;
+      return 1;
+    }
+  }
+
+  benchDecode();
+  benchPush();
+  benchDerived();
+  benchAlarms();
+  benchRing();
+  benchLog();
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file motor_udp_sender.cpp
+ * @brief 可配置的 UDP 电机数据压测发送端
+ * @author mafangniu
+ * @date 2025-04-28
+ *
+ * @details
+ * 以设定帧率向插件发送合成的 InteractiveMotorData 数据报（见 motorLoadGen.h），可注入错误码，
+ * 用于在没有真实机器人时复现高负载、触发"仅错误记录"日志，以及配合插件的接收统计（_stats/）检查丢包。
+ *
+ * 用法：
+ *   motor_udp_sender [--host 127.0.0.1] [--port 4015] [--rate 1000] [--duration 0] [--motors 13]
+ *                    [--legacy] [--compact] [--keyframe 1] [--no-stamp] [--error-prob 0] [--error-code 1]
+ *                    [--error-hold 50] [--burst 32] [--seed 1]
+ *   --duration 0 表示一直发送直到 Ctrl+C；--host 可以是组播地址。
+ *   --compact 发送紧凑格式，--keyframe N 表示每 N 帧一个关键帧、其余为差分帧。
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "motorLoadGen.h"
+
+static std::atomic<bool> g_stop{false};
+
+static void handleSignal(int)
+{
+  g_stop = true;
+}
+
+static void printUsage(const char *prog)
+{
+  std::cerr << "用法: " << prog
+            << " [--host 127.0.0.1] [--port 4015] [--rate 1000] [--duration 0] [--motors 13]\n"
+               "       [--legacy] [--compact] [--keyframe 1] [--no-stamp] [--error-prob 0] [--error-code 1] [--error-hold 50]\n"
+               "       [--burst 32] [--seed 1]"
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::string host = "127.0.0.1";
+  int port = 4015;
+  double rate_hz = 1000.0;
+  double duration_s = 0.0;
+  int burst = 32;
+  MotorLoadConfig config;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--host") == 0 && has_value)
+      host = argv[++i];
+    else if (std::strcmp(argv[i], "--port") == 0 && has_value)
+      port = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--rate") == 0 && has_value)
+      rate_hz = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--duration") == 0 && has_value)
+      duration_s = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--motors") == 0 && has_value)
+      config.motor_count = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--legacy") == 0)
+      config.legacy = true;
+    else if (std::strcmp(argv[i], "--compact") == 0)
+      config.compact = true;
+    else if (std::strcmp(argv[i], "--keyframe") == 0 && has_value)
+      config.keyframe_interval = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--no-stamp") == 0)
+      config.sender_stamp = false;
+    else if (std::strcmp(argv[i], "--error-prob") == 0 && has_value)
+      config.error_probability = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--error-code") == 0 && has_value)
+      config.error_code = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--error-hold") == 0 && has_value)
+      config.error_hold_frames = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--burst") == 0 && has_value)
+      burst = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--seed") == 0 && has_value)
+      config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (rate_hz <= 0.0 || port <= 0 || port > 65535)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  sockaddr_in dest;
+  std::memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(static_cast<uint16_t>(port));
+  if (inet_pton(AF_INET, host.c_str(), &dest.sin_addr) != 1)
+  {
+    std::cerr << "无效的目的地址: " << host << std::endl;
+    return 1;
+  }
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0)
+  {
+    std::cerr << "创建 socket 失败: " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  int sndbuf = 4 * 1024 * 1024;
+  setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+  std::signal(SIGINT, handleSignal);
+  std::signal(SIGTERM, handleSignal);
+
+  MotorLoadGenerator generator(config);
+  std::cout << "发送到 " << host << ":" << port << "，目标帧率 " << rate_hz << " Hz，电机数 " << generator.config().motor_count
+            << (config.legacy ? "（旧版数据报）" : config.compact ? "（紧凑格式）" : "（带包头）") << std::endl;
+
+  uint64_t last_sent = 0;
+  double last_elapsed = 0.0;
+  const PacedSendResult result = sendPaced(sock, dest, generator, rate_hz, duration_s, g_stop, burst,
+                                           [&](uint64_t sent, double elapsed)
+                                           {
+                                             const double rate = (sent - last_sent) / std::max(1e-9, elapsed - last_elapsed);
+                                             std::cout << "已发送 " << sent << " 帧，当前 " << static_cast<uint64_t>(rate)
+                                                       << " 帧/秒，已注入错误 " << generator.errorsInjected() << " 次" << std::endl;
+                                             last_sent = sent;
+                                             last_elapsed = elapsed;
+                                           });
+  close(sock);
+
+  std::cout << "✅ 共发送 " << result.sent << " 帧，用时 " << result.seconds << " 秒，平均 "
+            << static_cast<uint64_t>(result.sent / std::max(1e-9, result.seconds)) << " 帧/秒，注入错误 "
+            << generator.errorsInjected() << " 次，发送错误 " << result.send_errors << " 次" << std::endl;
+  return 0;
+}
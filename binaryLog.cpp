@@ -0,0 +1,329 @@
+/**
+ * @file binaryLog.cpp
+ * @brief 紧凑二进制日志格式（带可随机定位的时间索引）实现
+ * @author mafangniu
+ * @date 2025-04-14
+ */
+
+#include "binaryLog.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const size_t WRITE_BUFFER_BYTES = 1 << 20; // 1MB 写缓冲，保证大块顺序写入
+
+/**
+ * @brief 生成描述当前 InteractiveMotorData 布局的文件头
+ */
+BinaryLogHeader makeHeader(int motor_count)
+{
+  BinaryLogHeader h{};
+  std::memcpy(h.magic, BINARY_LOG_MAGIC, sizeof(h.magic));
+  h.version = BINARY_LOG_VERSION;
+  h.header_size = sizeof(BinaryLogHeader);
+  h.motor_count = static_cast<uint32_t>(motor_count);
+  h.motor_size = sizeof(InteractiveMotorData);
+  h.record_size = static_cast<uint32_t>(sizeof(double) + motor_count * sizeof(InteractiveMotorData));
+  h.index_interval = BINARY_LOG_INDEX_INTERVAL;
+  h.field_count = BINARY_LOG_FIELD_COUNT;
+
+  // 字段布局由 MOTOR_FIELDS 描述表生成
+  for (uint32_t i = 0; i < BINARY_LOG_FIELD_COUNT; ++i)
+  {
+    std::strncpy(h.fields[i].name, MOTOR_FIELDS[i].name, sizeof(h.fields[i].name) - 1);
+    h.fields[i].offset = static_cast<uint32_t>(MOTOR_FIELDS[i].offset);
+    h.fields[i].type = 0;
+  }
+  return h;
+}
+
+/**
+ * @brief 检查文件头是否与当前布局一致（续写前使用）
+ */
+bool sameLayout(const BinaryLogHeader &a, const BinaryLogHeader &b)
+{
+  return std::memcmp(&a, &b, sizeof(BinaryLogHeader)) == 0;
+}
+} // namespace
+
+// ============================ BinaryLogFile ============================
+
+BinaryLogFile::~BinaryLogFile()
+{
+  close();
+}
+
+bool BinaryLogFile::open(const std::string &filename, int motor_count)
+{
+  close();
+  if (motor_count <= 0 || motor_count > MAX_MOTOR_COUNT)
+  {
+    return false;
+  }
+
+  const BinaryLogHeader header = makeHeader(motor_count);
+
+  // 文件已存在且布局一致时续写，否则重新创建
+  bool resume = false;
+  struct stat st;
+  if (::stat(filename.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) >= header.header_size)
+  {
+    std::FILE *probe = std::fopen(filename.c_str(), "rb");
+    if (probe)
+    {
+      BinaryLogHeader existing{};
+      resume = std::fread(&existing, sizeof(existing), 1, probe) == 1 && sameLayout(existing, header);
+      std::fclose(probe);
+    }
+  }
+
+  if (resume)
+  {
+    uint64_t payload = static_cast<uint64_t>(st.st_size) - header.header_size;
+    record_count_ = payload / header.record_size;
+    // 上次异常退出可能留下不完整的记录，截断到最后一条完整记录
+    if (payload % header.record_size != 0 &&
+        ::truncate(filename.c_str(), static_cast<off_t>(header.header_size + record_count_ * header.record_size)) != 0)
+    {
+      return false;
+    }
+    data_ = std::fopen(filename.c_str(), "ab");
+    index_ = std::fopen((filename + ".idx").c_str(), "ab");
+  }
+  else
+  {
+    record_count_ = 0;
+    data_ = std::fopen(filename.c_str(), "wb");
+    index_ = std::fopen((filename + ".idx").c_str(), "wb");
+    if (data_)
+    {
+      std::fwrite(&header, sizeof(header), 1, data_);
+    }
+  }
+
+  if (!data_ || !index_)
+  {
+    close();
+    return false;
+  }
+
+  std::setvbuf(data_, nullptr, _IOFBF, WRITE_BUFFER_BYTES);
+  motor_count_ = motor_count;
+  return true;
+}
+
+void BinaryLogFile::append(const RawMotorFrame &frame)
+{
+  if (!data_)
+  {
+    return;
+  }
+
+  if (record_count_ % BINARY_LOG_INDEX_INTERVAL == 0)
+  {
+    const BinaryLogIndexEntry entry{frame.stamp, record_count_};
+    std::fwrite(&entry, sizeof(entry), 1, index_);
+  }
+
+  std::fwrite(&frame.stamp, sizeof(frame.stamp), 1, data_);
+  const int valid = std::min<int>(frame.motor_count, motor_count_);
+  std::fwrite(frame.motors, sizeof(InteractiveMotorData), static_cast<size_t>(valid), data_);
+  static const InteractiveMotorData zero{};
+  for (int m = valid; m < motor_count_; ++m)
+  {
+    std::fwrite(&zero, sizeof(zero), 1, data_);
+  }
+  ++record_count_;
+}
+
+void BinaryLogFile::flush()
+{
+  if (data_)
+  {
+    std::fflush(data_);
+  }
+  if (index_)
+  {
+    std::fflush(index_);
+  }
+}
+
+void BinaryLogFile::close()
+{
+  if (data_)
+  {
+    std::fclose(data_);
+    data_ = nullptr;
+  }
+  if (index_)
+  {
+    std::fclose(index_);
+    index_ = nullptr;
+  }
+}
+
+uint64_t BinaryLogFile::bytesWritten() const
+{
+  const uint64_t index_entries = (record_count_ + BINARY_LOG_INDEX_INTERVAL - 1) / BINARY_LOG_INDEX_INTERVAL;
+  return sizeof(BinaryLogHeader) + record_count_ * (sizeof(double) + motor_count_ * sizeof(InteractiveMotorData)) +
+         index_entries * sizeof(BinaryLogIndexEntry);
+}
+
+// ============================ BinaryLogReader ============================
+
+BinaryLogReader::~BinaryLogReader()
+{
+  close();
+}
+
+bool BinaryLogReader::open(const std::string &filename)
+{
+  close();
+
+  data_ = std::fopen(filename.c_str(), "rb");
+  if (!data_)
+  {
+    return false;
+  }
+
+  if (std::fread(&header_, sizeof(header_), 1, data_) != 1 ||
+      std::memcmp(header_.magic, BINARY_LOG_MAGIC, sizeof(header_.magic)) != 0 ||
+      header_.version != BINARY_LOG_VERSION || header_.record_size == 0 ||
+      header_.record_size != sizeof(double) + header_.motor_count * header_.motor_size)
+  {
+    close();
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(fileno(data_), &st) != 0 || static_cast<uint64_t>(st.st_size) < header_.header_size)
+  {
+    close();
+    return false;
+  }
+  record_count_ = (static_cast<uint64_t>(st.st_size) - header_.header_size) / header_.record_size;
+
+  // 读取索引（可选），丢弃指向不存在记录的项
+  std::FILE *index = std::fopen((filename + ".idx").c_str(), "rb");
+  if (index)
+  {
+    BinaryLogIndexEntry entry;
+    while (std::fread(&entry, sizeof(entry), 1, index) == 1)
+    {
+      if (entry.record < record_count_)
+      {
+        index_.push_back(entry);
+      }
+    }
+    std::fclose(index);
+  }
+  return true;
+}
+
+void BinaryLogReader::close()
+{
+  if (data_)
+  {
+    std::fclose(data_);
+    data_ = nullptr;
+  }
+  record_count_ = 0;
+  index_.clear();
+}
+
+bool BinaryLogReader::readStamp(uint64_t record, double &stamp)
+{
+  if (!data_ || record >= record_count_)
+  {
+    return false;
+  }
+  const uint64_t offset = header_.header_size + record * header_.record_size;
+  return ::fseeko(data_, static_cast<off_t>(offset), SEEK_SET) == 0 &&
+         std::fread(&stamp, sizeof(stamp), 1, data_) == 1;
+}
+
+bool BinaryLogReader::readRecord(uint64_t record, double &stamp, InteractiveMotorData *motors)
+{
+  if (!readStamp(record, stamp))
+  {
+    return false;
+  }
+  const size_t motor_bytes = static_cast<size_t>(header_.motor_count) * header_.motor_size;
+  if (header_.motor_size == sizeof(InteractiveMotorData))
+  {
+    return std::fread(motors, motor_bytes, 1, data_) == 1;
+  }
+
+  // 布局不同（例如发送端新增字段）：按文件头中的字段偏移逐个拷贝同名字段
+  std::vector<char> raw(motor_bytes);
+  if (std::fread(raw.data(), motor_bytes, 1, data_) != 1)
+  {
+    return false;
+  }
+  const BinaryLogHeader current = makeHeader(MOTOR_COUNT);
+  for (uint32_t m = 0; m < header_.motor_count; ++m)
+  {
+    InteractiveMotorData out{};
+    for (uint32_t f = 0; f < std::min(header_.field_count, BINARY_LOG_FIELD_COUNT); ++f)
+    {
+      for (uint32_t c = 0; c < BINARY_LOG_FIELD_COUNT; ++c)
+      {
+        if (std::strncmp(header_.fields[f].name, current.fields[c].name, sizeof(current.fields[c].name)) == 0 &&
+            header_.fields[f].offset + sizeof(double) <= header_.motor_size)
+        {
+          std::memcpy(reinterpret_cast<char *>(&out) + current.fields[c].offset,
+                      raw.data() + m * header_.motor_size + header_.fields[f].offset, sizeof(double));
+          break;
+        }
+      }
+    }
+    motors[m] = out;
+  }
+  return true;
+}
+
+uint64_t BinaryLogReader::findRecord(double stamp)
+{
+  // 1. 在索引中二分，找到最后一个时间戳 < stamp 的索引项，确定查找区间
+  uint64_t lo = 0;
+  uint64_t hi = record_count_;
+  if (!index_.empty())
+  {
+    auto it = std::lower_bound(index_.begin(), index_.end(), stamp,
+                               [](const BinaryLogIndexEntry &e, double t)
+                               { return e.stamp < t; });
+    if (it != index_.begin())
+    {
+      lo = std::prev(it)->record;
+    }
+    if (it != index_.end())
+    {
+      hi = std::min<uint64_t>(it->record + 1, record_count_);
+    }
+  }
+
+  // 2. 在区间内按记录时间戳二分（记录定长，可直接定位）
+  while (lo < hi)
+  {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    double t = 0.0;
+    if (!readStamp(mid, t))
+    {
+      break;
+    }
+    if (t < stamp)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file binaryLog.h
+ * @brief 紧凑二进制日志格式（带可随机定位的时间索引）头文件
+ * @author mafangniu
+ * @date 2025-04-14
+ *
+ * @details
+ * 文本日志每帧约 1.2KB 且大部分是重复的标签，全时记录时很快占满 /tmp。二进制格式为：
+ *
+ * - 文件头（BinaryLogHeader）：魔数、版本、电机数、每条记录字节数、索引间隔，
+ *   以及 InteractiveMotorData 每个字段的名称和字节偏移，读取端据此解析，不依赖编译期结构体；
+ * - 定长记录：8 字节 double 时间戳 + motor_count 个原始 InteractiveMotorData（各 104 字节），
+ *   第 i 条记录位于 header_size + i * record_size；电机数在打开文件时确定，同一文件内不变；
+ * - 索引文件（同名 + ".idx"）：每 index_interval 条记录追加一项 {时间戳, 记录号}，
+ *   按时间查找只需二分索引再在一个间隔内线性查找，无需扫描全文件。
+ *
+ * 所有数值按本机字节序（x86/ARM 小端）写入。文本格式可由 tools/motor_log_convert 离线转换得到。
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "motorData.h"
+#include "motorFields.h"
+
+static constexpr char BINARY_LOG_MAGIC[8] = {'P', 'J', 'M', 'O', 'T', 'O', 'R', '1'};
+static constexpr uint32_t BINARY_LOG_VERSION = 1;
+static constexpr uint32_t BINARY_LOG_FIELD_COUNT = MOTOR_FIELD_COUNT;
+static constexpr uint32_t BINARY_LOG_INDEX_INTERVAL = 256; // 每 256 条记录写一项索引
+
+// 文件头中对单个字段的描述
+struct BinaryLogField
+{
+  char name[24];   // 字段名（以 '\0' 结尾）
+  uint32_t offset; // 在 InteractiveMotorData 中的字节偏移
+  uint32_t type;   // 字段类型，目前固定为 0（double）
+};
+
+// 二进制日志文件头
+struct BinaryLogHeader
+{
+  char magic[8];           // BINARY_LOG_MAGIC
+  uint32_t version;        // BINARY_LOG_VERSION
+  uint32_t header_size;    // 文件头总字节数（记录区起始偏移）
+  uint32_t motor_count;    // 每条记录中的电机数
+  uint32_t motor_size;     // 每个电机的字节数（sizeof(InteractiveMotorData)）
+  uint32_t record_size;    // 每条记录字节数（8 + motor_count * motor_size）
+  uint32_t index_interval; // 索引间隔（记录条数）
+  uint32_t field_count;    // 字段描述个数
+  uint32_t reserved;
+  BinaryLogField fields[BINARY_LOG_FIELD_COUNT];
+};
+
+// 索引项：第 record 条记录的时间戳
+struct BinaryLogIndexEntry
+{
+  double stamp;
+  uint64_t record;
+};
+
+/**
+ * @class BinaryLogFile
+ * @brief 二进制日志写入器（追加记录，周期性追加索引）
+ *
+ * 只在写线程中使用，不做线程同步。
+ */
+class BinaryLogFile
+{
+public:
+  BinaryLogFile() = default;
+  ~BinaryLogFile();
+
+  BinaryLogFile(const BinaryLogFile &) = delete;
+  BinaryLogFile &operator=(const BinaryLogFile &) = delete;
+
+  /**
+   * @brief 打开（或续写）二进制日志文件
+   * @param filename 日志文件名，索引写入 filename + ".idx"
+   * @param motor_count 每条记录中的电机数（1 ~ MAX_MOTOR_COUNT）
+   * @return 成功返回 true
+   *
+   * 文件已存在且文件头匹配（含电机数）时在末尾续写，否则重新创建。
+   */
+  bool open(const std::string &filename, int motor_count);
+
+  /**
+   * @brief 追加一条记录
+   * @param frame 原始帧（时间戳取 frame.stamp），写入前 motorCount() 个电机，
+   *              frame.motor_count 不足时缺少的电机补零
+   */
+  void append(const RawMotorFrame &frame);
+
+  /**
+   * @brief 将缓冲写入磁盘
+   */
+  void flush();
+
+  /**
+   * @brief 关闭文件
+   */
+  void close();
+
+  bool isOpen() const { return data_ != nullptr; }
+
+  /**
+   * @brief 当前文件每条记录的电机数
+   */
+  int motorCount() const { return motor_count_; }
+
+  /**
+   * @brief 已写入（含续写前已有）的记录条数
+   */
+  uint64_t recordCount() const { return record_count_; }
+
+  /**
+   * @brief 当前数据文件与索引文件的总字节数
+   */
+  uint64_t bytesWritten() const;
+
+private:
+  std::FILE *data_ = nullptr;  ///< 数据文件
+  std::FILE *index_ = nullptr; ///< 索引文件
+  uint64_t record_count_ = 0;  ///< 记录条数
+  int motor_count_ = 0;        ///< 每条记录的电机数
+};
+
+/**
+ * @class BinaryLogReader
+ * @brief 二进制日志读取器（离线转换、回放使用）
+ */
+class BinaryLogReader
+{
+public:
+  BinaryLogReader() = default;
+  ~BinaryLogReader();
+
+  BinaryLogReader(const BinaryLogReader &) = delete;
+  BinaryLogReader &operator=(const BinaryLogReader &) = delete;
+
+  /**
+   * @brief 打开二进制日志文件并读取文件头和索引（索引文件缺失时退化为二分查找记录）
+   * @param filename 日志文件名
+   * @return 文件头有效返回 true
+   */
+  bool open(const std::string &filename);
+
+  void close();
+
+  const BinaryLogHeader &header() const { return header_; }
+
+  /**
+   * @brief 文件中完整记录的条数（末尾不完整的记录被忽略）
+   */
+  uint64_t recordCount() const { return record_count_; }
+
+  /**
+   * @brief 读取第 record 条记录
+   * @param record 记录号
+   * @param stamp 输出时间戳
+   * @param motors 输出电机数据，需至少容纳 header().motor_count 个元素
+   * @return 成功返回 true
+   */
+  bool readRecord(uint64_t record, double &stamp, InteractiveMotorData *motors);
+
+  /**
+   * @brief 查找第一条时间戳 >= stamp 的记录号
+   * @param stamp 目标时间（秒）
+   * @return 记录号；所有记录都早于 stamp 时返回 recordCount()
+   */
+  uint64_t findRecord(double stamp);
+
+private:
+  /**
+   * @brief 读取第 record 条记录的时间戳
+   */
+  bool readStamp(uint64_t record, double &stamp);
+
+  std::FILE *data_ = nullptr;
+  BinaryLogHeader header_{};
+  uint64_t record_count_ = 0;
+  std::vector<BinaryLogIndexEntry> index_;
+};
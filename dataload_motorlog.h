@@ -0,0 +1,61 @@
+/**
+ * @file dataload_motorlog.h
+ * @author mafangniu
+ * @brief PlotJuggler 数据加载插件头文件（在 PlotJuggler 中回放已记录的电机日志）
+ * @version 1.0
+ * @date 2025-04-30
+ *
+ * @details
+ * 实时插件记录的日志（motor_error_log_*.txt / full_log_*.txt 文本日志，以及 *.bin 二进制日志）
+ * 可以在 PlotJuggler 中通过 File -> Load Data 直接打开，曲线与实时显示相同（Motor1/Pos ...），
+ * 便于事后对照错误发生前后的数据。
+ *
+ * 加载由 motorLogLoader.h 完成（mmap + 二进制直接抽取 / 文本分块并行解析），
+ * 本类只负责注册曲线并把各列并行推送到 PlotJuggler，多 GB 的日志也能在数秒内加载完成。
+ */
+
+#pragma once
+
+#include <QtPlugin>
+#include <vector>
+#include "PlotJuggler/dataloader_base.h"
+
+/**
+ * @class DataLoadMotorLog
+ * @brief 电机日志加载插件
+ */
+class DataLoadMotorLog : public PJ::DataLoader
+{
+  Q_OBJECT
+  Q_PLUGIN_METADATA(IID "facontidavide.PlotJuggler3.DataLoader")
+  Q_INTERFACES(PJ::DataLoader)
+
+public:
+  DataLoadMotorLog();
+
+  /**
+   * @brief 支持的文件扩展名（txt / bin）
+   */
+  virtual const std::vector<const char *> &compatibleFileExtensions() const override;
+
+  /**
+   * @brief 加载日志文件到 PlotJuggler
+   * @param fileload_info 文件信息（使用 filename）
+   * @param destination 曲线容器
+   * @return 加载成功返回 true，失败时弹窗提示原因
+   */
+  virtual bool readDataFromFile(PJ::FileLoadInfo *fileload_info, PJ::PlotDataMapRef &destination) override;
+
+  virtual ~DataLoadMotorLog() override = default;
+
+  /**
+   * @brief 加载插件的名称
+   */
+  virtual const char *name() const override
+  {
+    return "MotorMonitor Log";
+  }
+
+private:
+  std::vector<const char *> extensions_;
+};
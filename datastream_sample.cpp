@@ -7,7 +7,7 @@
  *
  * @details
  * 该文件实现了 DataStreamSample 类，作为 PlotJuggler 的插件，支持通过 UDP 接收电机状态数据并进行可视化。
- * 数据源为裸字节流形式发送的 `InteractiveMotorData` 结构体数组。
+ * 数据源为裸字节流形式发送的 `InteractiveMotorData` 结构体数组，可带自描述包头（电机数、格式版本、序号，见 motorPacket.h）。
  * 插件负责将数据解析为结构化变量，并通过 PlotJuggler 的接口显示在图形界面中。
  *
  * 支持功能包括：
@@ -22,29 +22,46 @@
  * - 使用多线程分别处理数据流和 UI 更新；
  * - 使用 Qt 元对象系统在非主线程中更新 UI；
  * - 使用标准库进行错误数据缓存与日志输出；
- * - 所有数据按字段顺序手动提取，保证与发送端结构严格对齐；
+ * - 所有字段按 `MOTOR_FIELDS` 描述表中的偏移提取，保证与发送端结构严格对齐；
  *
  * @note
- * 若更改 `InteractiveMotorData` 结构体字段或顺序，需同时修改：
- * - `extract_fields()` 函数字段提取逻辑；
- * - `field_names` 中字段名称顺序；
- * - UI 和日志导出格式。
+ * 若更改 `InteractiveMotorData` 结构体字段或顺序，只需修改 motorFields.h 中的 `MOTOR_FIELDS` 描述表，
+ * 变量注册、解码、UI 和日志导出格式都由该表生成。
  *
  */
 
 #include <QDebug>
+#include <algorithm>
 #include <thread>
 #include <mutex>
 #include <chrono>
 #include <cmath>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include "datastream_sample.h"
 #include "saveErrorLog.h"
+#include "logWriter.h"
+#include "motorPacket.h"
 
 // 用于显示错误类型
 #include <QLabel>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QTimer>
-
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QSettings>
+#include <QTableView>
+#include <QAbstractItemView>
+#include <QHeaderView>
+
+#include <fstream>
 #include <filesystem> // 确保日志存储位置有效，文件夹不存在时进行创建
 
 using namespace PJ;
@@ -57,7 +74,7 @@ using namespace PJ;
  * 该构造函数负责初始化数据流对象，创建数据存储数组，并在 PlotJuggler 中注册变量名称。
  */
 DataStreamSample::DataStreamSample(int group_count, int var_count)
-    : _group_count(group_count), _var_count(var_count)
+    : _var_count(std::min(var_count, static_cast<int>(PLOTTED_FIELD_COUNT))), _frame_ring(FRAME_RING_CAPACITY)
 {
 
   // 确保日志存储位置存在
@@ -73,40 +90,329 @@ DataStreamSample::DataStreamSample(int group_count, int var_count)
     qDebug() << "✅ 日志存储文件夹/tmp/plotjuggler_motor_monitor_log创建成功 ";
   }
 
-  _running = false;
   qRegisterMetaType<std::vector<std::vector<double>>>("std::vector<std::vector<double>>");
-  _data_array = std::vector<std::vector<double>>(_group_count, std::vector<double>(_var_count, 0.0));
 
-  // 注册各电机的各个量
-  for (int g = 0; g < _group_count; ++g)
+  // 曲线抽稀的默认桶宽取自字段描述表（默认不启用）
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
   {
-    for (int v = 0; v < _var_count; ++v)
+    decimation_bucket_ms_[f] = MOTOR_FIELDS[f].decimation_ms;
+    _decimation_bucket_s[f] = MOTOR_FIELDS[f].decimation_ms / 1000.0;
+  }
+
+  // 发布阶段的批量缓冲，只在构造时分配一次（单帧按 MAX_MOTOR_COUNT 预留，电机数变化时无需重新分配）
+  _publish_frames.resize(PUBLISH_BATCH_SIZE);
+  derived_mask_ = loadDerivedSignalMask();
+  field_mask_ = loadMotorFieldMask();
+  const AlarmConfig alarm_config = loadAlarmConfig();
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    history_max_seconds_ = std::max(0.0, settings.value("history_max_seconds", 0.0).toDouble());
+    history_max_points_ = std::max(0, settings.value("history_max_points", 0).toInt());
+  }
+
+  // 数据源列表在构造时确定，每个数据源有独立的曲线命名空间
+  const std::vector<UdpSourceConfig> configs = loadSourceList();
+  _sources.resize(configs.size());
+  _publish_last_frame.assign(configs.size(), -1);
+  for (size_t s = 0; s < configs.size(); ++s)
+  {
+    _sources[s].config = configs[s];
+    _sources[s].prefix = configs[s].name.empty() ? std::string() : configs[s].name + "/";
+    _sources[s].alarm_engine.configure(alarm_config);
+    // 注册各电机启用的字段（启动时按 group_count 注册，之后按数据报中的电机数补充，启用新字段时在推送时补充）
+    ensureMotorGroupsLocked(_sources[s], group_count);
+
+    // 注册接收统计曲线（_stats/rx_rate，多数据源时为 _stats/RobotA/rx_rate）
+    for (int i = 0; i < RX_STATS_SERIES_COUNT; ++i)
     {
-      if (v >= field_names.size())
-        continue;
-      std::string name = "Motor" + std::to_string(g + 1) + "/" + field_names[v];
-      dataMap().addNumeric(name);
-      qDebug() << "Registered:" << QString::fromStdString(name);
+      std::string name = "_stats/" + _sources[s].prefix + RX_STATS_SERIES_NAMES[i];
+      _sources[s].stats_series[i] = &dataMap().addNumeric(name)->second;
+    }
+  }
+  _log_drops_series = &dataMap().addNumeric("_stats/log_drops")->second;
+  _relay_sent_series = &dataMap().addNumeric("_stats/relay_sent")->second;
+  _relay_dropped_series = &dataMap().addNumeric("_stats/relay_dropped")->second;
+
+  // 注册延迟统计曲线（单位微秒），计数快照缓冲一次性分配
+  static const char *const LATENCY_SERIES_SUFFIX[3] = {"/p50", "/p99", "/max"};
+  for (int s = 0; s < LATENCY_STAGE_COUNT; ++s)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      std::string name = std::string("_latency/") + LATENCY_STAGE_NAMES[s] + LATENCY_SERIES_SUFFIX[k];
+      _latency_series[s][k] = &dataMap().addNumeric(name)->second;
     }
   }
+  _latency_prev_counts.assign(LATENCY_STAGE_COUNT, LatencyHistogram::Counts{});
+  _latency_counts = std::make_unique<LatencyHistogram::Counts>();
+  _publish_recv_ns.reserve(FRAME_RING_CAPACITY);
+  log_writer_.setLatencyProfiler(&latency_profiler_);
+}
+
+/**
+ * @brief 读取数据源列表
+ * @return 数据源配置，至少包含一个数据源
+ */
+std::vector<UdpSourceConfig> DataStreamSample::loadSourceList()
+{
+  std::string spec = std::to_string(DEFAULT_UDP_PORT);
+  if (const char *env = std::getenv("MOTOR_MONITOR_SOURCES"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("udp_sources", QString::fromStdString(spec)).toString().toStdString();
+  }
+
+  std::vector<UdpSourceConfig> sources;
+  std::string error;
+  if (!parseUdpSourceList(spec, sources, &error))
+  {
+    qDebug() << "⚠️ 数据源列表无效：" << QString::fromStdString(error) << "，使用默认端口" << DEFAULT_UDP_PORT;
+    sources.assign(1, UdpSourceConfig{});
+  }
+  return sources;
+}
+
+/**
+ * @brief 读取接收线程配置
+ * @return 接收线程配置（配置无效时为默认配置）
+ */
+RxThreadProfile DataStreamSample::loadRxThreadProfile()
+{
+  std::string spec;
+  if (const char *env = std::getenv("MOTOR_MONITOR_RX_PROFILE"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("rx_profile", QString()).toString().toStdString();
+  }
+
+  RxThreadProfile profile;
+  std::string error;
+  if (!parseRxThreadProfile(spec, profile, &error))
+  {
+    qDebug() << "⚠️ 接收线程配置无效：" << QString::fromStdString(error) << "，使用默认配置";
+  }
+  return profile;
+}
+
+/**
+ * @brief 读取启用的派生曲线
+ * @return 启用掩码（配置无效时不启用）
+ */
+uint32_t DataStreamSample::loadDerivedSignalMask()
+{
+  std::string spec;
+  if (const char *env = std::getenv("MOTOR_MONITOR_DERIVED"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("derived_signals", QString()).toString().toStdString();
+  }
+
+  uint32_t mask = 0;
+  std::string error;
+  if (!parseDerivedSignalMask(spec, mask, &error))
+  {
+    qDebug() << "⚠️ 派生曲线配置无效：" << QString::fromStdString(error) << "，不启用派生曲线";
+  }
+  return mask;
+}
+
+/**
+ * @brief 读取启用的字段
+ * @return 字段掩码（配置无效时为默认字段）
+ */
+uint32_t DataStreamSample::loadMotorFieldMask()
+{
+  std::string spec;
+  if (const char *env = std::getenv("MOTOR_MONITOR_FIELDS"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("plotted_fields", QString()).toString().toStdString();
+  }
+
+  uint32_t mask = DEFAULT_MOTOR_FIELD_MASK;
+  std::string error;
+  if (!parseMotorFieldMask(spec, mask, &error))
+  {
+    qDebug() << "⚠️ 显示字段配置无效：" << QString::fromStdString(error) << "，使用默认字段";
+  }
+  return mask;
+}
+
+/**
+ * @brief 读取告警规则
+ * @return 告警配置（配置无效时不启用告警）
+ */
+AlarmConfig DataStreamSample::loadAlarmConfig()
+{
+  std::string spec;
+  if (const char *env = std::getenv("MOTOR_MONITOR_ALARMS"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("alarm_rules", QString()).toString().toStdString();
+  }
+
+  AlarmConfig config;
+  std::string error;
+  if (!parseAlarmConfig(spec, config, &error))
+  {
+    qDebug() << "⚠️ 告警规则无效：" << QString::fromStdString(error) << "，不启用告警";
+  }
+  return config;
+}
+
+/**
+ * @brief 读取转发配置
+ * @return 转发配置（配置无效时不转发）
+ */
+UdpRelayConfig DataStreamSample::loadRelayConfig()
+{
+  std::string spec;
+  if (const char *env = std::getenv("MOTOR_MONITOR_RELAY"))
+  {
+    spec = env;
+  }
+  else
+  {
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    spec = settings.value("relay", QString()).toString().toStdString();
+  }
+
+  UdpRelayConfig config;
+  std::string error;
+  if (!parseUdpRelayConfig(spec, config, &error))
+  {
+    qDebug() << "⚠️ 转发配置无效：" << QString::fromStdString(error) << "，不转发";
+  }
+  return config;
+}
+
+/**
+ * @brief 注册一个电机的一个字段的曲线（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param group 电机序号
+ * @param field MOTOR_FIELDS 下标
+ * @return 曲线指针
+ */
+PlotData *DataStreamSample::registerFieldSeriesLocked(MotorSource &source, int group, size_t field)
+{
+  PlotData *&plot = source.series[group * MOTOR_FIELD_COUNT + field];
+  if (!plot)
+  {
+    std::string name = source.prefix + "Motor" + std::to_string(group + 1) + "/" + MOTOR_FIELDS[field].name;
+    // unordered_map 中元素地址稳定，直接缓存 PlotData 指针，推送时无需再拼接名字和查表
+    plot = &dataMap().addNumeric(name)->second;
+    qDebug() << "Registered:" << QString::fromStdString(name);
+  }
+  return plot;
+}
 
-  // 针对错误类型显示界面加空指针保护
-  if (!motor_error_labels_.empty())
+/**
+ * @brief 按保留策略裁剪插件暂存数据表 dataMap() 中的所有曲线（发布线程调用）
+ *
+ * 所有曲线在一次 mutex() 加锁内裁剪，裁剪后的暂存点数显示在界面上。
+ * PlotJuggler 每次刷新都会取走并清空 dataMap()，只有暂停（停止取数据）时点才会累积到被裁剪；
+ * 主界面曲线的历史长度由 PlotJuggler 的 Buffer 设置决定，不在这里统计。
+ */
+void DataStreamSample::trimHistory()
+{
+  HistoryRetentionPolicy policy;
+  policy.max_seconds = history_max_seconds_;
+  policy.max_points = static_cast<size_t>(std::max(0, history_max_points_.load()));
+
+  uint64_t trimmed = 0;
+  uint64_t retained = 0;
   {
-    for (int i = 0; i < std::min(_group_count, (int)motor_error_labels_.size()); ++i)
+    std::lock_guard<std::mutex> lock(mutex());
+    for (auto &it : dataMap().numeric)
+    {
+      if (policy.enabled())
+      {
+        trimmed += trimSeriesHistory(it.second, policy);
+      }
+      retained += it.second.size();
+    }
+    for (auto &it : dataMap().strings)
     {
-      QLabel *label = motor_error_labels_[i];
-      if (!label)
-        continue; // ✅ 防止空指针崩溃
+      if (policy.enabled())
+      {
+        trimmed += trimSeriesHistory(it.second, policy);
+      }
+      retained += it.second.size();
+    }
+  }
+  _history_trimmed_points += trimmed;
+
+  if (_history_label)
+  {
+    // 每个数值点 16 字节（时间 + 数值），不含容器自身的开销
+    const QString text = QString("待 PlotJuggler 取走 %1 点(约 %2 MiB) | 暂停时已裁剪 %3 点")
+                             .arg(static_cast<qulonglong>(retained))
+                             .arg(retained * 16.0 / (1024.0 * 1024.0), 0, 'f', 1)
+                             .arg(static_cast<qulonglong>(_history_trimmed_points));
+    QMetaObject::invokeMethod(_history_label, "setText", Qt::QueuedConnection, Q_ARG(QString, text));
+  }
+}
+
+/**
+ * @brief 确保数据源至少已注册 motor_count 个电机的曲线（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param motor_count 需要的电机数
+ */
+void DataStreamSample::ensureMotorGroupsLocked(MotorSource &source, int motor_count)
+{
+  motor_count = std::min(motor_count, MAX_MOTOR_COUNT);
+  if (motor_count <= source.group_count)
+  {
+    return;
+  }
 
-      int error_val = static_cast<int>(_data_array[i][3] + 0.5);
-      QString error_str = errorToText(error_val);
-      label->setText(QString("%1 (%2)").arg(error_str).arg(error_val));
+  source.series.resize(motor_count * MOTOR_FIELD_COUNT, nullptr);
+  source.decimators.resize(motor_count * MOTOR_FIELD_COUNT);
+  source.last_motors.resize(motor_count, InteractiveMotorData{});
+  const uint32_t field_mask = field_mask_.load(std::memory_order_relaxed);
+  for (int g = source.group_count; g < motor_count; ++g)
+  {
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      source.decimators[g * MOTOR_FIELD_COUNT + f].configure(_decimation_bucket_s[f], _decimation_mode);
+      if (field_mask & (1u << f))
+      {
+        registerFieldSeriesLocked(source, g, f); // 未启用的字段在启用后第一次推送时注册
+      }
     }
   }
 
-  // 缓存上一帧每个电机的错误码，只在值变化时才刷新对应
-  last_errors_.resize(_group_count, -1);  // 用 -1 表示“初始无记录”
+  // 派生曲线在启用时才注册，这里只扩展表格
+  source.derived_series.resize(motor_count * DERIVED_SIGNAL_COUNT, nullptr);
+  source.derived_decimators.resize(motor_count * DERIVED_SIGNAL_COUNT);
+  for (int i = source.group_count * DERIVED_SIGNAL_COUNT; i < motor_count * DERIVED_SIGNAL_COUNT; ++i)
+  {
+    source.derived_decimators[i].configure(DERIVED_SIGNALS[i % DERIVED_SIGNAL_COUNT].decimation_ms / 1000.0, _decimation_mode);
+  }
+
+  source.data_array.resize(motor_count, std::vector<double>(_var_count, 0.0));
+  source.group_count = motor_count;
+  source.error_snapshot->setMotorCount(motor_count); // 界面表格在下次刷新时增加新电机的行
 }
 
 
@@ -117,15 +423,12 @@ DataStreamSample::DataStreamSample(int group_count, int var_count)
 void DataStreamSample::setData(const std::vector<std::vector<double>> &data)
 {
   // 检查数据大小是否符合预期
-  if (data.size() != _group_count || data[0].size() != _var_count)
+  if (data.size() != _sources[0].group_count || data[0].size() != _var_count)
   {
     qDebug() << "Invalid data size!";
     return;
   }
 
-  // 更新数据存储数组
-  _data_array = data;
-
   // 调试时打印输出，后期可注释。
   // qDebug() << "setData() received:";
   // for (int g = 0; g < _group_count; ++g)
@@ -133,32 +436,50 @@ void DataStreamSample::setData(const std::vector<std::vector<double>> &data)
   //   qDebug() << "Group" << g + 1 << ":" << data[g];
   // }
 
-  // 更新数据并通知监听者
-  updateData();
+  // 更新数据并通知监听者（与 loop() 线程共用 data_array，整批推送同样只在 mutex 内读写）
+  auto now = std::chrono::high_resolution_clock::now();
+  double stamp = std::chrono::duration<double>(now.time_since_epoch()).count();
+  setDataBatch({data}, {stamp}, 1);
 }
 
 /**
  * @brief 启动数据流
  * @return 成功启动返回 true
  *
- * 该函数启动数据更新线程和 UDP 数据监听线程。
+ * 该函数启动数据更新线程和 UDP 数据监听线程。两个线程都由本对象持有，shutdown() 中唤醒并等待退出，
+ * 因此停止后再次启动时旧线程已经关闭了所有 socket，不会与新线程争用端口或 setData()。
  */
 bool DataStreamSample::start(QStringList *)
 {
+  if (_running)
+  {
+    shutdown(); // 未停止就再次启动：先完整地停止上一轮
+  }
+
+  // 停止时用于唤醒接收线程（加入接收线程的 epoll）
+  _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_wake_fd < 0)
+  {
+    qDebug() << "⚠️ 无法创建 eventfd，停止时接收线程最多延迟 100ms 退出, errno =" << errno;
+  }
   _running = true;
 
+  // 启动临时窗口显示电机错误类型
+  // (所使用的plotjuggler里没有OptionWidgets,而plotjuggler界面里只能显示数据,不能显示文本,额外单独开一个UI界面显示电机错误类型)
+  // 窗口必须在启动线程之前建好：发布线程读取窗口中的标签指针（stats_label、_log_stats_label 等），
+  // 指针在创建线程之前写入，线程创建保证其可见，之后直到析构都不再改变
+  startUIWindow();
+
+  // 启动异步日志写线程
+  log_writer_.start();
+
   // 启动数据更新线程,
   _thread = std::thread([this]()
                         { this->loop(); });
 
-  // 启动 UDP 数据监听线程（分离模式）
-  std::thread udp_thread([this]()
-                         { this->receiveUDPData(); });
-  udp_thread.detach(); // 分离线程，不阻塞主线程
-
-  // 启动临时窗口显示电机错误类型
-  // (所使用的plotjuggler里没有OptionWidgets,而plotjuggler界面里只能显示数据,不能显示文本,额外单独开一个UI界面显示电机错误类型)
-  startUIWindow();
+  // 启动 UDP 数据监听线程
+  _udp_thread = std::thread([this]()
+                            { this->receiveUDPData(); });
   return true;
 }
 
@@ -168,10 +489,38 @@ bool DataStreamSample::start(QStringList *)
 void DataStreamSample::shutdown()
 {
   _running = false;
+
+  // 唤醒接收线程：epoll 中的 eventfd 变为可读；在共享内存 futex 上等待时直接打断
+  if (_wake_fd >= 0)
+  {
+    const uint64_t one = 1;
+    if (write(_wake_fd, &one, sizeof(one)) < 0)
+    {
+      qDebug() << "⚠️ 唤醒接收线程失败, errno =" << errno;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(_rx_wait_mutex);
+    if (_rx_wait_reader)
+    {
+      _rx_wait_reader->interrupt();
+    }
+  }
+
+  if (_udp_thread.joinable())
+  {
+    _udp_thread.join(); // 接收线程退出前关闭所有 socket 和共享内存映射
+  }
   if (_thread.joinable())
   {
     _thread.join();
   }
+  if (_wake_fd >= 0)
+  {
+    close(_wake_fd);
+    _wake_fd = -1;
+  }
+  log_writer_.stop(); // 写完缓冲中剩余的日志帧后退出
 }
 
 /**
@@ -189,6 +538,54 @@ bool DataStreamSample::isRunning() const
 DataStreamSample::~DataStreamSample()
 {
   shutdown();
+
+  // 线程已退出，不会再向标签投递文本；窗口中的定时器、表格模型引用本实例，随窗口一起删除
+  for (MotorSource &source : _sources)
+  {
+    source.stats_label = nullptr;
+  }
+  _log_stats_label = nullptr;
+  _rx_profile_label = nullptr;
+  _history_label = nullptr;
+  delete ui_window_.data();
+}
+
+/**
+ * @brief 批量设置数据（UDP 批量接收时调用）
+ * @param frames       预分配的帧数组
+ * @param stamps       与 frames 一一对应的每帧时间戳（秒）
+ * @param frame_count  本批次有效帧数
+ * @param notify       推送后是否立即发出 dataReceived 信号
+ *
+ * 整批数据只获取一次 mutex，推送完成后最多发出一次 dataReceived 信号。多数据源时写入第一个数据源。
+ */
+void DataStreamSample::setDataBatch(const std::vector<std::vector<std::vector<double>>> &frames, const std::vector<double> &stamps,
+                                    int frame_count, bool notify)
+{
+  if (frame_count <= 0 || frame_count > static_cast<int>(frames.size()) || frame_count > static_cast<int>(stamps.size()))
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    MotorSource &source = _sources[0];
+
+    for (int f = 0; f < frame_count; ++f)
+    {
+      pushFrameLocked(source, frames[f], stamps[f]);
+    }
+
+    // 保留最后一帧，供 loop() 和错误码快照使用
+    source.data_array = frames[frame_count - 1];
+
+    publishErrorSnapshot(source);
+  }
+
+  if (notify)
+  {
+    emit dataReceived();
+  }
 }
 
 /**
@@ -204,228 +601,1145 @@ void DataStreamSample::updateData()
   double stamp = std::chrono::duration<double>(now.time_since_epoch()).count();
   // const double stamp = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / 1000.0;
 
-  // 将各电机的各个值推送到plotjuggler界面
-  for (int g = 0; g < _group_count; ++g)
+  for (MotorSource &source : _sources)
+  {
+    pushMotorsLocked(source, source.last_motors.data(), source.group_count, stamp, false);
+    publishErrorSnapshot(source);
+  }
+
+  emit dataReceived();
+}
+
+/**
+ * @brief 将一帧数据推送到 PlotJuggler（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param data  一帧数据
+ * @param stamp 时间戳（秒）
+ */
+void DataStreamSample::pushFrameLocked(MotorSource &source, const std::vector<std::vector<double>> &data, double stamp)
+{
+  // data 按 plotted 字段排列，写入最后一帧的原始数据后与实时数据走同一条推送路径
+  for (int g = 0; g < source.group_count; ++g)
   {
+    const double *values = data[g].data();
+    char *motor = reinterpret_cast<char *>(&source.last_motors[g]);
     for (int v = 0; v < _var_count; ++v)
     {
-      if (v >= field_names.size())
-        continue;
+      *reinterpret_cast<double *>(motor + MOTOR_FIELDS[PLOTTED_FIELDS[v]].offset) = values[v];
+    }
+  }
+  pushMotorsLocked(source, source.last_motors.data(), source.group_count, stamp, false);
+}
+
+/**
+ * @brief 按启用的字段推送若干电机的数据（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param motors 电机数据
+ * @param count 电机数
+ * @param stamp 时间戳（秒）
+ * @param decimate 是否经过抽稀
+ */
+void DataStreamSample::pushMotorsLocked(MotorSource &source, const InteractiveMotorData *motors, int count, double stamp, bool decimate)
+{
+  // 启用的字段每帧展开一次（最多 MOTOR_FIELD_COUNT 项，不分配内存），未启用的字段不读取
+  uint8_t fields[MOTOR_FIELD_COUNT];
+  const int field_count = expandMotorFieldMask(field_mask_.load(std::memory_order_relaxed), fields);
 
-      std::string name = "Motor" + std::to_string(g + 1) + "/" + field_names[v];
-      auto it = dataMap().numeric.find(name);
-      if (it != dataMap().numeric.end())
+  PlotData **series = source.series.data();
+  const int groups = std::min(count, source.group_count);
+  for (int g = 0; g < groups; ++g)
+  {
+    for (int k = 0; k < field_count; ++k)
+    {
+      const size_t f = fields[k];
+      const size_t i = g * MOTOR_FIELD_COUNT + f;
+      PlotData *plot = series[i] ? series[i] : registerFieldSeriesLocked(source, g, f);
+      const double value = motorFieldValue(motors[g], f);
+      if (decimate)
       {
-        it->second.pushBack(PlotData::Point(stamp, _data_array[g][v]));
-        // qDebug() << "mfn debug -> timestamp =" << stamp; // 调试用，查看时间戳是否正确
+        // 每桶只推送代表点（桶宽为 0 的字段原样推送）
+        SeriesDecimator::Point out[2];
+        const int n = source.decimators[i].push(stamp, value, out);
+        for (int p = 0; p < n; ++p)
+        {
+          plot->pushBack(PlotData::Point(out[p].t, out[p].v));
+        }
       }
       else
       {
-        qDebug() << "Not found in dataMap:" << QString::fromStdString(name);
+        plot->pushBack(PlotData::Point(stamp, value));
       }
     }
   }
+}
 
-  // 电机错误类型数据是单独界面显示,在此处进行更新
-  if (!motor_error_labels_.empty())
-  {
-    for (int i = 0; i < std::min(_group_count, (int)motor_error_labels_.size()); ++i)
-    {
-      int error_val = static_cast<int>(_data_array[i][3] + 0.5); // error字段下标
-      if(last_errors_[i]  != error_val)
-      {
-        last_errors_[i] = error_val;
-        QString error_str = errorToText(error_val);
-        QString text = QString("%1 (%2)").arg(error_str).arg(error_val);
+/**
+ * @brief 将一帧原始数据直接解码推送到 PlotJuggler（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param frame 原始帧
+ */
+void DataStreamSample::pushRawFrameLocked(MotorSource &source, const RawMotorFrame &frame)
+{
+  pushMotorsLocked(source, frame.motors, frame.motor_count, frame.stamp, _decimation_active);
 
-        // ⬇️ 设置颜色：错误为红色，无错为黑色
-        QString color = (error_val == 0) ? "black" : "red";
+  const uint32_t derived_mask = derived_mask_.load(std::memory_order_relaxed);
+  if (derived_mask != 0)
+  {
+    pushDerivedSignalsLocked(source, frame, derived_mask);
+  }
+  _decimation_pending = _decimation_pending || _decimation_active;
+}
 
-        // ⬇️ 设置字体颜色样式并更新文本
-        QMetaObject::invokeMethod(motor_error_labels_[i], "setStyleSheet", Qt::QueuedConnection,
-                                  Q_ARG(QString, QString("color: %1;").arg(color)));
+/**
+ * @brief 计算一帧的派生量并推送启用的派生曲线（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param frame 原始帧
+ * @param mask 启用的派生量
+ */
+void DataStreamSample::pushDerivedSignalsLocked(MotorSource &source, const RawMotorFrame &frame, uint32_t mask)
+{
+  const int groups = std::min<int>(frame.motor_count, source.group_count);
+  computeDerivedSignals(frame.motors, groups, _derived_block); // 所有电机、所有派生量一遍算完
 
-        QMetaObject::invokeMethod(motor_error_labels_[i], "setText", Qt::QueuedConnection,
-                                  Q_ARG(QString, text));
+  for (int d = 0; d < DERIVED_SIGNAL_COUNT; ++d)
+  {
+    if (!(mask & (1u << d)))
+    {
+      continue;
+    }
+    const double *values = _derived_block.values[d];
+    for (int g = 0; g < groups; ++g)
+    {
+      const int i = g * DERIVED_SIGNAL_COUNT + d;
+      PlotData *plot = source.derived_series[i];
+      if (!plot)
+      {
+        // 第一次启用该派生量时注册（每条曲线只发生一次）
+        std::string name = source.prefix + "Motor" + std::to_string(g + 1) + "/" + DERIVED_SIGNALS[d].name;
+        plot = source.derived_series[i] = &dataMap().addNumeric(name)->second;
+        qDebug() << "Registered:" << QString::fromStdString(name);
+      }
+      if (_decimation_active)
+      {
+        SeriesDecimator::Point out[2];
+        const int n = source.derived_decimators[i].push(frame.stamp, values[g], out);
+        for (int k = 0; k < n; ++k)
+        {
+          plot->pushBack(PlotData::Point(out[k].t, out[k].v));
+        }
+      }
+      else
+      {
+        plot->pushBack(PlotData::Point(frame.stamp, values[g]));
       }
     }
   }
-
-  emit dataReceived();
 }
 
 /**
- * @brief 数据流循环
- * 该函数以 50Hz 的频率运行，不断调用 updateData() 更新数据。
+ * @brief 检测一帧中各电机错误码的跳变并发布为事件（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param frame 原始帧
  */
-void DataStreamSample::loop()
+void DataStreamSample::publishErrorTransitionsLocked(MotorSource &source, const RawMotorFrame &frame)
 {
-  while (_running)
+  const int count = source.event_tracker.observe(frame, _publish_transitions.data());
+  for (int i = 0; i < count; ++i)
   {
-    auto prev = std::chrono::high_resolution_clock::now();
-    updateData();
-    // emit dataReceived(); // updateData() 内部也有 emit dataReceived()，这里可以注销
-    std::this_thread::sleep_until(prev + std::chrono::milliseconds(20)); // 50Hz 运行频率
+    const ErrorTransition &e = _publish_transitions[i];
+    if (e.motor >= source.event_series.size())
+    {
+      source.event_series.resize(e.motor + 1, nullptr);
+      source.event_text_series.resize(e.motor + 1, nullptr);
+    }
+    if (!source.event_series[e.motor])
+    {
+      const std::string name = "_events/" + source.prefix + "Motor" + std::to_string(e.motor + 1);
+      source.event_series[e.motor] = &dataMap().addNumeric(name + "/error_code")->second;
+      source.event_text_series[e.motor] = &dataMap().addStringSeries(name + "/transition")->second;
+      qDebug() << "Registered:" << QString::fromStdString(name);
+    }
+
+    // 数值序列只在跳变时刻有点（值为新错误码），文本序列给出旧 -> 新及旧错误码持续时长
+    source.event_series[e.motor]->pushBack(PlotData::Point(e.stamp, e.new_code));
+    const QString old_text = (e.old_code == ERROR_CODE_UNKNOWN) ? QString("首次出现")
+                                                                : QString("%1(%2)").arg(errorToText(e.old_code)).arg(e.old_code);
+    QString text = QString("%1 -> %2(%3)").arg(old_text).arg(errorToText(e.new_code)).arg(e.new_code);
+    if (e.old_code != ERROR_CODE_UNKNOWN)
+    {
+      text += QString("，持续 %1 s").arg(e.duration, 0, 'f', 3);
+    }
+    source.event_text_series[e.motor]->pushBack(StringSeries::Point(e.stamp, text.toStdString()));
   }
 }
 
 /**
- * @brief 监听 UDP 端口并接收数据
- *
- * 该函数会监听 4015 端口，并接收 UDP 发送的数据，解析后更新数据存储数组。
+ * @brief 更新告警统计，到判断周期时发布告警（调用者需已持有 mutex()）
+ * @param source 数据源
+ * @param frame 原始帧
  */
-void DataStreamSample::receiveUDPData()
+void DataStreamSample::updateAlarmsLocked(MotorSource &source, const RawMotorFrame &frame)
 {
-  int sock = socket(AF_INET, SOCK_DGRAM, 0);
-  if (sock < 0)
+  MotorAlarmEngine &engine = source.alarm_engine;
+  if (!engine.enabled())
   {
-    qDebug() << "Error: Unable to create socket!";
     return;
   }
-
-  int reuse = 1;
-  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
-
-  sockaddr_in serverAddr{};
-  serverAddr.sin_family = AF_INET;
-  serverAddr.sin_port = htons(4015);
-  serverAddr.sin_addr.s_addr = INADDR_ANY;
-
-  if (bind(sock, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
+  engine.observe(frame);
+  if (!engine.evaluateIfDue(frame.stamp))
   {
-    qDebug() << "Error: Unable to bind to port 4015!";
-    close(sock);
     return;
   }
 
-  qDebug() << "Listening on UDP port 4015...";
-
-  const int MOTOR_COUNT = 13;
-  InteractiveMotorData recv_data[MOTOR_COUNT];
-
-  std::string timestamp_str_first = "";  // 用于存储最早出现错误时的时间戳  
-  while (_running)
+  const size_t rule_count = engine.ruleCount();
+  const int motors = engine.motorCount();
+  if (source.alarm_active_series.size() < static_cast<size_t>(motors))
   {
-
-    ssize_t bytesRead = recvfrom(sock, recv_data, sizeof(recv_data), 0, nullptr, nullptr);
-    if (bytesRead != sizeof(recv_data))
+    // 新出现的电机第一次判断时注册它的告警曲线（每种布局只发生一次）
+    const int registered = static_cast<int>(source.alarm_active_series.size());
+    source.alarm_series.resize(static_cast<size_t>(motors) * rule_count, nullptr);
+    source.alarm_active_series.resize(motors, nullptr);
+    for (int m = registered; m < motors; ++m)
     {
-      qDebug() << "⚠️ UDP接收字节数不匹配：" << bytesRead << " != " << sizeof(recv_data);
-      continue;
+      const std::string name = "_alarms/" + source.prefix + "Motor" + std::to_string(m + 1) + "/";
+      for (size_t r = 0; r < rule_count; ++r)
+      {
+        source.alarm_series[m * rule_count + r] = &dataMap().addNumeric(name + formatAlarmRule(engine.rule(r)))->second;
+      }
+      source.alarm_active_series[m] = &dataMap().addNumeric(name + "active")->second;
+      qDebug() << "Registered:" << QString::fromStdString(name) << "(告警)";
     }
+  }
 
-    std::vector<std::vector<double>> data(_group_count);
+  for (int m = 0; m < motors; ++m)
+  {
+    for (size_t r = 0; r < rule_count; ++r)
+    {
+      const double value = engine.value(m, r);
+      if (!std::isnan(value)) // 窗口内数据不足时不推送
+      {
+        source.alarm_series[m * rule_count + r]->pushBack(PlotData::Point(frame.stamp, value));
+      }
+    }
+    const uint32_t mask = engine.activeMask(m);
+    source.alarm_active_series[m]->pushBack(PlotData::Point(frame.stamp, static_cast<double>(mask)));
+    source.error_snapshot->publishAlarms(m, mask);
+  }
+}
 
-    for (int i = 0; i < _group_count; ++i)
+/**
+ * @brief 应用界面上修改的告警规则（发布线程调用）
+ *
+ * 已注册的告警曲线保留在数据表中（可能仍在图中使用），只是按新规则重新注册、推送。
+ */
+void DataStreamSample::applyAlarmConfig()
+{
+  if (!alarm_config_changed_.exchange(false))
+  {
+    return;
+  }
+  AlarmConfig config;
+  {
+    std::lock_guard<std::mutex> lock(alarm_config_mutex_);
+    config = pending_alarm_config_;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex());
+  for (MotorSource &source : _sources)
+  {
+    source.alarm_engine.configure(config);
+    source.alarm_series.clear();
+    source.alarm_active_series.clear();
+    for (int m = 0; m < MAX_MOTOR_COUNT; ++m)
     {
-      auto values = extract_fields(recv_data[i]);
-      data[i] = std::vector<double>(values.begin(), values.begin() + std::min(_var_count, static_cast<int>(values.size())));
+      source.error_snapshot->publishAlarms(m, 0);
     }
+  }
+}
+
+/**
+ * @brief 应用界面上修改的抽稀设置（发布线程调用）
+ * @return 输出了未完成的桶返回 true
+ */
+bool DataStreamSample::applyDecimationSettings()
+{
+  const uint32_t generation = decimation_generation_;
+  if (generation == _decimation_applied_generation)
+  {
+    return false;
+  }
+  _decimation_applied_generation = generation;
 
-    setData(data);
+  std::lock_guard<std::mutex> lock(mutex());
+  const bool flushed = flushDecimatorsLocked(); // 已缓存的桶按旧设置输出
 
-    // ---------------- 日志判断逻辑 ----------------
-    bool should_log_frame = false;
-    bool current_frame_has_error = false;
-    // 1. 全时记录模式
-    if (log_mode_ == 1)
+  _decimation_active = decimation_enabled_;
+  _decimation_mode = static_cast<DecimationMode>(decimation_mode_.load());
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    _decimation_bucket_s[f] = std::max(0.0, decimation_bucket_ms_[f].load()) / 1000.0;
+  }
+  for (MotorSource &source : _sources)
+  {
+    for (size_t i = 0; i < source.decimators.size(); ++i)
     {
-      should_log_frame = true;
+      source.decimators[i].configure(_decimation_bucket_s[i % MOTOR_FIELD_COUNT], _decimation_mode);
     }
-    // 2. 错误触发记录模式（检测 error_ != 0）
-    else
+    for (size_t i = 0; i < source.derived_decimators.size(); ++i)
+    {
+      source.derived_decimators[i].configure(DERIVED_SIGNALS[i % DERIVED_SIGNAL_COUNT].decimation_ms / 1000.0, _decimation_mode);
+    }
+  }
+  return flushed;
+}
+
+/**
+ * @brief 输出所有未完成的抽稀桶（发布线程调用）
+ * @return 推送了数据返回 true
+ */
+bool DataStreamSample::flushDecimators()
+{
+  if (!_decimation_pending)
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex());
+  return flushDecimatorsLocked();
+}
+
+bool DataStreamSample::flushDecimatorsLocked()
+{
+  if (!_decimation_pending)
+  {
+    return false;
+  }
+  _decimation_pending = false;
+  bool pushed = false;
+  auto flush = [&pushed](const std::vector<PlotData *> &series, std::vector<SeriesDecimator> &decimators)
+  {
+    for (size_t i = 0; i < decimators.size(); ++i)
     {
-      // 电机错误时,保存数据(只要有一个电机出现错误,就保存后续所有电机的数据)
-      // ✅ 检查是否有 error != 0 bool current_frame_has_error = false;
-      for (int i = 0; i < MOTOR_COUNT; ++i)
+      PlotData *plot = series[i];
+      if (!plot || !decimators[i].pending())
       {
-        if (recv_data[i].error_ != 0)
+        continue;
+      }
+      SeriesDecimator::Point out[2];
+      const int n = decimators[i].flush(out);
+      for (int k = 0; k < n; ++k)
+      {
+        plot->pushBack(PlotData::Point(out[k].t, out[k].v));
+      }
+      pushed = pushed || n > 0;
+    }
+  };
+  for (MotorSource &source : _sources)
+  {
+    flush(source.series, source.decimators);
+    flush(source.derived_series, source.derived_decimators); // 派生曲线（含已关闭的派生量中未输出的桶）
+  }
+  return pushed;
+}
+
+/**
+ * @brief 把数据源 `data_array` 中各电机的错误码写入错误码快照
+ * @param source 数据源
+ *
+ * 只做原子写入，不向界面线程投递事件；错误类型界面由定时器按固定频率读取快照并只重绘变化的行，
+ * 错误码以数据报速率跳变时界面事件队列也不会堆积。
+ */
+void DataStreamSample::publishErrorSnapshot(MotorSource &source)
+{
+  for (int i = 0; i < source.group_count; ++i)
+  {
+    const int error_val = static_cast<int>(source.data_array[i][PLOTTED_ERROR_POSITION] + 0.5); // error字段下标
+    source.error_snapshot->publish(i, error_val);
+  }
+}
+
+/**
+ * @brief 数据流循环
+ * 每个周期批量取出帧队列中的所有新帧并推送，同一周期内的所有新帧只通知 PlotJuggler 一次：
+ * - 事件驱动模式（publish_mode_ == 0）：周期为 1 / max_notify_rate_hz_，没有新帧时不推送任何点；
+ * - 保持最后值模式（publish_mode_ == 1）：以 50Hz 运行，没有新帧时调用 updateData() 重复推送最后一帧。
+ */
+void DataStreamSample::loop()
+{
+  while (_running)
+  {
+    auto prev = std::chrono::high_resolution_clock::now();
+    const int mode = publish_mode_;
+
+    const bool settings_flushed = applyDecimationSettings();
+    applyAlarmConfig();
+    const bool has_frames = publishPendingFrames() > 0;
+    // 数据流暂停时输出抽稀中未完成的桶，最后一段数据不会滞留
+    const bool idle_flushed = !has_frames && flushDecimators();
+    const bool has_stats = publishStatsIfDue();
+    if (has_stats)
+    {
+      trimHistory(); // 与接收统计同周期（0.5 秒）批量裁剪
+    }
+    const bool pushed = has_frames || settings_flushed || idle_flushed;
+    if (!pushed && mode == 1)
+    {
+      updateData(); // updateData() 内部有 emit dataReceived()
+    }
+    else if (pushed || has_stats)
+    {
+      emit dataReceived(); // 本周期内的新帧、抽稀输出和统计合并为一次通知
+    }
+
+    // 端到端延迟：recvmmsg 返回 -> 本周期通知发出
+    if (!_publish_recv_ns.empty())
+    {
+      const uint64_t notified_ns = LatencyProfiler::nowNs();
+      for (uint64_t recv_ns : _publish_recv_ns)
+      {
+        latency_profiler_.record(LATENCY_END_TO_END, notified_ns > recv_ns ? notified_ns - recv_ns : 0);
+      }
+      _publish_recv_ns.clear();
+    }
+
+    const int rate_hz = (mode == 1) ? 50 : std::max(1, max_notify_rate_hz_.load());
+    std::this_thread::sleep_until(prev + std::chrono::microseconds(1000000 / rate_hz));
+  }
+}
+
+/**
+ * @brief 发布阶段：批量取出帧队列中的新帧，解码后一次性推送
+ * @return 本次推送的帧数
+ *
+ * 该函数只推送数据，不发出 dataReceived 信号，由调用者决定通知时机。
+ */
+int DataStreamSample::publishPendingFrames()
+{
+  int total = 0;
+  while (true)
+  {
+    const int count = static_cast<int>(_frame_ring.drain(_publish_frames.data(), _publish_frames.size()));
+    if (count == 0)
+    {
+      break;
+    }
+
+    // 延迟统计：帧在队列中等待的时间、等待 mutex() 的时间和持有 mutex() 推送的时间
+    const bool profiling = latency_profiler_.enabled();
+    const uint64_t drained_ns = profiling ? LatencyProfiler::nowNs() : 0;
+    if (profiling)
+    {
+      for (int f = 0; f < count; ++f)
+      {
+        const uint64_t recv_ns = _publish_frames[f].recv_ns;
+        if (recv_ns == 0)
         {
-          current_frame_has_error = true;
-          should_log_frame = true;
-          break;
+          continue; // 接收时尚未启用延迟统计
+        }
+        latency_profiler_.record(LATENCY_RING_WAIT, drained_ns > recv_ns ? drained_ns - recv_ns : 0);
+        if (_publish_recv_ns.size() < _publish_recv_ns.capacity())
+        {
+          _publish_recv_ns.push_back(recv_ns);
         }
       }
     }
 
-    // ---------------- 缓存数据帧 ----------------
-    if (should_log_frame)
     {
-      error_data_buffer_.emplace_back(std::vector<InteractiveMotorData>(recv_data, recv_data + MOTOR_COUNT));
+      std::lock_guard<std::mutex> lock(mutex());
+      const uint64_t locked_ns = profiling ? LatencyProfiler::nowNs() : 0;
+      if (profiling)
+      {
+        latency_profiler_.record(LATENCY_MUTEX_WAIT, locked_ns - drained_ns);
+      }
+
+      for (int f = 0; f < count; ++f)
+      {
+        const RawMotorFrame &frame = _publish_frames[f];
+        if (frame.source >= _sources.size())
+        {
+          continue;
+        }
+        MotorSource &source = _sources[frame.source];
+        // 出现电机数更多的布局时先补充注册（每种布局只发生一次）
+        ensureMotorGroupsLocked(source, frame.motor_count);
+        pushRawFrameLocked(source, frame);
+        publishErrorTransitionsLocked(source, frame);
+        updateAlarmsLocked(source, frame);
+        _publish_last_frame[frame.source] = f;
+      }
+
+      // 保留每个数据源的最后一帧，供 loop() 和错误码快照使用
+      std::array<double, PLOTTED_FIELD_COUNT> values;
+      for (size_t s = 0; s < _sources.size(); ++s)
+      {
+        if (_publish_last_frame[s] < 0)
+        {
+          continue;
+        }
+        MotorSource &source = _sources[s];
+        const RawMotorFrame &last = _publish_frames[_publish_last_frame[s]];
+        for (int g = 0; g < std::min<int>(last.motor_count, source.group_count); ++g)
+        {
+          decodePlottedFields(last.motors[g], values.data());
+          std::copy_n(values.begin(), _var_count, source.data_array[g].begin());
+          source.last_motors[g] = last.motors[g];
+        }
+        publishErrorSnapshot(source);
+        _publish_last_frame[s] = -1;
+      }
+
+      if (profiling)
+      {
+        latency_profiler_.recordSince(LATENCY_PUBLISH, locked_ns);
+      }
+    }
+
+    total += count;
+    if (count < static_cast<int>(_publish_frames.size()))
+    {
+      break; // 队列已取空
+    }
+  }
+  return total;
+}
+
+/**
+ * @brief 定期发布接收统计
+ * @return 本次推送了统计数据返回 true
+ */
+bool DataStreamSample::publishStatsIfDue()
+{
+  const double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  if (now - _last_stats_time < STATS_PUBLISH_INTERVAL_S)
+  {
+    return false;
+  }
+  _last_stats_time = now;
+
+  const uint64_t log_drops = log_writer_.droppedFrames();
+  std::lock_guard<std::mutex> lock(mutex());
+  for (MotorSource &source : _sources)
+  {
+    double values[RX_STATS_SERIES_COUNT];
+    source.stats_sampler.sample(*source.stats, now, values);
+    for (int i = 0; i < RX_STATS_SERIES_COUNT; ++i)
+    {
+      source.stats_series[i]->pushBack(PlotData::Point(now, values[i]));
     }
 
-    // ---------------- 导出数据帧 ----------------
-    if ((log_mode_ == 1) || current_frame_has_error)
+    if (source.stats_label)
     {
-      std::string timestamp_str = getCurrentTimestampString();
-      if (timestamp_str_first.empty())
+      const QString text = QString("%1%2 Hz | 收 %3 | 无效 %4 | 序号丢失 %5 | 内核丢弃 %6 | 绘图丢弃 %7 | 序号重置 %8")
+                               .arg(source.config.name.empty() ? QString() : QString::fromStdString(source.config.name + ": "))
+                               .arg(values[RX_STATS_RATE], 0, 'f', 1)
+                               .arg(static_cast<qulonglong>(values[RX_STATS_RECEIVED]))
+                               .arg(static_cast<qulonglong>(values[RX_STATS_MALFORMED]))
+                               .arg(static_cast<qulonglong>(values[RX_STATS_SEQ_LOST]))
+                               .arg(static_cast<qulonglong>(values[RX_STATS_KERNEL_DROPS]))
+                               .arg(static_cast<qulonglong>(values[RX_STATS_PLOT_DROPS]))
+                               .arg(static_cast<qulonglong>(values[RX_STATS_SEQ_RESETS]));
+      QMetaObject::invokeMethod(source.stats_label, "setText", Qt::QueuedConnection, Q_ARG(QString, text));
+    }
+  }
+
+  _log_drops_series->pushBack(PlotData::Point(now, static_cast<double>(log_drops)));
+  const uint64_t relay_sent = _relay.sentDatagrams();
+  const uint64_t relay_dropped = _relay.droppedDatagrams();
+  if (relay_sent > 0 || relay_dropped > 0)
+  {
+    _relay_sent_series->pushBack(PlotData::Point(now, static_cast<double>(relay_sent)));
+    _relay_dropped_series->pushBack(PlotData::Point(now, static_cast<double>(relay_dropped)));
+  }
+
+  // 延迟统计：与上次发布时的计数做差，得到最近一个周期的分位数（微秒）
+  if (latency_profiler_.enabled())
+  {
+    LatencyHistogram::Counts &counts = *_latency_counts;
+    for (int s = 0; s < LATENCY_STAGE_COUNT; ++s)
+    {
+      LatencyHistogram &histogram = latency_profiler_.stage(static_cast<LatencyStage>(s));
+      histogram.snapshot(counts);
+      LatencyHistogram::Counts &prev = _latency_prev_counts[s];
+      bool has_samples = false;
+      for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i)
+      {
+        const uint64_t current = counts[i];
+        counts[i] = current - prev[i];
+        prev[i] = current;
+        has_samples = has_samples || counts[i] != 0;
+      }
+      const uint64_t interval_max = histogram.takeIntervalMax();
+      if (!has_samples)
       {
-        timestamp_str_first = timestamp_str;
+        continue;
       }
+      _latency_series[s][0]->pushBack(PlotData::Point(now, LatencyHistogram::percentile(counts, 0.50) / 1000.0));
+      _latency_series[s][1]->pushBack(PlotData::Point(now, LatencyHistogram::percentile(counts, 0.99) / 1000.0));
+      _latency_series[s][2]->pushBack(PlotData::Point(now, interval_max / 1000.0));
+    }
+  }
+  if (_log_stats_label)
+  {
+    QString text = QString("日志丢弃 %1").arg(static_cast<qulonglong>(log_drops));
+    if (relay_sent > 0 || relay_dropped > 0)
+    {
+      text += QString(" | 转发 %1 | 转发丢弃 %2").arg(static_cast<qulonglong>(relay_sent)).arg(static_cast<qulonglong>(relay_dropped));
+    }
+    QMetaObject::invokeMethod(_log_stats_label, "setText", Qt::QueuedConnection, Q_ARG(QString, text));
+  }
+  if (_rx_profile_label && _rx_profile_report_changed.exchange(false))
+  {
+    std::lock_guard<std::mutex> report_lock(_rx_profile_mutex);
+    QMetaObject::invokeMethod(_rx_profile_label, "setText", Qt::QueuedConnection,
+                              Q_ARG(QString, QString("接收线程: ") + QString::fromStdString(_rx_profile_report)));
+  }
+  return true;
+}
 
-      std::string log_filename =
-          (log_mode_ == 1)
-              ? "/tmp/plotjuggler_motor_monitor_log/full_log_" + timestamp_str_first + ".txt"
-              : "/tmp/plotjuggler_motor_monitor_log/motor_error_log_" + timestamp_str_first + ".txt";
+/**
+ * @brief 监听 UDP 端口并接收数据
+ *
+ * 该函数为每个数据源打开一个 UDP socket（默认只监听 4015 端口），所有 socket 由同一个 epoll 循环服务，
+ * 接收数据并解析后交给发布线程和日志线程。
+ *
+ * 共享内存数据源（shm:，见 shmTransport.h）也在该线程中读取：
+ * - 只有一个共享内存数据源、没有 UDP 数据源时，在共享内存的 futex 上等待，写端发布后微秒级唤醒；
+ * - 与 UDP 数据源或其他共享内存数据源混用时，epoll_wait 超时缩短为 1ms，每次唤醒都轮询共享内存。
+ * 写端尚未创建共享内存时每秒重试一次。
+ */
+void DataStreamSample::receiveUDPData()
+{
+  // 先设置 CPU 绑定和调度策略，再创建 socket；实际生效的设置汇总后打印并显示到界面
+  const RxThreadProfile rx_profile = loadRxThreadProfile();
+  std::string rx_report = applyRxThreadProfile(rx_profile);
+
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0)
+  {
+    qDebug() << "Error: Unable to create epoll instance!";
+    return;
+  }
+
+  // 停止唤醒：eventfd 可读时 epoll_wait 立即返回（事件中的数据源序号为 WAKE_EVENT）
+  const uint32_t WAKE_EVENT = UINT32_MAX;
+  if (_wake_fd >= 0)
+  {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = WAKE_EVENT;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, _wake_fd, &ev);
+  }
+
+  // 每个数据源一个非阻塞 socket，epoll 事件中携带数据源序号
+  int opened_sources = 0;
+  std::vector<size_t> shm_sources; // 共享内存数据源的下标
+  for (size_t s = 0; s < _sources.size(); ++s)
+  {
+    MotorSource &source = _sources[s];
+    if (source.config.isShm())
+    {
+      source.shm_reader = std::make_unique<ShmRingReader>();
+      shm_sources.push_back(s);
+      ++opened_sources;
+      continue;
+    }
+    std::string error;
+    source.socket_fd = openUdpSourceSocket(source.config, &error);
+    if (source.socket_fd < 0)
+    {
+      qDebug() << "Error:" << QString::fromStdString(error);
+      continue;
+    }
+    if (!error.empty())
+    {
+      qDebug() << "⚠️" << QString::fromStdString(error);
+    }
+    const std::string socket_report = applyRxSocketProfile(source.socket_fd, rx_profile);
+    if (!socket_report.empty())
+    {
+      rx_report += " | " + (source.config.name.empty() ? std::string() : source.config.name + ": ") + socket_report;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(s);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, source.socket_fd, &ev) < 0)
+    {
+      qDebug() << "Error: epoll_ctl failed for port" << source.config.port;
+      close(source.socket_fd);
+      source.socket_fd = -1;
+      continue;
+    }
+    ++opened_sources;
+    qDebug() << "Listening on UDP port" << source.config.port
+             << (source.config.multicast_group.empty() ? QString() : QString::fromStdString("@" + source.config.multicast_group))
+             << (source.config.name.empty() ? QString() : QString::fromStdString("as " + source.config.name)) << "...";
+  }
+  // 转发：接收线程中批量 sendmmsg，没有订阅者时不创建 socket
+  const UdpRelayConfig relay_config = loadRelayConfig();
+  if (relay_config.enabled())
+  {
+    std::vector<uint16_t> listen_ports;
+    for (const MotorSource &source : _sources)
+    {
+      listen_ports.push_back(source.config.isShm() ? 0 : source.config.port);
+    }
+    std::string error;
+    const size_t max_batch = udp_batch_mode_ ? static_cast<size_t>(std::max(1, udp_batch_size_)) : 1;
+    if (_relay.open(relay_config, listen_ports, max_batch, &error))
+    {
+      rx_report += " | " + _relay.describe();
+      qDebug() << "✅ 转发:" << QString::fromStdString(formatUdpRelayConfig(relay_config));
+    }
+    else
+    {
+      rx_report += " | 未转发: " + error;
+      qDebug() << "⚠️ 转发未启用：" << QString::fromStdString(error);
+    }
+  }
+  qDebug() << "接收线程配置:" << QString::fromStdString(formatRxThreadProfile(rx_profile)) << "，实际生效:"
+           << QString::fromStdString(rx_report);
+  {
+    std::lock_guard<std::mutex> lock(_rx_profile_mutex);
+    _rx_profile_report = rx_report;
+  }
+  _rx_profile_report_changed = true;
+  if (opened_sources == 0)
+  {
+    close(epoll_fd);
+    return;
+  }
+
+  // 控制消息：内核接收时间戳（SCM_TIMESTAMPNS）+ 内核丢包计数（SO_RXQ_OVFL）
+  const size_t CONTROL_BYTES = CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t));
+
+  // ---------------- 预分配批量接收缓冲 ----------------
+  // 数据报长度取决于是否带包头和其中的电机数，每个数据报按最大长度 MAX_MOTOR_PACKET_BYTES 预留接收缓冲，
+  // 解析后写入对应的 RawMotorFrame。所有缓冲只在此处分配一次，所有数据源共用（每次只处理一个数据源的一批），
+  // 超过最大长度的数据报会被标记为截断并丢弃。
+  const int batch_size = udp_batch_mode_ ? std::max(1, udp_batch_size_) : 1;
+  std::vector<RawMotorFrame> recv_frames(batch_size);
+  std::vector<char> packets(batch_size * MAX_MOTOR_PACKET_BYTES);
+  std::vector<struct iovec> iovecs(batch_size);
+  std::vector<struct mmsghdr> msgs(batch_size);
+  std::vector<char> control(batch_size * CONTROL_BYTES);
+  std::vector<epoll_event> events(_sources.size() + 1); // 另有一个 eventfd
+  std::vector<double> shm_stamps(batch_size); // 共享内存帧的写端发布时间
+  std::vector<struct iovec> relay_datagrams(batch_size); // 校验通过的数据报（与 recv_frames 前部一一对应，转发时零拷贝引用）
+  for (int i = 0; i < batch_size; ++i)
+  {
+    iovecs[i].iov_base = &packets[i * MAX_MOTOR_PACKET_BYTES];
+    iovecs[i].iov_len = MAX_MOTOR_PACKET_BYTES;
+    msgs[i] = {};
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  // 日志状态：触发前缓冲按 错误前记录时长 x FLIGHT_RECORDER_RATE_HZ 一次性预分配（帧率更高时自动扩大，最多 FLIGHT_RECORDER_MAX_FRAMES 帧），
+  // 写线程中同样大小的交接存储用于错误上升沿时整体交换
+  timestamp_str_first_.clear();
+  const double pre_trigger_s = std::max(0.0, pre_trigger_seconds_.load());
+  const size_t recorder_frames = std::min(FLIGHT_RECORDER_MAX_FRAMES, static_cast<size_t>(pre_trigger_s * FLIGHT_RECORDER_RATE_HZ));
+  for (size_t s = 0; s < _sources.size(); ++s)
+  {
+    MotorSource &source = _sources[s];
+    source.sequence_tracker.reset();
+    source.active_log_mode = -1;
+    source.active_log_format = -1;
+    source.post_trigger_active = false;
+    source.recorder_limit_warned = false;
+    source.flight_recorder.reset(recorder_frames, pre_trigger_s, FLIGHT_RECORDER_MAX_FRAMES);
+    log_writer_.reserveRecording(recorder_frames, s);
+  }
+
+  // 单个数据源每次就绪最多连续取出的批数，之后轮到其他就绪的数据源（水平触发，剩余数据下次 epoll_wait 仍会就绪）
+  const int MAX_BATCHES_PER_WAKEUP = 8;
+
+  // 解析成功后的公共处理（UDP 与共享内存数据源共用）：统计、序号、时间戳选择、入帧队列
+  // transport_stamp 为内核接收时间（UDP）或写端发布时间（共享内存），不可用时为 0
+  struct RxBatch
+  {
+    size_t source_index;
+    double wall_stamp; // 本批次的系统时间（用于"系统时间"来源，以及没有内核/发送端时间戳时的回退）
+    int ts_source;
+    bool profiling;
+    uint64_t recv_ns;
+  };
+  auto acceptFrame = [this](const RxBatch &batch, RawMotorFrame &frame, double transport_stamp)
+  {
+    RxStatsCounters &stats = *_sources[batch.source_index].stats;
+    frame.source = static_cast<uint8_t>(batch.source_index);
+    frame.recv_ns = batch.recv_ns;
+    stats.received.fetch_add(1, std::memory_order_relaxed);
+    if (batch.profiling && transport_stamp > 0.0)
+    {
+      // 内核时间戳 / 写端发布时间与系统时间同为 CLOCK_REALTIME，差值即在接收队列中等待的时间
+      latency_profiler_.record(LATENCY_RX_QUEUE, static_cast<uint64_t>(std::max(0.0, batch.wall_stamp - transport_stamp) * 1e9));
+    }
+    if (frame.flags & FRAME_FLAG_SEQUENCE)
+    {
+      _sources[batch.source_index].sequence_tracker.observe(frame.sequence, stats);
+    }
+
+    // 按选择的来源确定该帧时间戳，来源不可用时依次回退：发送端 -> 内核 -> 系统时间
+    if (batch.ts_source == 1 && (frame.flags & FRAME_FLAG_SENDER_STAMP))
+    {
+      // frame.stamp 已由 decodeMotorPacket() 从数据报尾部写入
+    }
+    else if (batch.ts_source != 2 && transport_stamp > 0.0)
+    {
+      frame.stamp = transport_stamp;
+    }
+    else
+    {
+      frame.stamp = batch.wall_stamp;
+    }
+
+    if (!_frame_ring.tryPush(frame))
+    {
+      // 发布线程跟不上（例如界面卡顿），丢弃该帧的绘图数据，日志仍照常记录
+      stats.plot_dropped.fetch_add(1, std::memory_order_relaxed);
+      uint64_t dropped = ++_ring_dropped_frames;
+      if ((dropped & (dropped - 1)) == 0) // 按 1, 2, 4, 8... 次打印，避免刷屏
+      {
+        qDebug() << "⚠️ 帧队列已满，已丢弃绘图帧数：" << dropped;
+      }
+    }
+  };
+
+  // 读取一个共享内存数据源中的所有新帧（写端尚未创建共享内存时按间隔重试映射）
+  const bool shm_only = shm_sources.size() == 1 && opened_sources == 1;
+  auto last_shm_attach = std::chrono::steady_clock::time_point();
+  auto receiveShmSources = [&]()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const bool retry_attach = now - last_shm_attach >= std::chrono::seconds(1);
+    if (retry_attach)
+    {
+      last_shm_attach = now;
+    }
+    for (size_t source_index : shm_sources)
+    {
+      MotorSource &source = _sources[source_index];
+      ShmRingReader &reader = *source.shm_reader;
+      if (!reader.attached())
+      {
+        std::string error;
+        if (!retry_attach || !reader.attach(source.config.shm_name, &error))
+        {
+          continue;
+        }
+        source.compact_keyframe.valid = false;
+        qDebug() << "Reading shared memory" << QString::fromStdString(source.config.shm_name)
+                 << (source.config.name.empty() ? QString() : QString::fromStdString("as " + source.config.name)) << "...";
+      }
+
+      RxStatsCounters &stats = *source.stats;
+      for (int batch = 0; batch < MAX_BATCHES_PER_WAKEUP; ++batch)
+      {
+        const bool profiling = latency_profiler_.enabled();
+        const RxBatch rx_batch{source_index, std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count(),
+                               timestamp_source_, profiling, profiling ? LatencyProfiler::nowNs() : 0};
+
+        // 在共享内存槽位中原地解析到 recv_frames，不经过 socket 拷贝
+        const ShmReadResult result = reader.readFrames(recv_frames.data(), shm_stamps.data(), batch_size, &source.compact_keyframe);
+        stats.kernel_dropped.store(reader.overruns(), std::memory_order_relaxed); // 共享内存被写端覆盖而跳过的帧
+        if (result.malformed > 0)
+        {
+          // 累计数每跨过一个 2 的幂打印一次，避免刷屏
+          const uint64_t before = stats.malformed.fetch_add(result.malformed, std::memory_order_relaxed);
+          const uint64_t malformed = before + result.malformed;
+          if ((before ^ malformed) > before)
+          {
+            qDebug() << "⚠️ 共享内存数据报无效：" << motorPacketStatusText(result.last_error) << "，字节数" << result.last_error_bytes
+                     << "，累计" << malformed;
+          }
+        }
+        for (int f = 0; f < result.frames; ++f)
+        {
+          acceptFrame(rx_batch, recv_frames[f], shm_stamps[f]);
+        }
+        if (result.frames > 0)
+        {
+          logFrames(source_index, recv_frames.data(), result.frames);
+          _relay.relay(source_index, recv_frames.data(), nullptr, result.frames); // 共享内存帧没有数据报，重新编码
+        }
+        if (profiling)
+        {
+          latency_profiler_.recordSince(LATENCY_RX_PROCESS, rx_batch.recv_ns);
+        }
+        if (result.frames + result.malformed < batch_size)
+        {
+          break; // 已取空
+        }
+      }
+    }
+  };
 
-      for (size_t i = 0; i < error_data_buffer_.size(); ++i)
+  while (_running)
+  {
+    int ready = 0;
+    if (shm_only)
+    {
+      // 只有一个共享内存数据源：在 futex 上等待写端发布（超时用于重试映射），忙等时直接轮询。
+      // 等待期间登记读端，shutdown() 通过 interrupt() 打断；登记时再检查 _running，避免错过 shutdown() 的唤醒
+      ShmRingReader &reader = *_sources[shm_sources[0]].shm_reader;
+      if (reader.attached())
       {
-        printMotorDataToFile(error_data_buffer_[i].data(), MOTOR_COUNT, log_filename, timestamp_str);
+        if (!rx_profile.spin)
+        {
+          {
+            std::lock_guard<std::mutex> lock(_rx_wait_mutex);
+            if (!_running)
+            {
+              break;
+            }
+            _rx_wait_reader = &reader;
+          }
+          reader.waitForData(100);
+          std::lock_guard<std::mutex> lock(_rx_wait_mutex);
+          _rx_wait_reader = nullptr;
+        }
       }
+      else if (std::chrono::steady_clock::now() - last_shm_attach < std::chrono::seconds(1))
+      {
+        // 写端尚未创建共享内存：在只有 eventfd 的 epoll 上等待，停止时立即返回
+        epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 100);
+      }
+    }
+    else
+    {
+      // 停止时由 eventfd 唤醒；有共享内存数据源时超时缩短为 1ms 以便轮询，忙等时不睡眠
+      const int timeout_ms = rx_profile.spin ? 0 : (shm_sources.empty() ? 100 : 1);
+      ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout_ms);
+      if (ready < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        qDebug() << "Error: epoll_wait failed, errno =" << errno;
+        break;
+      }
+    }
+    if (!shm_sources.empty())
+    {
+      receiveShmSources();
+    }
 
-      std::cout << "✅ 已导出日志到 " << log_filename << std::endl;
-      error_data_buffer_.clear();
+    for (int e = 0; e < ready; ++e)
+    {
+      if (events[e].data.u32 == WAKE_EVENT)
+      {
+        continue; // shutdown() 的唤醒，循环条件中检查 _running
+      }
+      const size_t source_index = events[e].data.u32;
+      const int sock = _sources[source_index].socket_fd;
+      RxStatsCounters &stats = *_sources[source_index].stats;
 
-      if (log_mode_ == 0)
+      for (int batch = 0; batch < MAX_BATCHES_PER_WAKEUP; ++batch)
       {
-        error_triggered_ = false; // 错误记录模式才重置
+        // 内核会改写 msg_controllen，每次接收前重置
+        for (int i = 0; i < batch_size; ++i)
+        {
+          msgs[i].msg_hdr.msg_control = &control[i * CONTROL_BYTES];
+          msgs[i].msg_hdr.msg_controllen = CONTROL_BYTES;
+        }
+
+        // 非阻塞：把内核中已排队的数据报一次性取完（最多 batch_size 个），没有数据时返回 EAGAIN
+        int received = recvmmsg(sock, msgs.data(), batch_size, MSG_DONTWAIT, nullptr);
+        if (received < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          if (errno != EAGAIN && errno != EWOULDBLOCK)
+            qDebug() << "Error: recvmmsg failed on port" << _sources[source_index].config.port << ", errno =" << errno;
+          break;
+        }
+
+        // 本批次的系统时间（用于"系统时间"来源，以及没有内核/发送端时间戳时的回退）
+        const double batch_wall_stamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        const int ts_source = timestamp_source_;
+        const bool profiling = latency_profiler_.enabled();
+        const uint64_t batch_recv_ns = profiling ? LatencyProfiler::nowNs() : 0;
+
+        // ---------------- 解析并入队 ----------------
+        // 有效帧依次解析到 recv_frames 前部，便于后续整批日志导出；
+        // 接收线程只负责入队，解码和推送由 loop() 线程批量完成，不再等待 PlotJuggler 的 mutex
+        int valid_count = 0;
+        for (int m = 0; m < received; ++m)
+        {
+          unsigned int bytesRead = msgs[m].msg_len;
+          msgs[m].msg_len = 0;
+          const bool truncated = (msgs[m].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+          msgs[m].msg_hdr.msg_flags = 0;
+          RawMotorFrame &frame = recv_frames[valid_count];
+          const MotorPacketStatus status =
+              truncated ? MotorPacketStatus::SizeMismatch : decodeMotorPacket(&packets[m * MAX_MOTOR_PACKET_BYTES], bytesRead, frame,
+                                                          &_sources[source_index].compact_keyframe);
+          // 解析内核接收时间戳和内核丢包计数（SO_RXQ_OVFL 为该 socket 自创建以来的累计值）
+          double kernel_stamp = 0.0;
+          for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[m].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msgs[m].msg_hdr, cmsg))
+          {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+              struct timespec ts;
+              std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+              kernel_stamp = ts.tv_sec + ts.tv_nsec * 1e-9;
+            }
+            else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+              uint32_t kernel_drops = 0;
+              std::memcpy(&kernel_drops, CMSG_DATA(cmsg), sizeof(kernel_drops));
+              stats.kernel_dropped.store(kernel_drops, std::memory_order_relaxed);
+            }
+          }
+
+          if (status != MotorPacketStatus::Ok)
+          {
+            // 计入统计，按 1, 2, 4, 8... 次打印，避免刷屏
+            uint64_t malformed = stats.malformed.fetch_add(1, std::memory_order_relaxed) + 1;
+            if ((malformed & (malformed - 1)) == 0)
+            {
+              qDebug() << "⚠️ UDP数据报无效：" << motorPacketStatusText(status) << "，字节数" << bytesRead << "，累计" << malformed;
+            }
+            continue;
+          }
+          acceptFrame(RxBatch{source_index, batch_wall_stamp, ts_source, profiling, batch_recv_ns}, frame, kernel_stamp);
+          relay_datagrams[valid_count].iov_base = &packets[m * MAX_MOTOR_PACKET_BYTES];
+          relay_datagrams[valid_count].iov_len = bytesRead;
+          ++valid_count;
+        }
+
+        // ---------------- 日志 ----------------
+        if (valid_count > 0)
+        {
+          logFrames(source_index, recv_frames.data(), valid_count);
+          _relay.relay(source_index, recv_frames.data(), relay_datagrams.data(), valid_count);
+        }
+        if (profiling)
+        {
+          latency_profiler_.recordSince(LATENCY_RX_PROCESS, batch_recv_ns);
+        }
+
+        if (received < batch_size)
+        {
+          break; // 该数据源已取空
+        }
       }
     }
   }
 
-  close(sock);
+  for (MotorSource &source : _sources)
+  {
+    if (source.socket_fd >= 0)
+    {
+      close(source.socket_fd);
+      source.socket_fd = -1;
+    }
+    source.shm_reader.reset();
+  }
+  _relay.close();
+  close(epoll_fd);
 }
 
 /**
- * @brief 数据是按char类型发送InteractiveMotorData结构体,该函数用于提取所有字段,并打印(调试用,后期可取消)
- * @param m 输入的电机数据结构体（已反序列化）
- * @return double 数组,包含了提取所有字段（按顺序）
- * @note 注意：字段提取顺序必须与字段在 sender 中定义一致。
- *       若字段数或顺序变动，需同步更新此函数及字段名列表 field_names。
+ * @brief 日志判断与提交（在 UDP 接收线程中调用）
+ * @param frames 本批次的有效帧
+ * @param count  帧数
+ *
+ * 接收线程只判断哪些帧需要记录并交给异步写线程，格式化和磁盘写入都不在此线程进行：
+ * - 全时记录模式：每帧都提交；
+ * - 仅错误记录模式：无错误时帧只进入触发前缓冲；出现错误上升沿时先提交触发前窗口内的帧，
+ *   之后持续提交，直到错误消失并超过错误后记录时长。
  */
-std::vector<double> extract_fields(const InteractiveMotorData &m)
+void DataStreamSample::logFrames(size_t source_index, const RawMotorFrame *frames, int count)
 {
-  // 将解码的电机信息打印，调试时候用（后期可以注释）
-  // std::cout << "M=" << m.mode
-  //           << ", Index=" << m.index    // 不显示
-  //           << ", P=" << m.pos_
-  //           << ", V=" << m.vel_
-  //           << ", T=" << m.tau_
-  //           << ", Pd=" << m.pos_des_
-  //           << ", Vd=" << m.vel_des_
-  //           << ", Kp=" << m.kp_
-  //           << ", Kd=" << m.kd_
-  //           << ", FF=" << m.ff_ 
-  //           << ", Error=" << m.error_
-  //           << ", Temperature=" << m.temperature_
-  //           << ", Mos Temperature=" << m.mos_temperature_
-  //           << std::endl;
+  MotorSource &source = _sources[source_index];
+  const int log_mode = log_mode_;
+  const int log_format = log_format_;
 
-  // 此处返回的值要和需要显示的量field_names对应
-  return {
-      // m.mode, // "Mode"
-      m.pos_,                      // "Pos"
-      m.vel_,                      // "Vel"
-      m.tau_,                      // "Torque"
-      // m.pos_des_,                  // "Pos_des"
-      // m.vel_des_,                  // "Vel_des"
-      // m.kp_,                       // "Kp"
-      // m.kd_,                       // "Kd"
-      // m.ff_,                        // "FF"
-      m.error_,                    // “Error”
-      m.temperature_,              // "Temperature"
-      m.mos_temperature_           // "Mos Temperature"
+  // 首次需要记录时确定文件名，日志模式/格式切换时切换文件
+  auto ensureLogFile = [&]()
+  {
+    if (timestamp_str_first_.empty())
+    {
+      timestamp_str_first_ = getCurrentTimestampString();
+    }
+    if (log_mode != source.active_log_mode || log_format != source.active_log_format)
+    {
+      source.active_log_mode = log_mode;
+      source.active_log_format = log_format;
+      // 多数据源时文件名带数据源名称，每个数据源写入各自的日志流
+      const std::string source_tag = source.config.name.empty() ? std::string() : source.config.name + "_";
+      std::string log_filename =
+          (log_mode == 1)
+              ? "/tmp/plotjuggler_motor_monitor_log/full_log_" + source_tag + timestamp_str_first_
+              : "/tmp/plotjuggler_motor_monitor_log/motor_error_log_" + source_tag + timestamp_str_first_;
+      static const char *const LOG_EXTENSIONS[] = {".txt", ".bin", ".arrow"};
+      static const AsyncLogWriter::Format LOG_FORMATS[] = {AsyncLogWriter::Format::Text, AsyncLogWriter::Format::Binary,
+                                                           AsyncLogWriter::Format::Session};
+      const int format_index = (log_format >= 0 && log_format <= 2) ? log_format : 0;
+      log_filename += LOG_EXTENSIONS[format_index];
+      log_writer_.setFile(log_filename, LOG_FORMATS[format_index], source_index);
+    }
   };
+
+  // 交给写线程（缓冲满时丢弃并计数，不阻塞接收）
+  auto submit = [this](const RawMotorFrame &frame)
+  { log_writer_.submit(frame); };
+
+  for (int f = 0; f < count; ++f)
+  {
+    const RawMotorFrame &frame = frames[f];
+
+    // 1. 全时记录模式
+    if (log_mode == 1)
+    {
+      source.post_trigger_active = false;
+      ensureLogFile();
+      submit(frame);
+      continue;
+    }
+
+    // 2. 错误触发记录模式（检测 error_ != 0，只要有一个电机出现错误即视为该帧有错误）
+    bool frame_has_error = false;
+    for (int i = 0; i < frame.motor_count; ++i)
+    {
+      if (frame.motors[i].error_ != 0)
+      {
+        frame_has_error = true;
+        break;
+      }
+    }
+
+    if (frame_has_error)
+    {
+      ensureLogFile();
+      if (!source.post_trigger_active)
+      {
+        // 错误上升沿：触发前窗口内的帧整体交给写线程（交换存储，不经过有界的前台缓冲）
+        log_writer_.submitRecording(source.flight_recorder, frame.stamp - pre_trigger_seconds_, source_index);
+        source.post_trigger_active = true;
+      }
+      source.post_trigger_deadline = frame.stamp + post_trigger_seconds_;
+      submit(frame);
+    }
+    else if (source.post_trigger_active && frame.stamp <= source.post_trigger_deadline)
+    {
+      // 错误后记录窗口内，继续记录
+      submit(frame);
+    }
+    else
+    {
+      // 无错误：只进入触发前缓冲
+      source.post_trigger_active = false;
+      source.flight_recorder.push(frame);
+      if (source.flight_recorder.limited() && !source.recorder_limit_warned)
+      {
+        source.recorder_limit_warned = true;
+        qDebug() << "⚠️ 帧率过高，触发前缓冲已达上限" << static_cast<qulonglong>(FLIGHT_RECORDER_MAX_FRAMES)
+                 << "帧，错误前只能记录约" << source.flight_recorder.span() << "s";
+      }
+    }
+  }
 }
 
 /**
@@ -457,11 +1771,12 @@ extern "C"
  */
 void DataStreamSample::startUIWindow()
 {
-  // ❗️ 如果已经初始化过，就不再创建
-  if (ui_window_initialized_)
+  // ❗️ 停止后再次启动时本实例的窗口已存在，只重新显示（窗口被关闭时只是隐藏）
+  if (ui_window_)
+  {
+    ui_window_->show();
     return;
-
-  ui_window_initialized_ = true; // 标记为已初始化
+  }
 
   // 创建一个 QWidget 作为主窗口
   QWidget *widget = new QWidget;
@@ -473,25 +1788,40 @@ void DataStreamSample::startUIWindow()
   // 使用网格布局，将标签按表格形式排列
   QGridLayout *layout = new QGridLayout(widget);
 
-  // 添加表头：Motor 和 Error 两列
-  QLabel *header1 = new QLabel("Motor");
-  QLabel *header2 = new QLabel("Error");
-  layout->addWidget(header1, 0, 0);
-  layout->addWidget(header2, 0, 1);
-
-  // 清空错误标签数组，避免旧状态残留
-  motor_error_labels_.clear();
-  // 为每个电机创建一行显示内容
-  for (int i = 0; i < _group_count; ++i)
+  // 错误码表格：Motor、Error 和 Alarm 三列，每个数据源的每个电机一行（多数据源时电机名前加数据源名称）
+  // 数据来自发布线程写入的错误码和告警快照，由定时器以固定频率刷新，只重绘变化的行
+  MotorErrorTableModel *error_model = new MotorErrorTableModel([this](int error) { return errorToText(error); }, widget);
+  for (MotorSource &source : _sources)
   {
-    QLabel *motor_id = new QLabel(QString("Motor[%1]").arg(i + 1));
-    QLabel *error_label = new QLabel("N/A");
-
-    layout->addWidget(motor_id, i + 1, 0);
-    layout->addWidget(error_label, i + 1, 1);
-
-    motor_error_labels_.push_back(error_label);
+    error_model->addSource(QString::fromStdString(source.config.name), source.error_snapshot.get());
   }
+  // 告警规则的名称（告警掩码的第 r 位对应第 r 条规则）
+  auto alarm_labels = [](const AlarmConfig &config)
+  {
+    QStringList labels;
+    for (const AlarmRule &rule : config.rules)
+    {
+      labels << QString::fromStdString(formatAlarmRule(rule));
+    }
+    return labels;
+  };
+  const AlarmConfig alarm_config = loadAlarmConfig();
+  error_model->setAlarmLabels(alarm_labels(alarm_config));
+  error_model->refresh();
+
+  QTableView *error_table = new QTableView();
+  error_table->setModel(error_model);
+  error_table->setSelectionMode(QAbstractItemView::NoSelection);
+  error_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  error_table->verticalHeader()->setVisible(false);
+  error_table->horizontalHeader()->setStretchLastSection(true);
+  layout->addWidget(error_table, 0, 0, 1, 2);
+  const int motor_rows = 0; // 错误码表格只占第 0 行，以下控件从第 1 行开始
+
+  QTimer *error_refresh_timer = new QTimer(widget);
+  QObject::connect(error_refresh_timer, &QTimer::timeout, error_model, [error_model]()
+                   { error_model->refresh(); });
+  error_refresh_timer->start(ERROR_TABLE_REFRESH_MS);
 
   // 添加日志记录模式控件
   // 添加日志模式设置控件
@@ -503,33 +1833,463 @@ void DataStreamSample::startUIWindow()
   // 设置当前值
   log_mode_selector->setCurrentIndex(log_mode_);
 
+  // 日志格式：文本（可直接阅读）、紧凑二进制（带时间索引，可用 motor_log_convert 转为文本）
+  // 或列式会话（Arrow IPC 文件，pandas.read_feather() 直接读取，完整 double 精度，见 sessionStore.h）
+  QLabel *log_format_label = new QLabel("日志格式:");
+  QComboBox *log_format_selector = new QComboBox();
+  log_format_selector->addItem("文本(.txt)", 0);
+  log_format_selector->addItem("二进制(.bin + .idx)", 1);
+  log_format_selector->addItem("列式会话(.arrow, pandas/pyarrow)", 2);
+  log_format_selector->setCurrentIndex(log_format_);
+
+  // 仅错误记录模式下的触发前/触发后记录时长
+  QLabel *pre_trigger_label = new QLabel("错误前记录时长(下次启动生效):");
+  QDoubleSpinBox *pre_trigger_spin = new QDoubleSpinBox();
+  pre_trigger_spin->setRange(0.0, 10.0);
+  pre_trigger_spin->setDecimals(1);
+  pre_trigger_spin->setSuffix(" s");
+  pre_trigger_spin->setValue(pre_trigger_seconds_);
+  pre_trigger_spin->setToolTip(QString("触发前缓冲按 %1Hz 预分配，帧率更高时自动扩大，最多 %2 帧（超出时错误前的记录时长相应缩短）")
+                                   .arg(FLIGHT_RECORDER_RATE_HZ, 0, 'f', 0)
+                                   .arg(static_cast<qulonglong>(FLIGHT_RECORDER_MAX_FRAMES)));
+
+  QLabel *post_trigger_label = new QLabel("错误后记录时长:");
+  QDoubleSpinBox *post_trigger_spin = new QDoubleSpinBox();
+  post_trigger_spin->setRange(0.0, 60.0);
+  post_trigger_spin->setDecimals(1);
+  post_trigger_spin->setSuffix(" s");
+  post_trigger_spin->setValue(post_trigger_seconds_);
+
+  // 日志分段轮转与压缩（0 表示不启用）
+  QLabel *segment_size_label = new QLabel("单个日志分段上限(0不分段):");
+  QSpinBox *segment_size_spin = new QSpinBox();
+  segment_size_spin->setRange(0, 100000);
+  segment_size_spin->setSuffix(" MB");
+  segment_size_spin->setValue(0);
+
+  QLabel *segment_time_label = new QLabel("单个日志分段时长(0不分段):");
+  QSpinBox *segment_time_spin = new QSpinBox();
+  segment_time_spin->setRange(0, 24 * 60);
+  segment_time_spin->setSuffix(" min");
+  segment_time_spin->setValue(0);
+
+  QLabel *disk_budget_label = new QLabel("日志总空间上限(0不限):");
+  QSpinBox *disk_budget_spin = new QSpinBox();
+  disk_budget_spin->setRange(0, 1000000);
+  disk_budget_spin->setSuffix(" MB");
+  disk_budget_spin->setValue(0);
+
+  QCheckBox *compress_check = new QCheckBox("已关闭的分段压缩为 .zst");
+  compress_check->setChecked(false);
+  compress_check->setEnabled(logCompressionAvailable()); // 编译时未找到 libzstd 时不可选
+
   // 设置按钮
   QPushButton *apply_log_mode_btn = new QPushButton("设置日志模式");
 
   // 添加到布局（加在表格最后一行+1行）
-  int control_row = _group_count + 2;
+  // 接收统计（每个数据源一行，另有日志丢弃一行，由发布线程每 0.5s 刷新）
+  layout->addWidget(new QLabel("接收统计:"), motor_rows + 1, 0);
+  int stats_rows = 0;
+  for (MotorSource &source : _sources)
+  {
+    source.stats_label = new QLabel("N/A");
+    layout->addWidget(source.stats_label, motor_rows + 1 + stats_rows, 1);
+    ++stats_rows;
+  }
+  _log_stats_label = new QLabel("N/A");
+  layout->addWidget(_log_stats_label, motor_rows + 1 + stats_rows, 1);
+  ++stats_rows;
+  _rx_profile_label = new QLabel("N/A"); // 接收线程实际生效的设置（接收线程启动后由发布线程填入）
+  layout->addWidget(_rx_profile_label, motor_rows + 1 + stats_rows, 1);
+  ++stats_rows;
+
+  int control_row = motor_rows + stats_rows + 2;
   layout->addWidget(log_mode_label, control_row, 0);
   layout->addWidget(log_mode_selector, control_row, 1);
-  layout->addWidget(apply_log_mode_btn, control_row + 1, 1);
-
-  // 槽函数：点击按钮时更新 log_mode_
-  QObject::connect(apply_log_mode_btn, &QPushButton::clicked, [this, log_mode_selector]()
+  layout->addWidget(log_format_label, control_row + 1, 0);
+  layout->addWidget(log_format_selector, control_row + 1, 1);
+  layout->addWidget(pre_trigger_label, control_row + 2, 0);
+  layout->addWidget(pre_trigger_spin, control_row + 2, 1);
+  layout->addWidget(post_trigger_label, control_row + 3, 0);
+  layout->addWidget(post_trigger_spin, control_row + 3, 1);
+  layout->addWidget(segment_size_label, control_row + 4, 0);
+  layout->addWidget(segment_size_spin, control_row + 4, 1);
+  layout->addWidget(segment_time_label, control_row + 5, 0);
+  layout->addWidget(segment_time_spin, control_row + 5, 1);
+  layout->addWidget(disk_budget_label, control_row + 6, 0);
+  layout->addWidget(disk_budget_spin, control_row + 6, 1);
+  layout->addWidget(compress_check, control_row + 7, 1);
+  layout->addWidget(apply_log_mode_btn, control_row + 8, 1);
+
+  // 槽函数：点击按钮时更新 log_mode_、log_format_、触发前/后记录时长以及轮转策略
+  QObject::connect(apply_log_mode_btn, &QPushButton::clicked, [this, log_mode_selector, log_format_selector, pre_trigger_spin, post_trigger_spin,
+                                                               segment_size_spin, segment_time_spin, disk_budget_spin, compress_check]()
                    {
     int selected_mode = log_mode_selector->currentData().toInt();
     this->log_mode_ = selected_mode;
-    qDebug() << "✅ 日志记录模式已更新为:" << selected_mode; });
+    this->log_format_ = log_format_selector->currentData().toInt();
+    this->pre_trigger_seconds_ = pre_trigger_spin->value();
+    this->post_trigger_seconds_ = post_trigger_spin->value();
+
+    LogRotationPolicy policy;
+    policy.max_segment_bytes = static_cast<uint64_t>(segment_size_spin->value()) * 1024 * 1024;
+    policy.max_segment_seconds = segment_time_spin->value() * 60.0;
+    policy.disk_budget_bytes = static_cast<uint64_t>(disk_budget_spin->value()) * 1024 * 1024;
+    policy.compress = compress_check->isChecked();
+    this->log_writer_.setRotation(policy);
+
+    qDebug() << "✅ 日志记录模式已更新为:" << selected_mode << ", 日志格式:" << this->log_format_.load()
+             << ", 错误前/后记录时长:" << this->pre_trigger_seconds_.load() << "/" << this->post_trigger_seconds_.load() << "s"
+             << ", 分段:" << segment_size_spin->value() << "MB /" << segment_time_spin->value() << "min"
+             << ", 空间上限:" << disk_budget_spin->value() << "MB, 压缩:" << policy.compress; });
+
+
+
+  // 添加数据发布模式控件
+  QLabel *publish_mode_label = new QLabel("数据发布模式:");
+  QComboBox *publish_mode_selector = new QComboBox();
+  publish_mode_selector->addItem("仅新数据到达时推送", 0);
+  publish_mode_selector->addItem("50Hz保持最后值推送", 1);
+  publish_mode_selector->setCurrentIndex(publish_mode_);
+
+  QLabel *notify_rate_label = new QLabel("最大刷新频率:");
+  QSpinBox *notify_rate_spin = new QSpinBox();
+  notify_rate_spin->setRange(1, 200);
+  notify_rate_spin->setSuffix(" Hz");
+  notify_rate_spin->setValue(max_notify_rate_hz_);
+
+  QPushButton *apply_publish_mode_btn = new QPushButton("设置发布模式");
+
+  int publish_row = control_row + 9;
+  layout->addWidget(publish_mode_label, publish_row, 0);
+  layout->addWidget(publish_mode_selector, publish_row, 1);
+  layout->addWidget(notify_rate_label, publish_row + 1, 0);
+  layout->addWidget(notify_rate_spin, publish_row + 1, 1);
+  layout->addWidget(apply_publish_mode_btn, publish_row + 2, 1);
+
+  // 槽函数：点击按钮时更新发布模式和刷新频率（loop() 线程在下一个周期生效）
+  QObject::connect(apply_publish_mode_btn, &QPushButton::clicked, [this, publish_mode_selector, notify_rate_spin]()
+                   {
+    this->publish_mode_ = publish_mode_selector->currentData().toInt();
+    this->max_notify_rate_hz_ = notify_rate_spin->value();
+    qDebug() << "✅ 数据发布模式已更新为:" << this->publish_mode_.load() << ", 最大刷新频率:" << this->max_notify_rate_hz_.load() << "Hz"; });
+
+  // 添加时间戳来源控件
+  QLabel *ts_source_label = new QLabel("时间戳来源:");
+  QComboBox *ts_source_selector = new QComboBox();
+  ts_source_selector->addItem("内核接收时间(SO_TIMESTAMPNS)", 0);
+  ts_source_selector->addItem("发送端时间戳(数据报尾部8字节)", 1);
+  ts_source_selector->addItem("接收时系统时间", 2);
+  ts_source_selector->setCurrentIndex(timestamp_source_);
+
+  QPushButton *apply_ts_source_btn = new QPushButton("设置时间戳来源");
+
+  int ts_row = publish_row + 3;
+  layout->addWidget(ts_source_label, ts_row, 0);
+  layout->addWidget(ts_source_selector, ts_row, 1);
+  layout->addWidget(apply_ts_source_btn, ts_row + 1, 1);
+
+  // 槽函数：点击按钮时更新时间戳来源（接收线程在下一批数据生效）
+  QObject::connect(apply_ts_source_btn, &QPushButton::clicked, [this, ts_source_selector]()
+                   {
+    this->timestamp_source_ = ts_source_selector->currentData().toInt();
+    qDebug() << "✅ 时间戳来源已更新为:" << this->timestamp_source_.load(); });
+
+  // 添加延迟统计控件（开关后的下一批数据生效，导出为累计直方图）
+  QCheckBox *latency_check = new QCheckBox("启用分阶段延迟统计(_latency/...)");
+  latency_check->setChecked(latency_profiler_.enabled());
+  QPushButton *dump_latency_btn = new QPushButton("导出延迟直方图");
 
+  int latency_row = ts_row + 2;
+  layout->addWidget(latency_check, latency_row, 1);
+  layout->addWidget(dump_latency_btn, latency_row + 1, 1);
 
+  QObject::connect(latency_check, &QCheckBox::toggled, [this](bool checked)
+                   {
+    this->latency_profiler_.setEnabled(checked);
+    qDebug() << "✅ 延迟统计已" << (checked ? "启用" : "关闭"); });
+
+  // 槽函数：把各阶段的累计直方图写入日志目录
+  QObject::connect(dump_latency_btn, &QPushButton::clicked, [this]()
+                   {
+    const std::string report = this->latency_profiler_.report();
+    const std::string filename = "/tmp/plotjuggler_motor_monitor_log/latency_" + getCurrentTimestampString() + ".txt";
+    std::ofstream ofs(filename);
+    ofs << report;
+    qDebug().noquote() << QString::fromStdString(report);
+    qDebug() << "✅ 延迟直方图已导出到" << QString::fromStdString(filename); });
+
+  // 添加曲线抽稀控件：每个 plotted 字段一个桶宽（毫秒，0 表示不抽稀），日志不受影响
+  QCheckBox *decimation_check = new QCheckBox("启用曲线抽稀(仅影响绘图，日志保持原始速率)");
+  decimation_check->setChecked(decimation_enabled_);
+  QLabel *decimation_mode_label = new QLabel("抽稀方式:");
+  QComboBox *decimation_mode_selector = new QComboBox();
+  decimation_mode_selector->addItem("每桶最小/最大值(保留尖峰)", static_cast<int>(DecimationMode::MinMax));
+  decimation_mode_selector->addItem("每桶首/末值", static_cast<int>(DecimationMode::FirstLast));
+  decimation_mode_selector->setCurrentIndex(decimation_mode_);
+
+  QLabel *decimation_bucket_label = new QLabel("抽稀桶宽(ms, 0=不抽稀):");
+  QGridLayout *decimation_bucket_layout = new QGridLayout();
+  std::vector<QDoubleSpinBox *> decimation_bucket_spins;
+  constexpr int FIELD_GRID_COLUMNS = 7; // 字段较多，每行 7 个
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    QDoubleSpinBox *spin = new QDoubleSpinBox();
+    spin->setRange(0.0, 10000.0);
+    spin->setDecimals(1);
+    spin->setValue(decimation_bucket_ms_[f]);
+    const int row = static_cast<int>(f) / FIELD_GRID_COLUMNS;
+    const int column = static_cast<int>(f) % FIELD_GRID_COLUMNS * 2;
+    decimation_bucket_layout->addWidget(new QLabel(MOTOR_FIELDS[f].name), row, column);
+    decimation_bucket_layout->addWidget(spin, row, column + 1);
+    decimation_bucket_spins.push_back(spin);
+  }
+  QPushButton *apply_decimation_btn = new QPushButton("设置曲线抽稀");
+
+  int decimation_row = latency_row + 2;
+  layout->addWidget(decimation_check, decimation_row, 1);
+  layout->addWidget(decimation_mode_label, decimation_row + 1, 0);
+  layout->addWidget(decimation_mode_selector, decimation_row + 1, 1);
+  layout->addWidget(decimation_bucket_label, decimation_row + 2, 0);
+  layout->addLayout(decimation_bucket_layout, decimation_row + 2, 1);
+  layout->addWidget(apply_decimation_btn, decimation_row + 3, 1);
+
+  // 槽函数：点击按钮时更新抽稀设置（发布线程在下一个周期先输出未完成的桶再生效）
+  QObject::connect(apply_decimation_btn, &QPushButton::clicked, [this, decimation_check, decimation_mode_selector, decimation_bucket_spins]()
+                   {
+    this->decimation_enabled_ = decimation_check->isChecked();
+    this->decimation_mode_ = decimation_mode_selector->currentData().toInt();
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      this->decimation_bucket_ms_[f] = decimation_bucket_spins[f]->value();
+    }
+    ++this->decimation_generation_;
+    qDebug() << "✅ 曲线抽稀已" << (this->decimation_enabled_ ? "启用" : "关闭") << ", 方式:" << this->decimation_mode_.load(); });
+
+  // 添加数据源列表控件（格式见 udpSources.h，例如 RobotA=4015,RobotB=4016@239.0.0.1）
+  QLabel *sources_label = new QLabel("数据源(下次启用插件生效):");
+  QLineEdit *sources_edit = new QLineEdit();
+  std::vector<UdpSourceConfig> current_sources;
+  for (const MotorSource &source : _sources)
+  {
+    current_sources.push_back(source.config);
+  }
+  sources_edit->setText(QString::fromStdString(formatUdpSourceList(current_sources)));
+  sources_edit->setPlaceholderText("名称=端口[@组播地址], ...");
+
+  QPushButton *apply_sources_btn = new QPushButton("设置数据源");
+
+  int sources_row = decimation_row + 4;
+  layout->addWidget(sources_label, sources_row, 0);
+  layout->addWidget(sources_edit, sources_row, 1);
+  layout->addWidget(apply_sources_btn, sources_row + 1, 1);
+
+  // 槽函数：校验并保存数据源列表（环境变量 MOTOR_MONITOR_SOURCES 存在时以环境变量为准）
+  QObject::connect(apply_sources_btn, &QPushButton::clicked, [sources_edit]()
+                   {
+    std::vector<UdpSourceConfig> sources;
+    std::string error;
+    if (!parseUdpSourceList(sources_edit->text().toStdString(), sources, &error))
+    {
+      qDebug() << "⚠️ 数据源列表无效：" << QString::fromStdString(error);
+      return;
+    }
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("udp_sources", QString::fromStdString(formatUdpSourceList(sources)));
+    qDebug() << "✅ 数据源已更新为:" << QString::fromStdString(formatUdpSourceList(sources)) << "(下次启用插件生效)"; });
+
+  // 添加接收线程配置控件（格式见 rxThreadProfile.h，例如 rcvbuf=8M,cpu=3,fifo=80）
+  QLabel *rx_profile_label = new QLabel("接收线程配置(下次启用插件生效):");
+  QLineEdit *rx_profile_edit = new QLineEdit();
+  rx_profile_edit->setText(QString::fromStdString(formatRxThreadProfile(loadRxThreadProfile())));
+  rx_profile_edit->setPlaceholderText("rcvbuf=8M,busy_poll=50,spin,cpu=3,fifo=80");
+
+  QPushButton *apply_rx_profile_btn = new QPushButton("设置接收线程");
+
+  int rx_profile_row = sources_row + 2;
+  layout->addWidget(rx_profile_label, rx_profile_row, 0);
+  layout->addWidget(rx_profile_edit, rx_profile_row, 1);
+  layout->addWidget(apply_rx_profile_btn, rx_profile_row + 1, 1);
+
+  // 槽函数：校验并保存接收线程配置（环境变量 MOTOR_MONITOR_RX_PROFILE 存在时以环境变量为准）
+  QObject::connect(apply_rx_profile_btn, &QPushButton::clicked, [rx_profile_edit]()
+                   {
+    RxThreadProfile profile;
+    std::string error;
+    if (!parseRxThreadProfile(rx_profile_edit->text().toStdString(), profile, &error))
+    {
+      qDebug() << "⚠️ 接收线程配置无效：" << QString::fromStdString(error);
+      return;
+    }
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("rx_profile", QString::fromStdString(formatRxThreadProfile(profile)));
+    qDebug() << "✅ 接收线程配置已更新为:" << QString::fromStdString(formatRxThreadProfile(profile)) << "(下次启用插件生效)"; });
+
+  // 添加派生曲线控件：每个派生量一个复选框，立即生效（第一次启用时注册曲线），同时保存为下次启动的默认值
+  QLabel *derived_label = new QLabel("派生曲线(Motor<n>/<名称>):");
+  QHBoxLayout *derived_layout = new QHBoxLayout();
+  std::vector<QCheckBox *> derived_checks;
+  for (int d = 0; d < DERIVED_SIGNAL_COUNT; ++d)
+  {
+    QCheckBox *check = new QCheckBox(QString("%1 = %2").arg(DERIVED_SIGNALS[d].name).arg(DERIVED_SIGNALS[d].formula));
+    check->setChecked(derived_mask_ & (1u << d));
+    derived_layout->addWidget(check);
+    derived_checks.push_back(check);
+  }
+  QPushButton *apply_derived_btn = new QPushButton("设置派生曲线");
+
+  int derived_row = rx_profile_row + 2;
+  layout->addWidget(derived_label, derived_row, 0);
+  layout->addLayout(derived_layout, derived_row, 1);
+  layout->addWidget(apply_derived_btn, derived_row + 1, 1);
+
+  // 槽函数：更新启用的派生量（发布线程在下一帧生效），并保存设置（环境变量 MOTOR_MONITOR_DERIVED 存在时启动时以环境变量为准）
+  QObject::connect(apply_derived_btn, &QPushButton::clicked, [this, derived_checks]()
+                   {
+    uint32_t mask = 0;
+    for (int d = 0; d < DERIVED_SIGNAL_COUNT; ++d)
+    {
+      if (derived_checks[d]->isChecked())
+      {
+        mask |= 1u << d;
+      }
+    }
+    this->derived_mask_ = mask;
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("derived_signals", QString::fromStdString(formatDerivedSignalMask(mask)));
+    qDebug() << "✅ 派生曲线已设置为:" << QString::fromStdString(mask ? formatDerivedSignalMask(mask) : std::string("无")); });
+
+  // 添加显示字段控件：每个字段一个复选框，立即生效（新启用的字段在下一帧注册），同时保存为下次启动的默认值
+  QLabel *fields_label = new QLabel("显示的字段:");
+  QGridLayout *fields_layout = new QGridLayout();
+  std::vector<QCheckBox *> field_checks;
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    QCheckBox *check = new QCheckBox(MOTOR_FIELDS[f].name);
+    check->setChecked(field_mask_ & (1u << f));
+    fields_layout->addWidget(check, static_cast<int>(f) / FIELD_GRID_COLUMNS, static_cast<int>(f) % FIELD_GRID_COLUMNS);
+    field_checks.push_back(check);
+  }
+  QPushButton *apply_fields_btn = new QPushButton("设置显示字段");
+
+  int fields_row = derived_row + 2;
+  layout->addWidget(fields_label, fields_row, 0);
+  layout->addLayout(fields_layout, fields_row, 1);
+  layout->addWidget(apply_fields_btn, fields_row + 1, 1);
+
+  // 槽函数：更新启用的字段（下一帧生效，关闭的字段保留已注册的曲线），并保存设置（环境变量 MOTOR_MONITOR_FIELDS 存在时启动时以环境变量为准）
+  QObject::connect(apply_fields_btn, &QPushButton::clicked, [this, field_checks]()
+                   {
+    uint32_t mask = 0;
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      if (field_checks[f]->isChecked())
+      {
+        mask |= 1u << f;
+      }
+    }
+    this->field_mask_ = mask;
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("plotted_fields", QString::fromStdString(formatMotorFieldMask(mask)));
+    qDebug() << "✅ 显示字段已设置为:" << QString::fromStdString(formatMotorFieldMask(mask)); });
+
+  // 添加曲线历史上限控件：时间窗口和每条曲线点数（0 表示不限），立即生效并保存
+  QLabel *history_label = new QLabel("暂停时暂存上限(0不限):");
+  QHBoxLayout *history_layout = new QHBoxLayout();
+  QDoubleSpinBox *history_seconds_spin = new QDoubleSpinBox();
+  history_seconds_spin->setRange(0.0, 86400.0);
+  history_seconds_spin->setDecimals(0);
+  history_seconds_spin->setSuffix(" s");
+  history_seconds_spin->setValue(history_max_seconds_);
+  QSpinBox *history_points_spin = new QSpinBox();
+  history_points_spin->setRange(0, 100000000);
+  history_points_spin->setSingleStep(10000);
+  history_points_spin->setSuffix(" 点/曲线");
+  history_points_spin->setValue(history_max_points_);
+  history_layout->addWidget(history_seconds_spin);
+  history_layout->addWidget(history_points_spin);
+  QPushButton *apply_history_btn = new QPushButton("设置暂存上限");
+  _history_label = new QLabel("N/A");
+  const QString history_tip = "只在 PlotJuggler 暂停（不取数据）时起作用；主界面曲线保留的历史长度由 PlotJuggler 的 Buffer 设置决定";
+  history_label->setToolTip(history_tip);
+  apply_history_btn->setToolTip(history_tip);
+
+  int history_row = fields_row + 2;
+  layout->addWidget(history_label, history_row, 0);
+  layout->addLayout(history_layout, history_row, 1);
+  layout->addWidget(_history_label, history_row + 1, 0);
+  layout->addWidget(apply_history_btn, history_row + 1, 1);
+
+  // 槽函数：更新保留策略（发布线程在下一个统计周期裁剪），并保存设置
+  QObject::connect(apply_history_btn, &QPushButton::clicked, [this, history_seconds_spin, history_points_spin]()
+                   {
+    this->history_max_seconds_ = history_seconds_spin->value();
+    this->history_max_points_ = history_points_spin->value();
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("history_max_seconds", history_seconds_spin->value());
+    settings.setValue("history_max_points", history_points_spin->value());
+    qDebug() << "✅ 暂停时暂存上限已设置为:" << history_seconds_spin->value() << "s," << history_points_spin->value() << "点/曲线"; });
+
+  // 添加告警规则控件：立即生效（清空统计窗口重新开始），同时保存为下次启动的默认值
+  QLabel *alarm_label = new QLabel("告警规则(见 motorAlarms.h):");
+  QLineEdit *alarm_edit = new QLineEdit(QString::fromStdString(formatAlarmConfig(alarm_config)));
+  alarm_edit->setPlaceholderText("window=2,Temperatrue.max>70,Mos Temperature.slope>0.5");
+  QPushButton *apply_alarm_btn = new QPushButton("设置告警规则");
+
+  int alarm_row = history_row + 2;
+  layout->addWidget(alarm_label, alarm_row, 0);
+  layout->addWidget(alarm_edit, alarm_row, 1);
+  layout->addWidget(apply_alarm_btn, alarm_row + 1, 1);
+
+  // 槽函数：校验规则，交给发布线程在下一个周期生效，并保存设置（环境变量 MOTOR_MONITOR_ALARMS 存在时启动时以环境变量为准）
+  QObject::connect(apply_alarm_btn, &QPushButton::clicked, [this, alarm_edit, error_model, alarm_labels]()
+                   {
+    AlarmConfig config;
+    std::string error;
+    if (!parseAlarmConfig(alarm_edit->text().toStdString(), config, &error))
+    {
+      qDebug() << "⚠️ 告警规则无效：" << QString::fromStdString(error);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->alarm_config_mutex_);
+      this->pending_alarm_config_ = config;
+    }
+    this->alarm_config_changed_ = true;
+    error_model->setAlarmLabels(alarm_labels(config));
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("alarm_rules", QString::fromStdString(formatAlarmConfig(config)));
+    qDebug() << "✅ 告警规则已设置为:" << QString::fromStdString(config.rules.empty() ? std::string("无") : formatAlarmConfig(config)); });
+
+  // 添加转发配置控件：把接收到的数据流再发给多个查看端（下次启用插件生效）
+  QLabel *relay_label = new QLabel("转发(下次启用插件生效):");
+  QLineEdit *relay_edit = new QLineEdit(QString::fromStdString(formatUdpRelayConfig(loadRelayConfig())));
+  relay_edit->setPlaceholderText("192.168.1.20:4015,239.0.0.1:4015,format=compact,rate=200");
+  QPushButton *apply_relay_btn = new QPushButton("设置转发");
+
+  int relay_row = alarm_row + 2;
+  layout->addWidget(relay_label, relay_row, 0);
+  layout->addWidget(relay_edit, relay_row, 1);
+  layout->addWidget(apply_relay_btn, relay_row + 1, 1);
+
+  // 槽函数：校验并保存转发配置（环境变量 MOTOR_MONITOR_RELAY 存在时以环境变量为准）
+  QObject::connect(apply_relay_btn, &QPushButton::clicked, [relay_edit]()
+                   {
+    UdpRelayConfig config;
+    std::string error;
+    if (!parseUdpRelayConfig(relay_edit->text().toStdString(), config, &error))
+    {
+      qDebug() << "⚠️ 转发配置无效：" << QString::fromStdString(error);
+      return;
+    }
+    QSettings settings("PlotJuggler_MotorMonitor", "MotorMonitor");
+    settings.setValue("relay", QString::fromStdString(formatUdpRelayConfig(config)));
+    qDebug() << "✅ 转发配置已更新为:" << QString::fromStdString(config.enabled() ? formatUdpRelayConfig(config) : std::string("不转发")) << "(下次启用插件生效)"; });
 
   // 将布局应用到窗口
   widget->setLayout(layout);
   widget->show();
 
-  // 将指针保存到成员变量中（可选，用于后续操作窗口）
+  // 将指针保存到成员变量中（析构时删除）
   ui_window_ = widget;
-
 }
-
-// PlotJuggler 在每次点击“启用插件”或刷新插件时，会重新调用 createPlugin() 构造新实例，导致 startUIWindow() 也被重复调用，从而弹出多个窗口,避免该问题
-// 确保只打开一次错误类型显示窗口
-bool DataStreamSample::ui_window_initialized_ = false;
@@ -10,7 +10,8 @@
  * 插件通过继承 PlotJuggler 的 PJ::DataStreamer 接口，实现：
  *
  * - 启动/停止数据流线程；
- * - 接收按结构体发送的电机数据（InteractiveMotorData）；
+ * - 接收按结构体发送的电机数据（InteractiveMotorData），可同时接收多个 UDP 数据源（端口/组播组），
+ *   每个数据源有独立的曲线命名空间（RobotA/Motor3/Pos）和日志文件；
  * - 解码后展示在 PlotJuggler 实时曲线图中；
  * - 同时显示每个电机当前的错误类型（文本）,通过单独的Qt界面显示；
  * - 支持 UI 控件界面显示和日志导出。
@@ -24,6 +25,19 @@
  *   - 变量注册与绘图
  *   - 错误码解释与 UI 显示
  *   - 错误日志保存
+ *   - 接收统计（帧率、无效包、序号丢包、内核丢包，发布为 _stats/... 曲线）
+ *   - 分阶段延迟统计（可在界面上开关，发布为 _latency/... 曲线，可导出直方图）
+ *   - 曲线抽稀（按字段设置时间桶宽，每桶保留最小/最大值，日志不受影响）
+ *   - 同机共享内存传输（shm: 数据源，发送端库见 tools/motor_shm_writer.h）
+ *   - 接收线程实时配置（接收缓冲、忙轮询、CPU 绑定、SCHED_FIFO，见 rxThreadProfile.h）
+ *   - 错误码跳变事件（日志旁的 .events 索引，发布为 _events/... 曲线和文本序列，见 errorEvents.h）
+ *   - 运行时选择显示的字段（只注册、推送启用的字段，见 motorFieldSelection.h）
+ *   - PlotJuggler 暂停时插件暂存曲线的上限（按时间窗口和每条曲线点数批量裁剪，见 historyRetention.h；
+ *     主界面的历史长度由 PlotJuggler 的 Buffer 设置决定）
+ *   - 接收时计算的派生曲线（跟踪误差、机械功率、PD 力矩，可在界面上选择，见 derivedSignals.h）
+ *   - UDP 转发（把接收到的数据流再发给多个查看端，可转为紧凑格式或限帧率，见 udpRelay.h）
+ *   - 滑动窗口统计告警（温度、力矩等的阈值 / 上升速率，显示在错误类型界面并发布为 _alarms/... 曲线，见 motorAlarms.h）
+ *   - 列式会话记录（Arrow IPC 文件，pandas 直接读取、完整 double 精度，按块 mmap 写入，见 sessionStore.h）
  *
  * @note 使用该插件需搭配发送端使用同样的数据结构发送 UDP 字节流。
  *
@@ -34,7 +48,29 @@
 #include <QtPlugin>
 #include <thread>
 #include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <mutex>
 #include "PlotJuggler/datastreamer_base.h"
+#include "frameRing.h"
+#include "motorData.h"
+#include "motorFields.h"
+#include "logWriter.h"
+#include "flightRecorder.h"
+#include "udpSources.h"
+#include "rxStats.h"
+#include "latencyProfiler.h"
+#include "plotDecimator.h"
+#include "errorTableModel.h"
+#include "shmTransport.h"
+#include "rxThreadProfile.h"
+#include "errorEvents.h"
+#include "derivedSignals.h"
+#include "motorFieldSelection.h"
+#include "historyRetention.h"
+#include "motorAlarms.h"
+#include "udpRelay.h"
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -44,40 +80,11 @@
 // 显示错误类型界面
 #include <QString>
 #include <QLabel>
+#include <QPointer>
 // 添加日志记录模式按钮
 #include <QComboBox>  
 #include <QPushButton>
 
-// 电机信息结构体
-typedef struct
-{
-  double mode, index;                            // 这里必须是double才行，否则和python那边发过来的对不上，就无法正常通信，电机控制模式，可以起到软急停的作用，模式为0代表停止运动，目前还没实现
-  double tau_, pos_, vel_;                       // 当前的位置rad、速度rad/s、力矩N.m
-  double pos_des_, vel_des_, kp_, kd_, ff_;      // 期望的位置、速度、比例、积分、力矩N.m
-  double error_, temperature_, mos_temperature_; // 读到的错误类型，电机温度和MOS温度
-} InteractiveMotorData;
-static_assert(sizeof(InteractiveMotorData) == 8 * 13, "Struct size mismatch! Must match sender."); // 已确定发送端为8 * 13字节
-
-std::vector<double> extract_fields(const InteractiveMotorData &m);
-// std::vector<double> extract_fields_from_raw(const char *raw_ptr);
-
-// Plotjuggler中显示的var名
-// 该量用于注册变量 -> plotjuggler,提取的值和该处字段对应.
-static const std::vector<std::string> field_names = {
-    // "Mode",  
-    "Pos",
-    "Vel",
-    "Torque",
-    // "Pos_des",
-    // "Vel_des",
-    // "Kp",
-    // "Kd",
-    // "FF",
-    "Error",
-    "Temperatrue",
-    "Mos Temperature"};
-
-
 // error ID到error类型(文本描述)的映射
 static const std::map<int, QString>
     error_text_map =
@@ -99,7 +106,7 @@ static const std::map<int, QString>
  * 该类继承自 `PJ::DataStreamer`，用于实时流式处理数据，并支持外部订阅更新的数据。
  * 它包含多线程处理，包括：
  * - 一个数据流线程（loop()）
- * - 一个 UDP 监听线程（receiveUDPData()）
+ * - 一个 UDP 监听线程（receiveUDPData()，用一个 epoll 循环服务所有数据源）
  *
  * 主要功能包括：
  * - 通过 `start()` 方法启动数据流，并监听 UDP 端口接收数据
@@ -117,28 +124,31 @@ class DataStreamSample : public PJ::DataStreamer
 public:
   /**
    * @brief DataStreamSample 构造函数
-   * @param group_count 数据组数，每组包含多个变量
-   * @param var_count 每组的变量数,和field_names中变量数一致
+   * @param group_count 每个数据源启动时预先注册的电机数（收到电机数更多的自描述数据报时会自动补充注册）
+   * @param var_count 每组的变量数，即 `MOTOR_FIELDS` 中 plotted 字段数（超出时按该数截断）
    *
-   * 该构造函数初始化数据存储数组，并在 PlotJuggler 中注册数据变量名称。
+   * 该构造函数读取数据源列表（见 loadSourceList()），初始化数据存储数组，并在 PlotJuggler 中注册数据变量名称。
    */
-  DataStreamSample(int group_count = 13, int var_count = 6);
+  DataStreamSample(int group_count = MOTOR_COUNT, int var_count = static_cast<int>(PLOTTED_FIELD_COUNT));
 
   /**
    * @brief 启动数据流
    * @param 参数列表（未使用）
    * @return 启动成功返回 true
    *
-   * 该方法会创建两个线程：
-   * - 一个线程运行 `loop()`，以 50Hz 频率更新数据
-   * - 一个线程运行 `receiveUDPData()`，监听 UDP 端口接收数据
+   * 未停止就再次调用时先 shutdown()。创建停止时唤醒接收线程用的 eventfd，先建好错误类型窗口
+   * （发布线程读取其中的标签指针，须在创建线程之前写入），再启动异步日志写线程，并创建两个由本对象持有的线程：
+   * - 发布线程运行 `loop()`：事件驱动模式下按通知频率上限、保持最后值模式下以 50Hz 批量推送帧队列中的新帧
+   * - 接收线程运行 `receiveUDPData()`：在 epoll（或共享内存的 futex）上等待各数据源的数据并写入帧队列
    */
   virtual bool start(QStringList *) override;
 
   /**
    * @brief 关闭数据流
    *
-   * 该方法会安全终止 `loop()` 线程，但不会直接管理 UDP 线程（该线程为分离线程）。
+   * 清除运行标志后写 eventfd 唤醒阻塞在 epoll_wait 中的接收线程，接收线程在共享内存 futex 上等待时直接打断，
+   * 然后依次 join 接收线程（退出前关闭所有 socket 和共享内存映射）和发布线程，关闭 eventfd，
+   * 最后停止日志写线程（写完缓冲中剩余的帧）。返回后不再有线程访问本对象，可以立即再次 start() 或析构。
    */
   virtual void shutdown() override;
 
@@ -151,7 +161,7 @@ public:
   /**
    * @brief 析构函数
    *
-   * 确保在对象销毁时调用 `shutdown()` 以正确终止线程。
+   * 确保在对象销毁时调用 `shutdown()` 以正确终止线程，之后删除本实例的错误类型显示窗口（连同其中的定时器和表格模型）。
    */
   virtual ~DataStreamSample() override;
 
@@ -171,14 +181,35 @@ public:
    * @param newData 传入的新数据，格式为 `std::vector<std::vector<double>>`
    *
    * 该方法允许外部程序手动更新数据，数据更新后会触发 `updateData()` 并推送到 PlotJuggler。
+   * 多数据源时数据写入第一个数据源。
    */
   void setData(const std::vector<std::vector<double>> &newData);
 
+  /**
+   * @brief 批量设置数据（UDP 批量接收时调用）
+   * @param frames 预分配的帧数组，每帧格式同 `setData()`
+   * @param stamps 与 frames 一一对应的每帧时间戳（秒），推送时原样作为曲线横坐标
+   * @param frame_count 本批次有效帧数（取 frames 的前 frame_count 帧）
+   * @param notify 推送后是否立即发出 dataReceived 信号（发布线程合并通知时传 false）
+   *
+   * 与逐帧调用 `setData()` 不同，该方法只获取一次 PlotJuggler 的 mutex，
+   * 将整批数据一次性推送，并且只刷新一次错误标签、最多发出一次 dataReceived 信号。
+   */
+  void setDataBatch(const std::vector<std::vector<std::vector<double>>> &frames, const std::vector<double> &stamps,
+                    int frame_count, bool notify = true);
+
   /**
    * @brief 监听 UDP 数据
    *
-   * 该方法会创建一个 UDP socket 监听端口 `5050`，并在 `_running` 为 `true` 时循环接收数据。
-   * 收到数据后会调用 `setData()` 进行更新。
+   * 该方法为每个数据源创建一个非阻塞 UDP socket（默认只有端口 `4015`），全部加入同一个 epoll，
+   * 在 `_running` 为 `true` 时循环接收数据，数据源再多也只占用这一个线程。
+   * 停止时 shutdown() 通过 eventfd（或共享内存读端的 interrupt()）立即唤醒该线程并等待其关闭所有 socket 后退出。
+   * 数据报可以是旧版的 13 个电机裸结构体数组，也可以带自描述包头（电机数、格式版本、序号，见 motorPacket.h）。
+   * 批量模式下（`udp_batch_mode_`）使用 recvmmsg 每次系统调用最多取出 `udp_batch_size_` 个数据报，
+   * 校验后的原始帧只放入无锁帧队列 `_frame_ring`，由 `loop()` 线程批量解码推送；日志按批写入。
+   * 非批量模式下每次只取一个数据报。
+   * 线程开始时按接收线程配置（loadRxThreadProfile()）设置 CPU 绑定、调度策略和各 socket 的接收缓冲，
+   * 实际生效的设置显示在电机错误类型界面上。
    */
   void receiveUDPData();
 
@@ -192,28 +223,259 @@ signals:
   void dataUpdated(const std::vector<std::vector<double>> &data);
 
 private:
+  /**
+   * @brief 单个 UDP 数据源的绘图、界面与日志状态
+   */
+  struct MotorSource
+  {
+    UdpSourceConfig config; ///< 端口 / 组播组 / 名称
+    std::string prefix;     ///< 曲线命名空间前缀（如 "RobotA/"，单数据源未命名时为空）
+
+    // 以下由 mutex() 保护（发布线程、外部 setData() 访问）
+    int group_count = 0;                          ///< 已注册的电机分组数（随自描述数据报中的电机数增长）
+    std::vector<PJ::PlotData *> series;           ///< 扁平的 [group][field] 序列表（下标 g * MOTOR_FIELD_COUNT + f），字段启用后才注册，未注册为 nullptr
+    std::vector<SeriesDecimator> decimators;      ///< 与 series 一一对应的抽稀状态（启用曲线抽稀时使用）
+    std::vector<InteractiveMotorData> last_motors; ///< 最后一帧的原始电机数据（保持最后值模式按启用的字段重复推送）
+    std::vector<PJ::PlotData *> derived_series;   ///< 扁平的 [group][派生量] 序列表（下标 g * DERIVED_SIGNAL_COUNT + d），启用后才注册，未注册为 nullptr
+    std::vector<SeriesDecimator> derived_decimators; ///< 与 derived_series 一一对应的抽稀状态
+    std::vector<std::vector<double>> data_array;  ///< 最后一帧数据，每组 `var_count` 个变量
+    std::array<PJ::PlotData *, RX_STATS_SERIES_COUNT> stats_series{}; ///< 接收统计曲线（_stats/...）
+    ErrorTransitionTracker event_tracker;         ///< 错误码跳变检测（发布到 _events/...）
+    std::vector<PJ::PlotData *> event_series;     ///< 各电机的 _events/Motor<n>/error_code（第一次跳变时注册）
+    std::vector<PJ::StringSeries *> event_text_series; ///< 各电机的 _events/Motor<n>/transition（跳变的文字描述）
+    MotorAlarmEngine alarm_engine;                ///< 滑动窗口统计和告警状态
+    std::vector<PJ::PlotData *> alarm_series;     ///< 扁平的 [电机][规则] 统计量曲线 _alarms/Motor<n>/<规则>（第一次判断时注册）
+    std::vector<PJ::PlotData *> alarm_active_series; ///< 各电机的 _alarms/Motor<n>/active（告警掩码）
+    RxStatsSampler stats_sampler;                 ///< 接收统计采样（计算帧率）
+    QLabel *stats_label = nullptr;                ///< 接收统计显示标签
+
+    // 接收线程写、其他线程只读（原子计数器，放在堆上使 MotorSource 可移动）
+    std::unique_ptr<RxStatsCounters> stats = std::make_unique<RxStatsCounters>();
+
+    // 发布线程写、界面定时器读（见 errorTableModel.h）
+    std::unique_ptr<MotorErrorSnapshot> error_snapshot = std::make_unique<MotorErrorSnapshot>();
+
+    // 以下仅接收线程访问
+    int socket_fd = -1;                  ///< 该数据源的 UDP socket
+    SequenceTracker sequence_tracker;    ///< 发送端序号缺口检测
+    CompactKeyframe compact_keyframe;    ///< 紧凑格式的最近关键帧（用于还原差分帧，见 motorPacket.h）
+    std::unique_ptr<ShmRingReader> shm_reader; ///< 共享内存数据源的读端（shm: 数据源，见 shmTransport.h）
+    FlightRecorder flight_recorder;      ///< 仅错误记录模式下的触发前环形缓冲（固定容量，不随运行时长增长）
+    bool post_trigger_active = false;    ///< 是否处于错误记录窗口中
+    double post_trigger_deadline = 0.0;  ///< 错误记录窗口结束时间
+    bool recorder_limit_warned = false;  ///< 是否已提示过触发前缓冲达到上限
+    int active_log_mode = -1;            ///< 当前日志文件对应的日志模式，-1 表示尚未打开日志文件
+    int active_log_format = -1;          ///< 当前日志文件对应的日志格式
+  };
+
+  /**
+   * @brief 读取数据源列表：环境变量 MOTOR_MONITOR_SOURCES 优先，其次为界面上保存的设置，默认只监听 4015 端口
+   */
+  static std::vector<UdpSourceConfig> loadSourceList();
+
+  /**
+   * @brief 读取接收线程配置：环境变量 MOTOR_MONITOR_RX_PROFILE 优先，其次为界面上保存的设置，默认只请求 4 MiB 接收缓冲
+   */
+  static RxThreadProfile loadRxThreadProfile();
+
+  /**
+   * @brief 读取启用的派生曲线：环境变量 MOTOR_MONITOR_DERIVED 优先，其次为界面上保存的设置，默认不启用
+   */
+  static uint32_t loadDerivedSignalMask();
+
+  /**
+   * @brief 读取启用的字段：环境变量 MOTOR_MONITOR_FIELDS 优先，其次为界面上保存的设置，默认为 MOTOR_FIELDS 中 plotted 的字段
+   */
+  static uint32_t loadMotorFieldMask();
+
+  /**
+   * @brief 读取告警规则：环境变量 MOTOR_MONITOR_ALARMS 优先，其次为界面上保存的设置，默认不启用告警
+   */
+  static AlarmConfig loadAlarmConfig();
+
+  /**
+   * @brief 读取转发配置：环境变量 MOTOR_MONITOR_RELAY 优先，其次为界面上保存的设置，默认不转发
+   */
+  static UdpRelayConfig loadRelayConfig();
+
+  /**
+   * @brief 注册一个电机的一个字段的曲线（调用者需已持有 mutex()）
+   * @return 曲线指针（已注册时直接返回）
+   */
+  PJ::PlotData *registerFieldSeriesLocked(MotorSource &source, int group, size_t field);
+
+  /**
+   * @brief 按启用的字段推送若干电机的数据（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param motors 电机数据
+   * @param count 电机数（只推送已注册的电机分组）
+   * @param stamp 时间戳（秒）
+   * @param decimate 是否经过抽稀
+   *
+   * 启用后尚未注册的字段在这里注册（每条曲线只发生一次），未启用的字段不读取也不推送。
+   */
+  void pushMotorsLocked(MotorSource &source, const InteractiveMotorData *motors, int count, double stamp, bool decimate);
+
   /**
    * @brief 数据流循环
    *
-   * 该方法在独立线程 `_thread` 中运行，每 20ms（50Hz）执行一次 `updateData()`。
+   * 该方法在独立线程 `_thread` 中运行，每个周期批量推送帧队列中的新帧并合并为一次通知。
+   * 事件驱动模式下周期为 `1 / max_notify_rate_hz_`，没有新帧时不推送；
+   * 保持最后值模式下以 50Hz 运行，没有新帧时执行一次 `updateData()` 保持显示最后一帧。
    * 当 `_running` 设为 `false` 时，循环终止。
    */
   void loop();
 
+  /**
+   * @brief 发布阶段：批量取出帧队列中的所有新帧，解码后在一次 mutex 持有内推送
+   * @return 本次推送的帧数，为 0 表示队列中没有新帧
+   */
+  int publishPendingFrames();
+
+  /**
+   * @brief 每隔 STATS_PUBLISH_INTERVAL_S 采样一次接收统计，推送到 _stats/... 曲线并刷新界面上的统计标签；
+   *        启用延迟统计时同时推送最近一个周期各阶段的 p50/p99/max 到 _latency/... 曲线
+   * @return 本次推送了统计数据返回 true（不发出 dataReceived 信号，由调用者决定通知时机）
+   */
+  bool publishStatsIfDue();
+
+  /**
+   * @brief 按曲线历史保留策略裁剪插件数据表中的所有曲线（发布线程在发布接收统计的周期调用，一次加锁）
+   */
+  void trimHistory();
+
+  /**
+   * @brief 确保数据源至少已注册 motor_count 个电机的曲线（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param motor_count 需要的电机数
+   *
+   * 只在出现更多电机的布局时注册新增电机（只注册当前启用的字段）并扩展缓冲，每种布局只分配一次；
+   * 电机数减少时保留已注册的曲线（可能仍在图中使用），只是不再推送。
+   */
+  void ensureMotorGroupsLocked(MotorSource &source, int motor_count);
+
+  /**
+   * @brief 将一帧原始数据直接解码推送到 PlotJuggler（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param frame 原始帧，只推送前 frame.motor_count 个电机
+   */
+  void pushRawFrameLocked(MotorSource &source, const RawMotorFrame &frame);
+
+  /**
+   * @brief 计算一帧的派生量并推送启用的派生曲线（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param frame 原始帧
+   * @param mask 启用的派生量
+   *
+   * 某个派生量第一次启用时才注册该数据源所有电机的对应曲线，关闭后保留已注册的曲线，只是不再推送。
+   */
+  void pushDerivedSignalsLocked(MotorSource &source, const RawMotorFrame &frame, uint32_t mask);
+
+  /**
+   * @brief 检测一帧中各电机错误码的跳变，发布到 _events/... 曲线和文本序列（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param frame 原始帧
+   *
+   * 某个电机第一次出现跳变时才注册它的事件序列，没有错误的电机不会产生 _events 条目。
+   */
+  void publishErrorTransitionsLocked(MotorSource &source, const RawMotorFrame &frame);
+
+  /**
+   * @brief 把一帧推入告警统计窗口，到判断周期时发布统计量曲线并把告警掩码写入错误码快照（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param frame 原始帧
+   */
+  void updateAlarmsLocked(MotorSource &source, const RawMotorFrame &frame);
+
+  /**
+   * @brief 界面修改了告警规则时，按新规则重新配置所有数据源（清空统计和告警状态，发布线程调用）
+   */
+  void applyAlarmConfig();
+
+  /**
+   * @brief 界面修改了抽稀设置时，先按旧设置输出未完成的桶，再重新配置所有曲线的抽稀状态（发布线程调用）
+   * @return 输出了未完成的桶（需要通知界面）返回 true
+   */
+  bool applyDecimationSettings();
+
+  /**
+   * @brief 输出所有曲线中抽稀未完成的桶（数据流暂停时调用，避免最后一段数据滞留在桶中）
+   * @return 推送了数据返回 true
+   */
+  bool flushDecimators();
+
+  /**
+   * @brief flushDecimators() 的实现（调用者需已持有 mutex()）
+   */
+  bool flushDecimatorsLocked();
+
   std::thread _thread; ///< 运行数据流的线程
-  bool _running; ///< 标志数据流是否正在运行
-  int _group_count; ///< 记录数据的分组数
+  std::thread _udp_thread; ///< UDP 接收线程（shutdown() 中唤醒并等待其退出，退出时关闭所有 socket）
+  std::atomic<bool> _running{false}; ///< 标志数据流是否正在运行
+  int _wake_fd = -1; ///< eventfd，shutdown() 写入后阻塞在 epoll_wait 中的接收线程立即返回
+  std::mutex _rx_wait_mutex;                     ///< 保护 _rx_wait_reader
+  ShmRingReader *_rx_wait_reader = nullptr;      ///< 接收线程正在 futex 上等待的共享内存读端（shutdown() 中打断）
   int _var_count;   ///< 记录每组数据的变量数
-  std::vector<std::vector<double>> _data_array; ///< 存储数据数组，每组 `group_count` 个数据，每个包含 `var_count` 个变量
+  std::vector<MotorSource> _sources; ///< 各数据源（构造时确定，运行中不增删，下标即 RawMotorFrame::source）
+  static constexpr size_t FRAME_RING_CAPACITY = 2048; ///< 帧队列容量（约 2 秒 @1kHz，单帧按 MAX_MOTOR_COUNT 预留）
+  static constexpr size_t PUBLISH_BATCH_SIZE = 256;   ///< 发布阶段每次从队列取出的最大帧数
+
+  SpscRing<RawMotorFrame> _frame_ring;                              ///< 接收线程 -> 发布线程的无锁帧队列
+  std::atomic<uint64_t> _ring_dropped_frames{0};                    ///< 因帧队列已满而丢弃的绘图帧数
+  std::vector<RawMotorFrame> _publish_frames;                       ///< 发布阶段的批量取帧缓冲（预分配）
+  std::vector<int> _publish_last_frame;                             ///< 发布阶段每个数据源本批最后一帧的下标（预分配）
+  std::array<ErrorTransition, MAX_MOTOR_COUNT> _publish_transitions; ///< 发布阶段单帧的错误码跳变缓冲
+  DerivedSignalBlock _derived_block;                                ///< 发布阶段单帧的派生量计算结果
+
+  static constexpr double STATS_PUBLISH_INTERVAL_S = 0.5; ///< 接收统计的发布周期（秒）
+  static constexpr int ERROR_TABLE_REFRESH_MS = 100;       ///< 错误类型界面从错误码快照刷新的周期（毫秒）
+  double _last_stats_time = 0.0;                          ///< 上次发布接收统计的时间（发布线程访问）
+  PJ::PlotData *_log_drops_series = nullptr;              ///< _stats/log_drops：日志写入跟不上而丢弃的帧数
+  PJ::PlotData *_relay_sent_series = nullptr;             ///< _stats/relay_sent：累计转发的数据报数
+  PJ::PlotData *_relay_dropped_series = nullptr;          ///< _stats/relay_dropped：发送缓冲满等原因未能转发的数据报数
+  UdpRelay _relay;                                        ///< UDP 转发（接收线程启动时按转发配置打开，计数器可在其他线程读取）
+  // 以下标签指针（及各数据源的 stats_label）在启动线程之前由 startUIWindow() 写入，窗口存在期间不再改变，发布线程只读
+  QLabel *_log_stats_label = nullptr;                     ///< 日志统计显示标签
+  QLabel *_rx_profile_label = nullptr;                    ///< 接收线程实际生效设置的显示标签
+  QLabel *_history_label = nullptr;                       ///< 暂存曲线点数和裁剪统计的显示标签
+  uint64_t _history_trimmed_points = 0;                   ///< 累计裁剪的点数（发布线程访问）
+
+  std::atomic<double> history_max_seconds_{0.0}; ///< 暂存曲线的时间窗口（秒），0 表示不限（界面修改，发布线程读取）
+  std::atomic<int> history_max_points_{0};       ///< 每条暂存曲线最多保留的点数，0 表示不限
+
+  std::mutex _rx_profile_mutex;                   ///< 保护 _rx_profile_report
+  std::string _rx_profile_report;                 ///< 接收线程实际生效的设置（接收线程启动时写入）
+  std::atomic<bool> _rx_profile_report_changed{false}; ///< _rx_profile_report 已更新、尚未显示到界面
+
+  LatencyProfiler latency_profiler_;                                  ///< 分阶段延迟直方图（默认关闭，可在界面上开关）
+  std::array<std::array<PJ::PlotData *, 3>, LATENCY_STAGE_COUNT> _latency_series{}; ///< _latency/<阶段>/p50、p99、max（微秒）
+  std::vector<LatencyHistogram::Counts> _latency_prev_counts;        ///< 上次发布时各阶段的累计计数（发布线程访问）
+  std::unique_ptr<LatencyHistogram::Counts> _latency_counts;         ///< 发布时的计数快照缓冲（发布线程访问）
+  std::vector<uint64_t> _publish_recv_ns;                            ///< 本周期已推送帧的接收时刻，通知后计入端到端延迟（预分配）
 
   /**
    * @brief 更新数据并通知订阅者
    *
-   * 该方法遍历 `_data_array`，并将数据推送到 PlotJuggler 进行可视化。
+   * 该方法遍历各数据源的最后一帧，并将数据推送到 PlotJuggler 进行可视化。
    * 每次更新数据后都会发送 `dataUpdated` 信号。
    */
   void updateData();
 
+  /**
+   * @brief 将一帧数据推送到 PlotJuggler（调用者需已持有 mutex()）
+   * @param source 数据源
+   * @param data 一帧数据，格式同 `MotorSource::data_array`
+   * @param stamp 该帧的时间戳（秒）
+   *
+   * data 中的字段写入 `last_motors`（其余字段保持最后一帧的值）后按启用的字段推送。
+   */
+  void pushFrameLocked(MotorSource &source, const std::vector<std::vector<double>> &data, double stamp);
+
+  /**
+   * @brief 把数据源 `data_array` 中各电机的错误码写入错误码快照（不投递界面事件，由界面定时器读取）
+   */
+  void publishErrorSnapshot(MotorSource &source);
+
   // 用于显示错误类型
 public:
   /**
@@ -234,14 +496,71 @@ public:
   QString errorToText(int mode) const;
 
 private:
-  QVector<QLabel *> motor_error_labels_; // 用于保存所有电机错误显示标签（QLabel）的容器
-  QWidget *ui_window_ = nullptr; // ✅ 用于保存新建的UI窗口指针
+  // 错误类型显示窗口（每个实例一个）：表格模型引用本实例各数据源的错误码快照，按钮和定时器捕获 this，
+  // 因此窗口随实例销毁（析构函数中先停止线程再删除窗口）。PlotJuggler 重新启用插件时会构造新实例，新窗口按新实例的数据源建立
+  QPointer<QWidget> ui_window_;
 
   // 用于出现错误时保存电机数据
 private:
-  std::vector<std::vector<InteractiveMotorData>> error_data_buffer_;   // 出现错误时缓存电机数据
-  bool error_triggered_ = false;   // 出现错误标志
-  std::vector<int> last_errors_;   // 缓存上一帧每个电机的错误码，只在值变化时才刷新对应 motor 的 QLabel，防止强制刷新UI拖慢帧率
-  static bool ui_window_initialized_; // PlotJuggler 在每次点击“启用插件”或刷新插件时，会重新调用 createPlugin() 构造新实例，导致 startUIWindow() 也被重复调用，从而弹出多个窗口,避免该问题
-  int log_mode_ = 0;                  // 日志记录模式 0: 仅错误记录，1: 全时记录
+  /**
+   * @brief 日志判断与提交（在 UDP 接收线程中调用）
+   * @param source_index 数据源序号（同时也是日志流序号）
+   * @param frames 本批次的有效帧（均来自该数据源）
+   * @param count  帧数
+   *
+   * 仅错误记录模式下，没有错误时帧只进入该数据源的触发前缓冲 `flight_recorder`；
+   * 检测到错误上升沿时把触发前 `pre_trigger_seconds_` 内的帧整体交给写线程（AsyncLogWriter::submitRecording()），
+   * 之后持续记录到错误消失后 `post_trigger_seconds_`。
+   */
+  void logFrames(size_t source_index, const RawMotorFrame *frames, int count);
+
+  static constexpr double FLIGHT_RECORDER_RATE_HZ = 1000.0; // 触发前缓冲按该帧率预分配容量（帧率更高时自动扩大）
+  static constexpr size_t FLIGHT_RECORDER_MAX_FRAMES = 16384; // 触发前缓冲扩大的上限（每帧约 5KB，连同写线程的交接存储每个数据源最多约 160MB）
+
+  AsyncLogWriter log_writer_{2048, MAX_UDP_SOURCES}; // 异步日志写线程（每个数据源一个日志流），接收线程只提交帧，由写线程保持文件打开并批量写入
+  std::atomic<double> pre_trigger_seconds_{2.0};  // 错误前记录时长（秒），容量在接收开始时按此分配
+  std::atomic<double> post_trigger_seconds_{2.0}; // 错误消失后继续记录的时长（秒）
+  std::string timestamp_str_first_;    // 日志文件名中的时间戳（首次需要记录时确定，所有数据源共用，接收线程访问）
+  std::atomic<int> log_mode_{0};      // 日志记录模式 0: 仅错误记录，1: 全时记录（界面线程写，接收线程读）
+  std::atomic<int> log_format_{0};    // 日志格式 0: 文本，1: 紧凑二进制（带时间索引），2: 列式会话（Arrow IPC）
+
+  // 数据发布模式（可在错误类型显示界面上修改）
+private:
+  std::atomic<int> publish_mode_{0};         // 发布模式 0: 仅新数据到达时推送（事件驱动），1: 50Hz 保持最后值推送
+  std::atomic<int> max_notify_rate_hz_{60};  // 事件驱动模式下 dataReceived 通知的最大频率（Hz）
+
+  // 曲线抽稀（可在错误类型显示界面上修改，发布线程在下一个周期生效；只影响绘图，日志保持原始速率）
+private:
+  std::atomic<bool> decimation_enabled_{false};                            // 是否启用抽稀
+  std::atomic<int> decimation_mode_{0};                                    // 抽稀方式，见 DecimationMode
+  std::array<std::atomic<double>, MOTOR_FIELD_COUNT> decimation_bucket_ms_{};   // 各字段的桶宽（毫秒），0 表示不抽稀，默认取自 MOTOR_FIELDS
+  std::atomic<uint32_t> decimation_generation_{0};                         // 界面每次修改设置加 1
+  uint32_t _decimation_applied_generation = 0;                             // 发布线程已生效的设置版本（以下仅发布线程访问）
+  bool _decimation_active = false;                                         // 当前是否抽稀
+  bool _decimation_pending = false;                                        // 是否有未输出的桶
+  DecimationMode _decimation_mode = DecimationMode::MinMax;                // 当前抽稀方式
+  std::array<double, MOTOR_FIELD_COUNT> _decimation_bucket_s{};            // 当前各字段桶宽（秒）
+
+  // 派生曲线（可在错误类型显示界面上修改，发布线程在下一帧生效）
+private:
+  std::atomic<uint32_t> derived_mask_{0}; // 启用的派生量（第 d 位对应 DERIVED_SIGNALS[d]）
+
+  // 显示的字段（可在错误类型显示界面上修改，下一帧生效）
+private:
+  std::atomic<uint32_t> field_mask_{DEFAULT_MOTOR_FIELD_MASK}; // 启用的字段（第 f 位对应 MOTOR_FIELDS[f]）
+
+  // 告警规则（可在错误类型显示界面上修改，发布线程在下一个周期生效）
+private:
+  std::mutex alarm_config_mutex_;              // 保护 pending_alarm_config_
+  AlarmConfig pending_alarm_config_;           // 界面上设置的新规则
+  std::atomic<bool> alarm_config_changed_{false}; // pending_alarm_config_ 已更新、尚未生效
+
+  // 帧时间戳来源（可在错误类型显示界面上修改）
+private:
+  std::atomic<int> timestamp_source_{0}; // 0: 内核接收时间（SO_TIMESTAMPNS），1: 发送端时间戳（数据报尾部 8 字节 double），2: 接收时系统时间
+
+  // UDP 批量接收
+private:
+  bool udp_batch_mode_ = true; // 批量接收模式，true: recvmmsg 一次取多个数据报，false: 每次只取一个
+  int udp_batch_size_ = 32;    // 批量模式下每次系统调用最多取出的数据报数量
 };
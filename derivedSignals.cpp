@@ -0,0 +1,60 @@
+/**
+ * @file derivedSignals.cpp
+ * @brief 派生曲线配置的解析与格式化
+ * @author mafangniu
+ * @date 2025-05-12
+ */
+
+#include "derivedSignals.h"
+
+#include <strings.h>
+
+#include "specTokens.h"
+
+bool parseDerivedSignalMask(const std::string &spec, uint32_t &mask, std::string *error)
+{
+  uint32_t parsed = 0;
+  for (const std::string &entry : specTokens(spec))
+  {
+    if (strcasecmp(entry.c_str(), "none") == 0)
+    {
+      continue;
+    }
+    if (strcasecmp(entry.c_str(), "all") == 0)
+    {
+      parsed = DERIVED_SIGNAL_ALL;
+      continue;
+    }
+
+    bool found = false;
+    for (int d = 0; d < DERIVED_SIGNAL_COUNT; ++d)
+    {
+      if (strcasecmp(entry.c_str(), DERIVED_SIGNALS[d].name) == 0)
+      {
+        parsed |= 1u << d;
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+    {
+      setError(error, "未知的派生量: " + entry);
+      return false;
+    }
+  }
+  mask = parsed;
+  return true;
+}
+
+std::string formatDerivedSignalMask(uint32_t mask)
+{
+  std::string spec;
+  for (int d = 0; d < DERIVED_SIGNAL_COUNT; ++d)
+  {
+    if (mask & (1u << d))
+    {
+      spec += (spec.empty() ? "" : ",") + std::string(DERIVED_SIGNALS[d].name);
+    }
+  }
+  return spec;
+}
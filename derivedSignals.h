@@ -0,0 +1,100 @@
+/**
+ * @file derivedSignals.h
+ * @brief 接收时计算的派生曲线（跟踪误差、机械功率、PD 力矩）
+ * @author mafangniu
+ * @date 2025-05-12
+ *
+ * @details
+ * 调参时经常要在 PlotJuggler 中用 Lua/JS 自定义函数计算跟踪误差、功率等，13 个电机、1kHz 时这些脚本很慢。
+ * 本模块在发布线程中直接从 InteractiveMotorData 计算（包括没有显示的 pos_des_、vel_des_、kp_、kd_、ff_ 字段）：
+ *
+ *     Pos_err    = pos_des_ - pos_                           跟踪误差（rad）
+ *     Vel_err    = vel_des_ - vel_                           跟踪误差（rad/s）
+ *     Power      = tau_ * vel_                               机械功率（W）
+ *     Torque_pd  = kp_ * Pos_err + kd_ * Vel_err + ff_       PD 控制律给出的力矩（N·m）
+ *
+ * computeDerivedSignals() 对一帧的所有电机做一遍无分支的循环，结果按 [派生量][电机] 存放（结构数组转数组结构），
+ * 编译器可对该循环向量化；所有派生量总是一起计算（每个电机只有几次乘加），只有启用的派生量会注册和推送。
+ * 派生曲线命名为 Motor<n>/<name>，启用的派生量用逗号分隔的名称表示，例如 "Pos_err,Power"（见 parseDerivedSignalMask()）。
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "motorData.h"
+
+/**
+ * @brief 派生量（DERIVED_SIGNALS 中的下标，也是启用掩码中的位）
+ */
+enum DerivedSignal
+{
+  DERIVED_POS_ERROR = 0,
+  DERIVED_VEL_ERROR,
+  DERIVED_POWER,
+  DERIVED_PD_TORQUE,
+  DERIVED_SIGNAL_COUNT
+};
+
+// 单个派生量的描述
+struct DerivedSignalDescriptor
+{
+  const char *name;     // 曲线名（Motor<n>/<name>），也是配置字符串中的名称
+  const char *formula;  // 界面上显示的公式
+  double decimation_ms; // 启用曲线抽稀时的桶宽（毫秒）
+};
+
+static constexpr DerivedSignalDescriptor DERIVED_SIGNALS[DERIVED_SIGNAL_COUNT] = {
+    {"Pos_err", "pos_des - pos", 5.0},
+    {"Vel_err", "vel_des - vel", 5.0},
+    {"Power", "tau * vel", 5.0},
+    {"Torque_pd", "kp*(pos_des-pos) + kd*(vel_des-vel) + ff", 5.0},
+};
+
+static constexpr uint32_t DERIVED_SIGNAL_ALL = (1u << DERIVED_SIGNAL_COUNT) - 1;
+
+/**
+ * @brief 一帧所有电机的派生量，values[派生量][电机]
+ */
+struct DerivedSignalBlock
+{
+  alignas(64) double values[DERIVED_SIGNAL_COUNT][MAX_MOTOR_COUNT];
+};
+
+/**
+ * @brief 计算一帧中前 count 个电机的所有派生量
+ * @param motors 电机数据
+ * @param count  电机数（不超过 MAX_MOTOR_COUNT）
+ * @param out    输出，只写入每个派生量的前 count 项
+ */
+inline void computeDerivedSignals(const InteractiveMotorData *__restrict motors, int count, DerivedSignalBlock &__restrict out)
+{
+  double *__restrict pos_error = out.values[DERIVED_POS_ERROR];
+  double *__restrict vel_error = out.values[DERIVED_VEL_ERROR];
+  double *__restrict power = out.values[DERIVED_POWER];
+  double *__restrict pd_torque = out.values[DERIVED_PD_TORQUE];
+  for (int i = 0; i < count; ++i)
+  {
+    const InteractiveMotorData &m = motors[i];
+    const double e_pos = m.pos_des_ - m.pos_;
+    const double e_vel = m.vel_des_ - m.vel_;
+    pos_error[i] = e_pos;
+    vel_error[i] = e_vel;
+    power[i] = m.tau_ * m.vel_;
+    pd_torque[i] = m.kp_ * e_pos + m.kd_ * e_vel + m.ff_;
+  }
+}
+
+/**
+ * @brief 解析启用的派生量
+ * @param spec 逗号（或分号、空白）分隔的派生量名称（不区分大小写），"all" 表示全部，空字符串或 "none" 表示不启用
+ * @param mask 输出的启用掩码（第 i 位对应 DERIVED_SIGNALS[i]，解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true
+ */
+bool parseDerivedSignalMask(const std::string &spec, uint32_t &mask, std::string *error = nullptr);
+
+/**
+ * @brief 将启用掩码格式化为配置字符串（parseDerivedSignalMask() 的逆操作）
+ */
+std::string formatDerivedSignalMask(uint32_t mask);
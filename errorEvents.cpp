@@ -0,0 +1,225 @@
+/**
+ * @file errorEvents.cpp
+ * @brief 错误码跳变事件的跟踪、事件文件读写和查询实现
+ * @author mafangniu
+ * @date 2025-05-11
+ */
+
+#include "errorEvents.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "specTokens.h"
+
+namespace
+{
+const size_t WRITE_BUFFER_BYTES = 64 * 1024; // 事件很稀疏，小缓冲即可，每批写入后 flush()
+
+ErrorEventHeader makeHeader()
+{
+  ErrorEventHeader h{};
+  std::memcpy(h.magic, ERROR_EVENT_MAGIC, sizeof(h.magic));
+  h.version = ERROR_EVENT_VERSION;
+  h.record_size = sizeof(ErrorTransition);
+  return h;
+}
+
+bool validHeader(const ErrorEventHeader &h)
+{
+  return std::memcmp(h.magic, ERROR_EVENT_MAGIC, sizeof(h.magic)) == 0 && h.version == ERROR_EVENT_VERSION &&
+         h.record_size == sizeof(ErrorTransition);
+}
+
+} // namespace
+
+// ============================ ErrorTransitionTracker ============================
+
+void ErrorTransitionTracker::reset()
+{
+  motors_.fill(MotorState{});
+}
+
+int ErrorTransitionTracker::observe(const RawMotorFrame &frame, ErrorTransition *out)
+{
+  int count = 0;
+  const int motors = std::min<int>(frame.motor_count, MAX_MOTOR_COUNT);
+  for (int m = 0; m < motors; ++m)
+  {
+    MotorState &state = motors_[m];
+    const int32_t code = motorErrorCode(frame.motors[m]);
+    if (state.seen && code == state.code)
+    {
+      continue;
+    }
+
+    // 第一次出现且无错误时只记下状态；否则生成一条跳变
+    if (state.seen || code != 0)
+    {
+      ErrorTransition &e = out[count++];
+      e = ErrorTransition{};
+      e.stamp = frame.stamp;
+      e.duration = state.seen ? frame.stamp - state.since : 0.0;
+      e.old_code = state.seen ? state.code : ERROR_CODE_UNKNOWN;
+      e.new_code = code;
+      e.motor = static_cast<uint16_t>(m);
+    }
+    state.seen = true;
+    state.code = code;
+    state.since = frame.stamp;
+  }
+  return count;
+}
+
+// ============================ ErrorEventFile ============================
+
+ErrorEventFile::~ErrorEventFile()
+{
+  close();
+}
+
+bool ErrorEventFile::open(const std::string &filename)
+{
+  close();
+  const ErrorEventHeader header = makeHeader();
+
+  // 文件已存在且文件头一致时续写，否则重新创建
+  bool resume = false;
+  struct stat st;
+  if (::stat(filename.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) >= sizeof(header))
+  {
+    std::FILE *probe = std::fopen(filename.c_str(), "rb");
+    if (probe)
+    {
+      ErrorEventHeader existing{};
+      resume = std::fread(&existing, sizeof(existing), 1, probe) == 1 && validHeader(existing);
+      std::fclose(probe);
+    }
+  }
+
+  if (resume)
+  {
+    const uint64_t payload = static_cast<uint64_t>(st.st_size) - sizeof(header);
+    record_count_ = payload / sizeof(ErrorTransition);
+    // 上次异常退出可能留下不完整的记录，截断到最后一条完整记录
+    if (payload % sizeof(ErrorTransition) != 0 &&
+        ::truncate(filename.c_str(), static_cast<off_t>(sizeof(header) + record_count_ * sizeof(ErrorTransition))) != 0)
+    {
+      return false;
+    }
+    file_ = std::fopen(filename.c_str(), "ab");
+  }
+  else
+  {
+    record_count_ = 0;
+    file_ = std::fopen(filename.c_str(), "wb");
+    if (file_)
+    {
+      std::fwrite(&header, sizeof(header), 1, file_);
+    }
+  }
+
+  if (!file_)
+  {
+    return false;
+  }
+  std::setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER_BYTES);
+  return true;
+}
+
+void ErrorEventFile::append(const ErrorTransition *events, int count)
+{
+  if (!file_ || count <= 0)
+  {
+    return;
+  }
+  std::fwrite(events, sizeof(ErrorTransition), static_cast<size_t>(count), file_);
+  record_count_ += static_cast<uint64_t>(count);
+}
+
+void ErrorEventFile::flush()
+{
+  if (file_)
+  {
+    std::fflush(file_);
+  }
+}
+
+void ErrorEventFile::close()
+{
+  if (file_)
+  {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+uint64_t ErrorEventFile::bytesWritten() const
+{
+  return sizeof(ErrorEventHeader) + record_count_ * sizeof(ErrorTransition);
+}
+
+// ============================ 读取与查询 ============================
+
+std::string errorEventFilename(const std::string &log_filename)
+{
+  return log_filename + ".events";
+}
+
+bool readErrorEvents(const std::string &filename, std::vector<ErrorTransition> &events, std::string *error)
+{
+  events.clear();
+  std::FILE *file = std::fopen(filename.c_str(), "rb");
+  if (!file)
+  {
+    setError(error, "无法打开事件文件: " + filename);
+    return false;
+  }
+
+  ErrorEventHeader header{};
+  if (std::fread(&header, sizeof(header), 1, file) != 1 || !validHeader(header))
+  {
+    std::fclose(file);
+    setError(error, "不是有效的事件文件: " + filename);
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(fileno(file), &st) == 0 && static_cast<uint64_t>(st.st_size) > sizeof(header))
+  {
+    events.resize((static_cast<uint64_t>(st.st_size) - sizeof(header)) / sizeof(ErrorTransition));
+    events.resize(std::fread(events.data(), sizeof(ErrorTransition), events.size(), file));
+  }
+  std::fclose(file);
+  return true;
+}
+
+std::vector<size_t> findErrorEvents(const std::vector<ErrorTransition> &events, const ErrorEventFilter &filter,
+                                    size_t max_results)
+{
+  // 事件按时间追加，时间范围用二分查找确定，范围内再按电机和错误码线性过滤
+  auto by_stamp = [](const ErrorTransition &e, double t)
+  { return e.stamp < t; };
+  const auto first = filter.begin_stamp >= 0.0
+                         ? std::lower_bound(events.begin(), events.end(), filter.begin_stamp, by_stamp)
+                         : events.begin();
+  const auto last = filter.end_stamp >= 0.0 ? std::lower_bound(first, events.end(), filter.end_stamp, by_stamp)
+                                            : events.end();
+
+  std::vector<size_t> result;
+  for (auto it = first; it != last; ++it)
+  {
+    if ((filter.motor >= 0 && it->motor != filter.motor) || (filter.code >= 0 && it->new_code != filter.code))
+    {
+      continue;
+    }
+    result.push_back(static_cast<size_t>(it - events.begin()));
+    if (max_results > 0 && result.size() >= max_results)
+    {
+      break;
+    }
+  }
+  return result;
+}
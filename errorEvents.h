@@ -0,0 +1,168 @@
+/**
+ * @file errorEvents.h
+ * @brief 错误码跳变事件：跟踪、紧凑事件索引文件（日志旁的 .events）和查询
+ * @author mafangniu
+ * @date 2025-05-11
+ *
+ * @details
+ * 错误信息原先只存在于逐帧的日志中（以及界面使用的最后值快照），要找出 "Motor7 第一次报 DRV驱动错误(7) 是什么时候"
+ * 只能扫描整个日志。本模块只记录每个电机错误码的变化：
+ *
+ * - ErrorTransitionTracker 逐帧比较各电机的错误码（与界面相同按 error_ + 0.5 取整），
+ *   错误码变化时生成一条 ErrorTransition {时间戳, 电机, 旧错误码, 新错误码, 旧错误码持续时长}；
+ *   某个电机第一次出现时，只有错误码非 0 才生成事件（旧错误码为 ERROR_CODE_UNKNOWN）；
+ * - 日志写线程把每个分段的事件写入同名 + ".events" 文件（ErrorEventFile）：
+ *   16 字节文件头 + 定长 32 字节记录，按时间顺序追加，与 .idx 一样不压缩；
+ * - readErrorEvents() 一次读入整个事件文件（通常只有几 KB），按电机、错误码、时间范围过滤，
+ *   命令行工具见 tools/motor_error_events.cpp；
+ * - 发布线程用同样的跟踪器把跳变发布为稀疏曲线 _events/Motor7/error_code（只在跳变时刻有点）
+ *   和文本序列 _events/Motor7/transition（"无错误 -> DRV驱动错误"），可在 PlotJuggler 中作为事件标记查看。
+ *
+ * 所有数值按本机字节序（x86/ARM 小端）写入。
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "motorData.h"
+
+static constexpr char ERROR_EVENT_MAGIC[8] = {'P', 'J', 'M', 'E', 'V', 'T', 'S', '1'};
+static constexpr uint32_t ERROR_EVENT_VERSION = 1;
+static constexpr int32_t ERROR_CODE_UNKNOWN = -1; // 跳变前的错误码未知（该电机在本文件中第一次出现）
+
+// 事件文件头
+struct ErrorEventHeader
+{
+  char magic[8];        // ERROR_EVENT_MAGIC
+  uint32_t version;     // ERROR_EVENT_VERSION
+  uint32_t record_size; // 每条记录字节数（sizeof(ErrorTransition)）
+};
+
+// 一次错误码跳变（事件文件中的一条记录）
+struct ErrorTransition
+{
+  double stamp;     // 跳变时刻（帧时间戳，秒，Unix 时间）
+  double duration;  // 旧错误码持续的时长（秒），旧错误码未知时为 0
+  int32_t old_code; // 旧错误码，ERROR_CODE_UNKNOWN 表示未知
+  int32_t new_code; // 新错误码
+  uint16_t motor;   // 电机序号（从 0 开始，与曲线名 Motor<n> 差 1）
+  uint16_t reserved1;
+  uint32_t reserved2;
+};
+static_assert(sizeof(ErrorTransition) == 32, "ErrorTransition must stay 32 bytes (on-disk record)");
+
+/**
+ * @brief 从原始电机数据取错误码（与错误类型界面的取整方式相同）
+ */
+inline int32_t motorErrorCode(const InteractiveMotorData &motor)
+{
+  return static_cast<int32_t>(motor.error_ + 0.5);
+}
+
+/**
+ * @class ErrorTransitionTracker
+ * @brief 逐帧检测各电机错误码的变化（只在一个线程中使用，不分配内存）
+ */
+class ErrorTransitionTracker
+{
+public:
+  /**
+   * @brief 忘记所有电机的错误码（打开新的日志分段时调用，之后每个电机第一次出现按首次出现处理）
+   */
+  void reset();
+
+  /**
+   * @brief 检查一帧中各电机的错误码
+   * @param frame 原始帧（时间戳取 frame.stamp）
+   * @param out   输出的跳变事件，需至少容纳 MAX_MOTOR_COUNT 条
+   * @return 本帧的跳变事件数
+   */
+  int observe(const RawMotorFrame &frame, ErrorTransition *out);
+
+private:
+  struct MotorState
+  {
+    bool seen = false;   ///< 是否已出现过
+    int32_t code = 0;    ///< 当前错误码
+    double since = 0.0;  ///< 当前错误码开始的时刻
+  };
+  std::array<MotorState, MAX_MOTOR_COUNT> motors_{};
+};
+
+/**
+ * @class ErrorEventFile
+ * @brief 事件文件写入器（只在写线程中使用）
+ */
+class ErrorEventFile
+{
+public:
+  ErrorEventFile() = default;
+  ~ErrorEventFile();
+
+  ErrorEventFile(const ErrorEventFile &) = delete;
+  ErrorEventFile &operator=(const ErrorEventFile &) = delete;
+
+  /**
+   * @brief 打开（或续写）事件文件
+   * @param filename 事件文件名（通常为日志分段文件名 + ".events"）
+   * @return 成功返回 true
+   *
+   * 文件已存在且文件头匹配时在末尾续写（截断不完整的最后一条记录），否则重新创建。
+   */
+  bool open(const std::string &filename);
+
+  /**
+   * @brief 追加若干条事件
+   */
+  void append(const ErrorTransition *events, int count);
+
+  void flush();
+  void close();
+  bool isOpen() const { return file_ != nullptr; }
+
+  /**
+   * @brief 文件的总字节数（含续写前已有的记录）
+   */
+  uint64_t bytesWritten() const;
+
+private:
+  std::FILE *file_ = nullptr;
+  uint64_t record_count_ = 0;
+};
+
+/**
+ * @brief 事件文件名：日志分段文件名 + ".events"
+ */
+std::string errorEventFilename(const std::string &log_filename);
+
+/**
+ * @brief 读取整个事件文件
+ * @param filename 事件文件名
+ * @param events   输出的事件（按时间顺序），末尾不完整的记录被忽略
+ * @param error    失败时写入原因（可为 nullptr）
+ * @return 文件头有效返回 true
+ */
+bool readErrorEvents(const std::string &filename, std::vector<ErrorTransition> &events, std::string *error = nullptr);
+
+// 事件查询条件（各条件同时满足）
+struct ErrorEventFilter
+{
+  int motor = -1;            // 电机序号（从 0 开始），-1 表示所有电机
+  int32_t code = -1;         // 跳变后的错误码，-1 表示任意
+  double begin_stamp = -1.0; // 时间范围起点（含），< 0 表示不限
+  double end_stamp = -1.0;   // 时间范围终点（不含），< 0 表示不限
+};
+
+/**
+ * @brief 按条件查询事件
+ * @param events 按时间顺序排列的事件（readErrorEvents() 的结果）
+ * @param filter 查询条件，时间范围按二分查找确定
+ * @param max_results 最多返回的事件数，0 表示不限（例如只要第一次出现时传 1）
+ * @return 满足条件的事件在 events 中的下标（按时间顺序）
+ */
+std::vector<size_t> findErrorEvents(const std::vector<ErrorTransition> &events, const ErrorEventFilter &filter,
+                                    size_t max_results = 0);
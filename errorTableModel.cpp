@@ -0,0 +1,209 @@
+/**
+ * @file errorTableModel.cpp
+ * @author mafangniu
+ * @brief 电机错误类型显示界面的数据模型实现
+ * @version 1.0
+ * @date 2025-05-04
+ */
+
+#include "errorTableModel.h"
+
+#include <QColor>
+
+#include <algorithm>
+
+MotorErrorTableModel::MotorErrorTableModel(ErrorTextFunction error_text, QObject *parent)
+    : QAbstractTableModel(parent),
+      error_text_(std::move(error_text)),
+      ok_text_(QColor(Qt::black)),
+      error_text_brush_(QColor(Qt::red)),
+      error_background_(QColor(255, 228, 228)),
+      idle_text_(QColor(Qt::gray)),
+      alarm_text_(QColor(200, 90, 0)),
+      alarm_background_(QColor(255, 240, 210))
+{
+}
+
+void MotorErrorTableModel::addSource(const QString &name, const MotorErrorSnapshot *snapshot)
+{
+  Source source;
+  source.name = name;
+  source.snapshot = snapshot;
+  source.first_row = row_count_;
+  sources_.push_back(source);
+}
+
+void MotorErrorTableModel::setAlarmLabels(const QStringList &labels)
+{
+  alarm_labels_ = labels;
+  for (Source &source : sources_)
+  {
+    for (int m = 0; m < source.alarms.size(); ++m)
+    {
+      source.alarm_texts[m] = alarmText(source.alarms[m]);
+    }
+  }
+  if (row_count_ > 0)
+  {
+    emit dataChanged(index(0, 2), index(row_count_ - 1, 2), {Qt::DisplayRole});
+  }
+}
+
+QString MotorErrorTableModel::alarmText(uint32_t mask) const
+{
+  QStringList active;
+  for (int r = 0; r < 32; ++r)
+  {
+    if (mask & (1u << r))
+    {
+      active << (r < alarm_labels_.size() ? alarm_labels_[r] : QString("#%1").arg(r + 1));
+    }
+  }
+  return active.join(", ");
+}
+
+int MotorErrorTableModel::refresh()
+{
+  int changed_rows = 0;
+  for (int s = 0; s < sources_.size(); ++s)
+  {
+    Source &source = sources_[s];
+    const uint32_t generation = source.snapshot->generation.load(std::memory_order_acquire);
+    if (generation == source.seen_generation)
+    {
+      continue; // 该数据源自上次刷新后没有变化
+    }
+    source.seen_generation = generation;
+
+    // 电机数增长时在该数据源末尾插入新行，后续数据源整体下移
+    const int motor_count = std::min<int>(source.snapshot->motor_count.load(std::memory_order_relaxed), MAX_MOTOR_COUNT);
+    const int old_count = source.shown.size();
+    if (motor_count > old_count)
+    {
+      beginInsertRows(QModelIndex(), source.first_row + old_count, source.first_row + motor_count - 1);
+      source.shown.resize(motor_count);
+      source.texts.resize(motor_count);
+      source.alarms.resize(motor_count);
+      source.alarm_texts.resize(motor_count);
+      for (int m = old_count; m < motor_count; ++m)
+      {
+        source.shown[m] = MotorErrorSnapshot::NO_VALUE;
+        source.texts[m] = "N/A";
+        source.alarms[m] = 0;
+      }
+      row_count_ += motor_count - old_count;
+      for (int t = s + 1; t < sources_.size(); ++t)
+      {
+        sources_[t].first_row += motor_count - old_count;
+      }
+      endInsertRows();
+    }
+
+    for (int m = 0; m < source.shown.size(); ++m)
+    {
+      const int32_t code = source.snapshot->codes[m].load(std::memory_order_relaxed);
+      const uint32_t alarms = source.snapshot->alarms[m].load(std::memory_order_relaxed);
+      const bool code_changed = code != source.shown[m];
+      const bool alarms_changed = alarms != source.alarms[m];
+      if (!code_changed && !alarms_changed)
+      {
+        continue;
+      }
+      if (code_changed)
+      {
+        source.shown[m] = code;
+        source.texts[m] = (code == MotorErrorSnapshot::NO_VALUE) ? QString("N/A")
+                                                                  : QString("%1 (%2)").arg(error_text_(code)).arg(code);
+      }
+      if (alarms_changed)
+      {
+        source.alarms[m] = alarms;
+        source.alarm_texts[m] = alarmText(alarms);
+      }
+      emit dataChanged(index(source.first_row + m, code_changed ? 1 : 2), index(source.first_row + m, alarms_changed ? 2 : 1),
+                       {Qt::DisplayRole, Qt::ForegroundRole, Qt::BackgroundRole});
+      ++changed_rows;
+    }
+  }
+  return changed_rows;
+}
+
+int MotorErrorTableModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : row_count_;
+}
+
+int MotorErrorTableModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : 3;
+}
+
+bool MotorErrorTableModel::locate(int row, const Source **source, int *motor) const
+{
+  for (const Source &candidate : sources_)
+  {
+    if (row >= candidate.first_row && row < candidate.first_row + candidate.shown.size())
+    {
+      *source = &candidate;
+      *motor = row - candidate.first_row;
+      return true;
+    }
+  }
+  return false;
+}
+
+QVariant MotorErrorTableModel::data(const QModelIndex &index, int role) const
+{
+  const Source *source = nullptr;
+  int motor = 0;
+  if (!index.isValid() || !locate(index.row(), &source, &motor))
+  {
+    return QVariant();
+  }
+
+  const int32_t code = source->shown[motor];
+  switch (role)
+  {
+  case Qt::DisplayRole:
+    if (index.column() == 0)
+    {
+      return source->name.isEmpty() ? QString("Motor[%1]").arg(motor + 1)
+                                    : QString("%1 Motor[%2]").arg(source->name).arg(motor + 1);
+    }
+    return index.column() == 1 ? source->texts[motor] : source->alarm_texts[motor];
+  case Qt::ForegroundRole:
+    if (index.column() == 1)
+    {
+      if (code == MotorErrorSnapshot::NO_VALUE)
+        return idle_text_;
+      return code == 0 ? ok_text_ : error_text_brush_;
+    }
+    return index.column() == 2 ? alarm_text_ : ok_text_;
+  case Qt::BackgroundRole:
+    if (index.column() == 1 && code > 0)
+    {
+      return error_background_;
+    }
+    if (index.column() == 2 && source->alarms[motor] != 0)
+    {
+      return alarm_background_;
+    }
+    return QVariant();
+  default:
+    return QVariant();
+  }
+}
+
+QVariant MotorErrorTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+  {
+    return QVariant();
+  }
+  static const char *const HEADERS[] = {"Motor", "Error", "Alarm"};
+  if (section < 0 || section >= 3)
+  {
+    return QVariant();
+  }
+  return QString(HEADERS[section]);
+}
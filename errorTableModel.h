@@ -0,0 +1,178 @@
+/**
+ * @file errorTableModel.h
+ * @author mafangniu
+ * @brief 电机错误类型显示界面的数据模型（Motor Errors 窗口）
+ * @version 1.0
+ * @date 2025-05-04
+ *
+ * @details
+ * 原实现在每次错误码变化时向每个 QLabel 投递两次 invokeMethod（setStyleSheet + setText），
+ * 编码器错误以数据报速率反复跳变时，界面事件队列被塞满，样式表重新 polish 占满 CPU。现改为：
+ * - 发布线程只把每个电机的错误码原子地写入 MotorErrorSnapshot（不投递任何界面事件）；
+ * - 界面线程的定时器以固定频率调用 MotorErrorTableModel::refresh()，读取快照，
+ *   只对错误码发生变化的行发出 dataChanged，由 QTableView 重绘这些行；
+ * - 文字颜色/底色使用预先构造的几种画刷（ForegroundRole / BackgroundRole），不再每次设置样式表。
+ *
+ * 两次刷新之间的跳变只显示最后的值，跳变次数可在接收统计和日志中查看。
+ *
+ * 第三列 Alarm 显示滑动窗口告警（见 motorAlarms.h）：发布线程把各电机的告警掩码写入同一快照，
+ * 有告警的行以橙色显示触发的规则，在驱动报错之前给出预警。
+ */
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QBrush>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "motorPacket.h"
+
+/**
+ * @brief 一个数据源各电机错误码的快照（发布线程写，界面线程读，无锁）
+ */
+struct MotorErrorSnapshot
+{
+  MotorErrorSnapshot()
+  {
+    for (std::atomic<int32_t> &code : codes)
+    {
+      code.store(NO_VALUE, std::memory_order_relaxed);
+    }
+    for (std::atomic<uint32_t> &mask : alarms)
+    {
+      mask.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static constexpr int32_t NO_VALUE = -1; ///< 尚未收到数据（显示 N/A）
+
+  /**
+   * @brief 写入一个电机的错误码（值未变化时不修改快照）
+   */
+  void publish(int motor, int32_t code)
+  {
+    if (motor < 0 || motor >= MAX_MOTOR_COUNT)
+    {
+      return;
+    }
+    if (codes[motor].load(std::memory_order_relaxed) != code)
+    {
+      codes[motor].store(code, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /**
+   * @brief 写入一个电机的告警掩码（第 r 位对应第 r 条告警规则，值未变化时不修改快照）
+   */
+  void publishAlarms(int motor, uint32_t mask)
+  {
+    if (motor < 0 || motor >= MAX_MOTOR_COUNT)
+    {
+      return;
+    }
+    if (alarms[motor].load(std::memory_order_relaxed) != mask)
+    {
+      alarms[motor].store(mask, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /**
+   * @brief 更新电机数（电机数增长时界面表格自动增加行）
+   */
+  void setMotorCount(int count)
+  {
+    if (motor_count.load(std::memory_order_relaxed) != count)
+    {
+      motor_count.store(count, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  std::array<std::atomic<int32_t>, MAX_MOTOR_COUNT> codes; ///< 各电机最新错误码
+  std::array<std::atomic<uint32_t>, MAX_MOTOR_COUNT> alarms; ///< 各电机的告警掩码
+  std::atomic<int> motor_count{0};                         ///< 已注册的电机数
+  std::atomic<uint32_t> generation{0};                     ///< 任意内容变化时加 1，界面据此跳过未变化的数据源
+};
+
+/**
+ * @class MotorErrorTableModel
+ * @brief 三列（Motor / Error / Alarm）的只读表格模型，数据来自若干数据源的 MotorErrorSnapshot
+ *
+ * @note 只在界面线程中使用
+ */
+class MotorErrorTableModel : public QAbstractTableModel
+{
+public:
+  /// 错误码 -> 文本描述
+  using ErrorTextFunction = std::function<QString(int)>;
+
+  explicit MotorErrorTableModel(ErrorTextFunction error_text, QObject *parent = nullptr);
+
+  /**
+   * @brief 添加一个数据源（在添加到视图之前调用）
+   * @param name     数据源名称（单数据源未命名时为空，行名为 Motor[n]）
+   * @param snapshot 该数据源的错误码快照，生存期须长于模型
+   */
+  void addSource(const QString &name, const MotorErrorSnapshot *snapshot);
+
+  /**
+   * @brief 设置告警规则的名称（告警掩码第 r 位显示为 labels[r]），告警配置修改后调用
+   */
+  void setAlarmLabels(const QStringList &labels);
+
+  /**
+   * @brief 读取所有快照，增加新电机的行，并只对错误码或告警变化的行发出 dataChanged（界面定时器调用）
+   * @return 变化的行数
+   */
+  int refresh();
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+  struct Source
+  {
+    QString name;
+    const MotorErrorSnapshot *snapshot = nullptr;
+    uint32_t seen_generation = 0; ///< 上次 refresh() 时的快照版本
+    int first_row = 0;            ///< 该数据源第一行在表格中的行号
+    QVector<int32_t> shown;       ///< 当前显示的错误码（下标为电机序号）
+    QVector<QString> texts;       ///< 当前显示的文本（只在错误码变化时重新生成）
+    QVector<uint32_t> alarms;     ///< 当前显示的告警掩码
+    QVector<QString> alarm_texts; ///< 当前显示的告警文本（只在告警变化时重新生成）
+  };
+
+  /**
+   * @brief 根据行号找到数据源和电机序号
+   */
+  bool locate(int row, const Source **source, int *motor) const;
+
+  /**
+   * @brief 告警掩码 -> 触发的规则名称（以逗号分隔）
+   */
+  QString alarmText(uint32_t mask) const;
+
+  ErrorTextFunction error_text_;
+  QVector<Source> sources_;
+  int row_count_ = 0;
+  QStringList alarm_labels_;
+
+  // 预先构造的画刷：无错误黑字白底，有错误红字浅红底，无数据灰字
+  QBrush ok_text_;
+  QBrush error_text_brush_;
+  QBrush error_background_;
+  QBrush idle_text_;
+  QBrush alarm_text_;
+  QBrush alarm_background_;
+};
@@ -0,0 +1,170 @@
+/**
+ * @file flightRecorder.h
+ * @author mafangniu
+ * @brief 错误前数据的"黑匣子"环形缓冲
+ * @version 1.0
+ * @date 2025-04-16
+ *
+ * @details
+ * 仅错误记录模式下，需要保留错误发生前一段时间的原始帧作为触发前上下文：
+ * - 容量在构造（或 reset）时按预计帧率一次性分配，之后每帧只做一次拷贝；
+ * - 实际帧率更高、缓冲满时覆盖不了整个触发前窗口时容量翻倍（最多 max_capacity 帧，只在开始接收后的头几秒内发生），
+ *   达到上限后 limited() 返回 true，窗口按实际能保存的帧数缩短；
+ * - 缓冲满时覆盖最旧的帧，内存占用与运行时长无关；
+ * - 检测到错误上升沿时调用 swapStorage() 把帧存储整体交给日志写线程（不拷贝帧，见 AsyncLogWriter::submitRecording()），
+ *   或调用 flush() 按时间顺序取出触发前窗口内的帧。
+ *
+ * @note 只在 UDP 接收线程中使用，不做线程同步。
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "motorData.h"
+
+class FlightRecorder
+{
+public:
+  /**
+   * @brief 构造函数
+   * @param capacity 最多保存的帧数
+   */
+  explicit FlightRecorder(size_t capacity = 0)
+  {
+    reset(capacity);
+  }
+
+  /**
+   * @brief 重新分配容量并清空缓冲（仅在接收开始前调用）
+   * @param capacity 最多保存的帧数
+   * @param window_s 触发前窗口（秒），缓冲满时覆盖不了该窗口则扩大容量；0 表示容量固定
+   * @param max_capacity 扩大容量的上限（帧）
+   */
+  void reset(size_t capacity, double window_s = 0.0, size_t max_capacity = 0)
+  {
+    frames_.assign(capacity, RawMotorFrame{});
+    window_s_ = window_s;
+    max_capacity_ = std::max(max_capacity, capacity);
+    limited_ = false;
+    head_ = 0;
+    count_ = 0;
+  }
+
+  /**
+   * @brief 保存一帧，缓冲满时覆盖最旧的帧
+   */
+  void push(const RawMotorFrame &frame)
+  {
+    if (frames_.empty())
+    {
+      return;
+    }
+    // 缓冲已满而最旧的帧仍在窗口内（留 5% 余量，避免帧时间抖动引起扩容）：帧率高于预计，扩大容量
+    if (count_ == frames_.size() && frame.stamp - frames_[head_].stamp < 0.95 * window_s_)
+    {
+      if (frames_.size() < max_capacity_)
+      {
+        grow(std::min(max_capacity_, frames_.size() * 2));
+      }
+      else
+      {
+        limited_ = true;
+      }
+    }
+    frames_[head_] = frame;
+    head_ = (head_ + 1) % frames_.size();
+    if (count_ < frames_.size())
+    {
+      ++count_;
+    }
+  }
+
+  /**
+   * @brief 按时间顺序取出时间戳不早于 since_stamp 的帧，然后清空缓冲
+   * @param since_stamp 触发前窗口的起始时间（秒）
+   * @param fn 对每一帧调用的回调，签名为 void(const RawMotorFrame &)
+   */
+  template <typename Fn>
+  void flush(double since_stamp, Fn &&fn)
+  {
+    const size_t capacity = frames_.size();
+    size_t index = (head_ + capacity - count_) % (capacity ? capacity : 1);
+    for (size_t i = 0; i < count_; ++i)
+    {
+      const RawMotorFrame &frame = frames_[index];
+      if (frame.stamp >= since_stamp)
+      {
+        fn(frame);
+      }
+      index = (index + 1) % capacity;
+    }
+    count_ = 0;
+  }
+
+  /**
+   * @brief 与外部存储交换帧存储（已保存的帧整体交出，不拷贝），然后清空缓冲
+   * @param storage 交换的存储；返回时为原缓冲的存储（环形，最旧的帧在 first 处，共 count 帧）。
+   *                传入的存储容量与本缓冲不同时（本缓冲扩大过容量）按本缓冲的容量重新分配
+   * @param first 输出：最旧的帧在 storage 中的下标
+   * @param count 输出：交出的帧数
+   */
+  void swapStorage(std::vector<RawMotorFrame> &storage, size_t &first, size_t &count)
+  {
+    const size_t capacity = frames_.size();
+    first = capacity ? (head_ + capacity - count_) % capacity : 0;
+    count = count_;
+    frames_.swap(storage);
+    if (frames_.size() != capacity)
+    {
+      frames_.assign(capacity, RawMotorFrame{});
+    }
+    head_ = 0;
+    count_ = 0;
+  }
+
+  size_t size() const { return count_; }
+  size_t capacity() const { return frames_.size(); }
+
+  /**
+   * @brief 容量已达上限且仍覆盖不了整个触发前窗口（帧率过高）
+   */
+  bool limited() const { return limited_; }
+
+  /**
+   * @brief 缓冲中最旧与最新帧的时间差（秒）
+   */
+  double span() const
+  {
+    if (count_ == 0)
+    {
+      return 0.0;
+    }
+    const size_t capacity = frames_.size();
+    return frames_[(head_ + capacity - 1) % capacity].stamp - frames_[(head_ + capacity - count_) % capacity].stamp;
+  }
+
+private:
+  /**
+   * @brief 扩大容量，按时间顺序保留已保存的帧
+   */
+  void grow(size_t capacity)
+  {
+    std::vector<RawMotorFrame> frames(capacity);
+    const size_t old_capacity = frames_.size();
+    for (size_t i = 0; i < count_; ++i)
+    {
+      frames[i] = frames_[(head_ + old_capacity - count_ + i) % old_capacity];
+    }
+    frames_.swap(frames);
+    head_ = count_;
+  }
+
+  std::vector<RawMotorFrame> frames_; ///< 预分配的帧存储
+  size_t head_ = 0;                   ///< 下一帧写入位置
+  size_t count_ = 0;                  ///< 当前保存的帧数
+  double window_s_ = 0.0;             ///< 触发前窗口（秒）
+  size_t max_capacity_ = 0;           ///< 扩大容量的上限（帧）
+  bool limited_ = false;              ///< 容量已达上限仍覆盖不了窗口
+};
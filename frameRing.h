@@ -0,0 +1,127 @@
+/**
+ * @file frameRing.h
+ * @author mafangniu
+ * @brief 单生产者/单消费者（SPSC）无锁环形队列
+ * @version 1.0
+ * @date 2025-04-10
+ *
+ * @details
+ * 用于在 UDP 接收线程（生产者）与 PlotJuggler 发布线程（消费者）之间传递固定大小的原始数据帧：
+ * - 容量在构造时一次性分配（向上取整为 2 的幂），运行过程中不再分配内存；
+ * - 生产者只写 head_，消费者只写 tail_，两端均不加锁，接收线程永远不会因界面阻塞；
+ * - 队列满时 tryPush() 直接返回 false，由调用者统计丢帧，不覆盖未消费的数据。
+ *
+ * @note 只允许一个线程调用 tryPush()，一个线程调用 tryPop()/drain()。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class SpscRing
+{
+public:
+  /**
+   * @brief 构造函数
+   * @param capacity 期望容量（帧数），实际容量向上取整为 2 的幂
+   */
+  explicit SpscRing(size_t capacity)
+  {
+    size_t cap = 2;
+    while (cap < capacity)
+    {
+      cap <<= 1;
+    }
+    buffer_.resize(cap);
+    mask_ = cap - 1;
+  }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /**
+   * @brief 入队一帧（仅生产者线程调用）
+   * @param item 待入队的帧
+   * @return 入队成功返回 true，队列已满返回 false
+   */
+  bool tryPush(const T &item)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail > mask_)
+    {
+      return false; // 队列已满
+    }
+    buffer_[head & mask_] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief 出队一帧（仅消费者线程调用）
+   * @param item 输出参数，保存出队的帧
+   * @return 出队成功返回 true，队列为空返回 false
+   */
+  bool tryPop(T &item)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    if (tail == head)
+    {
+      return false;
+    }
+    item = buffer_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief 批量出队（仅消费者线程调用）
+   * @param out 输出数组，至少可容纳 max_count 帧
+   * @param max_count 本次最多取出的帧数
+   * @return 实际取出的帧数
+   *
+   * 一次读取 head_，把当前可见的所有帧（最多 max_count）拷出后再统一推进 tail_。
+   */
+  size_t drain(T *out, size_t max_count)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    size_t count = head - tail;
+    if (count > max_count)
+    {
+      count = max_count;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+      out[i] = buffer_[(tail + i) & mask_];
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief 当前队列中的帧数（近似值，仅用于统计）
+   */
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief 队列容量（帧数）
+   */
+  size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+private:
+  std::vector<T> buffer_; ///< 预分配的帧存储
+  size_t mask_ = 0;       ///< 容量 - 1，用于取模
+  alignas(64) std::atomic<size_t> head_{0}; ///< 生产者写入位置（单调递增）
+  alignas(64) std::atomic<size_t> tail_{0}; ///< 消费者读取位置（单调递增）
+};
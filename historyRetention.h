@@ -0,0 +1,85 @@
+/**
+ * @file historyRetention.h
+ * @author mafangniu
+ * @brief 插件暂存数据表（dataMap()）中曲线点数的上限（按时间窗口和点数批量裁剪）
+ * @version 1.0
+ * @date 2025-05-14
+ *
+ * @details
+ * 插件推送的点先进入插件自己的 dataMap()，PlotJuggler 每次刷新界面时把其中的点全部移入主界面的曲线并清空，
+ * 正常显示时 dataMap() 中只有两次刷新之间的点，这里的上限不起作用。
+ * PlotJuggler 主界面中曲线保留多长的历史由其主界面的 Buffer 设置（秒）决定，插件无法裁剪，
+ * 长时间运行时限制内存应调整该设置。
+ *
+ * 只有 PlotJuggler 暂停（或停止取数据）时，点在 dataMap() 中持续累积，保持最后值模式下 loop() 还会额外以 50Hz 推送，
+ * 暂停越久内存越大。保留策略给暂存的每条曲线设置两个上限：
+ * - max_seconds：只保留最后一个点之前 max_seconds 秒内的点；
+ * - max_points：每条曲线最多保留的点数，与帧率无关，内存占用可按 曲线数 x 点数 x 16 字节 预估。
+ *
+ * 发布线程每个统计周期（0.5 秒）在一次 mutex() 加锁内裁剪所有曲线（trimSeriesHistory()），
+ * 推送时不做任何检查；两次裁剪之间最多超出半秒的数据。恢复显示后，PlotJuggler 只能取到暂停期间被保留的点。
+ *
+ * @note 只在发布线程中（持有 PlotJuggler mutex 时）使用，不做线程同步。
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief 暂存曲线的保留策略（各项为 0 表示不限制）
+ */
+struct HistoryRetentionPolicy
+{
+  double max_seconds = 0.0; ///< 时间窗口（秒）
+  size_t max_points = 0;    ///< 每条曲线最多保留的点数
+
+  bool enabled() const { return max_seconds > 0.0 || max_points > 0; }
+};
+
+/**
+ * @brief 按保留策略裁剪一条曲线最旧的点
+ * @tparam Series PJ::PlotData 或 PJ::StringSeries（需要 size()、at()、back()、popFront()）
+ * @param series 曲线
+ * @param policy 保留策略
+ * @return 删除的点数
+ *
+ * 先二分查找时间窗口起点，再与点数上限取较大的删除数，一次性从头部删除。
+ */
+template <class Series>
+size_t trimSeriesHistory(Series &series, const HistoryRetentionPolicy &policy)
+{
+  const size_t size = series.size();
+  if (size == 0)
+  {
+    return 0;
+  }
+
+  size_t drop = (policy.max_points > 0 && size > policy.max_points) ? size - policy.max_points : 0;
+  if (policy.max_seconds > 0.0)
+  {
+    // 第一个 x >= 最后时刻 - 窗口 的点之前的都删除（点按时间递增）
+    const double oldest = series.back().x - policy.max_seconds;
+    size_t lo = drop;
+    size_t hi = size;
+    while (lo < hi)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (series.at(mid).x < oldest)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    drop = lo;
+  }
+
+  for (size_t i = 0; i < drop; ++i)
+  {
+    series.popFront();
+  }
+  return drop;
+}
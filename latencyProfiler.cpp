@@ -0,0 +1,77 @@
+/**
+ * @file latencyProfiler.cpp
+ * @brief 热路径分阶段延迟统计实现
+ * @author mafangniu
+ * @date 2025-04-28
+ */
+
+#include "latencyProfiler.h"
+
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+double LatencyHistogram::percentile(const Counts &counts, double quantile)
+{
+  uint64_t total = 0;
+  for (uint64_t c : counts)
+  {
+    total += c;
+  }
+  if (total == 0)
+  {
+    return 0.0;
+  }
+
+  // 第一个累计计数达到 quantile * total 的桶
+  const double target = quantile * static_cast<double>(total);
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKET_COUNT; ++i)
+  {
+    seen += counts[i];
+    if (counts[i] > 0 && static_cast<double>(seen) >= target)
+    {
+      return static_cast<double>(bucketLowerBound(i)) + 0.5 * static_cast<double>(bucketWidth(i) - 1);
+    }
+  }
+  return static_cast<double>(bucketLowerBound(BUCKET_COUNT - 1));
+}
+
+std::string LatencyProfiler::report() const
+{
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  out << "# 延迟直方图（累计，单位 us）" << (enabled() ? "" : "（当前未启用）") << "\n";
+
+  auto counts = std::make_unique<LatencyHistogram::Counts>();
+  for (int s = 0; s < LATENCY_STAGE_COUNT; ++s)
+  {
+    const LatencyHistogram &histogram = stages_[s];
+    histogram.snapshot(*counts);
+    uint64_t total = 0;
+    for (uint64_t c : *counts)
+    {
+      total += c;
+    }
+
+    out << "\n[" << LATENCY_STAGE_NAMES[s] << "] count=" << total
+        << " p50=" << LatencyHistogram::percentile(*counts, 0.50) / 1000.0
+        << " p90=" << LatencyHistogram::percentile(*counts, 0.90) / 1000.0
+        << " p99=" << LatencyHistogram::percentile(*counts, 0.99) / 1000.0
+        << " p99.9=" << LatencyHistogram::percentile(*counts, 0.999) / 1000.0
+        << " max=" << histogram.max() / 1000.0 << "\n";
+
+    // 只输出非空桶：[下界, 上界) 计数
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i)
+    {
+      if ((*counts)[i] == 0)
+      {
+        continue;
+      }
+      const uint64_t lower = LatencyHistogram::bucketLowerBound(i);
+      out << "  [" << lower / 1000.0 << ", " << (lower + LatencyHistogram::bucketWidth(i)) / 1000.0 << ") "
+          << (*counts)[i] << "\n";
+    }
+  }
+  return out.str();
+}
@@ -0,0 +1,279 @@
+/**
+ * @file logRotation.cpp
+ * @brief 日志分段轮转、分段压缩与磁盘空间上限工具实现
+ * @author mafangniu
+ * @date 2025-04-18
+ */
+
+#include "logRotation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+#ifdef MOTOR_MONITOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+std::string logSegmentFilename(const std::string &base_filename, int index)
+{
+  const fs::path base(base_filename);
+  char suffix[16];
+  std::snprintf(suffix, sizeof(suffix), "_%03d", index);
+  fs::path segment = base.parent_path() / (base.stem().string() + suffix + base.extension().string());
+  return segment.string();
+}
+
+bool logCompressionAvailable()
+{
+#ifdef MOTOR_MONITOR_HAVE_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool compressLogFile(const std::string &filename, const std::atomic<bool> *cancel)
+{
+#ifdef MOTOR_MONITOR_HAVE_ZSTD
+  const std::string output = filename + ".zst";
+  std::FILE *in = std::fopen(filename.c_str(), "rb");
+  if (!in)
+  {
+    return false;
+  }
+  std::FILE *out = std::fopen(output.c_str(), "wb");
+  if (!out)
+  {
+    std::fclose(in);
+    return false;
+  }
+
+  ZSTD_CCtx *cctx = ZSTD_createCCtx();
+  ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 3);
+
+  // 固定大小的输入/输出缓冲，逐块流式压缩
+  std::vector<char> in_buf(ZSTD_CStreamInSize());
+  std::vector<char> out_buf(ZSTD_CStreamOutSize());
+  bool ok = true;
+  bool cancelled = false;
+  while (ok)
+  {
+    if (cancel && cancel->load(std::memory_order_relaxed))
+    {
+      ok = false;
+      cancelled = true;
+      break;
+    }
+    const size_t read = std::fread(in_buf.data(), 1, in_buf.size(), in);
+    const bool last_chunk = read < in_buf.size();
+    const ZSTD_EndDirective mode = last_chunk ? ZSTD_e_end : ZSTD_e_continue;
+    ZSTD_inBuffer input = {in_buf.data(), read, 0};
+    bool finished = false;
+    while (!finished)
+    {
+      ZSTD_outBuffer output_buf = {out_buf.data(), out_buf.size(), 0};
+      const size_t remaining = ZSTD_compressStream2(cctx, &output_buf, &input, mode);
+      if (ZSTD_isError(remaining) || std::fwrite(out_buf.data(), 1, output_buf.pos, out) != output_buf.pos)
+      {
+        ok = false;
+        break;
+      }
+      finished = last_chunk ? (remaining == 0) : (input.pos == input.size);
+    }
+    if (last_chunk)
+    {
+      break;
+    }
+  }
+  ok = ok && !std::ferror(in);
+
+  ZSTD_freeCCtx(cctx);
+  std::fclose(in);
+  ok = (std::fclose(out) == 0) && ok;
+
+  std::error_code ec;
+  if (!ok)
+  {
+    if (!cancelled)
+    {
+      std::cerr << "⚠️ 日志压缩失败，保留原文件: " << filename << std::endl;
+    }
+    fs::remove(output, ec);
+    return false;
+  }
+  if (!fs::remove(filename, ec))
+  {
+    fs::remove(output, ec); // 压缩期间原文件已因磁盘空间上限被删除
+  }
+  return true;
+#else
+  (void)filename;
+  (void)cancel;
+  return false;
+#endif
+}
+
+// ============================ LogCompressor ============================
+
+LogCompressor::~LogCompressor()
+{
+  stop();
+}
+
+void LogCompressor::enqueue(const std::string &filename)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(filename);
+    if (!running_)
+    {
+      running_ = true;
+      cancel_ = false;
+      thread_ = std::thread([this]()
+                            { this->run(); });
+    }
+  }
+  cv_.notify_one();
+}
+
+void LogCompressor::stop()
+{
+  size_t abandoned = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait_for(lock, std::chrono::milliseconds(COMPRESS_STOP_WAIT_MS), [this]()
+                      { return queue_.empty() && !busy_; });
+    running_ = false;
+    cancel_ = true;
+    abandoned = queue_.size();
+    queue_.clear();
+  }
+  cv_.notify_one();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+  if (abandoned > 0)
+  {
+    std::cerr << "⚠️ 停止时还有 " << abandoned << " 个日志分段未压缩，保留未压缩的原文件" << std::endl;
+  }
+}
+
+void LogCompressor::run()
+{
+  // 压缩是后台任务，降低调度优先级（nice 10），不与接收、发布线程争用 CPU
+  if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10) != 0)
+  {
+    std::cerr << "⚠️ 无法降低压缩线程优先级" << std::endl;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    cv_.wait(lock, [this]()
+             { return !running_ || !queue_.empty(); });
+    if (!running_)
+    {
+      break;
+    }
+    const std::string filename = queue_.front();
+    queue_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    if (!compressLogFile(filename, &cancel_) && cancel_)
+    {
+      std::cerr << "⚠️ 停止时放弃压缩，保留原文件: " << filename << std::endl;
+    }
+
+    lock.lock();
+    busy_ = false;
+    if (queue_.empty())
+    {
+      idle_cv_.notify_all();
+    }
+  }
+}
+
+int enforceLogDiskBudget(const std::string &base_filename, uint64_t budget_bytes, const std::string &active_filename)
+{
+  if (budget_bytes == 0)
+  {
+    return 0;
+  }
+
+  const fs::path base(base_filename);
+  const std::string prefix = base.stem().string(); // 同一次记录的所有分段都以该前缀开头
+  std::error_code ec;
+
+  struct Entry
+  {
+    fs::path path;
+    uint64_t size;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  for (const auto &item : fs::directory_iterator(base.parent_path(), ec))
+  {
+    if (!item.is_regular_file(ec))
+    {
+      continue;
+    }
+    const std::string name = item.path().filename().string();
+    if (name.compare(0, prefix.size(), prefix) != 0)
+    {
+      continue;
+    }
+    const uint64_t size = item.file_size(ec);
+    total += size;
+    entries.push_back({item.path(), size});
+  }
+
+  // 分段序号为定宽数字，按文件名排序即按时间从旧到新
+  std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+            { return a.path.filename().string() < b.path.filename().string(); });
+
+  const std::string active_name = fs::path(active_filename).filename().string();
+  int removed = 0;
+  for (const Entry &e : entries)
+  {
+    if (total <= budget_bytes)
+    {
+      break;
+    }
+    const std::string name = e.path.filename().string();
+    if (!active_name.empty() && name.compare(0, active_name.size(), active_name) == 0)
+    {
+      continue; // 正在写入的分段及其 .idx / .events
+    }
+    if (fs::remove(e.path, ec))
+    {
+      total -= e.size;
+      ++removed;
+      std::cout << "🗑️ 日志超出空间上限，已删除: " << e.path.string() << std::endl;
+
+      // 二进制分段的 .idx 和错误码事件文件 .events 随分段一起删除
+      for (const char *sidecar : {".idx", ".events"})
+      {
+        const fs::path sidecar_path = e.path.string() + sidecar;
+        const uint64_t sidecar_size = fs::exists(sidecar_path, ec) ? fs::file_size(sidecar_path, ec) : 0;
+        if (sidecar_size > 0 && fs::remove(sidecar_path, ec))
+        {
+          total -= std::min(total, sidecar_size);
+          ++removed;
+        }
+      }
+    }
+  }
+  return removed;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file logRotation.h
+ * @brief 日志分段轮转、分段压缩与磁盘空间上限工具头文件
+ * @author mafangniu
+ * @date 2025-04-18
+ *
+ * @details
+ * 长时间全时记录时单个日志文件会增长到数 GB，本模块为异步日志写线程提供：
+ * - 分段文件命名：full_log_<时间戳>.txt -> full_log_<时间戳>_000.txt、_001.txt ...；
+ * - 分段压缩：分段关闭后交给后台压缩线程（LogCompressor），以流式 zstd 压缩为 *.zst（固定 1MB 缓冲，内存占用恒定），
+ *   压缩成功后删除原文件。数 GB 的分段压缩要几十秒，放在日志写线程中会使其停止取帧、前台缓冲溢出，
+ *   因此写线程只把文件名放入队列；正在写入的分段保持不压缩，便于运行中查看，二进制日志在写入期间也可按索引定位；
+ * - 磁盘空间上限：统计同一次记录的所有分段（含 .idx 和 .events），超出上限时从最旧的分段开始删除。
+ *
+ * 压缩依赖 libzstd，编译时未找到 libzstd（未定义 MOTOR_MONITOR_HAVE_ZSTD）时分段保持不压缩。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief 日志轮转策略（各项为 0 表示不启用）
+ */
+struct LogRotationPolicy
+{
+  uint64_t max_segment_bytes = 0;   ///< 单个分段的最大字节数
+  double max_segment_seconds = 0.0; ///< 单个分段覆盖的最长时间（秒，按帧时间戳计算）
+  uint64_t disk_budget_bytes = 0;   ///< 同一次记录所有分段的总字节数上限
+  bool compress = false;            ///< 分段关闭后是否压缩为 .zst
+
+  /**
+   * @brief 是否启用分段（按大小或时长）
+   */
+  bool rotationEnabled() const { return max_segment_bytes > 0 || max_segment_seconds > 0.0; }
+};
+
+/**
+ * @brief 生成第 index 个分段的文件名
+ * @param base_filename 原日志文件名（如 /tmp/.../full_log_2025-04-18-10-00-00.txt）
+ * @param index 分段序号
+ * @return 分段文件名（如 /tmp/.../full_log_2025-04-18-10-00-00_003.txt）
+ */
+std::string logSegmentFilename(const std::string &base_filename, int index);
+
+/**
+ * @brief 流式压缩文件为 filename + ".zst"，成功后删除原文件
+ * @param filename 待压缩的文件
+ * @param cancel 不为 nullptr 时每压缩一块检查一次，为 true 时放弃压缩（删除不完整的 .zst，原文件保留）
+ * @return 压缩成功返回 true；不支持压缩、压缩失败或被放弃时返回 false，原文件保留
+ *
+ * 压缩期间原文件被磁盘空间上限删除时，压缩结果随之删除。
+ */
+bool compressLogFile(const std::string &filename, const std::atomic<bool> *cancel = nullptr);
+
+/**
+ * @brief 压缩是否可用（编译时是否链接了 libzstd）
+ */
+bool logCompressionAvailable();
+
+/**
+ * @brief 删除同一次记录中最旧的分段，直到总大小不超过上限
+ * @param base_filename 原日志文件名，用于匹配同一次记录的所有分段
+ * @param budget_bytes 总字节数上限（0 表示不限制）
+ * @param active_filename 正在写入的分段（及其 .idx / .events），不会被删除
+ * @return 删除的文件数
+ */
+int enforceLogDiskBudget(const std::string &base_filename, uint64_t budget_bytes, const std::string &active_filename);
+
+/**
+ * @class LogCompressor
+ * @brief 后台压缩线程：已关闭的分段排队后依次压缩，日志写线程不等待压缩
+ *
+ * 第一次 enqueue() 时启动线程（以较低的调度优先级运行，不与接收线程争用 CPU）。
+ * stop() 最多等待 COMPRESS_STOP_WAIT_MS 让剩余的分段（通常是停止时关闭的最后一个分段）压缩完，
+ * 不会因几 GB 的分段卡住停止操作几十秒：超时后正在压缩的分段被放弃，
+ * 排队中和被放弃的分段保留未压缩的原文件，可之后用 zstd 手动压缩。
+ */
+class LogCompressor
+{
+public:
+  LogCompressor() = default;
+  ~LogCompressor();
+
+  LogCompressor(const LogCompressor &) = delete;
+  LogCompressor &operator=(const LogCompressor &) = delete;
+
+  /**
+   * @brief 把已关闭的分段加入压缩队列（必要时启动压缩线程）
+   */
+  void enqueue(const std::string &filename);
+
+  /**
+   * @brief 停止压缩线程：最多等待 COMPRESS_STOP_WAIT_MS 让剩余的分段压缩完，之后放弃（保留原文件）
+   */
+  void stop();
+
+  static constexpr int COMPRESS_STOP_WAIT_MS = 3000; ///< stop() 等待剩余分段压缩完的上限（毫秒）
+
+private:
+  void run();
+
+  std::mutex mutex_;               ///< 保护 queue_ / running_
+  std::condition_variable cv_;     ///< 唤醒压缩线程
+  std::condition_variable idle_cv_; ///< 队列清空且没有正在压缩的分段时通知 stop()
+  bool busy_ = false;              ///< 是否正在压缩（mutex_ 保护）
+  std::deque<std::string> queue_;  ///< 待压缩的分段
+  bool running_ = false;           ///< 压缩线程是否在运行
+  std::atomic<bool> cancel_{false}; ///< 放弃正在进行的压缩
+  std::thread thread_;             ///< 压缩线程
+};
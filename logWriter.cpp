@@ -0,0 +1,477 @@
+/**
+ * @file logWriter.cpp
+ * @brief 异步双缓冲日志写入线程实现
+ * @author mafangniu
+ * @date 2025-04-12
+ *
+ * @details
+ * 写线程每 100ms 或前台缓冲过半时被唤醒，交换前后台缓冲后在锁外整批写入，
+ * 接收线程持锁的时间只有一次帧拷贝。触发前缓冲交接时只交换存储（vector::swap），
+ * 写线程在交换前后台缓冲时一并取走，按交接时的前台缓冲位置插入本批帧之间写入。
+ */
+
+#include "logWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity_frames, size_t stream_count)
+    : capacity_(capacity_frames > 0 ? capacity_frames : 1)
+{
+  // 两块缓冲都一次性预留，运行中不再分配
+  front_.reserve(capacity_);
+  back_.reserve(capacity_);
+
+  for (size_t i = 0; i < std::max<size_t>(stream_count, 1); ++i)
+  {
+    streams_.push_back(std::make_unique<Stream>());
+  }
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+  stop();
+}
+
+void AsyncLogWriter::start()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+  {
+    return;
+  }
+  running_ = true;
+  thread_ = std::thread([this]()
+                        { this->run(); });
+}
+
+void AsyncLogWriter::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_one();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+  compressor_.stop(); // 写线程关闭最后的分段后才停止压缩线程
+}
+
+void AsyncLogWriter::setFile(const std::string &filename, Format format, size_t stream)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stream &s = *streams_[stream < streams_.size() ? stream : 0];
+  s.pending_filename = filename;
+  s.pending_format = format;
+  s.file_changed = true;
+}
+
+bool AsyncLogWriter::submit(const RawMotorFrame &frame)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  return submitLocked(lock, frame, false);
+}
+
+bool AsyncLogWriter::submitLocked(std::unique_lock<std::mutex> &lock, const RawMotorFrame &frame, bool wait_for_space)
+{
+  if (front_.size() >= capacity_ && wait_for_space && running_)
+  {
+    cv_.notify_one();
+    space_cv_.wait_for(lock, std::chrono::milliseconds(SUBMIT_WAIT_MS), [this]()
+                       { return !running_ || front_.size() < capacity_; });
+  }
+  if (front_.size() >= capacity_)
+  {
+    ++dropped_frames_;
+    return false;
+  }
+  front_.push_back(frame);
+  if (front_.size() == capacity_ / 2)
+  {
+    cv_.notify_one(); // 缓冲过半时提前唤醒写线程
+  }
+  return true;
+}
+
+void AsyncLogWriter::reserveRecording(size_t capacity_frames, size_t stream_index)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stream &stream = *streams_[stream_index < streams_.size() ? stream_index : 0];
+  if (stream.recording_state == RecordingState::Idle && stream.recording.size() != capacity_frames)
+  {
+    stream.recording.assign(capacity_frames, RawMotorFrame{});
+  }
+}
+
+void AsyncLogWriter::submitRecording(FlightRecorder &recorder, double since_stamp, size_t stream_index)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  Stream &stream = *streams_[stream_index < streams_.size() ? stream_index : 0];
+  if (stream.recording_state == RecordingState::Idle)
+  {
+    recorder.swapStorage(stream.recording, stream.recording_first, stream.recording_count);
+    stream.recording_since = since_stamp;
+    stream.recording_offset = front_.size();
+    stream.recording_state = RecordingState::Pending;
+    ++recordings_pending_;
+    lock.unlock();
+    cv_.notify_one();
+    return;
+  }
+
+  // 上一次交接的帧还没写完：逐帧提交，缓冲满时等待写线程，触发前的帧不因缓冲满而丢弃
+  recorder.flush(since_stamp, [&](const RawMotorFrame &frame)
+                 { submitLocked(lock, frame, true); });
+}
+
+void AsyncLogWriter::run()
+{
+  // 切换文件请求在锁内取出，锁外执行（每个日志流一项，预先分配）
+  struct FileChange
+  {
+    bool changed = false;
+    std::string filename;
+    Format format = Format::Text;
+  };
+  std::vector<FileChange> changes(streams_.size());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    cv_.wait_for(lock, std::chrono::milliseconds(100), [this]()
+                 { return !running_ || front_.size() >= capacity_ / 2 || recordings_pending_ > 0; });
+
+    const bool stopping = !running_;
+
+    // 交换前后台缓冲，之后在锁外写文件
+    back_.clear();
+    back_.swap(front_);
+    recording_order_.clear();
+    for (size_t i = 0; i < streams_.size(); ++i)
+    {
+      Stream &stream = *streams_[i];
+      if (stream.recording_state == RecordingState::Pending)
+      {
+        stream.recording_state = RecordingState::Writing;
+        recording_order_.push_back(&stream);
+      }
+      changes[i].changed = stream.file_changed;
+      if (stream.file_changed)
+      {
+        changes[i].filename = stream.pending_filename;
+        changes[i].format = stream.pending_format;
+        stream.file_changed = false;
+      }
+    }
+    policy_ = pending_policy_;
+    recordings_pending_ = 0;
+    std::stable_sort(recording_order_.begin(), recording_order_.end(), [](const Stream *a, const Stream *b)
+                     { return a->recording_offset < b->recording_offset; });
+
+    lock.unlock();
+    space_cv_.notify_all(); // 前台缓冲已清空
+
+    for (size_t i = 0; i < streams_.size(); ++i)
+    {
+      Stream &stream = *streams_[i];
+      if (changes[i].changed && (changes[i].filename != stream.base_filename || changes[i].format != stream.current_format))
+      {
+        closeSegment(stream);
+        stream.base_filename = changes[i].filename;
+        stream.current_format = changes[i].format;
+        stream.segment_index = 0;
+        stream.open_pending = true; // 电机数取决于第一帧，写入第一帧前再打开
+      }
+    }
+
+    if (profiler_ && profiler_->enabled() && (!back_.empty() || !recording_order_.empty()))
+    {
+      const uint64_t write_start = LatencyProfiler::nowNs();
+      writeBatch();
+      profiler_->recordSince(LATENCY_LOG_WRITE, write_start);
+    }
+    else
+    {
+      writeBatch();
+    }
+
+    const uint64_t dropped = dropped_frames_;
+    if (dropped != reported_dropped_)
+    {
+      std::cerr << "⚠️ 日志写入跟不上，已丢弃日志帧数: " << dropped << std::endl;
+      reported_dropped_ = dropped;
+    }
+
+    lock.lock();
+    for (Stream *stream : recording_order_)
+    {
+      stream->recording_state = RecordingState::Idle; // 交接存储可再次使用
+    }
+    recording_order_.clear();
+    if (stopping && front_.empty() && recordings_pending_ == 0)
+    {
+      break;
+    }
+  }
+  lock.unlock();
+
+  for (auto &stream : streams_)
+  {
+    closeSegment(*stream);
+    stream->base_filename.clear();
+  }
+}
+
+void AsyncLogWriter::setRotation(const LogRotationPolicy &policy)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_policy_ = policy;
+}
+
+void AsyncLogWriter::openSegment(Stream &stream, int motor_count)
+{
+  // 未启用轮转时，只有电机数变化另起分段后文件名才带分段序号
+  stream.current_filename = (policy_.rotationEnabled() || stream.segment_index > 0)
+                                ? logSegmentFilename(stream.base_filename, stream.segment_index)
+                                : stream.base_filename;
+  stream.segment_start_stamp = -1.0;
+  stream.open_pending = false;
+
+  // 👈 以追加模式打开，文件保持打开直到切换、轮转或停止
+  bool opened = false;
+  if (stream.current_format == Format::Binary)
+  {
+    opened = stream.bin.open(stream.current_filename, motor_count);
+  }
+  else if (stream.current_format == Format::Session)
+  {
+    opened = stream.session.open(stream.current_filename, motor_count);
+  }
+  else
+  {
+    stream.ofs.open(stream.current_filename, std::ios::app);
+    opened = stream.ofs.is_open();
+  }
+
+  if (!opened)
+  {
+    std::cerr << "无法打开文件: " << stream.current_filename << std::endl;
+    return;
+  }
+  std::cout << "✅ 日志写入 " << stream.current_filename << std::endl;
+
+  // 错误码跳变记录在分段旁的 .events 文件中，每个分段重新开始跟踪
+  stream.error_tracker.reset();
+  const std::string events_filename = errorEventFilename(stream.current_filename);
+  if (!stream.events.open(events_filename))
+  {
+    std::cerr << "⚠️ 无法打开事件文件: " << events_filename << std::endl;
+  }
+}
+
+void AsyncLogWriter::closeSegment(Stream &stream)
+{
+  const bool was_open = stream.ofs.is_open() || stream.bin.isOpen() || stream.session.isOpen();
+  const bool session = stream.session.isOpen();
+  if (stream.ofs.is_open())
+  {
+    flushText(stream);
+    stream.ofs.close();
+  }
+  stream.text.clear();
+  stream.bin.close();
+  stream.session.close(); // 写入 Footer
+  stream.events.close();
+
+  if (!was_open || stream.current_filename.empty())
+  {
+    return;
+  }
+
+  // 已关闭的分段交给后台线程流式压缩（.idx 很小且用于定位，保持不压缩；列式会话文件保持可被 pandas 直接读取，不压缩）
+  if (policy_.compress && !session)
+  {
+    if (logCompressionAvailable())
+    {
+      compressor_.enqueue(stream.current_filename);
+    }
+    else if (!compress_warned_)
+    {
+      std::cerr << "⚠️ 编译时未找到 libzstd，日志分段不压缩" << std::endl;
+      compress_warned_ = true;
+    }
+  }
+  stream.current_filename.clear();
+}
+
+uint64_t AsyncLogWriter::segmentBytes(Stream &stream)
+{
+  if (stream.current_format == Format::Binary)
+  {
+    return stream.bin.bytesWritten();
+  }
+  if (stream.current_format == Format::Session)
+  {
+    return stream.session.bytesWritten();
+  }
+  const std::streamoff pos = stream.ofs.is_open() ? static_cast<std::streamoff>(stream.ofs.tellp()) : 0;
+  return (pos > 0 ? static_cast<uint64_t>(pos) : 0) + stream.text.size(); // 包含尚未写入的格式化缓冲
+}
+
+bool AsyncLogWriter::layoutChanged(const Stream &stream, const RawMotorFrame &next)
+{
+  return (stream.current_format == Format::Binary && stream.bin.isOpen() && next.motor_count != stream.bin.motorCount()) ||
+         (stream.current_format == Format::Session && stream.session.isOpen() && next.motor_count != stream.session.motorCount());
+}
+
+void AsyncLogWriter::rotateIfNeeded(Stream &stream, const RawMotorFrame &next)
+{
+  if (stream.current_filename.empty())
+  {
+    return;
+  }
+
+  // 二进制记录定长、列式会话的列数固定，电机数变化时必须另起分段（不受轮转开关影响）
+  const bool layout_changed = layoutChanged(stream, next);
+  const bool size_exceeded = policy_.rotationEnabled() && policy_.max_segment_bytes > 0 &&
+                             segmentBytes(stream) >= policy_.max_segment_bytes;
+  const bool time_exceeded = policy_.rotationEnabled() && policy_.max_segment_seconds > 0.0 && stream.segment_start_stamp >= 0.0 &&
+                             next.stamp - stream.segment_start_stamp >= policy_.max_segment_seconds;
+  if (!layout_changed && !size_exceeded && !time_exceeded)
+  {
+    return;
+  }
+
+  closeSegment(stream);
+  ++stream.segment_index;
+  openSegment(stream, next.motor_count);
+  enforceLogDiskBudget(stream.base_filename, policy_.disk_budget_bytes, stream.current_filename);
+}
+
+void AsyncLogWriter::writeBatch()
+{
+  if (back_.empty() && recording_order_.empty())
+  {
+    return;
+  }
+
+  // 按大小轮转在每个日志流本批第一帧时检查（最多超出一批），按时长轮转和电机数变化逐帧检查
+  for (auto &stream : streams_)
+  {
+    stream->segment_checked = false;
+  }
+
+  // 交接的触发前帧插在交接时前台缓冲中已有的帧之后
+  size_t next_recording = 0;
+  for (size_t i = 0; i <= back_.size(); ++i)
+  {
+    while (next_recording < recording_order_.size() && recording_order_[next_recording]->recording_offset <= i)
+    {
+      writeRecording(*recording_order_[next_recording++]);
+    }
+    if (i < back_.size())
+    {
+      writeFrame(back_[i]);
+    }
+  }
+
+  for (auto &stream : streams_)
+  {
+    if (stream->bin.isOpen())
+    {
+      stream->bin.flush();
+    }
+    if (stream->session.isOpen())
+    {
+      stream->session.flush();
+    }
+    if (stream->ofs.is_open())
+    {
+      flushText(*stream);
+      stream->ofs.flush();
+    }
+    stream->events.flush();
+  }
+  back_.clear();
+}
+
+void AsyncLogWriter::writeRecording(Stream &stream)
+{
+  const size_t capacity = stream.recording.size();
+  for (size_t i = 0; i < stream.recording_count && capacity > 0; ++i)
+  {
+    const RawMotorFrame &frame = stream.recording[(stream.recording_first + i) % capacity];
+    if (frame.stamp >= stream.recording_since)
+    {
+      writeFrame(frame);
+    }
+  }
+}
+
+void AsyncLogWriter::writeFrame(const RawMotorFrame &frame)
+{
+  Stream &stream = *streams_[frame.source < streams_.size() ? frame.source : 0];
+
+  if (stream.open_pending)
+  {
+    openSegment(stream, frame.motor_count);
+  }
+  if (!stream.segment_checked || policy_.max_segment_seconds > 0.0 || layoutChanged(stream, frame))
+  {
+    stream.segment_checked = true;
+    rotateIfNeeded(stream, frame);
+  }
+  if (stream.segment_start_stamp < 0.0)
+  {
+    stream.segment_start_stamp = frame.stamp;
+  }
+
+  if (stream.current_format == Format::Binary)
+  {
+    if (!stream.bin.isOpen())
+    {
+      return;
+    }
+    stream.bin.append(frame);
+  }
+  else if (stream.current_format == Format::Session)
+  {
+    if (!stream.session.isOpen())
+    {
+      return;
+    }
+    stream.session.append(frame);
+  }
+  else
+  {
+    if (!stream.ofs.is_open())
+    {
+      return;
+    }
+    // 格式化到缓冲（帧标识带微秒，秒级部分由格式化器缓存），累积到 TEXT_WRITE_BYTES 后整块写入
+    stream.text.appendFrame(frame.motors, frame.motor_count, frame.stamp);
+    if (stream.text.size() >= TEXT_WRITE_BYTES)
+    {
+      flushText(stream);
+    }
+  }
+  ++written_frames_;
+
+  const int transitions = stream.error_tracker.observe(frame, transitions_.data());
+  if (transitions > 0)
+  {
+    stream.events.append(transitions_.data(), transitions);
+  }
+}
+
+void AsyncLogWriter::flushText(Stream &stream)
+{
+  if (!stream.text.empty())
+  {
+    stream.ofs.write(stream.text.data(), static_cast<std::streamsize>(stream.text.size()));
+    stream.text.clear();
+  }
+}
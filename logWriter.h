@@ -0,0 +1,271 @@
+/**
+ * @file logWriter.h
+ * @brief 异步双缓冲日志写入线程头文件
+ * @author mafangniu
+ * @date 2025-04-12
+ *
+ * @details
+ * 原先日志在 UDP 接收线程中同步写入：每帧都要打开文件、格式化、关闭文件，磁盘较慢时会拖慢接收导致丢包。
+ * 本模块把日志写入移到独立线程：
+ * - 接收线程只调用 submit() 把原始帧拷入前台缓冲（有界，满时丢弃并计数，绝不阻塞接收）；
+ * - 错误上升沿时触发前缓冲（可达上万帧）由 submitRecording() 整体交给写线程（交换存储，不经过前台缓冲，不会因缓冲满而丢弃）；
+ * - 写线程定期（或前台缓冲过半时）交换前后台缓冲，整批格式化写入；
+ * - 日志文件在写线程中保持打开，只在切换文件时重新打开；
+ * - 丢弃的日志帧数会被统计并输出提示；
+ * - 可按大小/时长分段轮转，已关闭的分段可在后台线程中压缩，并限制总磁盘占用（见 logRotation.h）；
+ * - 多数据源时每个数据源是一个独立的日志流（按 RawMotorFrame::source 分流到各自的文件），共用一个写线程。
+ *
+ * 支持文本格式（与 printMotorDataToFile() 一致，帧标识带微秒，由 MotorTextFormatter 整批格式化后大块写入，见 textLogFormat.h）、
+ * 紧凑二进制格式（见 binaryLog.h）和列式会话格式（Arrow IPC 文件，pandas 直接读取，见 sessionStore.h）。每个分段旁另写一个错误码跳变事件文件（分段文件名 + ".events"，见 errorEvents.h）。
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "motorData.h"
+#include "flightRecorder.h"
+#include "binaryLog.h"
+#include "sessionStore.h"
+#include "textLogFormat.h"
+#include "errorEvents.h"
+#include "logRotation.h"
+#include "latencyProfiler.h"
+
+/**
+ * @class AsyncLogWriter
+ * @brief 异步双缓冲日志写入器
+ *
+ * 一个生产者（接收线程）调用 submit()/setFile()，写线程负责所有文件操作。
+ * 日志流个数在构造时确定，帧按 frame.source 写入对应的日志流（超出范围的帧写入日志流 0）。
+ */
+class AsyncLogWriter
+{
+public:
+  /**
+   * @brief 构造函数
+   * @param capacity_frames 前台缓冲最多容纳的帧数（所有日志流共用），超过后新帧被丢弃
+   * @param stream_count 日志流个数（每个数据源一个）
+   */
+  explicit AsyncLogWriter(size_t capacity_frames = 2048, size_t stream_count = 1);
+
+  /**
+   * @brief 析构函数，写完剩余帧后停止写线程
+   */
+  ~AsyncLogWriter();
+
+  AsyncLogWriter(const AsyncLogWriter &) = delete;
+  AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+  /**
+   * @brief 启动写线程（已启动时不重复启动）
+   */
+  void start();
+
+  /**
+   * @brief 停止写线程，停止前会把缓冲中剩余的帧全部写入
+   */
+  void stop();
+
+  /**
+   * @brief 日志文件格式
+   */
+  enum class Format
+  {
+    Text,   ///< 文本格式，与 printMotorDataToFile() 相同
+    Binary, ///< 紧凑二进制格式（见 binaryLog.h）
+    Session ///< 列式会话格式（Arrow IPC 文件，见 sessionStore.h）
+  };
+
+  /**
+   * @brief 设置某个日志流后续日志帧写入的文件（写线程在下一批写入前切换）
+   * @param filename 日志文件名（追加模式打开）
+   * @param format 日志格式
+   * @param stream 日志流序号（对应 RawMotorFrame::source）
+   */
+  void setFile(const std::string &filename, Format format = Format::Text, size_t stream = 0);
+
+  /**
+   * @brief 设置日志分段轮转、压缩和磁盘空间上限策略（所有日志流共用，磁盘空间上限按日志流分别计算，写线程在下一批写入前生效）
+   * @param policy 轮转策略，见 logRotation.h
+   */
+  void setRotation(const LogRotationPolicy &policy);
+
+  /**
+   * @brief 设置延迟统计（写线程把每批日志的写入耗时记入 LATENCY_LOG_WRITE，需在 start() 前调用）
+   * @param profiler 延迟统计，为 nullptr 时不统计
+   */
+  void setLatencyProfiler(LatencyProfiler *profiler) { profiler_ = profiler; }
+
+  /**
+   * @brief 提交一帧待写入的数据（非阻塞）
+   * @param frame 原始帧，帧标识时间戳取自 frame.stamp
+   * @return 成功放入缓冲返回 true；缓冲已满时丢弃该帧并返回 false
+   */
+  bool submit(const RawMotorFrame &frame);
+
+  /**
+   * @brief 为日志流预分配触发前帧的交接存储（接收开始时调用，容量与该数据源的 FlightRecorder 相同）
+   * @param capacity_frames 交接存储的帧数
+   * @param stream 日志流序号
+   */
+  void reserveRecording(size_t capacity_frames, size_t stream = 0);
+
+  /**
+   * @brief 把触发前缓冲中的帧整体交给写线程（错误上升沿时调用）
+   * @param recorder 数据源的触发前缓冲，与该日志流的交接存储交换存储后清空（不拷贝帧）
+   * @param since_stamp 只写入时间戳不早于该时刻的帧
+   * @param stream 日志流序号
+   *
+   * 交接的帧排在此前 submit() 的帧之后、此后 submit() 的帧之前写入。上一次交接的帧还没写完时
+   * （两次错误上升沿间隔很短）逐帧提交，前台缓冲满时等待写线程腾出空间（最多 SUBMIT_WAIT_MS），而不是丢弃触发前的帧。
+   */
+  void submitRecording(FlightRecorder &recorder, double since_stamp, size_t stream = 0);
+
+  /**
+   * @brief 因缓冲已满被丢弃的日志帧总数
+   */
+  uint64_t droppedFrames() const { return dropped_frames_; }
+
+  /**
+   * @brief 已写入文件的日志帧总数
+   */
+  uint64_t writtenFrames() const { return written_frames_; }
+
+private:
+  /**
+   * @brief 单个日志流的状态
+   */
+  /// 触发前帧交接存储的状态（mutex_ 保护）
+  enum class RecordingState
+  {
+    Idle,    ///< 交接存储空闲
+    Pending, ///< 已交接，等待写线程取走
+    Writing  ///< 写线程正在写入（只有写线程改变此状态）
+  };
+
+  struct Stream
+  {
+    std::string pending_filename;         ///< 接收线程设置的目标文件名（mutex_ 保护）
+    Format pending_format = Format::Text; ///< 接收线程设置的目标文件格式（mutex_ 保护）
+    bool file_changed = false;            ///< 目标文件是否已变更（mutex_ 保护）
+
+    std::ofstream ofs;                    ///< 当前打开的日志文件（以下仅写线程访问）
+    BinaryLogFile bin;                    ///< 当前打开的二进制日志
+    SessionStoreFile session;             ///< 当前打开的列式会话文件
+    Format current_format = Format::Text; ///< 当前日志格式
+    std::string base_filename;            ///< setFile() 指定的日志文件名
+    std::string current_filename;         ///< 当前分段文件名
+    int segment_index = 0;                ///< 当前分段序号
+    bool open_pending = false;            ///< 已切换文件但尚未打开（等待第一帧确定电机数）
+    double segment_start_stamp = -1.0;    ///< 当前分段第一帧的时间戳，-1 表示分段为空
+    bool segment_checked = false;         ///< 本批写入前是否已检查过分段大小
+    MotorTextFormatter text;              ///< 文本格式的输出缓冲（整批格式化后一次写入）
+    ErrorEventFile events;                ///< 当前分段的错误码跳变事件文件
+    ErrorTransitionTracker error_tracker; ///< 当前分段各电机的错误码（每个分段重新开始）
+
+    std::vector<RawMotorFrame> recording;            ///< 交接的触发前帧（环形存储，与 FlightRecorder 交换）
+    RecordingState recording_state = RecordingState::Idle;
+    size_t recording_first = 0;                      ///< 最旧的帧在 recording 中的下标
+    size_t recording_count = 0;                      ///< 交接的帧数
+    double recording_since = 0.0;                    ///< 只写入时间戳不早于该时刻的帧
+    size_t recording_offset = 0;                     ///< 交接时前台缓冲中的帧数（这些帧先于交接的帧写入）
+  };
+
+  /**
+   * @brief 写线程主循环
+   */
+  void run();
+
+  /**
+   * @brief 将后台缓冲中的帧和本批取走的触发前帧整批写入当前文件
+   */
+  void writeBatch();
+
+  /**
+   * @brief 把一帧写入其日志流的当前分段（必要时先打开或轮转分段）
+   */
+  void writeFrame(const RawMotorFrame &frame);
+
+  /**
+   * @brief 按时间顺序写入日志流交接的触发前帧
+   */
+  void writeRecording(Stream &stream);
+
+  /**
+   * @brief 把一帧放入前台缓冲（调用者已持有 mutex_）
+   * @param wait_for_space 缓冲已满时等待写线程腾出空间（最多 SUBMIT_WAIT_MS），否则立即丢弃
+   */
+  bool submitLocked(std::unique_lock<std::mutex> &lock, const RawMotorFrame &frame, bool wait_for_space);
+
+  static constexpr int SUBMIT_WAIT_MS = 200; ///< submitRecording() 逐帧提交时等待前台缓冲腾出空间的上限（毫秒）
+
+  /**
+   * @brief 把文本格式化缓冲中的内容写入当前文件
+   */
+  static void flushText(Stream &stream);
+
+  static constexpr size_t TEXT_WRITE_BYTES = 1 << 20; ///< 文本格式化缓冲累积到该大小时写入文件
+
+  /**
+   * @brief 打开日志流的当前分段文件（启用轮转或已另起分段时文件名带分段序号）
+   * @param stream 日志流
+   * @param motor_count 分段第一帧的电机数（二进制格式的记录长度、列式会话格式的列数由此确定）
+   */
+  void openSegment(Stream &stream, int motor_count);
+
+  /**
+   * @brief 关闭日志流的当前分段文件，按策略把已关闭的分段交给后台压缩线程
+   */
+  void closeSegment(Stream &stream);
+
+  /**
+   * @brief 日志流当前分段已写入的字节数
+   */
+  uint64_t segmentBytes(Stream &stream);
+
+  /**
+   * @brief 下一帧的电机数与当前二进制 / 列式会话分段不同（定长布局，须另起分段）
+   */
+  static bool layoutChanged(const Stream &stream, const RawMotorFrame &next);
+
+  /**
+   * @brief 当前分段超过大小或时长上限、或二进制 / 列式会话分段电机数与下一帧不同时切换到下一个分段，
+   *        并按磁盘空间上限删除最旧的分段
+   * @param stream 日志流
+   * @param next 即将写入的帧
+   */
+  void rotateIfNeeded(Stream &stream, const RawMotorFrame &next);
+
+  const size_t capacity_;               ///< 前台缓冲容量（帧）
+  std::vector<RawMotorFrame> front_;    ///< 前台缓冲：接收线程写入
+  std::vector<RawMotorFrame> back_;     ///< 后台缓冲：写线程格式化输出
+  std::vector<std::unique_ptr<Stream>> streams_; ///< 各日志流（个数构造时确定）
+  LogRotationPolicy pending_policy_;    ///< 接收线程设置的轮转策略
+
+  std::mutex mutex_;                    ///< 保护 front_ / 各日志流的 pending_* / running_
+  std::condition_variable cv_;          ///< 唤醒写线程
+  std::condition_variable space_cv_;    ///< 写线程取走前台缓冲后通知等待空间的 submitRecording()
+  size_t recordings_pending_ = 0;       ///< 状态为 Pending 的交接存储数（mutex_ 保护）
+  bool running_ = false;                ///< 写线程是否在运行
+  std::thread thread_;                  ///< 写线程
+
+  LogRotationPolicy policy_;            ///< 当前轮转策略（仅写线程访问）
+  bool compress_warned_ = false;        ///< 是否已提示过不支持压缩（仅写线程访问）
+  LogCompressor compressor_;            ///< 已关闭分段的后台压缩线程（写线程只排队，不等待压缩）
+  LatencyProfiler *profiler_ = nullptr; ///< 延迟统计（可为 nullptr）
+  std::array<ErrorTransition, MAX_MOTOR_COUNT> transitions_; ///< 单帧的跳变事件缓冲（仅写线程访问）
+  std::vector<Stream *> recording_order_;                    ///< 本批取走的交接存储，按 recording_offset 排序（仅写线程访问）
+
+  std::atomic<uint64_t> dropped_frames_{0}; ///< 丢弃的日志帧数
+  std::atomic<uint64_t> written_frames_{0}; ///< 已写入的日志帧数
+  uint64_t reported_dropped_ = 0;           ///< 已提示过的丢弃帧数（仅写线程访问）
+};
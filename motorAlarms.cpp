@@ -0,0 +1,258 @@
+/**
+ * @file motorAlarms.cpp
+ * @brief 告警配置的解析与格式化、滑动窗口告警判断实现
+ * @author mafangniu
+ * @date 2025-05-15
+ */
+
+#include "motorAlarms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <strings.h>
+
+#include "motorFields.h"
+#include "specTokens.h"
+
+namespace
+{
+bool parseNumber(const std::string &text, double &value)
+{
+  if (text.empty())
+  {
+    return false;
+  }
+  char *end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  return end && *end == '\0' && std::isfinite(value);
+}
+
+std::string formatNumber(double value)
+{
+  char text[32];
+  std::snprintf(text, sizeof(text), "%g", value);
+  return text;
+}
+} // namespace
+
+bool parseAlarmConfig(const std::string &spec, AlarmConfig &config, std::string *error)
+{
+  AlarmConfig parsed;
+  // 字段名可能含空格（"Mos Temperature"），只按逗号、分号分隔
+  for (const std::string &entry : specTokens(spec, SPEC_LIST_SEPARATORS))
+  {
+    if (strncasecmp(entry.c_str(), "window=", 7) == 0)
+    {
+      if (!parseNumber(trimSpec(entry.substr(7)), parsed.window_s) || parsed.window_s <= 0.0)
+      {
+        setError(error, "统计窗口无效: " + entry);
+        return false;
+      }
+      continue;
+    }
+
+    const size_t op = entry.find_first_of("<>");
+    const size_t dot = op == std::string::npos ? std::string::npos : entry.rfind('.', op);
+    if (op == std::string::npos || dot == std::string::npos)
+    {
+      setError(error, "规则格式应为 <字段>.<统计量><比较><阈值>: " + entry);
+      return false;
+    }
+
+    AlarmRule rule;
+    rule.above = entry[op] == '>';
+    const std::string field = trimSpec(entry.substr(0, dot));
+    const std::string statistic = trimSpec(entry.substr(dot + 1, op - dot - 1));
+    if (!parseNumber(trimSpec(entry.substr(op + 1)), rule.threshold))
+    {
+      setError(error, "阈值无效: " + entry);
+      return false;
+    }
+
+    bool found = false;
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT && !found; ++f)
+    {
+      if (strcasecmp(field.c_str(), MOTOR_FIELDS[f].name) == 0)
+      {
+        rule.field = f;
+        found = true;
+      }
+    }
+    if (!found)
+    {
+      setError(error, "未知的字段: " + field);
+      return false;
+    }
+
+    found = false;
+    for (int s = 0; s < ALARM_STAT_COUNT && !found; ++s)
+    {
+      if (strcasecmp(statistic.c_str(), ALARM_STATISTIC_NAMES[s]) == 0)
+      {
+        rule.statistic = static_cast<AlarmStatistic>(s);
+        found = true;
+      }
+    }
+    if (!found)
+    {
+      setError(error, "未知的统计量: " + statistic + "（可用 mean/min/max/std/slope）");
+      return false;
+    }
+
+    if (parsed.rules.size() >= static_cast<size_t>(MAX_ALARM_RULES))
+    {
+      setError(error, "规则数超过上限 " + std::to_string(MAX_ALARM_RULES));
+      return false;
+    }
+    parsed.rules.push_back(rule);
+  }
+  config = parsed;
+  return true;
+}
+
+std::string formatAlarmRule(const AlarmRule &rule)
+{
+  return std::string(MOTOR_FIELDS[rule.field].name) + "." + ALARM_STATISTIC_NAMES[rule.statistic] +
+         (rule.above ? ">" : "<") + formatNumber(rule.threshold);
+}
+
+std::string formatAlarmConfig(const AlarmConfig &config)
+{
+  if (config.rules.empty())
+  {
+    return std::string();
+  }
+  std::string spec = "window=" + formatNumber(config.window_s);
+  for (const AlarmRule &rule : config.rules)
+  {
+    spec += "," + formatAlarmRule(rule);
+  }
+  return spec;
+}
+
+// ============================ MotorAlarmEngine ============================
+
+void MotorAlarmEngine::configure(const AlarmConfig &config)
+{
+  config_ = config;
+  fields_.clear();
+  rule_stream_.clear();
+  for (const AlarmRule &rule : config_.rules)
+  {
+    const auto it = std::find(fields_.begin(), fields_.end(), rule.field);
+    rule_stream_.push_back(static_cast<size_t>(it - fields_.begin()));
+    if (it == fields_.end())
+    {
+      fields_.push_back(rule.field);
+    }
+  }
+  streams_.clear();
+  values_.clear();
+  last_true_.clear();
+  active_.clear();
+  motor_count_ = 0;
+  next_evaluation_ = 0.0;
+}
+
+void MotorAlarmEngine::observe(const RawMotorFrame &frame)
+{
+  if (!enabled())
+  {
+    return;
+  }
+  const int motors = std::min<int>(frame.motor_count, MAX_MOTOR_COUNT);
+  if (motors > motor_count_)
+  {
+    // 新电机的窗口只在第一次出现时分配
+    const size_t rule_count = config_.rules.size();
+    streams_.resize(static_cast<size_t>(motors) * fields_.size());
+    for (size_t i = static_cast<size_t>(motor_count_) * fields_.size(); i < streams_.size(); ++i)
+    {
+      // 窗口内完整的桶加上两端不完整的桶
+      streams_[i].reset(ALARM_WINDOW_BUCKETS + 2, config_.window_s, config_.window_s / ALARM_WINDOW_BUCKETS);
+    }
+    values_.resize(static_cast<size_t>(motors) * rule_count, std::numeric_limits<double>::quiet_NaN());
+    last_true_.resize(static_cast<size_t>(motors) * rule_count, -std::numeric_limits<double>::infinity());
+    active_.resize(static_cast<size_t>(motors), 0);
+    motor_count_ = motors;
+  }
+
+  const size_t field_count = fields_.size();
+  for (int m = 0; m < motors; ++m)
+  {
+    RollingStats *stream = &streams_[static_cast<size_t>(m) * field_count];
+    for (size_t k = 0; k < field_count; ++k)
+    {
+      stream[k].push(frame.stamp, motorFieldValue(frame.motors[m], fields_[k]));
+    }
+  }
+}
+
+bool MotorAlarmEngine::evaluateIfDue(double stamp)
+{
+  if (stamp + ALARM_EVAL_INTERVAL_S < next_evaluation_)
+  {
+    next_evaluation_ = stamp; // 时间戳回退（例如发送端时钟被重新设置）
+  }
+  if (!enabled() || stamp < next_evaluation_)
+  {
+    return false;
+  }
+  next_evaluation_ = stamp + ALARM_EVAL_INTERVAL_S;
+
+  const size_t rule_count = config_.rules.size();
+  const size_t field_count = fields_.size();
+  for (int m = 0; m < motor_count_; ++m)
+  {
+    uint32_t mask = 0;
+    for (size_t r = 0; r < rule_count; ++r)
+    {
+      const AlarmRule &rule = config_.rules[r];
+      const RollingStats &stats = streams_[static_cast<size_t>(m) * field_count + rule_stream_[r]];
+      double value = std::numeric_limits<double>::quiet_NaN();
+      if (stats.count() >= 2)
+      {
+        switch (rule.statistic)
+        {
+        case ALARM_STAT_MEAN:
+          value = stats.mean();
+          break;
+        case ALARM_STAT_MIN:
+          value = stats.min();
+          break;
+        case ALARM_STAT_MAX:
+          value = stats.max();
+          break;
+        case ALARM_STAT_STD:
+          value = stats.stddev();
+          break;
+        case ALARM_STAT_SLOPE:
+          // 不足半个窗口时斜率噪声太大，不判断
+          if (stats.span() >= 0.5 * config_.window_s)
+          {
+            value = stats.slope();
+          }
+          break;
+        default:
+          break;
+        }
+      }
+
+      const size_t i = static_cast<size_t>(m) * rule_count + r;
+      values_[i] = value;
+      if (!std::isnan(value) && (rule.above ? value > rule.threshold : value < rule.threshold))
+      {
+        last_true_[i] = stamp;
+      }
+      if (stamp - last_true_[i] <= ALARM_HOLD_S)
+      {
+        mask |= 1u << r;
+      }
+    }
+    active_[m] = mask;
+  }
+  return true;
+}
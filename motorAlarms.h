@@ -0,0 +1,142 @@
+/**
+ * @file motorAlarms.h
+ * @brief 基于滑动窗口统计的阈值 / 上升速率告警（在发布线程中计算，电机驱动报错之前给出预警）
+ * @author mafangniu
+ * @date 2025-05-15
+ *
+ * @details
+ * 错误类型界面只显示电机驱动上报的离散错误码，往往在驱动已经保护停机时才变红。告警规则对每个电机的
+ * 指定字段维护滑动窗口统计（见 rollingStats.h），统计量越过阈值时提前告警。规则用一个字符串描述，
+ * 条目之间以逗号或分号分隔（字段名可以含空格）：
+ *
+ *     window=<秒>                   统计窗口（默认 2 秒，所有规则共用）
+ *     <字段>.<统计量><比较><阈值>    一条规则，字段为 MOTOR_FIELDS 中的名称（不区分大小写），
+ *                                   统计量为 mean / min / max / std / slope（slope 单位为 字段单位/秒），比较为 > 或 <
+ *
+ * 例如 "window=5,Temperatrue.max>70,Mos Temperature.slope>0.5,Torque.std>3"：线圈温度超过 70、
+ * MOS 温度每秒上升超过 0.5、力矩在窗口内波动过大时告警。阈值告警用 max/min（窗口内的尖峰不会漏掉），
+ * 上升速率告警用 slope（窗口内的最小二乘斜率，窗口内数据不足半个窗口时不判断）。
+ *
+ * MotorAlarmEngine 每帧对规则涉及的字段各推入一个样本（每个样本 O(1)），每 ALARM_EVAL_INTERVAL_S
+ * （按帧时间）判断一次所有规则；条件满足后告警至少保持 ALARM_HOLD_S 秒，阈值附近抖动时不会反复闪烁。
+ * 统计窗口按 ALARM_WINDOW_BUCKETS 个时间桶（桶宽 = 窗口 / ALARM_WINDOW_BUCKETS）存放，缓冲大小与帧率和窗口长度无关，
+ * 1kHz 下几分钟的窗口也能完整覆盖（slope 告警需要窗口内有半个窗口以上的数据）；
+ * 缓冲在电机第一次出现时一次性分配，之后不再分配内存。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "motorPacket.h"
+#include "rollingStats.h"
+
+// 告警规则使用的统计量
+enum AlarmStatistic
+{
+  ALARM_STAT_MEAN = 0,
+  ALARM_STAT_MIN,
+  ALARM_STAT_MAX,
+  ALARM_STAT_STD,
+  ALARM_STAT_SLOPE,
+  ALARM_STAT_COUNT
+};
+
+static constexpr const char *ALARM_STATISTIC_NAMES[ALARM_STAT_COUNT] = {"mean", "min", "max", "std", "slope"};
+
+static constexpr int MAX_ALARM_RULES = 32;                ///< 规则数上限（每个电机的告警状态为 32 位掩码）
+static constexpr size_t ALARM_WINDOW_BUCKETS = 500;      ///< 每个电机每个字段的统计窗口划分的时间桶数
+static constexpr double ALARM_EVAL_INTERVAL_S = 0.05;    ///< 规则判断和告警曲线发布的周期（秒，按帧时间）
+static constexpr double ALARM_HOLD_S = 1.0;              ///< 条件最后一次满足后告警保持的时长（秒）
+
+// 一条告警规则：MOTOR_FIELDS[field] 的 statistic 高于（above）或低于 threshold
+struct AlarmRule
+{
+  size_t field = 0;
+  AlarmStatistic statistic = ALARM_STAT_MAX;
+  bool above = true;
+  double threshold = 0.0;
+};
+
+// 告警配置
+struct AlarmConfig
+{
+  double window_s = 2.0;        ///< 统计窗口（秒）
+  std::vector<AlarmRule> rules; ///< 规则（为空表示不启用告警）
+};
+
+/**
+ * @brief 解析告警配置字符串
+ * @param spec 配置字符串，格式见文件说明；空字符串表示不启用告警
+ * @param config 输出的配置（解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true
+ */
+bool parseAlarmConfig(const std::string &spec, AlarmConfig &config, std::string *error = nullptr);
+
+/**
+ * @brief 将配置格式化为字符串（parseAlarmConfig() 的逆操作）
+ */
+std::string formatAlarmConfig(const AlarmConfig &config);
+
+/**
+ * @brief 一条规则的文字，例如 "Temperatrue.max>70"（也用作告警曲线名）
+ */
+std::string formatAlarmRule(const AlarmRule &rule);
+
+/**
+ * @class MotorAlarmEngine
+ * @brief 一个数据源所有电机的滑动窗口统计和告警状态
+ *
+ * @note 只在发布线程中使用
+ */
+class MotorAlarmEngine
+{
+public:
+  /**
+   * @brief 应用新配置，清空所有统计和告警状态
+   */
+  void configure(const AlarmConfig &config);
+
+  bool enabled() const { return !config_.rules.empty(); }
+
+  /**
+   * @brief 把一帧中规则涉及的字段推入各电机的统计窗口（电机数增长时为新电机分配窗口）
+   */
+  void observe(const RawMotorFrame &frame);
+
+  /**
+   * @brief 距上次判断已超过 ALARM_EVAL_INTERVAL_S 时判断所有规则
+   * @param stamp 当前帧时间（秒）
+   * @return 本次做了判断返回 true（调用者据此发布告警曲线和状态）
+   */
+  bool evaluateIfDue(double stamp);
+
+  int motorCount() const { return motor_count_; }
+  size_t ruleCount() const { return config_.rules.size(); }
+  const AlarmRule &rule(size_t r) const { return config_.rules[r]; }
+
+  /**
+   * @brief 上次判断时的统计量，数据不足时为 NaN
+   */
+  double value(int motor, size_t r) const { return values_[motor * config_.rules.size() + r]; }
+
+  /**
+   * @brief 电机的告警状态（第 r 位对应第 r 条规则）
+   */
+  uint32_t activeMask(int motor) const { return active_[motor]; }
+
+private:
+  AlarmConfig config_;
+  std::vector<size_t> fields_;        ///< 规则涉及的字段（去重）
+  std::vector<size_t> rule_stream_;   ///< 规则 -> fields_ 下标
+  std::vector<RollingStats> streams_; ///< [电机][字段]（下标 motor * fields_.size() + k）
+  std::vector<double> values_;        ///< [电机][规则] 上次判断时的统计量
+  std::vector<double> last_true_;     ///< [电机][规则] 条件最后一次满足的时间
+  std::vector<uint32_t> active_;      ///< 各电机的告警掩码
+  int motor_count_ = 0;
+  double next_evaluation_ = 0.0;
+};
@@ -0,0 +1,48 @@
+/**
+ * @file motorData.h
+ * @author mafangniu
+ * @brief 电机数据结构定义（与发送端字节流严格对齐）
+ * @version 1.0
+ * @date 2025-04-12
+ *
+ * @details
+ * 定义 UDP 发送端按字节流发送的 `InteractiveMotorData` 结构体，以及插件内部在各线程之间传递的原始帧 `RawMotorFrame`。
+ * 该头文件不依赖 Qt 和 PlotJuggler，接收、发布、日志等模块共用。
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// 电机信息结构体
+typedef struct
+{
+  double mode, index;                            // 这里必须是double才行，否则和python那边发过来的对不上，就无法正常通信，电机控制模式，可以起到软急停的作用，模式为0代表停止运动，目前还没实现
+  double tau_, pos_, vel_;                       // 当前的位置rad、速度rad/s、力矩N.m
+  double pos_des_, vel_des_, kp_, kd_, ff_;      // 期望的位置、速度、比例、积分、力矩N.m
+  double error_, temperature_, mos_temperature_; // 读到的错误类型，电机温度和MOS温度
+} InteractiveMotorData;
+static_assert(sizeof(InteractiveMotorData) == 8 * 13, "Struct size mismatch! Must match sender."); // 已确定发送端为8 * 13字节
+
+// 不带包头的（旧版）UDP 数据报包含的电机数量
+static constexpr int MOTOR_COUNT = 13;
+
+// 单帧最多支持的电机数量（带包头的数据报由包头给出实际数量），决定各级帧缓冲的单帧大小
+static constexpr int MAX_MOTOR_COUNT = 48;
+
+// RawMotorFrame::flags
+static constexpr uint8_t FRAME_FLAG_SENDER_STAMP = 0x1; // stamp 为发送端时间戳（数据报尾部 8 字节）
+static constexpr uint8_t FRAME_FLAG_SEQUENCE = 0x2;     // sequence 为发送端给出的序号
+
+// 一个 UDP 数据报对应的原始帧（固定大小，用于在接收线程、发布线程和日志线程之间传递）
+// 只有前 motor_count 个电机数据有效
+struct RawMotorFrame
+{
+  double stamp;          // 该帧时间戳（秒，Unix 时间），由接收线程按 timestamp_source_ 确定，随帧一起批量传递
+  uint64_t recv_ns;      // 接收线程取到该帧时的单调时钟（纳秒，仅启用延迟统计时有效，见 latencyProfiler.h）
+  uint32_t sequence;     // 发送端序号（flags 含 FRAME_FLAG_SEQUENCE 时有效）
+  uint16_t motor_count;  // 本帧有效电机数
+  uint8_t flags;         // FRAME_FLAG_*
+  uint8_t source;        // 数据源序号（多数据源接收时区分曲线命名空间和日志，见 udpSources.h）
+  InteractiveMotorData motors[MAX_MOTOR_COUNT];
+};
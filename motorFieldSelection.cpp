@@ -0,0 +1,69 @@
+/**
+ * @file motorFieldSelection.cpp
+ * @brief 字段选择配置的解析与格式化
+ * @author mafangniu
+ * @date 2025-05-13
+ */
+
+#include "motorFieldSelection.h"
+
+#include <strings.h>
+
+#include "specTokens.h"
+
+bool parseMotorFieldMask(const std::string &spec, uint32_t &mask, std::string *error)
+{
+  uint32_t parsed = 0;
+  bool any = false;
+  // 字段名可能含空格（"Mos Temperature"），只按逗号、分号分隔
+  for (const std::string &entry : specTokens(spec, SPEC_LIST_SEPARATORS))
+  {
+    any = true;
+
+    if (strcasecmp(entry.c_str(), "all") == 0)
+    {
+      parsed |= ALL_MOTOR_FIELD_MASK;
+      continue;
+    }
+    if (strcasecmp(entry.c_str(), "none") == 0)
+    {
+      continue;
+    }
+    if (strcasecmp(entry.c_str(), "default") == 0)
+    {
+      parsed |= DEFAULT_MOTOR_FIELD_MASK;
+      continue;
+    }
+
+    bool found = false;
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      if (strcasecmp(entry.c_str(), MOTOR_FIELDS[f].name) == 0)
+      {
+        parsed |= 1u << f;
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+    {
+      setError(error, "未知的字段: " + entry);
+      return false;
+    }
+  }
+  mask = any ? parsed : DEFAULT_MOTOR_FIELD_MASK;
+  return true;
+}
+
+std::string formatMotorFieldMask(uint32_t mask)
+{
+  std::string spec;
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    if (mask & (1u << f))
+    {
+      spec += (spec.empty() ? "" : ",") + std::string(MOTOR_FIELDS[f].name);
+    }
+  }
+  return spec.empty() ? std::string("none") : spec;
+}
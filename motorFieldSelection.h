@@ -0,0 +1,74 @@
+/**
+ * @file motorFieldSelection.h
+ * @brief 运行时选择在 PlotJuggler 中显示的字段
+ * @author mafangniu
+ * @date 2025-05-13
+ *
+ * @details
+ * MOTOR_FIELDS 中的 plotted 只决定默认显示哪些字段。运行时启用的字段用一个位掩码表示（第 f 位对应 MOTOR_FIELDS[f]），
+ * 只有启用的字段才注册和推送曲线；调参时启用 Kp/Kd 等字段会在下一帧注册（不需要重新编译），
+ * 关闭的字段保留已注册的曲线（可能仍在图中使用），只是不再推送。
+ *
+ * 配置字符串为逗号或分号分隔的字段名（MOTOR_FIELDS[].name，不区分大小写，例如 "Pos,Vel,Kp,Kd"），
+ * "all" 表示全部字段，"default" 表示默认字段（plotted），"none" 表示不显示任何字段。
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "motorFields.h"
+
+static_assert(MOTOR_FIELD_COUNT <= 32, "Field selection mask holds at most 32 fields.");
+
+/**
+ * @brief 默认启用的字段掩码（MOTOR_FIELDS 中 plotted 为 true 的字段）
+ */
+constexpr uint32_t makeDefaultMotorFieldMask()
+{
+  uint32_t mask = 0;
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    if (MOTOR_FIELDS[f].plotted)
+    {
+      mask |= 1u << f;
+    }
+  }
+  return mask;
+}
+
+static constexpr uint32_t DEFAULT_MOTOR_FIELD_MASK = makeDefaultMotorFieldMask();
+static constexpr uint32_t ALL_MOTOR_FIELD_MASK = static_cast<uint32_t>((1ull << MOTOR_FIELD_COUNT) - 1);
+
+/**
+ * @brief 把字段掩码展开为字段下标表
+ * @param mask   字段掩码
+ * @param fields 输出的 MOTOR_FIELDS 下标（按表中顺序），至少容纳 MOTOR_FIELD_COUNT 项
+ * @return 启用的字段数
+ */
+inline int expandMotorFieldMask(uint32_t mask, uint8_t *fields)
+{
+  int count = 0;
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    if (mask & (1u << f))
+    {
+      fields[count++] = static_cast<uint8_t>(f);
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 解析字段选择配置
+ * @param spec  配置字符串，格式见文件说明；空字符串表示默认字段
+ * @param mask  输出的字段掩码（解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true
+ */
+bool parseMotorFieldMask(const std::string &spec, uint32_t &mask, std::string *error = nullptr);
+
+/**
+ * @brief 将字段掩码格式化为配置字符串（parseMotorFieldMask() 的逆操作）
+ */
+std::string formatMotorFieldMask(uint32_t mask);
@@ -0,0 +1,153 @@
+/**
+ * @file motorFields.h
+ * @author mafangniu
+ * @brief InteractiveMotorData 字段描述表（编译期常量）
+ * @version 1.0
+ * @date 2025-04-20
+ *
+ * @details
+ * 原先需要同时维护 extract_fields() 和 field_names 两处（靠注释掉行来选择显示哪些字段），容易不同步。
+ * 现在所有字段信息集中在 MOTOR_FIELDS 一张 constexpr 表中：
+ * - name：PlotJuggler 中的变量名（MotorN/<name>）；
+ * - offset：字段在 InteractiveMotorData 中的字节偏移；
+ * - log_label / log_suffix：文本日志中的标签和单位；
+ * - plotted：默认是否注册到 PlotJuggler 并推送（运行时可在界面上修改，见 motorFieldSelection.h）。
+ *
+ * 注册、解码、文本日志、二进制日志文件头都由该表生成。解码 decodePlottedFields() 在编译期展开为
+ * 对每个显示字段的直接读取，每帧不做任何内存分配。
+ *
+ * @note 若更改 `InteractiveMotorData` 结构体字段或顺序，只需同步修改该表；
+ *       需要修改默认显示的字段时修改对应的 plotted 即可。
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include "motorData.h"
+
+// 单个字段的描述
+struct MotorFieldDescriptor
+{
+  const char *name;       // PlotJuggler 中显示的变量名
+  size_t offset;          // 在 InteractiveMotorData 中的字节偏移
+  const char *log_label;  // 文本日志中的标签
+  const char *log_suffix; // 文本日志中的单位及换行
+  bool plotted;           // 默认是否在 PlotJuggler 中显示
+  double decimation_ms;   // 启用曲线抽稀时的默认桶宽（毫秒），0 表示该字段不抽稀（见 plotDecimator.h）
+};
+
+// 字段描述表，顺序即文本日志中的输出顺序，plotted 字段按此顺序注册到 PlotJuggler
+static constexpr MotorFieldDescriptor MOTOR_FIELDS[] = {
+    {"Index", offsetof(InteractiveMotorData, index), "  Index       : ", "\n", false, 0.0},
+    {"Mode", offsetof(InteractiveMotorData, mode), "  Mode       : ", "\n", false, 0.0},
+    {"Pos", offsetof(InteractiveMotorData, pos_), "  Position   : ", " rad\n", true, 5.0},
+    {"Vel", offsetof(InteractiveMotorData, vel_), "  Velocity   : ", " rad/s\n", true, 5.0},
+    {"Torque", offsetof(InteractiveMotorData, tau_), "  Torque     : ", " N·m\n", true, 5.0},
+    {"Pos_des", offsetof(InteractiveMotorData, pos_des_), "  Pos_des    : ", " rad\n", false, 0.0},
+    {"Vel_des", offsetof(InteractiveMotorData, vel_des_), "  Vel_des    : ", " rad/s\n", false, 0.0},
+    {"Kp", offsetof(InteractiveMotorData, kp_), "  Kp         : ", "\n", false, 0.0},
+    {"Kd", offsetof(InteractiveMotorData, kd_), "  Kd         : ", "\n", false, 0.0},
+    {"FF", offsetof(InteractiveMotorData, ff_), "  Feedforward: ", " N·m\n", false, 0.0},
+    {"Error", offsetof(InteractiveMotorData, error_), "  Error: ", " \n", true, 0.0},
+    {"Temperatrue", offsetof(InteractiveMotorData, temperature_), "  Temperature: ", " \n", true, 100.0}, // 变量名沿用旧版本，保证已保存的 PlotJuggler 布局可用
+    {"Mos Temperature", offsetof(InteractiveMotorData, mos_temperature_), "  Mos Temperature: ", " \n", true, 100.0},
+};
+
+static constexpr size_t MOTOR_FIELD_COUNT = sizeof(MOTOR_FIELDS) / sizeof(MOTOR_FIELDS[0]);
+static_assert(MOTOR_FIELD_COUNT * sizeof(double) == sizeof(InteractiveMotorData), "MOTOR_FIELDS must describe every field of InteractiveMotorData.");
+
+/**
+ * @brief 统计 plotted 字段数
+ */
+constexpr size_t countPlottedFields()
+{
+  size_t count = 0;
+  for (size_t i = 0; i < MOTOR_FIELD_COUNT; ++i)
+  {
+    if (MOTOR_FIELDS[i].plotted)
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static constexpr size_t PLOTTED_FIELD_COUNT = countPlottedFields();
+
+/**
+ * @brief 生成 plotted 字段在 MOTOR_FIELDS 中的下标表
+ */
+constexpr std::array<size_t, PLOTTED_FIELD_COUNT> makePlottedFieldIndices()
+{
+  std::array<size_t, PLOTTED_FIELD_COUNT> indices{};
+  size_t n = 0;
+  for (size_t i = 0; i < MOTOR_FIELD_COUNT; ++i)
+  {
+    if (MOTOR_FIELDS[i].plotted)
+    {
+      indices[n++] = i;
+    }
+  }
+  return indices;
+}
+
+static constexpr std::array<size_t, PLOTTED_FIELD_COUNT> PLOTTED_FIELDS = makePlottedFieldIndices();
+
+/**
+ * @brief 查找字段在 plotted 字段中的位置
+ * @param offset 字段偏移（offsetof(InteractiveMotorData, xxx)）
+ * @return 位置；该字段未显示时返回 PLOTTED_FIELD_COUNT
+ */
+constexpr size_t plottedFieldPosition(size_t offset)
+{
+  for (size_t p = 0; p < PLOTTED_FIELD_COUNT; ++p)
+  {
+    if (MOTOR_FIELDS[PLOTTED_FIELDS[p]].offset == offset)
+    {
+      return p;
+    }
+  }
+  return PLOTTED_FIELD_COUNT;
+}
+
+// 错误码在解码结果中的位置（错误类型界面使用）
+static constexpr size_t PLOTTED_ERROR_POSITION = plottedFieldPosition(offsetof(InteractiveMotorData, error_));
+static_assert(PLOTTED_ERROR_POSITION < PLOTTED_FIELD_COUNT, "The Error field must stay plotted (used by the Motor Errors window).");
+
+/**
+ * @brief 读取 MOTOR_FIELDS[FieldIndex] 描述的字段
+ */
+template <size_t FieldIndex>
+inline double motorFieldValue(const InteractiveMotorData &m)
+{
+  static_assert(FieldIndex < MOTOR_FIELD_COUNT, "Field index out of range.");
+  return *reinterpret_cast<const double *>(reinterpret_cast<const char *>(&m) + MOTOR_FIELDS[FieldIndex].offset);
+}
+
+/**
+ * @brief 运行时按下标读取字段（日志等非热点路径使用）
+ */
+inline double motorFieldValue(const InteractiveMotorData &m, size_t field_index)
+{
+  return *reinterpret_cast<const double *>(reinterpret_cast<const char *>(&m) + MOTOR_FIELDS[field_index].offset);
+}
+
+template <size_t... P>
+inline void decodePlottedFieldsImpl(const InteractiveMotorData &m, double *out, std::index_sequence<P...>)
+{
+  ((out[P] = motorFieldValue<PLOTTED_FIELDS[P]>(m)), ...);
+}
+
+/**
+ * @brief 按 plotted 字段顺序解码一个电机的数据
+ * @param m   电机数据
+ * @param out 输出数组，至少容纳 PLOTTED_FIELD_COUNT 个元素
+ *
+ * 编译期展开为 PLOTTED_FIELD_COUNT 次固定偏移的读取，不分配内存。
+ */
+inline void decodePlottedFields(const InteractiveMotorData &m, double *out)
+{
+  decodePlottedFieldsImpl(m, out, std::make_index_sequence<PLOTTED_FIELD_COUNT>{});
+}
@@ -0,0 +1,577 @@
+/**
+ * @file motorLogLoader.cpp
+ * @brief 已记录电机日志的快速加载实现（mmap + 二进制直接抽取 + 文本分块并行解析）
+ * @author mafangniu
+ * @date 2025-04-30
+ */
+
+#include "motorLogLoader.h"
+#include "binaryLog.h"
+#include "specTokens.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+constexpr char FRAME_PREFIX[] = "===== Frame [";
+constexpr size_t FRAME_PREFIX_LEN = sizeof(FRAME_PREFIX) - 1;
+constexpr size_t TIMESTAMP_LEN = 19; // yyyy-mm-dd-hh-mm-ss
+
+unsigned resolveThreads(unsigned threads, size_t work_items)
+{
+  if (threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, work_items)));
+}
+
+/**
+ * @brief 在 [0, count) 上并行执行 fn(begin, end)，每个线程一段连续区间
+ */
+template <typename Fn>
+void parallelFor(size_t count, unsigned threads, Fn &&fn)
+{
+  threads = resolveThreads(threads, count);
+  if (threads <= 1)
+  {
+    fn(size_t(0), count);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned t = 0; t < threads; ++t)
+  {
+    const size_t begin = count * t / threads;
+    const size_t end = count * (t + 1) / threads;
+    workers.emplace_back([&fn, begin, end]() { fn(begin, end); });
+  }
+  for (auto &w : workers)
+  {
+    w.join();
+  }
+}
+
+// ---------------- 文本日志 ----------------
+
+/**
+ * @brief 文本日志中各绘图字段的标签（去掉首尾空格和冒号，如 "Position"）
+ */
+struct PlottedLabels
+{
+  std::string text[PLOTTED_FIELD_COUNT];
+
+  PlottedLabels()
+  {
+    for (size_t p = 0; p < PLOTTED_FIELD_COUNT; ++p)
+    {
+      std::string label = MOTOR_FIELDS[PLOTTED_FIELDS[p]].log_label;
+      const size_t first = label.find_first_not_of(' ');
+      const size_t colon = label.find(':');
+      label = label.substr(first, colon - first);
+      label.erase(label.find_last_not_of(' ') + 1);
+      text[p] = label;
+    }
+  }
+
+  int find(const char *label, size_t len) const
+  {
+    for (size_t p = 0; p < PLOTTED_FIELD_COUNT; ++p)
+    {
+      if (text[p].size() == len && std::memcmp(text[p].data(), label, len) == 0)
+      {
+        return static_cast<int>(p);
+      }
+    }
+    return -1;
+  }
+};
+
+/**
+ * @brief 不依赖 locale 的数值解析（日志为 std::fixed 4 位小数，nan/inf 等少见情况回退 strtod）
+ */
+double parseNumber(const char *p, const char *end)
+{
+  static constexpr double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                     1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int fraction_digits = 0;
+  bool any = false;
+  bool in_fraction = false;
+  for (; p < end; ++p)
+  {
+    const char c = *p;
+    if (c >= '0' && c <= '9')
+    {
+      if (digits >= 18)
+      {
+        break; // 超出定点解析范围，回退
+      }
+      mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+      ++digits;
+      fraction_digits += in_fraction ? 1 : 0;
+      any = true;
+    }
+    else if (c == '.' && !in_fraction)
+    {
+      in_fraction = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if (any && (p == end || *p == ' ' || *p == '\n' || *p == '\r'))
+  {
+    const double value = static_cast<double>(mantissa) / POW10[fraction_digits];
+    return negative ? -value : value;
+  }
+
+  // 回退：nan / inf / 科学计数法 / 超长数字
+  char buf[64];
+  const size_t len = std::min<size_t>(sizeof(buf) - 1, static_cast<size_t>(end - start));
+  std::memcpy(buf, start, len);
+  buf[len] = '\0';
+  char *parsed_end = nullptr;
+  const double value = std::strtod(buf, &parsed_end);
+  return parsed_end == buf ? NaN : value;
+}
+
+/**
+ * @brief 解析帧标识 "yyyy-mm-dd-hh-mm-ss"（本地时间）为 Unix 秒，格式不符返回 NaN
+ */
+double parseFrameTimestamp(const char *p)
+{
+  int v[6];
+  static constexpr int POS[6] = {0, 5, 8, 11, 14, 17};
+  static constexpr int LEN[6] = {4, 2, 2, 2, 2, 2};
+  for (int i = 0; i < 6; ++i)
+  {
+    int x = 0;
+    for (int k = 0; k < LEN[i]; ++k)
+    {
+      const char c = p[POS[i] + k];
+      if (c < '0' || c > '9')
+      {
+        return NaN;
+      }
+      x = x * 10 + (c - '0');
+    }
+    v[i] = x;
+  }
+  std::tm tm_local{};
+  tm_local.tm_year = v[0] - 1900;
+  tm_local.tm_mon = v[1] - 1;
+  tm_local.tm_mday = v[2];
+  tm_local.tm_hour = v[3];
+  tm_local.tm_min = v[4];
+  tm_local.tm_sec = v[5];
+  tm_local.tm_isdst = -1;
+  return static_cast<double>(std::mktime(&tm_local));
+}
+
+/**
+ * @brief 一个文本块的解析结果
+ */
+struct TextChunk
+{
+  std::vector<double> seconds;              ///< 每帧的帧标识（Unix 秒）
+  bool has_subsecond = false;               ///< 帧标识是否带小数秒（MotorTextFormatter 写入的 ".uuuuuu"）
+  std::vector<std::vector<double>> columns; ///< 与 MotorLogColumns::columns 相同的布局
+  int motor_count = 0;
+};
+
+/**
+ * @brief 解析 [begin, end) 内的文本帧（begin 位于帧头或文件开头）
+ */
+void parseTextChunk(const char *begin, const char *end, const PlottedLabels &labels, TextChunk &chunk)
+{
+  const char *cached_stamp = nullptr; // 上一个帧标识，同一秒内的帧不再调用 mktime
+  double cached_seconds = NaN;
+  int motor = -1;
+
+  for (const char *line = begin; line < end;)
+  {
+    const char *eol = static_cast<const char *>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+    if (!eol)
+    {
+      eol = end;
+    }
+    const size_t len = static_cast<size_t>(eol - line);
+
+    if (len >= 2 && line[0] == ' ' && line[1] == ' ')
+    {
+      // "  Position   : 0.6113 rad"
+      if (motor >= 0 && !chunk.seconds.empty())
+      {
+        const char *colon = static_cast<const char *>(std::memchr(line, ':', len));
+        if (colon)
+        {
+          const char *label = line + 2;
+          while (label < colon && *label == ' ')
+            ++label;
+          const char *label_end = colon;
+          while (label_end > label && label_end[-1] == ' ')
+            --label_end;
+          const int p = labels.find(label, static_cast<size_t>(label_end - label));
+          if (p >= 0)
+          {
+            const char *value = colon + 1;
+            while (value < eol && *value == ' ')
+              ++value;
+            chunk.columns[motor * PLOTTED_FIELD_COUNT + p].back() = parseNumber(value, eol);
+          }
+        }
+      }
+    }
+    else if (len >= 6 && std::memcmp(line, "Motor[", 6) == 0)
+    {
+      // "Motor[3]"
+      int index = 0;
+      const char *p = line + 6;
+      bool valid = p < eol;
+      for (; p < eol && *p != ']'; ++p)
+      {
+        valid = valid && *p >= '0' && *p <= '9';
+        index = index * 10 + (*p - '0');
+        if (index >= MAX_MOTOR_COUNT)
+        {
+          valid = false;
+          break;
+        }
+      }
+      motor = (valid && !chunk.seconds.empty()) ? index : -1;
+      if (motor >= chunk.motor_count)
+      {
+        // 新出现的电机：之前的帧补 NaN
+        chunk.columns.resize(static_cast<size_t>(motor + 1) * PLOTTED_FIELD_COUNT, std::vector<double>(chunk.seconds.size(), NaN));
+        chunk.motor_count = motor + 1;
+      }
+    }
+    else if (len >= FRAME_PREFIX_LEN + TIMESTAMP_LEN && std::memcmp(line, FRAME_PREFIX, FRAME_PREFIX_LEN) == 0)
+    {
+      // "===== Frame [2025-04-05-00-45-49] =====" 或 "===== Frame [2025-04-05-00-45-49.123456] ====="
+      const char *stamp = line + FRAME_PREFIX_LEN;
+      if (!cached_stamp || std::memcmp(stamp, cached_stamp, TIMESTAMP_LEN) != 0)
+      {
+        cached_stamp = stamp;
+        cached_seconds = parseFrameTimestamp(stamp);
+      }
+      double fraction = 0.0;
+      const char *digit = stamp + TIMESTAMP_LEN;
+      if (digit < eol && *digit == '.')
+      {
+        double scale = 0.1;
+        for (++digit; digit < eol && *digit >= '0' && *digit <= '9'; ++digit, scale *= 0.1)
+        {
+          fraction += (*digit - '0') * scale;
+        }
+        chunk.has_subsecond = true;
+      }
+      chunk.seconds.push_back(cached_seconds + fraction);
+      for (auto &column : chunk.columns)
+      {
+        column.push_back(NaN);
+      }
+      motor = -1;
+    }
+
+    line = eol + 1;
+  }
+}
+
+/**
+ * @brief 将 [0, size) 按帧头切成约 count 块，返回各块起始偏移（末尾附 size）
+ */
+std::vector<size_t> splitAtFrames(const char *data, size_t size, unsigned count)
+{
+  static constexpr char NEEDLE[] = "\n===== Frame [";
+  std::vector<size_t> bounds{0};
+  for (unsigned i = 1; i < count; ++i)
+  {
+    const size_t from = std::max(bounds.back(), size * i / count);
+    const void *hit = memmem(data + from, size - from, NEEDLE, sizeof(NEEDLE) - 1);
+    if (!hit)
+    {
+      break;
+    }
+    const size_t pos = static_cast<size_t>(static_cast<const char *>(hit) - data) + 1;
+    if (pos > bounds.back())
+    {
+      bounds.push_back(pos);
+    }
+  }
+  bounds.push_back(size);
+  return bounds;
+}
+} // namespace
+
+// ---------------- MappedFile ----------------
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const std::string &filename, std::string *error)
+{
+  close();
+  const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    setError(error, "无法打开文件 " + filename + ": " + std::strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    setError(error, "无法读取文件大小 " + filename + ": " + std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0)
+  {
+    void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      setError(error, "无法映射文件 " + filename + ": " + std::strerror(errno));
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+    ::madvise(p, size_, MADV_SEQUENTIAL | MADV_WILLNEED); // 顺序预读
+    data_ = static_cast<const char *>(p);
+  }
+  ::close(fd); // 映射建立后不再需要文件描述符
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_)
+  {
+    ::munmap(const_cast<char *>(data_), size_);
+    data_ = nullptr;
+  }
+  size_ = 0;
+}
+
+// ---------------- 加载 ----------------
+
+MotorLogFormat detectMotorLogFormat(const char *data, size_t size)
+{
+  if (size >= sizeof(BINARY_LOG_MAGIC) && std::memcmp(data, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) == 0)
+  {
+    return MotorLogFormat::Binary;
+  }
+  // 文本日志以帧头开始（允许前面有空行）
+  size_t pos = 0;
+  while (pos < size && (data[pos] == '\n' || data[pos] == '\r'))
+  {
+    ++pos;
+  }
+  if (size - pos >= FRAME_PREFIX_LEN && std::memcmp(data + pos, FRAME_PREFIX, FRAME_PREFIX_LEN) == 0)
+  {
+    return MotorLogFormat::Text;
+  }
+  return MotorLogFormat::Unknown;
+}
+
+bool loadBinaryMotorLog(const char *data, size_t size, MotorLogColumns &out, unsigned threads, std::string *error)
+{
+  BinaryLogHeader header;
+  if (size < sizeof(header))
+  {
+    setError(error, "文件过短，不是有效的二进制日志");
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0 || header.version != BINARY_LOG_VERSION ||
+      header.motor_count == 0 || header.motor_count > static_cast<uint32_t>(MAX_MOTOR_COUNT) || header.header_size > size ||
+      header.record_size != sizeof(double) + header.motor_count * header.motor_size)
+  {
+    setError(error, "二进制日志文件头无效或版本不支持");
+    return false;
+  }
+
+  // 按字段名在文件头中查找绘图字段的偏移（与 BinaryLogReader 相同，兼容发送端字段布局变化）
+  long offsets[PLOTTED_FIELD_COUNT];
+  for (size_t p = 0; p < PLOTTED_FIELD_COUNT; ++p)
+  {
+    offsets[p] = -1;
+    const char *name = MOTOR_FIELDS[PLOTTED_FIELDS[p]].name;
+    for (uint32_t f = 0; f < std::min(header.field_count, BINARY_LOG_FIELD_COUNT); ++f)
+    {
+      if (std::strncmp(header.fields[f].name, name, sizeof(header.fields[f].name)) == 0 &&
+          header.fields[f].offset + sizeof(double) <= header.motor_size)
+      {
+        offsets[p] = static_cast<long>(header.fields[f].offset);
+        break;
+      }
+    }
+  }
+
+  const size_t records = (size - header.header_size) / header.record_size;
+  const char *base = data + header.header_size;
+  const int motors = static_cast<int>(header.motor_count);
+
+  out.motor_count = motors;
+  out.stamps.assign(records, 0.0);
+  out.columns.assign(static_cast<size_t>(motors) * PLOTTED_FIELD_COUNT, std::vector<double>());
+
+  // 每个线程负责一段连续的电机（同一电机的字段在记录中相邻），第 0 段同时抽取时间戳
+  parallelFor(static_cast<size_t>(motors), threads,
+              [&](size_t motor_begin, size_t motor_end)
+              {
+                if (motor_begin == 0)
+                {
+                  for (size_t r = 0; r < records; ++r)
+                  {
+                    std::memcpy(&out.stamps[r], base + r * header.record_size, sizeof(double));
+                  }
+                }
+                for (size_t m = motor_begin; m < motor_end; ++m)
+                {
+                  const char *motor_base = base + sizeof(double) + m * header.motor_size;
+                  for (size_t p = 0; p < PLOTTED_FIELD_COUNT; ++p)
+                  {
+                    std::vector<double> &column = out.columns[m * PLOTTED_FIELD_COUNT + p];
+                    if (offsets[p] < 0)
+                    {
+                      column.assign(records, NaN);
+                      continue;
+                    }
+                    column.resize(records);
+                    const char *src = motor_base + offsets[p];
+                    for (size_t r = 0; r < records; ++r, src += header.record_size)
+                    {
+                      std::memcpy(&column[r], src, sizeof(double));
+                    }
+                  }
+                }
+              });
+  return true;
+}
+
+bool parseTextMotorLog(const char *data, size_t size, MotorLogColumns &out, unsigned threads, std::string *error)
+{
+  static const PlottedLabels labels;
+
+  // 1. 按帧头切块，每块约 4MB 以上才值得多开一个线程
+  const unsigned chunk_count = resolveThreads(threads, std::max<size_t>(1, size / (4u << 20)));
+  const std::vector<size_t> bounds = splitAtFrames(data, size, chunk_count);
+  std::vector<TextChunk> chunks(bounds.size() - 1);
+
+  // 2. 各块并行解析
+  parallelFor(chunks.size(), static_cast<unsigned>(chunks.size()),
+              [&](size_t begin, size_t end)
+              {
+                for (size_t c = begin; c < end; ++c)
+                {
+                  parseTextChunk(data + bounds[c], data + bounds[c + 1], labels, chunks[c]);
+                }
+              });
+
+  // 3. 按块顺序拼接
+  size_t total = 0;
+  int motors = 0;
+  for (const TextChunk &chunk : chunks)
+  {
+    total += chunk.seconds.size();
+    motors = std::max(motors, chunk.motor_count);
+  }
+  if (total == 0)
+  {
+    setError(error, "文件中没有可识别的电机数据帧");
+    return false;
+  }
+
+  out.motor_count = motors;
+  out.stamps.clear();
+  out.stamps.reserve(total);
+  for (const TextChunk &chunk : chunks)
+  {
+    out.stamps.insert(out.stamps.end(), chunk.seconds.begin(), chunk.seconds.end());
+  }
+  out.columns.assign(static_cast<size_t>(motors) * PLOTTED_FIELD_COUNT, std::vector<double>());
+  parallelFor(out.columns.size(), threads,
+              [&](size_t begin, size_t end)
+              {
+                for (size_t col = begin; col < end; ++col)
+                {
+                  std::vector<double> &column = out.columns[col];
+                  column.reserve(total);
+                  for (const TextChunk &chunk : chunks)
+                  {
+                    if (col < chunk.columns.size())
+                      column.insert(column.end(), chunk.columns[col].begin(), chunk.columns[col].end());
+                    else
+                      column.insert(column.end(), chunk.seconds.size(), NaN);
+                  }
+                }
+              });
+
+  // 4. 旧版日志帧标识只精确到秒：同一秒内的 k 帧依次取 sec + i / k，保证时间单调（带小数秒的日志保持原值）
+  bool has_subsecond = false;
+  for (const TextChunk &chunk : chunks)
+  {
+    has_subsecond = has_subsecond || chunk.has_subsecond;
+  }
+  for (size_t i = 0; i < total && !has_subsecond;)
+  {
+    size_t j = i + 1;
+    while (j < total && out.stamps[j] == out.stamps[i])
+    {
+      ++j;
+    }
+    const double sec = out.stamps[i];
+    const double count = static_cast<double>(j - i);
+    for (size_t k = i; k < j; ++k)
+    {
+      out.stamps[k] = sec + static_cast<double>(k - i) / count;
+    }
+    i = j;
+  }
+  return true;
+}
+
+bool loadMotorLogFile(const std::string &filename, MotorLogColumns &out, unsigned threads, std::string *error)
+{
+  MappedFile file;
+  if (!file.open(filename, error))
+  {
+    return false;
+  }
+  switch (detectMotorLogFormat(file.data(), file.size()))
+  {
+  case MotorLogFormat::Binary:
+    return loadBinaryMotorLog(file.data(), file.size(), out, threads, error);
+  case MotorLogFormat::Text:
+    return parseTextMotorLog(file.data(), file.size(), out, threads, error);
+  case MotorLogFormat::Unknown:
+    break;
+  }
+  setError(error, "无法识别的日志格式: " + filename);
+  return false;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file motorLogLoader.h
+ * @brief 已记录电机日志（文本 .txt / 二进制 .bin）的快速加载，供回放插件使用
+ * @author mafangniu
+ * @date 2025-04-30
+ *
+ * @details
+ * 不依赖 Qt 和 PlotJuggler，把日志解析为按列存放的曲线数据（每个电机的每个绘图字段一列），
+ * 曲线与实时插件相同（MOTOR_FIELDS 中 plotted 的字段，MotorN/Field）：
+ * - 日志文件用 mmap 映射，不经过 iostream 逐行读取；
+ * - 二进制日志：定长记录直接按文件头中的字段偏移取值，按电机分给多个线程并行抽取；
+ * - 文本日志：按 "===== Frame [" 帧边界把文件切成若干块并行解析，数值用不依赖 locale 的定点解析，
+ *   最后按块顺序拼接。帧标识带微秒（MotorTextFormatter 写入）时直接使用；旧版日志的帧标识只精确到秒，
+ *   同一秒内的 k 帧按顺序均匀分布在该秒内（i / k）。
+ *
+ * 缺失的电机或字段以 NaN 填充（例如同一文本文件中途电机数变化），回放时跳过。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "motorFields.h"
+
+/**
+ * @class MappedFile
+ * @brief 只读内存映射文件（RAII）
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief 映射整个文件（空文件也视为成功，size() 为 0）
+   * @param filename 文件名
+   * @param error 失败时写入原因（可为 nullptr）
+   */
+  bool open(const std::string &filename, std::string *error = nullptr);
+
+  void close();
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief 按列存放的日志曲线数据
+ */
+struct MotorLogColumns
+{
+  int motor_count = 0;      ///< 电机数（各帧中的最大值）
+  std::vector<double> stamps; ///< 每帧时间戳（Unix 秒）
+  /// columns[motor * PLOTTED_FIELD_COUNT + p][frame] 为第 motor 个电机第 p 个绘图字段（PLOTTED_FIELDS[p]）的值
+  std::vector<std::vector<double>> columns;
+
+  size_t frameCount() const { return stamps.size(); }
+};
+
+/**
+ * @brief 日志文件格式
+ */
+enum class MotorLogFormat
+{
+  Unknown,
+  Text,  ///< printMotorDataToFile() / writeMotorFrame() 文本格式
+  Binary ///< BinaryLogFile 二进制格式（见 binaryLog.h）
+};
+
+/**
+ * @brief 根据文件内容判断日志格式（二进制看魔数，文本看第一帧的帧头）
+ */
+MotorLogFormat detectMotorLogFormat(const char *data, size_t size);
+
+/**
+ * @brief 从内存中的二进制日志抽取曲线数据
+ * @param data    文件内容
+ * @param size    文件字节数
+ * @param out     输出（原内容被替换）
+ * @param threads 并行线程数，0 表示按 CPU 核数
+ * @param error   失败时写入原因（可为 nullptr）
+ * @return 文件头有效返回 true（末尾不完整的记录被忽略）
+ */
+bool loadBinaryMotorLog(const char *data, size_t size, MotorLogColumns &out, unsigned threads = 0, std::string *error = nullptr);
+
+/**
+ * @brief 并行解析内存中的文本日志
+ * @param data    文件内容
+ * @param size    文件字节数
+ * @param out     输出（原内容被替换）
+ * @param threads 并行线程数，0 表示按 CPU 核数
+ * @param error   失败时写入原因（可为 nullptr）
+ * @return 至少解析出一帧返回 true
+ */
+bool parseTextMotorLog(const char *data, size_t size, MotorLogColumns &out, unsigned threads = 0, std::string *error = nullptr);
+
+/**
+ * @brief 映射并加载日志文件（自动判断格式）
+ * @param filename 日志文件名
+ * @param out      输出
+ * @param threads  并行线程数，0 表示按 CPU 核数
+ * @param error    失败时写入原因（可为 nullptr）
+ */
+bool loadMotorLogFile(const std::string &filename, MotorLogColumns &out, unsigned threads = 0, std::string *error = nullptr);
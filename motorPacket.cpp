@@ -0,0 +1,403 @@
+/**
+ * @file motorPacket.cpp
+ * @brief UDP 电机数据报解析实现
+ * @author mafangniu
+ * @date 2025-04-22
+ */
+
+#include "motorPacket.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// 紧凑格式解码按 double 下标直接写 InteractiveMotorData：tau_ ~ ff_ 为连续 8 个 double，对应 values[0 ~ 7]
+static_assert(offsetof(InteractiveMotorData, mode) == 0 * sizeof(double) && offsetof(InteractiveMotorData, index) == 1 * sizeof(double),
+              "Compact decoding assumes mode/index are the first two fields.");
+static_assert(offsetof(InteractiveMotorData, tau_) == 2 * sizeof(double) && offsetof(InteractiveMotorData, ff_) == 9 * sizeof(double),
+              "Compact decoding assumes tau_ .. ff_ are contiguous.");
+static_assert(offsetof(InteractiveMotorData, error_) == 10 * sizeof(double) && offsetof(InteractiveMotorData, mos_temperature_) == 12 * sizeof(double),
+              "Compact decoding assumes error_, temperature_, mos_temperature_ are the last three fields.");
+
+static inline double *motorDoubles(InteractiveMotorData &m)
+{
+  return reinterpret_cast<double *>(&m);
+}
+
+static inline const double *motorDoubles(const InteractiveMotorData &m)
+{
+  return reinterpret_cast<const double *>(&m);
+}
+
+/**
+ * @brief 整数字段取整并限制在目标类型范围内（NaN 记为 0）
+ */
+static inline int32_t roundToInt(double v, double lo, double hi)
+{
+  if (!(v == v))
+  {
+    return 0;
+  }
+  return static_cast<int32_t>(std::lround(std::min(hi, std::max(lo, v))));
+}
+
+/**
+ * @brief 一个电机的紧凑记录 -> InteractiveMotorData（物理量为连续的 float -> double 转换，编译器可向量化）
+ */
+static inline void expandCompactRecord(const CompactMotorRecord &r, InteractiveMotorData &m)
+{
+  double *d = motorDoubles(m);
+  d[0] = r.mode;
+  d[1] = r.index;
+  for (int k = 0; k < 8; ++k)
+  {
+    d[2 + k] = r.values[k];
+  }
+  d[10] = r.error;
+  d[11] = r.values[8];
+  d[12] = r.values[9];
+}
+
+static inline void packCompactRecord(const InteractiveMotorData &m, CompactMotorRecord &r)
+{
+  const double *d = motorDoubles(m);
+  r.mode = static_cast<int16_t>(roundToInt(d[0], INT16_MIN, INT16_MAX));
+  r.index = static_cast<int16_t>(roundToInt(d[1], INT16_MIN, INT16_MAX));
+  r.error = roundToInt(d[10], INT32_MIN, INT32_MAX);
+  for (int k = 0; k < 8; ++k)
+  {
+    r.values[k] = static_cast<float>(d[2 + k]);
+  }
+  r.values[8] = static_cast<float>(d[11]);
+  r.values[9] = static_cast<float>(d[12]);
+}
+
+// CompactMotorRecord::values[k] -> InteractiveMotorData 中的 double 下标
+static constexpr int COMPACT_VALUE_FIELD[10] = {2, 3, 4, 5, 6, 7, 8, 9, 11, 12};
+
+/**
+ * @brief 把差分帧中的一个字写入对应字段（字 0 为 mode + index，字 1 为 error，其余为 values）
+ */
+static inline void applyCompactWord(InteractiveMotorData &m, int word, const char *src)
+{
+  double *d = motorDoubles(m);
+  if (word >= 2)
+  {
+    float f;
+    std::memcpy(&f, src, sizeof(f));
+    d[COMPACT_VALUE_FIELD[word - 2]] = f;
+  }
+  else if (word == 1)
+  {
+    int32_t error;
+    std::memcpy(&error, src, sizeof(error));
+    d[10] = error;
+  }
+  else
+  {
+    int16_t mode_index[2];
+    std::memcpy(mode_index, src, sizeof(mode_index));
+    d[0] = mode_index[0];
+    d[1] = mode_index[1];
+  }
+}
+
+static constexpr uint32_t COMPACT_WORD_MASK = (1u << COMPACT_WORD_COUNT) - 1; // 变化掩码中的有效位
+
+// 差分帧中变化掩码区的字节数（按 4 字节对齐）
+static inline size_t compactMaskBytes(size_t motor_count)
+{
+  return (motor_count * sizeof(uint16_t) + 3) & ~static_cast<size_t>(3);
+}
+
+/**
+ * @brief 解析紧凑格式数据报（包头已校验：magic、版本、电机数）
+ */
+static MotorPacketStatus decodeCompactPacket(const char *bytes, size_t len, const MotorPacketHeader &header,
+                                             RawMotorFrame &frame, CompactKeyframe *keyframe)
+{
+  const bool has_stamp = (header.flags & MOTOR_PACKET_FLAG_SENDER_STAMP) != 0;
+  const size_t stamp_bytes = has_stamp ? sizeof(double) : 0;
+  const size_t motor_count = header.motor_count;
+  const char *body = bytes + sizeof(header);
+  size_t body_bytes = 0;
+
+  if ((header.flags & MOTOR_PACKET_FLAG_DELTA) == 0)
+  {
+    // 关键帧：motor_count 条定长记录
+    body_bytes = sizeof(CompactMotorRecord) * motor_count;
+    if (len != sizeof(header) + body_bytes + stamp_bytes)
+    {
+      return MotorPacketStatus::SizeMismatch;
+    }
+    CompactMotorRecord records[MAX_MOTOR_COUNT];
+    std::memcpy(records, body, body_bytes);
+    for (size_t m = 0; m < motor_count; ++m)
+    {
+      expandCompactRecord(records[m], frame.motors[m]);
+    }
+    if (keyframe)
+    {
+      keyframe->valid = true;
+      keyframe->sequence = header.sequence;
+      keyframe->motor_count = header.motor_count;
+      std::memcpy(keyframe->records, records, body_bytes);
+    }
+  }
+  else
+  {
+    // 差分帧：关键帧序号 + 变化掩码 + 变化的槽位值
+    const size_t mask_bytes = compactMaskBytes(motor_count);
+    if (len < sizeof(header) + sizeof(uint32_t) + mask_bytes + stamp_bytes)
+    {
+      return MotorPacketStatus::SizeMismatch;
+    }
+    uint32_t key_sequence;
+    std::memcpy(&key_sequence, body, sizeof(key_sequence));
+    uint16_t masks[MAX_MOTOR_COUNT];
+    std::memcpy(masks, body + sizeof(uint32_t), motor_count * sizeof(uint16_t));
+    size_t changed = 0;
+    for (size_t m = 0; m < motor_count; ++m)
+    {
+      changed += __builtin_popcount(masks[m] & COMPACT_WORD_MASK);
+    }
+    body_bytes = sizeof(uint32_t) + mask_bytes + changed * sizeof(uint32_t);
+    if (len != sizeof(header) + body_bytes + stamp_bytes)
+    {
+      return MotorPacketStatus::SizeMismatch;
+    }
+    if (!keyframe || !keyframe->valid || keyframe->sequence != key_sequence || keyframe->motor_count != header.motor_count)
+    {
+      return MotorPacketStatus::MissingKeyframe;
+    }
+
+    // 先按关键帧展开，再只改写变化的字对应的字段
+    const char *value = body + sizeof(uint32_t) + mask_bytes;
+    for (size_t m = 0; m < motor_count; ++m)
+    {
+      expandCompactRecord(keyframe->records[m], frame.motors[m]);
+      for (uint32_t mask = masks[m] & COMPACT_WORD_MASK; mask != 0; mask &= mask - 1)
+      {
+        applyCompactWord(frame.motors[m], __builtin_ctz(mask), value);
+        value += sizeof(uint32_t);
+      }
+    }
+  }
+
+  frame.motor_count = header.motor_count;
+  frame.sequence = header.sequence;
+  frame.flags = FRAME_FLAG_SEQUENCE;
+  if (has_stamp)
+  {
+    std::memcpy(&frame.stamp, body + body_bytes, sizeof(double));
+    frame.flags |= FRAME_FLAG_SENDER_STAMP;
+  }
+  return MotorPacketStatus::Ok;
+}
+
+MotorPacketStatus decodeMotorPacket(const void *data, size_t len, RawMotorFrame &frame, CompactKeyframe *keyframe)
+{
+  const char *bytes = static_cast<const char *>(data);
+  const size_t legacy_bytes = sizeof(InteractiveMotorData) * MOTOR_COUNT;
+
+  // 1. 带包头的自描述数据报
+  MotorPacketHeader header;
+  if (len >= sizeof(header))
+  {
+    std::memcpy(&header, bytes, sizeof(header));
+  }
+  if (len >= sizeof(header) && header.magic == MOTOR_PACKET_MAGIC)
+  {
+    if (header.schema_version != MOTOR_PACKET_SCHEMA_VERSION && header.schema_version != MOTOR_PACKET_SCHEMA_COMPACT)
+    {
+      return MotorPacketStatus::UnsupportedVersion;
+    }
+    if (header.motor_count == 0 || header.motor_count > MAX_MOTOR_COUNT)
+    {
+      return MotorPacketStatus::BadMotorCount;
+    }
+    if (header.schema_version == MOTOR_PACKET_SCHEMA_COMPACT)
+    {
+      return decodeCompactPacket(bytes, len, header, frame, keyframe);
+    }
+    const bool has_stamp = (header.flags & MOTOR_PACKET_FLAG_SENDER_STAMP) != 0;
+    const size_t motor_bytes = sizeof(InteractiveMotorData) * header.motor_count;
+    if (len != sizeof(header) + motor_bytes + (has_stamp ? sizeof(double) : 0))
+    {
+      return MotorPacketStatus::SizeMismatch;
+    }
+
+    std::memcpy(frame.motors, bytes + sizeof(header), motor_bytes);
+    frame.motor_count = header.motor_count;
+    frame.sequence = header.sequence;
+    frame.flags = FRAME_FLAG_SEQUENCE;
+    if (has_stamp)
+    {
+      std::memcpy(&frame.stamp, bytes + sizeof(header) + motor_bytes, sizeof(double));
+      frame.flags |= FRAME_FLAG_SENDER_STAMP;
+    }
+    return MotorPacketStatus::Ok;
+  }
+
+  // 2. 旧版数据报：13 个电机，可选 8 字节发送端时间戳
+  if (len != legacy_bytes && len != legacy_bytes + sizeof(double))
+  {
+    return MotorPacketStatus::SizeMismatch;
+  }
+  std::memcpy(frame.motors, bytes, legacy_bytes);
+  frame.motor_count = MOTOR_COUNT;
+  frame.sequence = 0;
+  frame.flags = 0;
+  if (len == legacy_bytes + sizeof(double))
+  {
+    std::memcpy(&frame.stamp, bytes + legacy_bytes, sizeof(double));
+    frame.flags |= FRAME_FLAG_SENDER_STAMP;
+  }
+  return MotorPacketStatus::Ok;
+}
+
+size_t encodeMotorPacket(const RawMotorFrame &frame, void *out, size_t capacity)
+{
+  if (frame.motor_count == 0 || frame.motor_count > MAX_MOTOR_COUNT)
+  {
+    return 0;
+  }
+  const bool has_stamp = (frame.flags & FRAME_FLAG_SENDER_STAMP) != 0;
+  const size_t motor_bytes = sizeof(InteractiveMotorData) * frame.motor_count;
+  const size_t len = sizeof(MotorPacketHeader) + motor_bytes + (has_stamp ? sizeof(double) : 0);
+  if (len > capacity)
+  {
+    return 0;
+  }
+
+  MotorPacketHeader header;
+  header.magic = MOTOR_PACKET_MAGIC;
+  header.schema_version = MOTOR_PACKET_SCHEMA_VERSION;
+  header.motor_count = frame.motor_count;
+  header.sequence = frame.sequence;
+  header.flags = has_stamp ? MOTOR_PACKET_FLAG_SENDER_STAMP : 0;
+
+  char *bytes = static_cast<char *>(out);
+  std::memcpy(bytes, &header, sizeof(header));
+  std::memcpy(bytes + sizeof(header), frame.motors, motor_bytes);
+  if (has_stamp)
+  {
+    std::memcpy(bytes + sizeof(header) + motor_bytes, &frame.stamp, sizeof(double));
+  }
+  return len;
+}
+
+size_t encodeCompactMotorPacket(const RawMotorFrame &frame, void *out, size_t capacity, CompactKeyframe &keyframe, bool force_keyframe)
+{
+  if (frame.motor_count == 0 || frame.motor_count > MAX_MOTOR_COUNT)
+  {
+    return 0;
+  }
+  const bool has_stamp = (frame.flags & FRAME_FLAG_SENDER_STAMP) != 0;
+  const size_t stamp_bytes = has_stamp ? sizeof(double) : 0;
+  const size_t motor_count = frame.motor_count;
+  const size_t key_len = sizeof(MotorPacketHeader) + sizeof(CompactMotorRecord) * motor_count + stamp_bytes;
+
+  MotorPacketHeader header;
+  header.magic = MOTOR_PACKET_MAGIC;
+  header.schema_version = MOTOR_PACKET_SCHEMA_COMPACT;
+  header.motor_count = frame.motor_count;
+  header.sequence = frame.sequence;
+  header.flags = has_stamp ? MOTOR_PACKET_FLAG_SENDER_STAMP : 0;
+  char *bytes = static_cast<char *>(out);
+
+  CompactMotorRecord records[MAX_MOTOR_COUNT];
+  for (size_t m = 0; m < motor_count; ++m)
+  {
+    packCompactRecord(frame.motors[m], records[m]);
+  }
+
+  // 先尝试差分帧：统计相对关键帧变化的字，差分帧不比关键帧小时改发关键帧
+  uint16_t masks[MAX_MOTOR_COUNT];
+  size_t delta_len = 0;
+  if (!force_keyframe && keyframe.valid && keyframe.motor_count == frame.motor_count)
+  {
+    size_t changed = 0;
+    for (size_t m = 0; m < motor_count; ++m)
+    {
+      uint32_t words[COMPACT_WORD_COUNT];
+      uint32_t key_words[COMPACT_WORD_COUNT];
+      std::memcpy(words, &records[m], sizeof(words));
+      std::memcpy(key_words, &keyframe.records[m], sizeof(key_words));
+      uint16_t mask = 0;
+      for (int w = 0; w < COMPACT_WORD_COUNT; ++w)
+      {
+        mask |= static_cast<uint16_t>((words[w] != key_words[w]) << w);
+      }
+      masks[m] = mask;
+      changed += __builtin_popcount(mask);
+    }
+    delta_len = sizeof(MotorPacketHeader) + sizeof(uint32_t) + compactMaskBytes(motor_count) + changed * sizeof(uint32_t) + stamp_bytes;
+  }
+
+  if (delta_len > 0 && delta_len < key_len)
+  {
+    if (delta_len > capacity)
+    {
+      return 0;
+    }
+    header.flags |= MOTOR_PACKET_FLAG_DELTA;
+    std::memcpy(bytes, &header, sizeof(header));
+    char *body = bytes + sizeof(header);
+    std::memcpy(body, &keyframe.sequence, sizeof(uint32_t));
+    const size_t mask_bytes = compactMaskBytes(motor_count);
+    std::memset(body + sizeof(uint32_t), 0, mask_bytes);
+    std::memcpy(body + sizeof(uint32_t), masks, motor_count * sizeof(uint16_t));
+    char *value = body + sizeof(uint32_t) + mask_bytes;
+    for (size_t m = 0; m < motor_count; ++m)
+    {
+      const char *words = reinterpret_cast<const char *>(&records[m]);
+      for (uint32_t mask = masks[m]; mask != 0; mask &= mask - 1)
+      {
+        std::memcpy(value, words + __builtin_ctz(mask) * sizeof(uint32_t), sizeof(uint32_t));
+        value += sizeof(uint32_t);
+      }
+    }
+    if (has_stamp)
+    {
+      std::memcpy(value, &frame.stamp, sizeof(double));
+    }
+    return delta_len;
+  }
+
+  // 关键帧，同时更新发送端关键帧状态
+  if (key_len > capacity)
+  {
+    return 0;
+  }
+  std::memcpy(bytes, &header, sizeof(header));
+  std::memcpy(bytes + sizeof(header), records, sizeof(CompactMotorRecord) * motor_count);
+  std::memcpy(keyframe.records, records, sizeof(CompactMotorRecord) * motor_count);
+  keyframe.valid = true;
+  keyframe.sequence = frame.sequence;
+  keyframe.motor_count = frame.motor_count;
+  if (has_stamp)
+  {
+    std::memcpy(bytes + sizeof(header) + sizeof(CompactMotorRecord) * motor_count, &frame.stamp, sizeof(double));
+  }
+  return key_len;
+}
+
+const char *motorPacketStatusText(MotorPacketStatus status)
+{
+  switch (status)
+  {
+  case MotorPacketStatus::Ok:
+    return "ok";
+  case MotorPacketStatus::SizeMismatch:
+    return "字节数不匹配";
+  case MotorPacketStatus::UnsupportedVersion:
+    return "不支持的数据格式版本";
+  case MotorPacketStatus::BadMotorCount:
+    return "电机数量无效";
+  case MotorPacketStatus::MissingKeyframe:
+    return "差分帧缺少对应的关键帧";
+  }
+  return "unknown";
+}
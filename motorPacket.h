@@ -0,0 +1,123 @@
+/**
+ * @file motorPacket.h
+ * @brief UDP 电机数据报解析（兼容旧版裸结构体数组和带包头的自描述数据报）
+ * @author mafangniu
+ * @date 2025-04-22
+ *
+ * @details
+ * 支持两种数据报：
+ * - 旧版：MOTOR_COUNT(13) 个 InteractiveMotorData，可选在末尾附带 8 字节 double 发送端时间戳；
+ * - 自描述：16 字节 MotorPacketHeader + motor_count 个 InteractiveMotorData，
+ *   若 flags 含 MOTOR_PACKET_FLAG_SENDER_STAMP，则末尾再附带 8 字节 double 发送端时间戳。
+ *   包头给出电机数量、数据格式版本和序号，电机数量可在 1 ~ MAX_MOTOR_COUNT 之间，无需为不同机器人重新编译插件。
+ *
+ * 以魔数区分两种数据报（旧版数据报的前 4 字节是第一个电机 mode 的低位字节，且长度必须严格匹配）。
+ *
+ * 带宽受限（如 Wi-Fi 连接的机器人）时，发送端可在包头中声明紧凑格式（schema_version = 2），插件按包头自动识别：
+ * - 关键帧：每个电机一条 48 字节的 CompactMotorRecord（mode / index / error 为整数，其余 10 个物理量为 float32），
+ *   13 个电机 640 字节（原始格式 1352 字节）；
+ * - 差分帧（flags 含 MOTOR_PACKET_FLAG_DELTA）：包头后为 4 字节关键帧序号、每个电机 2 字节变化掩码（按 4 字节对齐），
+ *   之后依次为各电机记录中相对关键帧发生变化的 4 字节字（CompactMotorRecord 按 12 个 uint32 看待）；未变化的字沿用关键帧。
+ *   差分帧相对最近的关键帧而不是上一帧，丢失差分帧不影响后续帧，丢失关键帧时后续差分帧被丢弃，直到下一个关键帧。
+ *
+ * 紧凑格式解码后仍为 RawMotorFrame（double），之后的发布、日志等流程与原始格式完全相同。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "motorData.h"
+
+static constexpr uint32_t MOTOR_PACKET_MAGIC = 0x4D4D4A50;       // 字节序列 "PJMM"（小端）
+static constexpr uint16_t MOTOR_PACKET_SCHEMA_VERSION = 1;       // 当前支持的数据格式版本
+static constexpr uint16_t MOTOR_PACKET_SCHEMA_COMPACT = 2;      // 紧凑格式（float32 + 整数字段，可差分）
+static constexpr uint32_t MOTOR_PACKET_FLAG_SENDER_STAMP = 0x1;  // 电机数据之后附带 8 字节发送端时间戳
+static constexpr uint32_t MOTOR_PACKET_FLAG_DELTA = 0x2;         // 紧凑格式的差分帧（相对 key_sequence 指定的关键帧）
+
+// 可选的自描述包头（16 字节，小端）
+struct MotorPacketHeader
+{
+  uint32_t magic;          // MOTOR_PACKET_MAGIC
+  uint16_t schema_version; // 数据格式版本
+  uint16_t motor_count;    // 本包电机数量
+  uint32_t sequence;       // 发送端序号（每包加 1）
+  uint32_t flags;          // MOTOR_PACKET_FLAG_*
+};
+static_assert(sizeof(MotorPacketHeader) == 16, "MotorPacketHeader must be 16 bytes.");
+
+// 紧凑格式中一个电机的记录（48 字节，小端）
+struct CompactMotorRecord
+{
+  int16_t mode;     // 控制模式（取整）
+  int16_t index;    // 电机编号（取整）
+  int32_t error;    // 错误码（取整）
+  float values[10]; // tau, pos, vel, pos_des, vel_des, kp, kd, ff, temperature, mos_temperature
+};
+static_assert(sizeof(CompactMotorRecord) == 48, "CompactMotorRecord must be 48 bytes.");
+
+// 差分帧按 CompactMotorRecord 的 4 字节字编码：字 0 为 mode + index，字 1 为 error，字 2 ~ 11 为 values
+static constexpr int COMPACT_WORD_COUNT = sizeof(CompactMotorRecord) / sizeof(uint32_t);
+
+/**
+ * @brief 紧凑格式的关键帧状态（接收端每个数据源一份，用于还原差分帧；发送端用于生成差分帧）
+ */
+struct CompactKeyframe
+{
+  bool valid = false;        // 是否已收到（发出）关键帧
+  uint32_t sequence = 0;     // 关键帧序号
+  uint16_t motor_count = 0;  // 关键帧电机数
+  CompactMotorRecord records[MAX_MOTOR_COUNT]; // 关键帧各电机的紧凑记录
+};
+
+// 任意合法数据报的最大字节数（接收缓冲按此分配）
+static constexpr size_t MAX_MOTOR_PACKET_BYTES =
+    sizeof(MotorPacketHeader) + sizeof(InteractiveMotorData) * MAX_MOTOR_COUNT + sizeof(double);
+
+/**
+ * @brief 数据报解析结果
+ */
+enum class MotorPacketStatus
+{
+  Ok,                 ///< 解析成功
+  SizeMismatch,       ///< 长度与任何已知格式都不匹配
+  UnsupportedVersion, ///< 包头中的数据格式版本不支持
+  BadMotorCount,      ///< 包头中的电机数量为 0 或超过 MAX_MOTOR_COUNT
+  MissingKeyframe     ///< 紧凑格式差分帧对应的关键帧未收到（丢失或乱序）
+};
+
+/**
+ * @brief 解析一个 UDP 数据报到原始帧
+ * @param data  数据报内容
+ * @param len   数据报长度（字节）
+ * @param frame 输出帧：motor_count、motors、sequence、flags；
+ *              数据报携带发送端时间戳时写入 stamp 并置 FRAME_FLAG_SENDER_STAMP，否则 stamp 不变
+ * @param keyframe 该数据源的紧凑格式关键帧状态（收到关键帧时更新）；为 nullptr 时差分帧返回 MissingKeyframe
+ * @return 解析结果，非 Ok 时 frame 内容无效
+ */
+MotorPacketStatus decodeMotorPacket(const void *data, size_t len, RawMotorFrame &frame, CompactKeyframe *keyframe = nullptr);
+
+/**
+ * @brief 将原始帧编码为带包头的数据报（decodeMotorPacket() 的逆操作，供压测发送端等工具使用）
+ * @param frame    输入帧：使用 motor_count、motors、sequence；flags 含 FRAME_FLAG_SENDER_STAMP 时附带 stamp
+ * @param out      输出缓冲
+ * @param capacity 输出缓冲字节数，不小于 MAX_MOTOR_PACKET_BYTES 时总能容纳
+ * @return 数据报字节数；电机数量无效或缓冲不足时返回 0
+ */
+size_t encodeMotorPacket(const RawMotorFrame &frame, void *out, size_t capacity);
+
+/**
+ * @brief 将原始帧编码为紧凑格式数据报（关键帧或相对 keyframe 的差分帧）
+ * @param frame        输入帧，同 encodeMotorPacket()
+ * @param out          输出缓冲
+ * @param capacity     输出缓冲字节数，不小于 MAX_MOTOR_PACKET_BYTES 时总能容纳
+ * @param keyframe     发送端关键帧状态：发出关键帧时更新，差分帧相对它编码
+ * @param force_keyframe 为 true 时总是发出关键帧（发送端按固定间隔发关键帧）；keyframe 无效或电机数变化时也发关键帧
+ * @return 数据报字节数；电机数量无效或缓冲不足时返回 0
+ */
+size_t encodeCompactMotorPacket(const RawMotorFrame &frame, void *out, size_t capacity, CompactKeyframe &keyframe, bool force_keyframe);
+
+/**
+ * @brief 解析结果的文字描述（调试输出用）
+ */
+const char *motorPacketStatusText(MotorPacketStatus status);
@@ -0,0 +1,69 @@
+/**
+ * @file motorShmLayout.h
+ * @brief 同机发送时使用的共享内存帧环形缓冲布局（C / C++ 共用）
+ * @author mafangniu
+ * @date 2025-05-06
+ *
+ * @details
+ * 发送端与 PlotJuggler 在同一台机器上（仿真、机器人机载电脑）时，可以不经过 UDP 协议栈，
+ * 直接把数据报写入 POSIX 共享内存（/dev/shm/<名称>）中的环形缓冲：
+ *
+ *     MotorShmHeader | MotorShmSlot[slot_count]
+ *
+ * - 每个槽位存放一个完整的数据报，内容与 UDP 数据报完全相同（旧版 / 带包头 / 紧凑格式，见 motorPacket.h），
+ *   插件直接在共享内存中原地解析；
+ * - 槽位用 seqlock 保护：写第 k 帧（从 0 开始）时先把 seq 置为 2k+1，写完后置为 2k+2；
+ *   读端读第 k 帧前后各读一次 seq，两次都等于 2k+2 才有效，否则说明读端落后一圈、槽位已被覆盖；
+ * - 写端每发布一帧把 write_seq 加 1 并递增 futex_word，读端正在等待（reader_waiting 非 0）时用 FUTEX_WAKE 唤醒。
+ *
+ * 写端永远不等待读端：读端跟不上时旧帧被覆盖，读端跳到最新位置并计入丢帧。
+ * 所有共享字段都用 __atomic 内建函数访问（C 写端与 C++ 读端使用同一套内存序），不使用 std::atomic。
+ *
+ * 发送端库见 tools/motor_shm_writer.h（C）和 tools/motor_shm_writer.py（Python，基于 ctypes）。
+ */
+
+#ifndef MOTOR_SHM_LAYOUT_H
+#define MOTOR_SHM_LAYOUT_H
+
+#include <stdint.h>
+
+#define MOTOR_SHM_MAGIC 0x534D4A50u     /* 字节序列 "PJMS"（小端），写端初始化完成后最后写入 */
+#define MOTOR_SHM_VERSION 1u            /* 布局版本 */
+#define MOTOR_SHM_SLOT_BYTES 5120u      /* 每个槽位的数据区字节数（不小于 MAX_MOTOR_PACKET_BYTES） */
+#define MOTOR_SHM_DEFAULT_SLOTS 1024u   /* 默认槽位数（约 1 秒 @1kHz），必须为 2 的幂 */
+
+/* 共享内存头部（192 字节，写端字段与读端字段分占不同缓存行） */
+typedef struct
+{
+  uint32_t magic;       /* MOTOR_SHM_MAGIC */
+  uint32_t version;     /* MOTOR_SHM_VERSION */
+  uint32_t slot_count;  /* 槽位数（2 的幂） */
+  uint32_t slot_bytes;  /* 槽位数据区字节数（MOTOR_SHM_SLOT_BYTES） */
+  uint8_t pad0[48];
+
+  uint64_t write_seq;   /* 已发布的帧数（写端写） */
+  uint32_t futex_word;  /* 每发布一帧加 1，读端在此等待 */
+  uint32_t pad1;
+  uint8_t pad2[48];
+
+  uint32_t reader_waiting; /* 读端正在 futex 等待时为 1（读端写） */
+  uint8_t pad3[60];
+} MotorShmHeader;
+
+/* 单个槽位 */
+typedef struct
+{
+  uint64_t seq;        /* seqlock：2k+1 表示第 k 帧写入中，2k+2 表示第 k 帧已写完 */
+  uint64_t publish_ns; /* 写端发布时间（CLOCK_REALTIME，纳秒），插件用作"内核接收时间"来源 */
+  uint32_t len;        /* 数据报字节数 */
+  uint32_t reserved;
+  uint8_t pad[40];
+  uint8_t data[MOTOR_SHM_SLOT_BYTES]; /* 数据报内容 */
+} MotorShmSlot;
+
+#ifdef __cplusplus
+static_assert(sizeof(MotorShmHeader) == 192, "MotorShmHeader must be 192 bytes.");
+static_assert(sizeof(MotorShmSlot) % 64 == 0, "MotorShmSlot must be a multiple of the cache line size.");
+#endif
+
+#endif /* MOTOR_SHM_LAYOUT_H */
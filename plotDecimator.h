@@ -0,0 +1,139 @@
+/**
+ * @file plotDecimator.h
+ * @author mafangniu
+ * @brief 保留极值的曲线抽稀（按时间桶输出 min/max 或 first/last）
+ * @version 1.0
+ * @date 2025-05-02
+ *
+ * @details
+ * 1kHz x 13 个电机 x 6 个字段的数据全部推送给 PlotJuggler 时，历史数据全部驻留内存并参与重绘。
+ * 启用抽稀后，发布线程在解码与 pushBack 之间为每条曲线维护一个时间桶：
+ * - 桶按时间网格对齐（floor(t / 桶宽)），同一时刻所有曲线的桶边界一致；
+ * - 点落入新桶时输出上一个桶的代表点（按时间先后）：min/max 模式下为最小值点和最大值点，
+ *   电流、温度的尖峰不会被抽掉；first/last 模式下为桶内第一个和最后一个点；
+ * - 桶宽为 0 的曲线（如 Error）原样推送，不抽稀。
+ *
+ * 抽稀只影响绘图，日志仍由接收线程按原始速率记录。
+ *
+ * @note 只在发布线程中（持有 PlotJuggler mutex 时）使用，不做线程同步。
+ */
+
+#pragma once
+
+#include <cmath>
+
+/**
+ * @brief 抽稀方式
+ */
+enum class DecimationMode
+{
+  MinMax = 0,   ///< 每桶输出最小值点和最大值点（保留尖峰）
+  FirstLast = 1 ///< 每桶输出第一个点和最后一个点
+};
+
+/**
+ * @class SeriesDecimator
+ * @brief 单条曲线的时间桶抽稀状态
+ */
+class SeriesDecimator
+{
+public:
+  struct Point
+  {
+    double t; ///< 时间（秒）
+    double v; ///< 数值
+  };
+
+  /**
+   * @brief 设置桶宽和抽稀方式（丢弃当前未输出的桶，调用者应先 flush()）
+   * @param bucket_seconds 桶宽（秒），<= 0 表示不抽稀
+   * @param mode 抽稀方式
+   */
+  void configure(double bucket_seconds, DecimationMode mode)
+  {
+    bucket_ = bucket_seconds > 0.0 ? bucket_seconds : 0.0;
+    mode_ = mode;
+    count_ = 0;
+  }
+
+  /**
+   * @brief 输入一个点
+   * @param t 时间（秒）
+   * @param v 数值
+   * @param out 输出：需要推送的点（按时间先后），最多 2 个
+   * @return 输出点数（0 ~ 2）；不抽稀时总是原样输出 1 个
+   */
+  int push(double t, double v, Point out[2])
+  {
+    if (bucket_ <= 0.0)
+    {
+      out[0] = {t, v};
+      return 1;
+    }
+
+    const double bucket = std::floor(t / bucket_);
+    int emitted = 0;
+    if (count_ > 0 && bucket != bucket_index_)
+    {
+      emitted = output(out); // 进入新桶（时间回退时同样结束旧桶）
+    }
+    if (count_ == 0)
+    {
+      bucket_index_ = bucket;
+      first_ = last_ = min_ = max_ = {t, v};
+      count_ = 1;
+      return emitted;
+    }
+
+    last_ = {t, v};
+    if (v < min_.v)
+      min_ = last_;
+    if (v > max_.v)
+      max_ = last_;
+    ++count_;
+    return emitted;
+  }
+
+  /**
+   * @brief 输出当前未完成的桶（数据流暂停或修改配置时调用）
+   * @param out 输出点，最多 2 个
+   * @return 输出点数
+   */
+  int flush(Point out[2]) { return count_ > 0 ? output(out) : 0; }
+
+  /**
+   * @brief 是否有尚未输出的点
+   */
+  bool pending() const { return count_ > 0; }
+
+private:
+  int output(Point out[2])
+  {
+    Point a = (mode_ == DecimationMode::MinMax) ? min_ : first_;
+    Point b = (mode_ == DecimationMode::MinMax) ? max_ : last_;
+    count_ = 0;
+    if (a.t == b.t)
+    {
+      out[0] = a; // 桶内只有一个点，或最小值与最大值为同一个点
+      return 1;
+    }
+    if (a.t > b.t)
+    {
+      const Point tmp = a;
+      a = b;
+      b = tmp;
+    }
+    out[0] = a;
+    out[1] = b;
+    return 2;
+  }
+
+  double bucket_ = 0.0;       ///< 桶宽（秒），0 表示不抽稀
+  DecimationMode mode_ = DecimationMode::MinMax;
+  double bucket_index_ = 0.0; ///< 当前桶序号（floor(t / bucket_)）
+  int count_ = 0;             ///< 当前桶内的点数
+  Point first_{0.0, 0.0};
+  Point last_{0.0, 0.0};
+  Point min_{0.0, 0.0};
+  Point max_{0.0, 0.0};
+};
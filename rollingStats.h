@@ -0,0 +1,282 @@
+/**
+ * @file rollingStats.h
+ * @brief 固定容量的滑动窗口统计（均值、最小值、最大值、标准差、线性斜率，每个样本 O(1)）
+ * @author mafangniu
+ * @date 2025-05-15
+ *
+ * @details
+ * 窗口按时间定义（最近 window_s 秒）。样本按时间合并到宽 bucket_s 的时间桶中，每个桶在预分配的环形缓冲中占一格，
+ * 保存桶内样本的累加和与最小、最大值，因此缓冲容量只与 window_s / bucket_s 有关，与帧率无关：
+ * 1kHz 下几分钟的窗口也只需几千格。bucket_s 为 0 时每个样本占一格（实际窗口为 min(window_s, capacity 个样本)）。
+ * 缓冲满时最旧的桶提前移出。每次 push() 的开销为常数：
+ * - 均值、标准差、斜率由累加和（Σy、Σy²、Σt、Σt²、Σty）增量维护，移出桶时减去该桶的累加和，
+ *   与逐样本累加的结果相同（合并到桶中不损失精度）；
+ *   桶内累加和相对桶内第一个样本存放，总累加和相对参考点（最旧的桶）存放以减小抵消误差，
+ *   每 capacity 个桶按缓冲重新计算一次总累加和（均摊 O(1)），浮点误差不随运行时长累积；
+ * - 最小值、最大值由两个单调队列维护（队列中存桶序号，均摊 O(1)），不会漏掉窗口内的尖峰。
+ *
+ * 桶整体移出（桶内最后可能的时刻早于窗口起点时），窗口边界的误差不超过一个桶宽。
+ * 斜率为窗口内 y 对 t 的最小二乘斜率（单位/秒），用于温度等的上升速率。
+ *
+ * @note 不做线程同步，只在一个线程中使用（发布线程）
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RollingStats
+{
+public:
+  /**
+   * @brief 设置容量和窗口并清空（分配内存，只在配置时调用）
+   * @param capacity 最多保存的桶数（向上取整为 2 的幂），应不小于 window_s / bucket_s + 2
+   * @param window_s 窗口时长（秒）
+   * @param bucket_s 时间桶宽（秒），0 表示不合并（每个样本一格）
+   */
+  void reset(size_t capacity, double window_s, double bucket_s = 0.0)
+  {
+    size_t cap = 1;
+    while (cap < std::max<size_t>(capacity, 2))
+    {
+      cap <<= 1;
+    }
+    mask_ = cap - 1;
+    window_s_ = window_s;
+    bucket_s_ = std::max(0.0, bucket_s);
+    buckets_.assign(cap, Bucket{});
+    min_queue_.assign(cap, 0);
+    max_queue_.assign(cap, 0);
+    clear();
+  }
+
+  /**
+   * @brief 清空样本（不释放内存）
+   */
+  void clear()
+  {
+    next_ = 0;
+    size_ = 0;
+    count_ = 0;
+    min_head_ = min_size_ = 0;
+    max_head_ = max_size_ = 0;
+    since_rebase_ = 0;
+    last_t_ = 0.0;
+    t_ref_ = y_ref_ = 0.0;
+    sum_t_ = sum_tt_ = sum_y_ = sum_yy_ = sum_ty_ = 0.0;
+  }
+
+  /**
+   * @brief 加入一个样本（时间应单调不减），并移出窗口外及超出容量的旧桶
+   */
+  void push(double t, double y)
+  {
+    if (buckets_.empty())
+    {
+      return;
+    }
+    const double t_cut = t - window_s_;
+    while (size_ > 0 && buckets_[oldest() & mask_].t0 + bucket_s_ < t_cut)
+    {
+      popOldest();
+    }
+
+    if (size_ == 0 || t >= buckets_[(next_ - 1) & mask_].t0 + bucket_s_)
+    {
+      if (size_ > mask_)
+      {
+        popOldest();
+      }
+      if (size_ == 0)
+      {
+        // 窗口为空（第一个样本或数据中断超过窗口）时以新样本为参考点
+        t_ref_ = t;
+        y_ref_ = y;
+        sum_t_ = sum_tt_ = sum_y_ = sum_yy_ = sum_ty_ = 0.0;
+      }
+      Bucket &bucket = buckets_[next_++ & mask_];
+      bucket = Bucket{};
+      bucket.t0 = t;
+      bucket.y0 = y;
+      bucket.min = bucket.max = y;
+      ++size_;
+      if (++since_rebase_ > mask_)
+      {
+        rebase();
+      }
+    }
+
+    const uint64_t index = next_ - 1;
+    Bucket &bucket = buckets_[index & mask_];
+    const double dt = t - bucket.t0;
+    const double dy = y - bucket.y0;
+    ++bucket.n;
+    bucket.st += dt;
+    bucket.stt += dt * dt;
+    bucket.sy += dy;
+    bucket.syy += dy * dy;
+    bucket.sty += dt * dy;
+    ++count_;
+    last_t_ = t;
+    accumulate(t - t_ref_, y - y_ref_);
+
+    // 单调队列：队尾比当前桶差的桶不可能再成为最值（当前桶已在队尾时只更新桶的最值）
+    if (y < bucket.min || bucket.n == 1)
+    {
+      bucket.min = y;
+      if (min_size_ > 0 && min_queue_[(min_head_ + min_size_ - 1) & mask_] == index)
+      {
+        --min_size_;
+      }
+      while (min_size_ > 0 && buckets_[min_queue_[(min_head_ + min_size_ - 1) & mask_] & mask_].min >= y)
+      {
+        --min_size_;
+      }
+      min_queue_[(min_head_ + min_size_++) & mask_] = index;
+    }
+    if (y > bucket.max || bucket.n == 1)
+    {
+      bucket.max = y;
+      if (max_size_ > 0 && max_queue_[(max_head_ + max_size_ - 1) & mask_] == index)
+      {
+        --max_size_;
+      }
+      while (max_size_ > 0 && buckets_[max_queue_[(max_head_ + max_size_ - 1) & mask_] & mask_].max <= y)
+      {
+        --max_size_;
+      }
+      max_queue_[(max_head_ + max_size_++) & mask_] = index;
+    }
+  }
+
+  /// 窗口内的样本数
+  size_t count() const { return count_; }
+
+  /// 窗口内最新与最旧样本的时间差（秒）
+  double span() const { return size_ > 0 ? last_t_ - buckets_[oldest() & mask_].t0 : 0.0; }
+
+  double mean() const { return count_ > 0 ? y_ref_ + sum_y_ / count_ : 0.0; }
+
+  double min() const { return min_size_ > 0 ? buckets_[min_queue_[min_head_ & mask_] & mask_].min : 0.0; }
+
+  double max() const { return max_size_ > 0 ? buckets_[max_queue_[max_head_ & mask_] & mask_].max : 0.0; }
+
+  /// 总体标准差
+  double stddev() const
+  {
+    if (count_ < 2)
+    {
+      return 0.0;
+    }
+    const double m = sum_y_ / count_;
+    return std::sqrt(std::max(0.0, sum_yy_ / count_ - m * m));
+  }
+
+  /// 最小二乘斜率（单位/秒），样本不足或时间跨度为 0 时返回 0
+  double slope() const
+  {
+    const double n = static_cast<double>(count_);
+    const double denominator = n * sum_tt_ - sum_t_ * sum_t_;
+    if (count_ < 2 || denominator <= 1e-9 * n * sum_tt_) // 所有样本时间相同（或几乎相同）
+    {
+      return 0.0;
+    }
+    return (n * sum_ty_ - sum_t_ * sum_y_) / denominator;
+  }
+
+private:
+  /// 一个时间桶：桶内样本相对第一个样本 (t0, y0) 的累加和
+  struct Bucket
+  {
+    double t0 = 0.0;
+    double y0 = 0.0;
+    double st = 0.0, stt = 0.0, sy = 0.0, syy = 0.0, sty = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    size_t n = 0;
+  };
+
+  uint64_t oldest() const { return next_ - size_; }
+
+  /// 把一个相对参考点的样本计入总累加和
+  void accumulate(double dt, double dy)
+  {
+    sum_t_ += dt;
+    sum_tt_ += dt * dt;
+    sum_y_ += dy;
+    sum_yy_ += dy * dy;
+    sum_ty_ += dt * dy;
+  }
+
+  /// 把桶的累加和平移到参考点后计入（sign = 1）或移出（sign = -1）总累加和
+  void accumulateBucket(const Bucket &b, double sign)
+  {
+    const double a = b.t0 - t_ref_;
+    const double c = b.y0 - y_ref_;
+    const double n = static_cast<double>(b.n);
+    sum_t_ += sign * (b.st + n * a);
+    sum_tt_ += sign * (b.stt + 2.0 * a * b.st + n * a * a);
+    sum_y_ += sign * (b.sy + n * c);
+    sum_yy_ += sign * (b.syy + 2.0 * c * b.sy + n * c * c);
+    sum_ty_ += sign * (b.sty + a * b.sy + c * b.st + n * a * c);
+  }
+
+  void popOldest()
+  {
+    const uint64_t index = oldest();
+    const Bucket &b = buckets_[index & mask_];
+    accumulateBucket(b, -1.0);
+    count_ -= b.n;
+    --size_;
+    if (min_size_ > 0 && min_queue_[min_head_ & mask_] == index)
+    {
+      ++min_head_;
+      --min_size_;
+    }
+    if (max_size_ > 0 && max_queue_[max_head_ & mask_] == index)
+    {
+      ++max_head_;
+      --max_size_;
+    }
+  }
+
+  /// 以最旧的桶为参考点重新计算总累加和
+  void rebase()
+  {
+    since_rebase_ = 0;
+    sum_t_ = sum_tt_ = sum_y_ = sum_yy_ = sum_ty_ = 0.0;
+    if (size_ == 0)
+    {
+      return;
+    }
+    const Bucket &first = buckets_[oldest() & mask_];
+    t_ref_ = first.t0;
+    y_ref_ = first.y0;
+    for (uint64_t i = oldest(); i < next_; ++i)
+    {
+      accumulateBucket(buckets_[i & mask_], 1.0);
+    }
+  }
+
+  std::vector<Bucket> buckets_;     ///< 环形缓冲（下标为桶序号 & mask_）
+  std::vector<uint64_t> min_queue_; ///< 最小值单调队列（桶序号，环形）
+  std::vector<uint64_t> max_queue_; ///< 最大值单调队列
+  size_t mask_ = 0;
+  double window_s_ = 0.0;
+  double bucket_s_ = 0.0;
+  uint64_t next_ = 0;  ///< 下一个桶的序号
+  size_t size_ = 0;    ///< 窗口内的桶数
+  size_t count_ = 0;   ///< 窗口内的样本数
+  uint64_t min_head_ = 0;
+  size_t min_size_ = 0;
+  uint64_t max_head_ = 0;
+  size_t max_size_ = 0;
+  size_t since_rebase_ = 0;
+  double last_t_ = 0.0; ///< 最新样本的时间
+  double t_ref_ = 0.0, y_ref_ = 0.0;
+  double sum_t_ = 0.0, sum_tt_ = 0.0, sum_y_ = 0.0, sum_yy_ = 0.0, sum_ty_ = 0.0;
+};
@@ -0,0 +1,150 @@
+/**
+ * @file rxStats.h
+ * @brief 接收统计：收包/格式错误/丢包计数、序号缺口检测和有效帧率
+ * @author mafangniu
+ * @date 2025-04-26
+ *
+ * @details
+ * 每个数据源一组计数器（RxStatsCounters），由接收线程以 relaxed 原子操作累加，发布线程定期采样（RxStatsSampler）
+ * 后作为 PlotJuggler 曲线（_stats/rx_rate 等）发布并显示在错误类型界面上，用于区分丢包发生在哪一环：
+ *
+ * - seq_lost：按发送端序号检测到的缺口（数据报带自描述包头时才有），包含网络丢包和内核丢弃；
+ * - seq_resets：发送端重启等原因序号大幅回退、重新同步的次数（回退后的包不计入缺口和乱序）；
+ * - kernel_drops：内核因 socket 接收缓冲满而丢弃的数据报（SO_RXQ_OVFL），seq_lost - kernel_drops 约为网络丢包；
+ * - plot_drops：插件内帧队列已满而未绘制的帧（日志仍照常记录）；
+ * - malformed：长度、版本或电机数无效的数据报。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// 统计曲线（发布顺序与 RX_STATS_SERIES_NAMES 一致）
+enum RxStatsSeries
+{
+  RX_STATS_RATE = 0,         // 有效帧率（帧/秒）
+  RX_STATS_RECEIVED,         // 累计有效帧数
+  RX_STATS_MALFORMED,        // 累计无效数据报数
+  RX_STATS_SEQ_LOST,         // 累计序号缺口（丢失的数据报数）
+  RX_STATS_KERNEL_DROPS,     // 内核丢弃的数据报数（SO_RXQ_OVFL）
+  RX_STATS_PLOT_DROPS,       // 帧队列已满未绘制的帧数
+  RX_STATS_SEQ_RESETS,       // 序号重新同步次数（发送端重启）
+  RX_STATS_SERIES_COUNT
+};
+
+// 统计曲线名称（完整曲线名为 "_stats/" + 数据源前缀 + 名称）
+static constexpr const char *RX_STATS_SERIES_NAMES[RX_STATS_SERIES_COUNT] = {
+    "rx_rate", "received", "malformed", "seq_lost", "kernel_drops", "plot_drops", "seq_resets"};
+
+/**
+ * @brief 单个数据源的接收计数器（接收线程写，其他线程只读）
+ */
+struct RxStatsCounters
+{
+  std::atomic<uint64_t> received{0};           ///< 有效帧数
+  std::atomic<uint64_t> malformed{0};          ///< 无效数据报数
+  std::atomic<uint64_t> sequence_lost{0};      ///< 序号缺口累计（丢失的数据报数）
+  std::atomic<uint64_t> sequence_reordered{0}; ///< 重复或乱序到达的数据报数
+  std::atomic<uint64_t> sequence_resets{0};    ///< 序号回退后重新同步的次数
+  std::atomic<uint64_t> kernel_dropped{0};     ///< 内核丢弃的数据报数（SO_RXQ_OVFL 的累计值）
+  std::atomic<uint64_t> plot_dropped{0};       ///< 帧队列已满未绘制的帧数
+};
+
+/**
+ * @class SequenceTracker
+ * @brief 发送端序号缺口检测（仅接收线程使用）
+ *
+ * 序号为 32 位、每包加 1，允许回绕；比上一个序号小（按回绕距离）的包视为重复或乱序，不计入缺口。
+ * 发送端重启后序号从头开始，之后的包都比上一个序号小：回退超过 SEQUENCE_RESYNC_GAP，
+ * 或连续 SEQUENCE_RESYNC_RUN 个包都比上一个序号小时，以当前包的序号重新同步，计一次 sequence_resets，
+ * 这些包不计入乱序。
+ */
+class SequenceTracker
+{
+public:
+  static constexpr uint32_t SEQUENCE_RESYNC_GAP = 1024; ///< 回退超过该距离时立即重新同步（乱序不会落后这么多）
+  static constexpr uint32_t SEQUENCE_RESYNC_RUN = 8;    ///< 连续这么多个包都比上一个序号小时重新同步
+
+  /**
+   * @brief 记录一个序号并更新计数器
+   * @param sequence 发送端序号
+   * @param counters 输出：缺口累加到 sequence_lost，重复/乱序累加到 sequence_reordered，重新同步累加到 sequence_resets
+   */
+  void observe(uint32_t sequence, RxStatsCounters &counters)
+  {
+    if (has_last_)
+    {
+      const uint32_t delta = sequence - last_; // 无符号减法自动处理回绕
+      if (delta == 0 || delta >= 0x80000000u)
+      {
+        // 乱序包先暂记，等到下一个正常的包再计入，重新同步时这些包不算乱序
+        if (last_ - sequence <= SEQUENCE_RESYNC_GAP && ++behind_run_ < SEQUENCE_RESYNC_RUN)
+        {
+          return;
+        }
+        counters.sequence_resets.fetch_add(1, std::memory_order_relaxed);
+        behind_run_ = 0;
+        last_ = sequence;
+        return;
+      }
+      if (behind_run_ > 0)
+      {
+        counters.sequence_reordered.fetch_add(behind_run_, std::memory_order_relaxed);
+        behind_run_ = 0;
+      }
+      if (delta > 1)
+      {
+        counters.sequence_lost.fetch_add(delta - 1, std::memory_order_relaxed);
+      }
+    }
+    last_ = sequence;
+    has_last_ = true;
+  }
+
+  /**
+   * @brief 清除上一个序号（重新开始接收时调用）
+   */
+  void reset()
+  {
+    has_last_ = false;
+    behind_run_ = 0;
+  }
+
+private:
+  uint32_t last_ = 0;       ///< 上一个序号
+  bool has_last_ = false;   ///< 是否已收到过带序号的包
+  uint32_t behind_run_ = 0; ///< 连续比上一个序号小的包数（尚未计入 sequence_reordered）
+};
+
+/**
+ * @class RxStatsSampler
+ * @brief 定期采样计数器，计算有效帧率（仅发布线程使用）
+ */
+class RxStatsSampler
+{
+public:
+  /**
+   * @brief 采样一次
+   * @param counters 数据源计数器
+   * @param now 当前时间（秒）
+   * @param values 输出，按 RxStatsSeries 顺序
+   */
+  void sample(const RxStatsCounters &counters, double now, double values[RX_STATS_SERIES_COUNT])
+  {
+    const uint64_t received = counters.received.load(std::memory_order_relaxed);
+    values[RX_STATS_RATE] = (last_time_ > 0.0 && now > last_time_) ? (received - last_received_) / (now - last_time_) : 0.0;
+    values[RX_STATS_RECEIVED] = static_cast<double>(received);
+    values[RX_STATS_MALFORMED] = static_cast<double>(counters.malformed.load(std::memory_order_relaxed));
+    values[RX_STATS_SEQ_LOST] = static_cast<double>(counters.sequence_lost.load(std::memory_order_relaxed));
+    values[RX_STATS_KERNEL_DROPS] = static_cast<double>(counters.kernel_dropped.load(std::memory_order_relaxed));
+    values[RX_STATS_PLOT_DROPS] = static_cast<double>(counters.plot_dropped.load(std::memory_order_relaxed));
+    values[RX_STATS_SEQ_RESETS] = static_cast<double>(counters.sequence_resets.load(std::memory_order_relaxed));
+    last_received_ = received;
+    last_time_ = now;
+  }
+
+private:
+  uint64_t last_received_ = 0; ///< 上次采样时的有效帧数
+  double last_time_ = 0.0;     ///< 上次采样时间
+};
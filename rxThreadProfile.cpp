@@ -0,0 +1,233 @@
+/**
+ * @file rxThreadProfile.cpp
+ * @brief 接收线程实时配置解析与应用实现
+ * @author mafangniu
+ * @date 2025-05-08
+ */
+
+#include "rxThreadProfile.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "specTokens.h"
+
+namespace
+{
+/**
+ * @brief 解析非负整数，可带 K / M 后缀（按 1024 进位）
+ */
+bool parseSize(const std::string &text, long max_value, int &value)
+{
+  char *end = nullptr;
+  long parsed = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || end == text.c_str() || parsed < 0)
+  {
+    return false;
+  }
+  if (*end == 'K' || *end == 'k')
+  {
+    parsed *= 1024;
+    ++end;
+  }
+  else if (*end == 'M' || *end == 'm')
+  {
+    parsed *= 1024 * 1024;
+    ++end;
+  }
+  if (*end != '\0' || parsed > max_value)
+  {
+    return false;
+  }
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+std::string formatBytes(int bytes)
+{
+  if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0)
+  {
+    return std::to_string(bytes / (1024 * 1024)) + " MiB";
+  }
+  if (bytes >= 1024)
+  {
+    return std::to_string(bytes / 1024) + " KiB";
+  }
+  return std::to_string(bytes) + " B";
+}
+
+void appendItem(std::string &report, const std::string &item)
+{
+  if (!report.empty())
+  {
+    report += " | ";
+  }
+  report += item;
+}
+} // namespace
+
+bool parseRxThreadProfile(const std::string &spec, RxThreadProfile &profile, std::string *error)
+{
+  RxThreadProfile parsed;
+  for (const std::string &entry : specTokens(spec))
+  {
+    const size_t eq = entry.find('=');
+    const std::string key = entry.substr(0, eq);
+    const std::string value = (eq == std::string::npos) ? std::string() : entry.substr(eq + 1);
+    bool ok = false;
+    if (key == "spin" && eq == std::string::npos)
+    {
+      parsed.spin = ok = true;
+    }
+    else if (key == "rcvbuf")
+    {
+      ok = parseSize(value, 1L << 30, parsed.rcvbuf_bytes);
+    }
+    else if (key == "busy_poll")
+    {
+      ok = parseSize(value, 1000000, parsed.busy_poll_us);
+    }
+    else if (key == "cpu")
+    {
+      ok = parseSize(value, CPU_SETSIZE - 1, parsed.cpu);
+    }
+    else if (key == "fifo")
+    {
+      ok = parseSize(value, 99, parsed.fifo_priority) && parsed.fifo_priority >= 1;
+    }
+    if (!ok)
+    {
+      setError(error, "无效的接收线程配置项: " + entry);
+      return false;
+    }
+  }
+  profile = parsed;
+  return true;
+}
+
+std::string formatRxThreadProfile(const RxThreadProfile &profile)
+{
+  std::string spec;
+  auto add = [&spec](const std::string &item)
+  {
+    spec += (spec.empty() ? "" : ",") + item;
+  };
+
+  if (profile.rcvbuf_bytes % (1024 * 1024) == 0)
+  {
+    add("rcvbuf=" + std::to_string(profile.rcvbuf_bytes / (1024 * 1024)) + (profile.rcvbuf_bytes ? "M" : ""));
+  }
+  else
+  {
+    add("rcvbuf=" + std::to_string(profile.rcvbuf_bytes));
+  }
+  if (profile.busy_poll_us > 0)
+  {
+    add("busy_poll=" + std::to_string(profile.busy_poll_us));
+  }
+  if (profile.spin)
+  {
+    add("spin");
+  }
+  if (profile.cpu >= 0)
+  {
+    add("cpu=" + std::to_string(profile.cpu));
+  }
+  if (profile.fifo_priority > 0)
+  {
+    add("fifo=" + std::to_string(profile.fifo_priority));
+  }
+  return spec;
+}
+
+std::string applyRxThreadProfile(const RxThreadProfile &profile)
+{
+  std::string report;
+  pthread_setname_np(pthread_self(), "motor_rx"); // 便于用 top -H / ps -L 查看接收线程
+
+  if (profile.cpu >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(profile.cpu, &cpus);
+    const int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    appendItem(report, rc == 0 ? "CPU " + std::to_string(profile.cpu)
+                               : "⚠️ 绑定 CPU " + std::to_string(profile.cpu) + " 失败(" + std::strerror(rc) + ")，不绑定");
+  }
+
+  if (profile.fifo_priority > 0)
+  {
+    sched_param param{};
+    param.sched_priority = profile.fifo_priority;
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc == 0)
+    {
+      appendItem(report, "SCHED_FIFO " + std::to_string(profile.fifo_priority));
+    }
+    else
+    {
+      // 没有 CAP_SYS_NICE（或 ulimit -r 为 0）时回退为提高 nice 优先级，仍失败则保持普通调度
+      const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+      const bool niced = setpriority(PRIO_PROCESS, static_cast<id_t>(tid), -10) == 0;
+      appendItem(report, std::string("⚠️ SCHED_FIFO 不可用(") + std::strerror(rc) + ")，" +
+                             (niced ? "已回退为 nice -10" : "保持普通调度（需要 CAP_SYS_NICE 或 ulimit -r）"));
+    }
+  }
+
+  if (profile.spin)
+  {
+    appendItem(report, profile.cpu >= 0 ? "忙等" : "忙等（未绑定 CPU，会占满一个核并与其他线程争用）");
+  }
+  return report.empty() ? std::string("普通调度") : report;
+}
+
+std::string applyRxSocketProfile(int sock, const RxThreadProfile &profile)
+{
+  std::string report;
+  if (profile.rcvbuf_bytes > 0)
+  {
+    // SO_RCVBUFFORCE 不受 net.core.rmem_max 限制（需要 CAP_NET_ADMIN），失败时回退为 SO_RCVBUF
+    const int requested = profile.rcvbuf_bytes;
+    const bool forced = setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &requested, sizeof(requested)) == 0;
+    if (!forced)
+    {
+      setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &requested, sizeof(requested));
+    }
+
+    // 内核记录的值为设置值的两倍（包含簿记开销），折半后与请求值比较
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &actual, &len);
+    actual /= 2;
+    if (actual >= requested)
+    {
+      appendItem(report, "SO_RCVBUF " + formatBytes(actual));
+    }
+    else
+    {
+      appendItem(report, "⚠️ SO_RCVBUF " + formatBytes(actual) + "（请求 " + formatBytes(requested) +
+                             "，受 net.core.rmem_max 限制，可 sysctl -w net.core.rmem_max=" + std::to_string(requested) + "）");
+    }
+  }
+
+  if (profile.busy_poll_us > 0)
+  {
+    const int busy_poll = profile.busy_poll_us;
+    if (setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == 0)
+    {
+      appendItem(report, "SO_BUSY_POLL " + std::to_string(busy_poll) + "us");
+    }
+    else
+    {
+      appendItem(report, std::string("⚠️ SO_BUSY_POLL 不可用(") + std::strerror(errno) + ")");
+    }
+  }
+  return report;
+}
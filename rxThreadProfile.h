@@ -0,0 +1,61 @@
+/**
+ * @file rxThreadProfile.h
+ * @brief 接收线程实时配置：socket 接收缓冲、忙轮询、CPU 绑定和 SCHED_FIFO 优先级
+ * @author mafangniu
+ * @date 2025-05-08
+ *
+ * @details
+ * 默认情况下接收线程是普通调度的线程、socket 使用系统默认的接收缓冲，与 PlotJuggler 的界面重绘线程争用 CPU，
+ * 窗口缩放等重绘负载较重时内核接收缓冲会溢出（_stats/kernel_drops 增加）。接收线程配置用一个字符串描述，
+ * 条目之间以逗号、分号或空白分隔：
+ *
+ *     rcvbuf=<字节数>[K|M]   请求的 SO_RCVBUF 大小（0 表示系统默认），例如 rcvbuf=8M
+ *     busy_poll=<微秒>       socket 的 SO_BUSY_POLL（内核在网卡队列上忙轮询，需要网卡驱动支持）
+ *     spin                   接收线程用户态忙等（epoll_wait 不睡眠、共享内存不在 futex 上等待），建议同时设置 cpu
+ *     cpu=<编号>             把接收线程绑定到指定 CPU（最好是 isolcpus 隔离出的核）
+ *     fifo=<1~99>            接收线程使用 SCHED_FIFO 实时调度及其优先级
+ *
+ * 例如 "rcvbuf=8M,cpu=3,fifo=80"。每一项单独应用、失败时回退（SO_RCVBUFFORCE -> SO_RCVBUF，
+ * SCHED_FIFO -> nice -10 -> 普通调度），实际生效的设置和回退原因由 apply*() 以文本返回，
+ * 接收线程启动时打印并显示在电机错误类型界面上。
+ */
+
+#pragma once
+
+#include <string>
+
+// 接收线程配置
+struct RxThreadProfile
+{
+  int rcvbuf_bytes = 4 * 1024 * 1024; // 请求的 SO_RCVBUF（字节），0 表示使用系统默认
+  int busy_poll_us = 0;               // SO_BUSY_POLL（微秒），0 表示不开启
+  bool spin = false;                  // 用户态忙等，不在 epoll_wait / futex 上睡眠
+  int cpu = -1;                       // 绑定的 CPU 编号，-1 表示不绑定
+  int fifo_priority = 0;              // SCHED_FIFO 优先级（1~99），0 表示普通调度
+};
+
+/**
+ * @brief 解析接收线程配置字符串
+ * @param spec 配置字符串，格式见文件说明；空字符串表示默认配置
+ * @param profile 输出的配置（解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true
+ */
+bool parseRxThreadProfile(const std::string &spec, RxThreadProfile &profile, std::string *error = nullptr);
+
+/**
+ * @brief 将配置格式化为字符串（parseRxThreadProfile() 的逆操作）
+ */
+std::string formatRxThreadProfile(const RxThreadProfile &profile);
+
+/**
+ * @brief 对调用线程应用 CPU 绑定和调度策略（在接收线程开始时调用）
+ * @return 实际生效的设置及回退原因，例如 "CPU 3 | SCHED_FIFO 80"
+ */
+std::string applyRxThreadProfile(const RxThreadProfile &profile);
+
+/**
+ * @brief 对一个 UDP socket 应用接收缓冲大小和 SO_BUSY_POLL
+ * @return 实际生效的设置及回退原因，例如 "SO_RCVBUF 8 MiB"
+ */
+std::string applyRxSocketProfile(int sock, const RxThreadProfile &profile);
@@ -15,6 +15,24 @@
  */
 
 #include "saveErrorLog.h"
+#include "textLogFormat.h"
+
+/**
+ * @brief 将一帧电机数据按日志格式写入已打开的输出流
+ *
+ * @param ofs            已打开的输出流
+ * @param motor_data     包含所有电机数据的数组
+ * @param size           电机数量（数组长度）
+ * @param timestamp_str  当前帧的时间戳字符串
+ */
+void writeMotorFrame(std::ostream &ofs, const InteractiveMotorData motor_data[], int size, const std::string &timestamp_str)
+{
+    // 由 MotorTextFormatter 格式化到线程内复用的缓冲，再一次写入流
+    thread_local MotorTextFormatter formatter;
+    formatter.clear();
+    formatter.appendFrame(motor_data, size, timestamp_str);
+    ofs.write(formatter.data(), static_cast<std::streamsize>(formatter.size()));
+}
 
 /**
  * @brief 导出当前帧的电机数据到日志文件（追加模式）
@@ -27,6 +45,20 @@
  * @note 日志每帧前加帧号（时间戳），每个电机分段写入，精度保留小数点后 4 位。
  */
 void printMotorDataToFile(const InteractiveMotorData motor_data[], int size, const std::string &filename, const std::string &timestamp_str)
+{
+    printMotorFramesToFile(motor_data, 1, size, filename, timestamp_str);
+}
+
+/**
+ * @brief 批量导出多帧电机数据到日志文件（追加模式，整批只打开一次文件）
+ *
+ * @param frames         多帧电机数据，按帧连续存放（frame_count * size 个元素）
+ * @param frame_count    帧数
+ * @param size           每帧的电机数量
+ * @param filename       要写入的日志文件名
+ * @param timestamp_str  本批次的时间戳字符串（yyyy-mm-dd-hh-mm-ss 形式，用作帧标识）
+ */
+void printMotorFramesToFile(const InteractiveMotorData frames[], int frame_count, int size, const std::string &filename, const std::string &timestamp_str)
 {
     std::ofstream ofs(filename, std::ios::app); // 👈 以追加模式打开
     if (!ofs.is_open())
@@ -35,30 +67,13 @@ void printMotorDataToFile(const InteractiveMotorData motor_data[], int size, con
         return;
     }
 
-    ofs << std::fixed << std::setprecision(4);
-    ofs << "===== Frame [" << timestamp_str << "] =====\n";
-
-    for (int i = 0; i < size; ++i)
+    MotorTextFormatter formatter;
+    for (int f = 0; f < frame_count; ++f)
     {
-        ofs << "Motor[" << i << "]\n";
-        ofs << "  Index       : " << motor_data[i].index << "\n";
-        ofs << "  Mode       : " << motor_data[i].mode << "\n";
-        ofs << "  Position   : " << motor_data[i].pos_ << " rad\n";
-        ofs << "  Velocity   : " << motor_data[i].vel_ << " rad/s\n";
-        ofs << "  Torque     : " << motor_data[i].tau_ << " N·m\n";
-        ofs << "  Pos_des    : " << motor_data[i].pos_des_ << " rad\n";
-        ofs << "  Vel_des    : " << motor_data[i].vel_des_ << " rad/s\n";
-        ofs << "  Kp         : " << motor_data[i].kp_ << "\n";
-        ofs << "  Kd         : " << motor_data[i].kd_ << "\n";
-        ofs << "  Feedforward: " << motor_data[i].ff_ << " N·m\n";
-        ofs << "  Error: " << motor_data[i].error_ << " \n";
-        ofs << "  Temperature: " << motor_data[i].temperature_ << " \n";
-        ofs << "  Mos Temperature: " << motor_data[i].mos_temperature_ << " \n";
-        ofs << "------------------------------\n";
-       
+        formatter.appendFrame(frames + f * size, size, timestamp_str);
     }
+    ofs.write(formatter.data(), static_cast<std::streamsize>(formatter.size()));
 
-    ofs << "\n";
     ofs.close();
 }
 
@@ -72,7 +87,18 @@ void printMotorDataToFile(const InteractiveMotorData motor_data[], int size, con
 std::string getCurrentTimestampString()
 {
     auto now = std::chrono::system_clock::now();
-    std::time_t time_now = std::chrono::system_clock::to_time_t(now);
+    return formatTimestampString(std::chrono::duration<double>(now.time_since_epoch()).count());
+}
+
+/**
+ * @brief 将 Unix 时间（秒）格式化为本地时间戳字符串
+ *
+ * @param stamp  Unix 时间（秒），小数部分被忽略
+ * @return std::string 本地时间戳，格式为 "yyyy-mm-dd-hh-mm-ss"
+ */
+std::string formatTimestampString(double stamp)
+{
+    std::time_t time_now = static_cast<std::time_t>(stamp);
 
     std::tm tm_local;
 #ifdef _WIN32
@@ -81,7 +107,7 @@ std::string getCurrentTimestampString()
     localtime_r(&time_now, &tm_local);
 #endif
 
-    std::ostringstream oss;
-    oss << std::put_time(&tm_local, "%Y-%m-%d-%H-%M-%S");
-    return oss.str();
-}
\ No newline at end of file
+    char buf[32];
+    const size_t len = std::strftime(buf, sizeof(buf), "%Y-%m-%d-%H-%M-%S", &tm_local);
+    return std::string(buf, len);
+}
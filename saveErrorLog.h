@@ -14,11 +14,17 @@
  * 与 PlotJuggler 插件联动，作为后端日志记录工具。
  */
 
+#pragma once
+
 #include <iomanip>
 #include <fstream>
-#include "datastream_sample.h"
+#include "motorData.h"
+#include "motorFields.h"
 #include <ctime>
 #include <sstream>
+#include <string>
+#include <chrono>
+#include <iostream>
 
 /**
  * @brief 导出当前帧的电机数据到日志文件（追加模式）
@@ -32,6 +38,31 @@
  */
 void printMotorDataToFile(const InteractiveMotorData motor_data[], int size, const std::string &filename, const std::string &timestamp_str);
 
+/**
+ * @brief 将一帧电机数据按日志格式写入已打开的输出流（格式与 printMotorDataToFile() 相同）
+ *
+ * @param ofs            已打开的输出流（数值固定保留 4 位小数，不受流的格式设置影响）
+ * @param motor_data     包含所有电机数据的数组
+ * @param size           电机数量（数组长度）
+ * @param timestamp_str  当前帧的时间戳字符串
+ *
+ * @note 由 MotorTextFormatter（textLogFormat.h）格式化后整帧写入；大量连续写入时直接使用 MotorTextFormatter 更快。
+ */
+void writeMotorFrame(std::ostream &ofs, const InteractiveMotorData motor_data[], int size, const std::string &timestamp_str);
+
+/**
+ * @brief 批量导出多帧电机数据到日志文件（追加模式，整批只打开一次文件）
+ *
+ * @param frames         多帧电机数据，按帧连续存放（frame_count * size 个元素）
+ * @param frame_count    帧数
+ * @param size           每帧的电机数量
+ * @param filename       要写入的日志文件名
+ * @param timestamp_str  本批次的时间戳字符串（yyyy-mm-dd-hh-mm-ss 形式，用作帧标识）
+ *
+ * @note 输出格式与 printMotorDataToFile() 完全一致，只是减少了反复打开/关闭文件的开销。
+ */
+void printMotorFramesToFile(const InteractiveMotorData frames[], int frame_count, int size, const std::string &filename, const std::string &timestamp_str);
+
 /**
  * @brief 获取当前系统时间戳字符串
  *
@@ -39,4 +70,14 @@ void printMotorDataToFile(const InteractiveMotorData motor_data[], int size, con
  *
  * @note 用于作为日志的帧标识（每帧写入日志时用来区分）
  */
-std::string getCurrentTimestampString();
\ No newline at end of file
+std::string getCurrentTimestampString();
+
+/**
+ * @brief 将 Unix 时间（秒）格式化为本地时间戳字符串
+ *
+ * @param stamp  Unix 时间（秒），小数部分被忽略
+ * @return std::string 本地时间戳，格式为 "yyyy-mm-dd-hh-mm-ss"
+ *
+ * @note 异步日志写线程用帧自身的时间戳生成帧标识，而不是写入时的时间。
+ */
+std::string formatTimestampString(double stamp);
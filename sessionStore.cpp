@@ -0,0 +1,736 @@
+/**
+ * @file sessionStore.cpp
+ * @brief 列式会话记录实现（Arrow IPC 文件格式的元数据编码、按块 mmap 写入、续写与补写 Footer）
+ * @author mafangniu
+ * @date 2025-05-18
+ *
+ * @details
+ * Arrow 的元数据是 FlatBuffers 编码的表，这里只需要 Schema / RecordBatch / Footer 三种消息、所有列都是 float64，
+ * 因此用一个很小的编码器手写，不依赖 Arrow 和 FlatBuffers 库。字段的槽位号即 .fbs 文件中的声明顺序：
+ *
+ *     Message     { version, header_type, header, bodyLength, custom_metadata }
+ *     Schema      { endianness, fields, custom_metadata, features }
+ *     Field       { name, nullable, type_type, type, dictionary, children, custom_metadata }
+ *     FloatingPoint { precision }
+ *     RecordBatch { length, nodes, buffers, compression, variadicBufferCounts }
+ *     Footer      { version, schema, dictionaries, recordBatches, custom_metadata }
+ *
+ * RecordBatch 元数据的长度只取决于列数（帧数、列间隔都是定长标量），写入过程中可以在块开头原地改写。
+ */
+
+#include "sessionStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "motorFields.h"
+#include "specTokens.h"
+
+namespace
+{
+// Arrow 列式格式（format/Schema.fbs、Message.fbs、File.fbs）中用到的常量
+const char ARROW_MAGIC[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0}; // 文件开头为魔数 + 补齐到 8 字节，结尾为 6 字节魔数
+const uint32_t ARROW_CONTINUATION = 0xFFFFFFFFu;                 // 封装消息的前缀
+const int16_t ARROW_METADATA_V5 = 4;
+const uint8_t ARROW_HEADER_SCHEMA = 1;
+const uint8_t ARROW_HEADER_RECORD_BATCH = 3;
+const uint8_t ARROW_TYPE_FLOATING_POINT = 3;
+const int16_t ARROW_PRECISION_DOUBLE = 2;
+const size_t ARROW_ALIGNMENT = 64;   // 消息体和各列按 64 字节对齐（Arrow 推荐的对齐）
+const size_t ARROW_BLOCK_BYTES = 24; // Footer 中的 Block { int64 offset; int32 metaDataLength; int64 bodyLength; }
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool preadAll(int fd, void *data, size_t size, uint64_t offset)
+{
+  char *p = static_cast<char *>(data);
+  while (size > 0)
+  {
+    const ssize_t n = ::pread(fd, p, size, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    p += n;
+    size -= static_cast<size_t>(n);
+    offset += static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+bool pwriteAll(int fd, const void *data, size_t size, uint64_t offset)
+{
+  const char *p = static_cast<const char *>(data);
+  while (size > 0)
+  {
+    const ssize_t n = ::pwrite(fd, p, size, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    p += n;
+    size -= static_cast<size_t>(n);
+    offset += static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+/**
+ * 最小的 FlatBuffers 编码器，只覆盖 Arrow 元数据用到的表、向量和字符串。
+ * 对象从前往后依次写入：uoffset 只能指向更高的地址，所以先写父对象（引用字段占位），
+ * 子对象写入后再用 patch() 填入偏移；vtable 放在它的表之前。
+ */
+class FlatBuilder
+{
+public:
+  // 表中的一个字段：slot 为 vtable 槽位，size 为标量字节数（1/2/4/8），0 表示引用（4 字节 uoffset，之后 patch()）
+  struct Slot
+  {
+    uint16_t slot;
+    uint8_t size;
+    int64_t value;
+  };
+
+  explicit FlatBuilder(std::vector<uint8_t> &out) : buf_(out) { buf_.assign(4, 0); } // 开头 4 字节为根表偏移
+
+  /**
+   * @brief 写一个表，字段按给出的顺序放置并各自按大小对齐
+   * @param refs 输出各引用字段的位置（按出现顺序），供 patch() 使用
+   * @return 表的位置
+   */
+  size_t table(std::initializer_list<Slot> slots, size_t *refs = nullptr)
+  {
+    uint16_t slot_count = 0;
+    for (const Slot &s : slots)
+    {
+      slot_count = std::max<uint16_t>(slot_count, static_cast<uint16_t>(s.slot + 1));
+    }
+    pad(2);
+    const size_t vtable = buf_.size();
+    const size_t vtable_size = 4 + 2 * static_cast<size_t>(slot_count);
+    const size_t table = alignUp(vtable + vtable_size, 4);
+
+    uint16_t offsets[MAX_SLOTS] = {};
+    size_t cursor = table + 4; // 表开头是到 vtable 的 soffset
+    for (const Slot &s : slots)
+    {
+      const size_t size = s.size > 0 ? s.size : 4;
+      cursor = alignUp(cursor, size);
+      offsets[s.slot] = static_cast<uint16_t>(cursor - table);
+      cursor += size;
+    }
+    buf_.resize(cursor, 0);
+
+    set(vtable, static_cast<int64_t>(vtable_size), 2);
+    set(vtable + 2, static_cast<int64_t>(cursor - table), 2);
+    for (uint16_t i = 0; i < slot_count; ++i)
+    {
+      set(vtable + 4 + 2 * i, offsets[i], 2);
+    }
+    set(table, static_cast<int64_t>(table - vtable), 4);
+
+    size_t ref = 0;
+    for (const Slot &s : slots)
+    {
+      if (s.size == 0)
+      {
+        if (refs)
+        {
+          refs[ref++] = table + offsets[s.slot];
+        }
+      }
+      else
+      {
+        set(table + offsets[s.slot], s.value, s.size);
+      }
+    }
+    return table;
+  }
+
+  /// 引用向量（元素 i 位于 返回值 + 4 + 4 * i，之后 patch()）
+  size_t offsetVector(size_t count)
+  {
+    pad(4);
+    const size_t vector = buf_.size();
+    buf_.resize(vector + 4 + 4 * count, 0);
+    set(vector, static_cast<int64_t>(count), 4);
+    return vector;
+  }
+
+  /// 结构体向量（元素按 8 字节对齐，元素 i 位于 返回值 + 4 + elem_size * i，之后 set()）
+  size_t structVector(size_t count, size_t elem_size)
+  {
+    while ((buf_.size() + 4) % 8 != 0)
+    {
+      buf_.push_back(0);
+    }
+    const size_t vector = buf_.size();
+    buf_.resize(vector + 4 + elem_size * count, 0);
+    set(vector, static_cast<int64_t>(count), 4);
+    return vector;
+  }
+
+  size_t string(const std::string &text)
+  {
+    pad(4);
+    const size_t pos = buf_.size();
+    buf_.resize(pos + 4, 0);
+    set(pos, static_cast<int64_t>(text.size()), 4);
+    buf_.insert(buf_.end(), text.begin(), text.end());
+    buf_.push_back(0);
+    return pos;
+  }
+
+  /// 在 at 处写入指向 target 的 uoffset
+  void patch(size_t at, size_t target) { set(at, static_cast<int64_t>(target - at), 4); }
+
+  /// 在 at 处写入 size 字节的小端标量
+  void set(size_t at, int64_t value, size_t size) { std::memcpy(&buf_[at], &value, size); }
+
+  /// 设置根表并补齐到 8 字节
+  void finish(size_t root)
+  {
+    patch(0, root);
+    pad(8);
+  }
+
+private:
+  static constexpr size_t MAX_SLOTS = 8;
+
+  void pad(size_t alignment)
+  {
+    buf_.resize(alignUp(buf_.size(), alignment), 0);
+  }
+
+  std::vector<uint8_t> &buf_;
+};
+
+/**
+ * 带越界检查的 FlatBuffers 读取（续写、补写 Footer 时解析已有的消息，文件损坏时返回 false）
+ */
+class FlatReader
+{
+public:
+  FlatReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  bool read(size_t at, T &value) const
+  {
+    if (at > size_ || size_ - at < sizeof(T))
+    {
+      return false;
+    }
+    std::memcpy(&value, data_ + at, sizeof(T));
+    return true;
+  }
+
+  /// at 处的 uoffset 指向的位置
+  bool ref(size_t at, size_t &target) const
+  {
+    uint32_t offset = 0;
+    if (!read(at, offset) || offset > size_ - at)
+    {
+      return false;
+    }
+    target = at + offset;
+    return true;
+  }
+
+  /// 表 table 中 slot 字段的位置（字段不存在时返回 false）
+  bool field(size_t table, uint16_t slot, size_t &at) const
+  {
+    int32_t soffset = 0;
+    uint16_t vtable_size = 0;
+    uint16_t offset = 0;
+    if (!read(table, soffset) || static_cast<int64_t>(table) - soffset < 0)
+    {
+      return false;
+    }
+    const size_t vtable = static_cast<size_t>(static_cast<int64_t>(table) - soffset);
+    if (!read(vtable, vtable_size) || 4u + 2u * slot >= vtable_size || !read(vtable + 4 + 2 * slot, offset) || offset == 0)
+    {
+      return false;
+    }
+    at = table + offset;
+    return true;
+  }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+};
+
+/// Schema 表：所有列为不可为空的 float64
+size_t writeSchema(FlatBuilder &fb, const std::vector<std::string> &names)
+{
+  size_t schema_refs[1];
+  const size_t schema = fb.table({{1, 0, 0}}, schema_refs);
+  const size_t fields = fb.offsetVector(names.size());
+  fb.patch(schema_refs[0], fields);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    size_t field_refs[3];
+    const size_t field = fb.table({{0, 0, 0}, {1, 1, 0}, {2, 1, ARROW_TYPE_FLOATING_POINT}, {3, 0, 0}, {5, 0, 0}}, field_refs);
+    fb.patch(fields + 4 + 4 * i, field);
+    fb.patch(field_refs[0], fb.string(names[i]));
+    fb.patch(field_refs[1], fb.table({{0, 2, ARROW_PRECISION_DOUBLE}}));
+    fb.patch(field_refs[2], fb.offsetVector(0)); // children 必须存在（可为空）
+  }
+  return schema;
+}
+
+void encodeSchemaMessage(const std::vector<std::string> &names, std::vector<uint8_t> &out)
+{
+  FlatBuilder fb(out);
+  size_t refs[1];
+  const size_t message = fb.table({{0, 2, ARROW_METADATA_V5}, {1, 1, ARROW_HEADER_SCHEMA}, {2, 0, 0}, {3, 8, 0}}, refs);
+  fb.patch(refs[0], writeSchema(fb, names));
+  fb.finish(message);
+}
+
+/**
+ * RecordBatch 消息：第 c 列的数据从消息体的 c * column_stride 开始，共 rows 个 double；
+ * 每列另有一个长度为 0 的有效位图（没有空值）
+ */
+void encodeRecordBatchMessage(size_t columns, uint64_t rows, uint64_t column_stride, std::vector<uint8_t> &out)
+{
+  FlatBuilder fb(out);
+  size_t message_refs[1];
+  const int64_t body_length = static_cast<int64_t>(columns * column_stride);
+  const size_t message = fb.table({{0, 2, ARROW_METADATA_V5}, {1, 1, ARROW_HEADER_RECORD_BATCH}, {2, 0, 0}, {3, 8, body_length}}, message_refs);
+  size_t batch_refs[2];
+  const size_t batch = fb.table({{0, 8, static_cast<int64_t>(rows)}, {1, 0, 0}, {2, 0, 0}}, batch_refs);
+  fb.patch(message_refs[0], batch);
+
+  const size_t nodes = fb.structVector(columns, 16); // FieldNode { length, null_count }
+  for (size_t c = 0; c < columns; ++c)
+  {
+    fb.set(nodes + 4 + 16 * c, static_cast<int64_t>(rows), 8);
+  }
+  fb.patch(batch_refs[0], nodes);
+
+  const size_t buffers = fb.structVector(2 * columns, 16); // Buffer { offset, length }
+  for (size_t c = 0; c < columns; ++c)
+  {
+    const size_t at = buffers + 4 + 32 * c;
+    fb.set(at, static_cast<int64_t>(c * column_stride), 8);
+    fb.set(at + 16, static_cast<int64_t>(c * column_stride), 8);
+    fb.set(at + 24, static_cast<int64_t>(rows * sizeof(double)), 8);
+  }
+  fb.patch(batch_refs[1], buffers);
+  fb.finish(message);
+}
+
+/// 封装消息：续接标记、元数据长度（含补齐）、FlatBuffer、补零到 framed_bytes
+void frameMessage(char *out, uint32_t framed_bytes, const std::vector<uint8_t> &flat)
+{
+  const uint32_t prefix[2] = {ARROW_CONTINUATION, framed_bytes - 8};
+  std::memcpy(out, prefix, sizeof(prefix));
+  std::memcpy(out + 8, flat.data(), flat.size());
+  std::memset(out + 8 + flat.size(), 0, framed_bytes - 8 - flat.size());
+}
+} // namespace
+
+std::vector<std::string> sessionColumnNames(int motor_count)
+{
+  std::vector<std::string> names;
+  names.reserve(1 + static_cast<size_t>(std::max(motor_count, 0)) * MOTOR_FIELD_COUNT);
+  names.push_back("timestamp");
+  for (int m = 0; m < motor_count; ++m)
+  {
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      names.push_back("Motor" + std::to_string(m + 1) + "/" + MOTOR_FIELDS[f].name);
+    }
+  }
+  return names;
+}
+
+SessionStoreFile::~SessionStoreFile()
+{
+  close();
+}
+
+bool SessionStoreFile::open(const std::string &filename, int motor_count)
+{
+  if (motor_count < 1 || motor_count > MAX_MOTOR_COUNT)
+  {
+    return false;
+  }
+  return openFile(filename, motor_count, nullptr);
+}
+
+bool SessionStoreFile::reopen(const std::string &filename, std::string *error)
+{
+  return openFile(filename, 0, error);
+}
+
+bool SessionStoreFile::openFile(const std::string &filename, int motor_count, std::string *error)
+{
+  close();
+  const int fd = ::open(filename.c_str(), motor_count > 0 ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDWR | O_CLOEXEC), 0644);
+  if (fd < 0)
+  {
+    setError(error, "无法打开文件, errno = " + std::to_string(errno));
+    return false;
+  }
+  fd_ = fd;
+  filename_ = filename;
+  failed_ = false;
+
+  // 已有的会话文件：在已有的块之后续写（去掉 Footer）；否则重新创建
+  if (load(motor_count))
+  {
+    return true;
+  }
+  if (motor_count > 0)
+  {
+    setLayout(motor_count);
+    if (create())
+    {
+      return true;
+    }
+    setError(error, "写入文件失败");
+  }
+  else
+  {
+    setError(error, "不是有效的会话文件");
+  }
+  ::close(fd_);
+  fd_ = -1;
+  return false;
+}
+
+void SessionStoreFile::setLayout(int motor_count)
+{
+  motor_count_ = motor_count;
+  column_count_ = 1 + static_cast<size_t>(motor_count) * MOTOR_FIELD_COUNT;
+  stage_.assign(column_count_ * SESSION_STAGE_ROWS, 0.0);
+  staged_rows_ = 0;
+  encodeRecordBatchMessage(column_count_, 0, 0, metadata_);
+  chunk_metadata_bytes_ = static_cast<uint32_t>(alignUp(8 + metadata_.size(), ARROW_ALIGNMENT));
+}
+
+bool SessionStoreFile::create()
+{
+  if (::ftruncate(fd_, 0) != 0)
+  {
+    return false;
+  }
+  std::vector<uint8_t> flat;
+  encodeSchemaMessage(sessionColumnNames(motor_count_), flat);
+  // Schema 消息从偏移 8 开始，补齐使第一个块从 64 字节边界开始
+  const uint32_t framed = static_cast<uint32_t>(alignUp(8 + 8 + flat.size(), ARROW_ALIGNMENT) - 8);
+  std::vector<char> head(8 + framed);
+  std::memcpy(head.data(), ARROW_MAGIC, sizeof(ARROW_MAGIC));
+  frameMessage(head.data() + 8, framed, flat);
+  if (!pwriteAll(fd_, head.data(), head.size(), 0))
+  {
+    return false;
+  }
+  end_ = head.size();
+  blocks_.clear();
+  row_count_ = 0;
+  return true;
+}
+
+bool SessionStoreFile::load(int motor_count)
+{
+  struct stat st{};
+  char magic[sizeof(ARROW_MAGIC)];
+  if (::fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(magic)) || !preadAll(fd_, magic, sizeof(magic), 0) ||
+      std::memcmp(magic, ARROW_MAGIC, 6) != 0)
+  {
+    return false;
+  }
+  const uint64_t size = static_cast<uint64_t>(st.st_size);
+
+  // 依次解析消息，直到结束标记、Footer 或末尾不完整的消息
+  std::vector<uint8_t> metadata;
+  std::vector<Block> blocks;
+  uint64_t rows = 0;
+  int file_motors = 0;
+  uint64_t pos = sizeof(ARROW_MAGIC);
+  while (pos + 8 <= size)
+  {
+    uint32_t prefix[2];
+    if (!preadAll(fd_, prefix, sizeof(prefix), pos) || prefix[0] != ARROW_CONTINUATION || prefix[1] == 0 ||
+        prefix[1] % 8 != 0 || pos + 8 + prefix[1] > size)
+    {
+      break;
+    }
+    metadata.resize(prefix[1]);
+    if (!preadAll(fd_, metadata.data(), metadata.size(), pos + 8))
+    {
+      break;
+    }
+
+    const FlatReader reader(metadata.data(), metadata.size());
+    size_t message = 0, header = 0, at = 0;
+    uint8_t type = 0;
+    int64_t body = 0;
+    if (!reader.ref(0, message) || !reader.field(message, 1, at) || !reader.read(at, type) ||
+        !reader.field(message, 2, at) || !reader.ref(at, header) || (reader.field(message, 3, at) && !reader.read(at, body)) ||
+        body < 0 || pos + 8 + prefix[1] + static_cast<uint64_t>(body) > size)
+    {
+      break;
+    }
+
+    if (file_motors == 0)
+    {
+      // 第一个消息必须是 Schema，电机数由列数得出
+      size_t fields = 0;
+      uint32_t columns = 0;
+      if (type != ARROW_HEADER_SCHEMA || !reader.field(header, 1, at) || !reader.ref(at, fields) || !reader.read(fields, columns) ||
+          columns < 1 + MOTOR_FIELD_COUNT || (columns - 1) % MOTOR_FIELD_COUNT != 0 ||
+          (columns - 1) / MOTOR_FIELD_COUNT > static_cast<uint32_t>(MAX_MOTOR_COUNT))
+      {
+        return false;
+      }
+      file_motors = static_cast<int>((columns - 1) / MOTOR_FIELD_COUNT);
+      if (motor_count > 0 && file_motors != motor_count)
+      {
+        return false;
+      }
+    }
+    else if (type == ARROW_HEADER_RECORD_BATCH)
+    {
+      int64_t length = 0;
+      if (reader.field(header, 0, at))
+      {
+        reader.read(at, length);
+      }
+      blocks.push_back({pos, 8 + prefix[1], static_cast<uint64_t>(body)});
+      rows += static_cast<uint64_t>(std::max<int64_t>(length, 0));
+    }
+    else
+    {
+      break; // 不是本模块写入的消息
+    }
+    pos += 8 + prefix[1] + static_cast<uint64_t>(body);
+  }
+  if (file_motors == 0 || ::ftruncate(fd_, static_cast<off_t>(pos)) != 0)
+  {
+    return false;
+  }
+
+  setLayout(file_motors);
+  end_ = pos;
+  blocks_ = std::move(blocks);
+  row_count_ = rows;
+  return true;
+}
+
+bool SessionStoreFile::startChunk()
+{
+  const uint64_t body_bytes = column_count_ * SESSION_CHUNK_ROWS * sizeof(double);
+  const uint64_t chunk_bytes = chunk_metadata_bytes_ + body_bytes;
+
+  // 先预留磁盘空间：映射区域写入时磁盘已满会触发 SIGBUS
+  const int rc = ::posix_fallocate(fd_, static_cast<off_t>(end_), static_cast<off_t>(chunk_bytes));
+  if (rc != 0)
+  {
+    std::cerr << "⚠️ 会话文件预留空间失败，停止记录: " << filename_ << ", errno = " << rc << std::endl;
+    failed_ = true;
+    return false;
+  }
+
+  static const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  const uint64_t map_offset = end_ / page * page;
+  map_length_ = static_cast<size_t>(end_ + chunk_bytes - map_offset);
+  void *map = ::mmap(nullptr, map_length_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, static_cast<off_t>(map_offset));
+  if (map == MAP_FAILED)
+  {
+    std::cerr << "⚠️ 会话文件映射失败，停止记录: " << filename_ << ", errno = " << errno << std::endl;
+    failed_ = true;
+    return false;
+  }
+  map_ = static_cast<char *>(map);
+  chunk_ = map_ + (end_ - map_offset);
+  columns_ = reinterpret_cast<double *>(chunk_ + chunk_metadata_bytes_);
+  chunk_rows_ = 0;
+  flushed_rows_ = 0;
+  writeChunkMetadata(0, SESSION_CHUNK_ROWS * sizeof(double));
+  return true;
+}
+
+void SessionStoreFile::writeChunkMetadata(uint64_t rows, uint64_t column_stride)
+{
+  encodeRecordBatchMessage(column_count_, rows, column_stride, metadata_);
+  frameMessage(chunk_, chunk_metadata_bytes_, metadata_);
+}
+
+void SessionStoreFile::append(const RawMotorFrame &frame)
+{
+  if (fd_ < 0 || failed_ || (!chunk_ && !startChunk()))
+  {
+    return;
+  }
+
+  // 暂存区第 c 列的第 row 个元素；列按 时间戳、Motor1 各字段、Motor2 各字段 ... 排列
+  const size_t row = staged_rows_;
+  double *column = stage_.data();
+  column[row] = frame.stamp;
+  const int motors = std::min<int>(frame.motor_count, motor_count_);
+  for (int m = 0; m < motor_count_; ++m)
+  {
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      column += SESSION_STAGE_ROWS;
+      column[row] = m < motors ? motorFieldValue(frame.motors[m], f) : 0.0;
+    }
+  }
+  ++row_count_;
+  // 暂存区攒满或当前块写满时拷入映射（flush() 会拷入不满的暂存区，块内帧数不一定是 SESSION_STAGE_ROWS 的倍数）
+  if (++staged_rows_ == SESSION_STAGE_ROWS || chunk_rows_ + staged_rows_ == SESSION_CHUNK_ROWS)
+  {
+    commitStage();
+    if (chunk_rows_ == SESSION_CHUNK_ROWS)
+    {
+      finishChunk();
+    }
+  }
+}
+
+void SessionStoreFile::commitStage()
+{
+  if (!chunk_ || staged_rows_ == 0)
+  {
+    return;
+  }
+  for (size_t c = 0; c < column_count_; ++c)
+  {
+    std::memcpy(columns_ + c * SESSION_CHUNK_ROWS + chunk_rows_, &stage_[c * SESSION_STAGE_ROWS], staged_rows_ * sizeof(double));
+  }
+  chunk_rows_ += staged_rows_;
+  staged_rows_ = 0;
+}
+
+void SessionStoreFile::flush()
+{
+  commitStage();
+  if (chunk_ && chunk_rows_ != flushed_rows_)
+  {
+    writeChunkMetadata(chunk_rows_, SESSION_CHUNK_ROWS * sizeof(double));
+    flushed_rows_ = chunk_rows_;
+  }
+}
+
+void SessionStoreFile::finishChunk()
+{
+  uint64_t stride = SESSION_CHUNK_ROWS * sizeof(double);
+  if (chunk_rows_ < SESSION_CHUNK_ROWS)
+  {
+    // 未写满的块：各列前移紧缩（列 c 的目标区间总在未移动的列之前，按列顺序移动即可），补齐部分清零
+    const uint64_t used = chunk_rows_ * sizeof(double);
+    stride = alignUp(used, ARROW_ALIGNMENT);
+    char *body = reinterpret_cast<char *>(columns_);
+    for (size_t c = 0; c < column_count_; ++c)
+    {
+      std::memmove(body + c * stride, columns_ + c * SESSION_CHUNK_ROWS, used);
+      std::memset(body + c * stride + used, 0, stride - used);
+    }
+  }
+  writeChunkMetadata(chunk_rows_, stride);
+
+  const uint64_t body_length = column_count_ * stride;
+  blocks_.push_back({end_, chunk_metadata_bytes_, body_length});
+  end_ += chunk_metadata_bytes_ + body_length;
+
+  ::munmap(map_, map_length_);
+  map_ = chunk_ = nullptr;
+  columns_ = nullptr;
+  chunk_rows_ = flushed_rows_ = 0;
+}
+
+bool SessionStoreFile::writeFooter()
+{
+  std::vector<uint8_t> tail;
+  {
+    FlatBuilder fb(tail);
+    size_t refs[3];
+    const size_t footer = fb.table({{0, 2, ARROW_METADATA_V5}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}}, refs);
+    fb.patch(refs[0], writeSchema(fb, sessionColumnNames(motor_count_)));
+    fb.patch(refs[1], fb.structVector(0, ARROW_BLOCK_BYTES));
+    const size_t batches = fb.structVector(blocks_.size(), ARROW_BLOCK_BYTES);
+    for (size_t i = 0; i < blocks_.size(); ++i)
+    {
+      const size_t at = batches + 4 + ARROW_BLOCK_BYTES * i;
+      fb.set(at, static_cast<int64_t>(blocks_[i].offset), 8);
+      fb.set(at + 8, blocks_[i].metadata_length, 4);
+      fb.set(at + 16, static_cast<int64_t>(blocks_[i].body_length), 8);
+    }
+    fb.patch(refs[2], batches);
+    fb.finish(footer);
+  }
+
+  // 流结束标记 + Footer + Footer 长度（int32）+ 结尾魔数
+  const uint32_t end_of_stream[2] = {ARROW_CONTINUATION, 0};
+  const int32_t footer_length = static_cast<int32_t>(tail.size());
+  std::vector<char> out(sizeof(end_of_stream));
+  std::memcpy(out.data(), end_of_stream, sizeof(end_of_stream));
+  out.insert(out.end(), tail.begin(), tail.end());
+  out.resize(out.size() + sizeof(footer_length));
+  std::memcpy(out.data() + out.size() - sizeof(footer_length), &footer_length, sizeof(footer_length));
+  out.insert(out.end(), ARROW_MAGIC, ARROW_MAGIC + 6);
+  return pwriteAll(fd_, out.data(), out.size(), end_);
+}
+
+void SessionStoreFile::close()
+{
+  if (fd_ < 0)
+  {
+    return;
+  }
+  commitStage();
+  if (map_)
+  {
+    if (chunk_rows_ > 0)
+    {
+      finishChunk();
+    }
+    else
+    {
+      ::munmap(map_, map_length_); // 空块不写入（预留的空间由下面的截断释放）
+      map_ = chunk_ = nullptr;
+      columns_ = nullptr;
+    }
+  }
+  if (::ftruncate(fd_, static_cast<off_t>(end_)) != 0 || !writeFooter())
+  {
+    std::cerr << "⚠️ 会话文件写入 Footer 失败: " << filename_ << std::endl;
+  }
+  ::close(fd_);
+  fd_ = -1;
+  blocks_.clear();
+  row_count_ = 0;
+  chunk_rows_ = flushed_rows_ = 0;
+  staged_rows_ = 0;
+}
+
+uint64_t SessionStoreFile::bytesWritten() const
+{
+  if (fd_ < 0)
+  {
+    return 0;
+  }
+  return end_ + (chunk_ ? chunk_metadata_bytes_ + (chunk_rows_ + staged_rows_) * column_count_ * sizeof(double) : 0);
+}
@@ -0,0 +1,193 @@
+/**
+ * @file sessionStore.h
+ * @brief 列式会话记录（Arrow IPC 文件，pandas / pyarrow 直接读取）头文件
+ * @author mafangniu
+ * @date 2025-05-18
+ *
+ * @details
+ * 文本日志按 4 位小数格式化，离线分析时解析很慢且丢失精度；二进制日志是按帧排列的记录，分析工具仍需逐帧展开。
+ * 会话记录把帧按列存放：每个 电机 x 字段 一个连续的 double 数组，外加一列时间戳（Unix 秒），
+ * 文件直接是 Arrow IPC 文件格式（Feather V2），可用
+ *
+ *     pandas.read_feather("xxx.arrow")  或  pyarrow.ipc.open_file("xxx.arrow").read_all()
+ *
+ * 读取（列名为 "timestamp"、"Motor1/Pos" ...，与 PlotJuggler 中的曲线名一致），数值为完整的 double 精度。
+ * 需要 Parquet 时由 pyarrow 一行转换：pyarrow.parquet.write_table(pyarrow.feather.read_table(f), "xxx.parquet")。
+ *
+ * 文件布局：
+ * - "ARROW1" 魔数 + Schema 消息（所有列均为 float64、不可为空）；
+ * - 每 SESSION_CHUNK_ROWS 帧一个 RecordBatch 消息（一个块）：元数据 + 消息体，消息体中各列依次连续存放。
+ *   块在开始时用 posix_fallocate 预留磁盘空间，整块通过 mmap 映射后由写线程按列写入，写满后解除映射，
+ *   内存中只有当前块（已写满的块由内核回写磁盘，可随时被换出），记录数小时也不会占用大量内存。
+ *   每帧先写入一个 SESSION_STAGE_ROWS 帧的按列暂存区（每帧逐列写入映射要访问上百个不同的页，TLB 开销很大），
+ *   攒满后每列一次拷贝 512 字节到映射中；
+ * - 关闭时把最后一个未写满的块按实际帧数紧缩并截断文件，追加 Footer（各块的位置）和结尾魔数。
+ *
+ * 每批写入后把当前块的元数据更新为已写入的帧数，进程异常退出时文件只缺 Footer，
+ * 可用 tools/motor_session_export --repair 补写（已写入的帧不丢失）。
+ * 所有数值按本机字节序（x86/ARM 小端）写入，与 Arrow 的小端约定一致。
+ *
+ * @note 只在写线程中使用，不做线程同步
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "motorData.h"
+
+static constexpr size_t SESSION_CHUNK_ROWS = 8192; ///< 每个块（RecordBatch）的帧数，每列 64 KiB
+static constexpr size_t SESSION_STAGE_ROWS = 64;   ///< 先在内存中按列暂存的帧数，攒满后每列整段拷入映射
+
+/**
+ * @brief 会话文件的列名：第 0 列为 "timestamp"，之后为 "Motor<n>/<字段名>"（电机从 1 开始，字段顺序同 MOTOR_FIELDS）
+ * @param motor_count 电机数
+ */
+std::vector<std::string> sessionColumnNames(int motor_count);
+
+/**
+ * @class SessionStoreFile
+ * @brief 列式会话文件写入器（按块 mmap 写入的 Arrow IPC 文件）
+ */
+class SessionStoreFile
+{
+public:
+  SessionStoreFile() = default;
+  ~SessionStoreFile();
+
+  SessionStoreFile(const SessionStoreFile &) = delete;
+  SessionStoreFile &operator=(const SessionStoreFile &) = delete;
+
+  /**
+   * @brief 打开（或续写）会话文件
+   * @param filename 会话文件名（通常以 .arrow 结尾）
+   * @param motor_count 每帧的电机数（1 ~ MAX_MOTOR_COUNT），决定列数
+   * @return 成功返回 true
+   *
+   * 文件已存在且是电机数相同的会话文件（已正常关闭或异常退出未补写 Footer）时在已有的块之后续写，否则重新创建。
+   */
+  bool open(const std::string &filename, int motor_count);
+
+  /**
+   * @brief 续写已有的会话文件，电机数取自文件（用于补写异常退出的文件的 Footer：reopen() 后直接 close()）
+   * @param filename 会话文件名
+   * @param error 失败时写入错误原因（可为 nullptr）
+   * @return 文件是有效的会话文件返回 true
+   */
+  bool reopen(const std::string &filename, std::string *error = nullptr);
+
+  /**
+   * @brief 追加一帧（写入暂存区，攒满后拷入当前块的各列，块写满时解除映射并开始下一块）
+   * @param frame 原始帧（时间戳取 frame.stamp），写入前 motorCount() 个电机，
+   *              frame.motor_count 不足时缺少的电机补零
+   */
+  void append(const RawMotorFrame &frame);
+
+  /**
+   * @brief 把暂存的帧拷入当前块，并把块的元数据更新为已写入的帧数（每批写入后调用，异常退出后可据此恢复）
+   */
+  void flush();
+
+  /**
+   * @brief 紧缩最后一个块，写入 Footer 并关闭文件
+   */
+  void close();
+
+  bool isOpen() const { return fd_ >= 0; }
+
+  /**
+   * @brief 当前文件每帧的电机数
+   */
+  int motorCount() const { return motor_count_; }
+
+  /**
+   * @brief 已写入（含续写前已有）的帧数
+   */
+  uint64_t rowCount() const { return row_count_; }
+
+  /**
+   * @brief 已写入数据的字节数（当前块按已写入的帧计算）
+   */
+  uint64_t bytesWritten() const;
+
+private:
+  /// Footer 中一个块的位置（Arrow File.fbs 的 Block）
+  struct Block
+  {
+    uint64_t offset;          ///< 消息起始偏移
+    uint32_t metadata_length; ///< 元数据字节数（含 8 字节前缀和补齐）
+    uint64_t body_length;     ///< 消息体字节数
+  };
+
+  /**
+   * @brief open() / reopen() 的实现
+   * @param motor_count 电机数；0 表示只续写已有的文件（电机数取自文件，不创建新文件）
+   */
+  bool openFile(const std::string &filename, int motor_count, std::string *error);
+
+  /**
+   * @brief 解析已有文件的 Schema 和各块，截断 Footer 以便续写
+   * @param motor_count 要求的电机数，0 表示不限
+   * @return 是有效的会话文件（且电机数相同）返回 true
+   */
+  bool load(int motor_count);
+
+  /**
+   * @brief 按电机数确定列数和块元数据的长度
+   */
+  void setLayout(int motor_count);
+
+  /**
+   * @brief 创建新文件：写入魔数和 Schema 消息
+   */
+  bool create();
+
+  /**
+   * @brief 预留、映射下一个块
+   */
+  bool startChunk();
+
+  /**
+   * @brief 把暂存区中的帧按列拷入当前块
+   */
+  void commitStage();
+
+  /**
+   * @brief 解除当前块的映射并记入 Footer 的块列表（未写满的块先紧缩）
+   */
+  void finishChunk();
+
+  /**
+   * @brief 把当前块的 RecordBatch 元数据写入映射
+   * @param rows 已写入的帧数
+   * @param column_stride 消息体中相邻两列的间隔（字节）
+   */
+  void writeChunkMetadata(uint64_t rows, uint64_t column_stride);
+
+  /**
+   * @brief 在文件末尾写入 Footer 和结尾魔数
+   */
+  bool writeFooter();
+
+  int fd_ = -1;
+  std::string filename_;
+  int motor_count_ = 0;
+  size_t column_count_ = 0;          ///< 1 + motor_count * MOTOR_FIELD_COUNT
+  uint32_t chunk_metadata_bytes_ = 0; ///< 块元数据字节数（列数确定后固定）
+  uint64_t end_ = 0;                 ///< 已完成的块之后的文件偏移（下一个块的起始）
+  std::vector<Block> blocks_;        ///< 已完成的块
+  uint64_t row_count_ = 0;           ///< 总帧数（含当前块）
+  bool failed_ = false;              ///< 预留空间、映射失败后不再写入（只提示一次）
+
+  char *map_ = nullptr;        ///< 当前块的映射（从页边界开始）
+  size_t map_length_ = 0;      ///< 映射长度
+  char *chunk_ = nullptr;      ///< 当前块消息的起始（映射内）
+  double *columns_ = nullptr;  ///< 当前块消息体（第 c 列从 columns_ + c * SESSION_CHUNK_ROWS 开始）
+  uint64_t chunk_rows_ = 0;    ///< 当前块已写入的帧数（不含暂存区）
+  uint64_t flushed_rows_ = 0;  ///< 当前块元数据中记录的帧数
+  std::vector<double> stage_;  ///< 暂存区（按列，第 c 列为 stage_[c * SESSION_STAGE_ROWS ...]）
+  size_t staged_rows_ = 0;     ///< 暂存区中的帧数
+  std::vector<uint8_t> metadata_; ///< 元数据编码缓冲（复用）
+};
@@ -0,0 +1,196 @@
+/**
+ * @file shmTransport.cpp
+ * @brief 共享内存帧环形缓冲读端实现
+ * @author mafangniu
+ * @date 2025-05-06
+ */
+
+#include "shmTransport.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "specTokens.h"
+
+ShmRingReader::~ShmRingReader()
+{
+  detach();
+}
+
+bool ShmRingReader::attach(const std::string &name, std::string *error)
+{
+  detach();
+
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd < 0)
+  {
+    setError(error, "无法打开共享内存 " + name + ": " + std::strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(MotorShmHeader))
+  {
+    setError(error, "共享内存 " + name + " 尚未初始化");
+    close(fd);
+    return false;
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    setError(error, "无法映射共享内存 " + name + ": " + std::strerror(errno));
+    return false;
+  }
+
+  // 写端最后写入 magic，读到 magic 后其余头部字段都已初始化
+  MotorShmHeader *header = static_cast<MotorShmHeader *>(base);
+  const uint32_t slot_count = header->slot_count;
+  const bool valid = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == MOTOR_SHM_MAGIC &&
+                     header->version == MOTOR_SHM_VERSION && header->slot_bytes == MOTOR_SHM_SLOT_BYTES &&
+                     slot_count > 0 && (slot_count & (slot_count - 1)) == 0 &&
+                     size >= sizeof(MotorShmHeader) + static_cast<size_t>(slot_count) * sizeof(MotorShmSlot);
+  if (!valid)
+  {
+    setError(error, "共享内存 " + name + " 布局不匹配或尚未初始化");
+    munmap(base, size);
+    return false;
+  }
+
+  header_ = header;
+  slots_ = reinterpret_cast<MotorShmSlot *>(static_cast<char *>(base) + sizeof(MotorShmHeader));
+  mapped_bytes_ = size;
+  slot_mask_ = slot_count - 1;
+  read_seq_ = __atomic_load_n(&header_->write_seq, __ATOMIC_ACQUIRE); // 从最新的帧开始读
+  return true;
+}
+
+void ShmRingReader::detach()
+{
+  if (header_)
+  {
+    munmap(header_, mapped_bytes_);
+  }
+  header_ = nullptr;
+  slots_ = nullptr;
+  mapped_bytes_ = 0;
+  interrupted_ = false;
+}
+
+bool ShmRingReader::hasData() const
+{
+  return header_ && __atomic_load_n(&header_->write_seq, __ATOMIC_SEQ_CST) != read_seq_;
+}
+
+ShmReadResult ShmRingReader::readFrames(RawMotorFrame *frames, double *publish_stamps, int max_frames, CompactKeyframe *keyframe)
+{
+  ShmReadResult result;
+  if (!header_)
+  {
+    return result;
+  }
+
+  const uint64_t write_seq = __atomic_load_n(&header_->write_seq, __ATOMIC_ACQUIRE);
+  if (write_seq - read_seq_ > slot_mask_ + 1)
+  {
+    // 落后超过一圈：未读的帧已被覆盖，跳到最新位置
+    overruns_ += write_seq - read_seq_;
+    read_seq_ = write_seq;
+    return result;
+  }
+
+  while (result.frames < max_frames && read_seq_ != write_seq)
+  {
+    const MotorShmSlot &slot = slots_[read_seq_ & slot_mask_];
+    const uint64_t expected = 2 * read_seq_ + 2;
+    const uint64_t seq_before = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+    if (seq_before != expected)
+    {
+      if (seq_before > expected)
+      {
+        // 该槽位已被下一圈的帧覆盖（或正在覆盖）
+        overruns_ += write_seq - read_seq_;
+        read_seq_ = write_seq;
+      }
+      break;
+    }
+
+    // 原地解析：槽位中的数据报直接解析到输出帧
+    const uint32_t len = slot.len;
+    const uint64_t publish_ns = slot.publish_ns;
+    RawMotorFrame &frame = frames[result.frames];
+    const MotorPacketStatus status =
+        decodeMotorPacket(slot.data, len <= MOTOR_SHM_SLOT_BYTES ? len : 0, frame, keyframe);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) != seq_before)
+    {
+      // 解析过程中被写端改写，结果无效；关键帧状态可能已被改写的内容污染，等待下一个关键帧
+      if (keyframe)
+      {
+        keyframe->valid = false;
+      }
+      overruns_ += write_seq - read_seq_;
+      read_seq_ = write_seq;
+      break;
+    }
+    ++read_seq_;
+
+    if (status == MotorPacketStatus::Ok)
+    {
+      publish_stamps[result.frames] = publish_ns * 1e-9;
+      ++result.frames;
+    }
+    else
+    {
+      ++result.malformed;
+      result.last_error = status;
+      result.last_error_bytes = len;
+    }
+  }
+  return result;
+}
+
+bool ShmRingReader::waitForData(int timeout_ms)
+{
+  if (!header_)
+  {
+    return false;
+  }
+
+  // 先取 futex_word 再声明等待并检查数据：写端在此之后发布的帧一定会改变 futex_word，FUTEX_WAIT 立即返回
+  const uint32_t observed = __atomic_load_n(&header_->futex_word, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&header_->reader_waiting, 1u, __ATOMIC_SEQ_CST);
+  if (!hasData() && !interrupted_)
+  {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+    // 跨进程共享的 futex，不能使用 FUTEX_PRIVATE_FLAG
+    syscall(SYS_futex, &header_->futex_word, FUTEX_WAIT, observed, &timeout, nullptr, 0);
+  }
+  __atomic_store_n(&header_->reader_waiting, 0u, __ATOMIC_RELAXED);
+  return hasData();
+}
+
+void ShmRingReader::interrupt()
+{
+  if (!header_)
+  {
+    return;
+  }
+
+  // 先置标志再改变 futex_word：读端若在此之前已取得 futex_word，FUTEX_WAIT 因值不同立即返回；否则会看到标志
+  interrupted_ = true;
+  __atomic_add_fetch(&header_->futex_word, 1u, __ATOMIC_SEQ_CST);
+  syscall(SYS_futex, &header_->futex_word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file shmTransport.h
+ * @brief 共享内存帧环形缓冲的读端（同机发送时替代 UDP 的输入）
+ * @author mafangniu
+ * @date 2025-05-06
+ *
+ * @details
+ * 布局与写端协议见 motorShmLayout.h。读端在接收线程中使用：
+ * - attach() 映射写端创建的共享内存（写端尚未启动时返回 false，接收线程定期重试），
+ *   从当前最新的帧开始读取，不回放映射前残留的旧帧；
+ * - readFrames() 在共享内存槽位中原地解析数据报（decodeMotorPacket()）得到 RawMotorFrame，
+ *   不经过 socket 缓冲和接收缓冲的拷贝；
+ * - waitForData() 在 futex_word 上等待写端发布新帧（只有共享内存数据源时使用，唤醒延迟为微秒级）。
+ *
+ * 读端落后超过一圈（槽位被覆盖或读取过程中被改写）时，跳到写端最新位置，跳过的帧计入 overruns()。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "motorPacket.h"
+#include "motorShmLayout.h"
+
+static_assert(MOTOR_SHM_SLOT_BYTES >= MAX_MOTOR_PACKET_BYTES, "A shared memory slot must hold the largest motor packet.");
+
+/**
+ * @brief readFrames() 的结果
+ */
+struct ShmReadResult
+{
+  int frames = 0;                                         ///< 解析成功并写入输出的帧数
+  int malformed = 0;                                      ///< 解析失败的数据报数
+  MotorPacketStatus last_error = MotorPacketStatus::Ok;   ///< 最后一个解析失败的原因
+  uint32_t last_error_bytes = 0;                          ///< 最后一个解析失败的数据报字节数
+};
+
+/**
+ * @class ShmRingReader
+ * @brief 共享内存环形缓冲读端（只在一个线程中使用）
+ */
+class ShmRingReader
+{
+public:
+  ShmRingReader() = default;
+  ~ShmRingReader();
+
+  ShmRingReader(const ShmRingReader &) = delete;
+  ShmRingReader &operator=(const ShmRingReader &) = delete;
+
+  /**
+   * @brief 映射共享内存并校验布局
+   * @param name  共享内存名称（shm_open 的名称，如 "/motor_monitor"）
+   * @param error 失败时写入原因（可为 nullptr）
+   * @return 成功返回 true；写端尚未创建或尚未初始化完成时返回 false
+   */
+  bool attach(const std::string &name, std::string *error = nullptr);
+
+  void detach();
+
+  bool attached() const { return header_ != nullptr; }
+
+  /**
+   * @brief 是否有尚未读取的帧
+   */
+  bool hasData() const;
+
+  /**
+   * @brief 读取最多 max_frames 个新帧
+   * @param frames         输出帧
+   * @param publish_stamps 输出每帧的写端发布时间（秒，Unix 时间）
+   * @param max_frames     最多读取的帧数
+   * @param keyframe       紧凑格式关键帧状态（见 decodeMotorPacket()）
+   */
+  ShmReadResult readFrames(RawMotorFrame *frames, double *publish_stamps, int max_frames, CompactKeyframe *keyframe);
+
+  /**
+   * @brief 等待写端发布新帧
+   * @param timeout_ms 超时（毫秒）
+   * @return 有新帧返回 true，超时或被信号打断返回 false
+   */
+  bool waitForData(int timeout_ms);
+
+  /**
+   * @brief 让正在（或之后）调用 waitForData() 的读端线程立即返回（可在其他线程中调用，用于停止接收线程）
+   *
+   * 调用后 waitForData() 不再睡眠，直到 detach()；调用者需保证此时读端仍处于映射状态。
+   */
+  void interrupt();
+
+  /**
+   * @brief 读端跟不上写端而跳过的帧数（累计）
+   */
+  uint64_t overruns() const { return overruns_; }
+
+private:
+  MotorShmHeader *header_ = nullptr;
+  MotorShmSlot *slots_ = nullptr;
+  size_t mapped_bytes_ = 0;
+  uint64_t slot_mask_ = 0;
+  uint64_t read_seq_ = 0;  ///< 下一个要读取的帧序号
+  uint64_t overruns_ = 0;
+  std::atomic<bool> interrupted_{false}; ///< interrupt() 已被调用
+};
@@ -0,0 +1,68 @@
+/**
+ * @file specTokens.h
+ * @brief 配置字符串解析的公共工具：切分条目、写入错误原因
+ * @author mafangniu
+ * @date 2025-05-17
+ *
+ * @details
+ * 数据源列表、接收线程配置、转发配置、派生曲线、显示字段、告警规则等配置都是一个字符串，
+ * 条目之间以分隔符隔开，解析失败时把原因写入调用者传入的 error（可为 nullptr）。
+ * 条目本身不含空格的配置用 SPEC_SEPARATORS（逗号、分号和空白都可分隔）；
+ * 条目可能含空格的配置（字段名 "Mos Temperature"）用 SPEC_LIST_SEPARATORS，只按逗号、分号分隔。
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+static constexpr const char *SPEC_SEPARATORS = ",; \t\n"; ///< 逗号、分号、空白
+static constexpr const char *SPEC_LIST_SEPARATORS = ",;"; ///< 只有逗号、分号（条目可含空格）
+
+/**
+ * @brief 去掉首尾空白
+ */
+inline std::string trimSpec(const std::string &text)
+{
+  const size_t first = text.find_first_not_of(" \t\n");
+  if (first == std::string::npos)
+  {
+    return std::string();
+  }
+  return text.substr(first, text.find_last_not_of(" \t\n") - first + 1);
+}
+
+/**
+ * @brief 按分隔符切分配置字符串
+ * @param spec 配置字符串
+ * @param separators 分隔字符
+ * @return 去掉首尾空白后的非空条目（按出现顺序）
+ */
+inline std::vector<std::string> specTokens(const std::string &spec, const char *separators = SPEC_SEPARATORS)
+{
+  std::vector<std::string> tokens;
+  size_t pos = 0;
+  while (pos < spec.size())
+  {
+    const size_t end = spec.find_first_of(separators, pos);
+    std::string entry = trimSpec(spec.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+    pos = (end == std::string::npos) ? spec.size() : end + 1;
+    if (!entry.empty())
+    {
+      tokens.push_back(std::move(entry));
+    }
+  }
+  return tokens;
+}
+
+/**
+ * @brief 写入错误原因（error 为 nullptr 时忽略）
+ */
+inline void setError(std::string *error, const std::string &message)
+{
+  if (error)
+  {
+    *error = message;
+  }
+}
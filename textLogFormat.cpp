@@ -0,0 +1,197 @@
+/**
+ * @file textLogFormat.cpp
+ * @brief 文本日志快速格式化实现
+ * @author mafangniu
+ * @date 2025-05-10
+ */
+
+#include "textLogFormat.h"
+#include "motorFields.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+constexpr char FRAME_PREFIX[] = "===== Frame [";
+constexpr char FRAME_SUFFIX[] = "] =====\n";
+constexpr char MOTOR_PREFIX[] = "Motor[";
+constexpr char MOTOR_SUFFIX[] = "]\n";
+constexpr char MOTOR_SEPARATOR[] = "------------------------------\n";
+
+// 单个数值 "%.4f" 的最长输出：DBL_MAX 的 309 位整数 + 符号 + 小数点 + 4 位小数（另留结尾 '\0' 的位置）
+constexpr size_t MAX_VALUE_CHARS = 320;
+
+constexpr size_t cstrlen(const char *s)
+{
+  size_t n = 0;
+  while (s[n] != '\0')
+  {
+    ++n;
+  }
+  return n;
+}
+
+// 标签和单位片段及其长度（由 MOTOR_FIELDS 在编译期生成）
+struct FieldFragments
+{
+  size_t label_len[MOTOR_FIELD_COUNT];
+  size_t suffix_len[MOTOR_FIELD_COUNT];
+  size_t fixed_bytes; // 一个电机所有标签、单位的总字节数
+};
+
+constexpr FieldFragments makeFieldFragments()
+{
+  FieldFragments fragments{};
+  for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+  {
+    fragments.label_len[f] = cstrlen(MOTOR_FIELDS[f].log_label);
+    fragments.suffix_len[f] = cstrlen(MOTOR_FIELDS[f].log_suffix);
+    fragments.fixed_bytes += fragments.label_len[f] + fragments.suffix_len[f];
+  }
+  return fragments;
+}
+
+constexpr FieldFragments FIELD_FRAGMENTS = makeFieldFragments();
+
+// 一个电机格式化后的最大字节数
+constexpr size_t MAX_MOTOR_BYTES = (sizeof(MOTOR_PREFIX) - 1) + 11 + (sizeof(MOTOR_SUFFIX) - 1) + FIELD_FRAGMENTS.fixed_bytes +
+                                   MOTOR_FIELD_COUNT * MAX_VALUE_CHARS + (sizeof(MOTOR_SEPARATOR) - 1);
+
+inline char *appendLiteral(char *p, const char *text, size_t len)
+{
+  std::memcpy(p, text, len);
+  return p + len;
+}
+
+/**
+ * @brief 按 "%.4f" 输出一个数值，p 之后至少有 MAX_VALUE_CHARS 字节可写
+ *
+ * |value| < 1e11 时按定点整数输出：value * 10000 的整数部分和舍入都是精确的（乘积小于 2^53），
+ * 只有乘积的小数部分恰好为 0.5 时才可能是乘法舍入造成的，此时用 fma 求出乘法误差的符号决定进位，
+ * 误差为 0（真正的中间值）时与 printf 一样就近取偶，因此结果与 printf("%.4f") 逐字节相同。
+ */
+inline char *appendFixed4(char *p, double value)
+{
+  if (!(std::fabs(value) < 1e11))
+  {
+    return p + std::snprintf(p, MAX_VALUE_CHARS, "%.4f", value); // 极大值、inf、nan
+  }
+  if (std::signbit(value))
+  {
+    *p++ = '-';
+    value = -value;
+  }
+  const double product = value * 10000.0;
+  const double whole = std::floor(product);
+  const double remainder = product - whole;
+  long long scaled = static_cast<long long>(whole);
+  if (remainder > 0.5)
+  {
+    ++scaled;
+  }
+  else if (remainder == 0.5)
+  {
+    const double error = std::fma(value, 10000.0, -product);
+    if (error > 0.0 || (error == 0.0 && (scaled & 1)))
+    {
+      ++scaled;
+    }
+  }
+  p = std::to_chars(p, p + 20, scaled / 10000).ptr;
+  const int frac = static_cast<int>(scaled % 10000);
+  p[0] = '.';
+  p[1] = static_cast<char>('0' + frac / 1000);
+  p[2] = static_cast<char>('0' + frac / 100 % 10);
+  p[3] = static_cast<char>('0' + frac / 10 % 10);
+  p[4] = static_cast<char>('0' + frac % 10);
+  return p + 5;
+}
+} // namespace
+
+size_t MotorTextFormatter::maxFrameBytes(int count)
+{
+  return 64 + static_cast<size_t>(count > 0 ? count : 0) * MAX_MOTOR_BYTES + 1;
+}
+
+char *MotorTextFormatter::reserve(size_t bytes)
+{
+  if (buffer_.size() - size_ < bytes)
+  {
+    buffer_.resize(std::max(buffer_.size() * 2, size_ + bytes));
+  }
+  return buffer_.data() + size_;
+}
+
+void MotorTextFormatter::appendFrame(const InteractiveMotorData motors[], int count, double stamp)
+{
+  // 帧标识：秒级部分按秒缓存，微秒部分每帧写入
+  long long sec = static_cast<long long>(std::floor(stamp));
+  long long usec = std::llround((stamp - static_cast<double>(sec)) * 1e6);
+  if (usec >= 1000000)
+  {
+    ++sec;
+    usec -= 1000000;
+  }
+  if (sec != cached_sec_)
+  {
+    cached_sec_ = sec;
+    std::time_t time_sec = static_cast<std::time_t>(sec);
+    std::tm tm_local;
+    localtime_r(&time_sec, &tm_local);
+    std::memcpy(second_prefix_, FRAME_PREFIX, sizeof(FRAME_PREFIX) - 1);
+    second_prefix_len_ = sizeof(FRAME_PREFIX) - 1;
+    second_prefix_len_ += std::strftime(second_prefix_ + second_prefix_len_, sizeof(second_prefix_) - second_prefix_len_,
+                                        "%Y-%m-%d-%H-%M-%S", &tm_local);
+  }
+
+  char *p = reserve(second_prefix_len_ + 8 + sizeof(FRAME_SUFFIX));
+  p = appendLiteral(p, second_prefix_, second_prefix_len_);
+  *p++ = '.';
+  for (int i = 5; i >= 0; --i)
+  {
+    p[i] = static_cast<char>('0' + usec % 10);
+    usec /= 10;
+  }
+  p += 6;
+  p = appendLiteral(p, FRAME_SUFFIX, sizeof(FRAME_SUFFIX) - 1);
+  size_ = static_cast<size_t>(p - buffer_.data());
+
+  appendMotors(motors, count);
+}
+
+void MotorTextFormatter::appendFrame(const InteractiveMotorData motors[], int count, const std::string &frame_id)
+{
+  char *p = reserve(sizeof(FRAME_PREFIX) + frame_id.size() + sizeof(FRAME_SUFFIX));
+  p = appendLiteral(p, FRAME_PREFIX, sizeof(FRAME_PREFIX) - 1);
+  p = appendLiteral(p, frame_id.data(), frame_id.size());
+  p = appendLiteral(p, FRAME_SUFFIX, sizeof(FRAME_SUFFIX) - 1);
+  size_ = static_cast<size_t>(p - buffer_.data());
+
+  appendMotors(motors, count);
+}
+
+void MotorTextFormatter::appendMotors(const InteractiveMotorData motors[], int count)
+{
+  char *p = reserve(static_cast<size_t>(count > 0 ? count : 0) * MAX_MOTOR_BYTES + 1);
+  for (int i = 0; i < count; ++i)
+  {
+    p = appendLiteral(p, MOTOR_PREFIX, sizeof(MOTOR_PREFIX) - 1);
+    p = std::to_chars(p, p + 11, i).ptr;
+    p = appendLiteral(p, MOTOR_SUFFIX, sizeof(MOTOR_SUFFIX) - 1);
+    // 标签、单位和输出顺序由 MOTOR_FIELDS 描述表生成
+    for (size_t f = 0; f < MOTOR_FIELD_COUNT; ++f)
+    {
+      p = appendLiteral(p, MOTOR_FIELDS[f].log_label, FIELD_FRAGMENTS.label_len[f]);
+      p = appendFixed4(p, motorFieldValue(motors[i], f));
+      p = appendLiteral(p, MOTOR_FIELDS[f].log_suffix, FIELD_FRAGMENTS.suffix_len[f]);
+    }
+    p = appendLiteral(p, MOTOR_SEPARATOR, sizeof(MOTOR_SEPARATOR) - 1);
+  }
+  *p++ = '\n';
+  size_ = static_cast<size_t>(p - buffer_.data());
+}
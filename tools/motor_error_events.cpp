@@ -0,0 +1,190 @@
+/**
+ * @file motor_error_events.cpp
+ * @brief 错误码跳变事件查询工具
+ * @author mafangniu
+ * @date 2025-05-11
+ *
+ * @details
+ * 读取日志分段旁的事件文件（*.events，见 errorEvents.h），按电机、错误码、时间范围列出跳变，
+ * 不需要扫描日志本身。例如查找 Motor7 第一次报 DRV驱动错误(7)：
+ *
+ *   motor_error_events full_log_2025-05-11-10-00-00.bin --motor 7 --code 7 --first
+ *
+ * 用法：
+ *   motor_error_events <日志文件或 .events 文件> [--motor <n>] [--code <错误码>] [--from <Unix秒>] [--to <Unix秒>] [--first]
+ *   motor_error_events --rebuild <日志.bin>
+ *
+ * --motor 与曲线名 Motor<n> 一致（从 1 开始）。--rebuild 扫描一遍二进制日志，重新生成它的 .events 文件
+ * （用于本功能之前记录的日志）。
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "binaryLog.h"
+#include "errorEvents.h"
+
+static void printUsage(const char *prog)
+{
+  std::cerr << "用法: " << prog
+            << " <日志文件或 .events 文件> [--motor <n>] [--code <错误码>] [--from <Unix秒>] [--to <Unix秒>] [--first]\n"
+            << "      " << prog << " --rebuild <日志.bin>" << std::endl;
+}
+
+static bool endsWith(const std::string &text, const std::string &suffix)
+{
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief 本地时间，精确到微秒（与文本日志的帧标识相同）
+ */
+static std::string formatStamp(double stamp)
+{
+  std::time_t sec = static_cast<std::time_t>(stamp);
+  long usec = static_cast<long>((stamp - static_cast<double>(sec)) * 1e6 + 0.5);
+  if (usec >= 1000000)
+  {
+    ++sec;
+    usec -= 1000000;
+  }
+  std::tm tm_local;
+  localtime_r(&sec, &tm_local);
+  char text[48];
+  const size_t n = std::strftime(text, sizeof(text), "%Y-%m-%d-%H-%M-%S", &tm_local);
+  std::snprintf(text + n, sizeof(text) - n, ".%06ld", usec);
+  return text;
+}
+
+/**
+ * @brief 扫描二进制日志，重新生成事件文件
+ */
+static int rebuild(const std::string &log_filename)
+{
+  BinaryLogReader reader;
+  if (!reader.open(log_filename))
+  {
+    std::cerr << "无法打开或解析二进制日志: " << log_filename << std::endl;
+    return 1;
+  }
+  const std::string events_filename = errorEventFilename(log_filename);
+  std::remove(events_filename.c_str()); // 不续写旧内容
+  ErrorEventFile events;
+  if (!events.open(events_filename))
+  {
+    std::cerr << "无法打开文件: " << events_filename << std::endl;
+    return 1;
+  }
+
+  RawMotorFrame frame{};
+  frame.motor_count = static_cast<uint16_t>(std::min<uint32_t>(reader.header().motor_count, MAX_MOTOR_COUNT));
+  std::vector<InteractiveMotorData> motors(reader.header().motor_count);
+  ErrorTransitionTracker tracker;
+  ErrorTransition transitions[MAX_MOTOR_COUNT];
+  uint64_t count = 0;
+  for (uint64_t r = 0; r < reader.recordCount(); ++r)
+  {
+    if (!reader.readRecord(r, frame.stamp, motors.data()))
+    {
+      break;
+    }
+    std::copy_n(motors.begin(), frame.motor_count, frame.motors);
+    const int n = tracker.observe(frame, transitions);
+    events.append(transitions, n);
+    count += static_cast<uint64_t>(n);
+  }
+  events.close();
+  std::cerr << "✅ " << events_filename << ": " << reader.recordCount() << " 帧，" << count << " 个跳变事件" << std::endl;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  std::string input;
+  ErrorEventFilter filter;
+  bool first_only = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--rebuild") == 0 && i + 1 < argc)
+    {
+      return rebuild(argv[i + 1]);
+    }
+    else if (std::strcmp(argv[i], "--motor") == 0 && i + 1 < argc)
+    {
+      filter.motor = std::atoi(argv[++i]) - 1;
+      if (filter.motor < 0)
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+    else if (std::strcmp(argv[i], "--code") == 0 && i + 1 < argc)
+    {
+      filter.code = std::atoi(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+    {
+      filter.begin_stamp = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc)
+    {
+      filter.end_stamp = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--first") == 0)
+    {
+      first_only = true;
+    }
+    else if (input.empty())
+    {
+      input = argv[i];
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (input.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  // 既可以给出日志文件（查找旁边的 .events），也可以直接给出 .events 文件
+  const std::string filename = endsWith(input, ".events") ? input : errorEventFilename(input);
+  std::vector<ErrorTransition> events;
+  std::string error;
+  if (!readErrorEvents(filename, events, &error))
+  {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
+  const std::vector<size_t> found = findErrorEvents(events, filter, first_only ? 1 : 0);
+  std::printf("%-26s  %-7s  %8s -> %-8s  %s\n", "time", "motor", "old", "new", "old_lasted_s");
+  for (size_t i : found)
+  {
+    const ErrorTransition &e = events[i];
+    char old_code[16];
+    if (e.old_code == ERROR_CODE_UNKNOWN)
+    {
+      std::snprintf(old_code, sizeof(old_code), "?");
+    }
+    else
+    {
+      std::snprintf(old_code, sizeof(old_code), "%d", e.old_code);
+    }
+    std::printf("%-26s  Motor%-2d  %8s -> %-8d  %.6f\n", formatStamp(e.stamp).c_str(), e.motor + 1, old_code, e.new_code,
+                e.duration);
+  }
+  std::cerr << "✅ " << found.size() << " / " << events.size() << " 个事件" << std::endl;
+  return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file motor_log_convert.cpp
+ * @brief 二进制电机日志 -> 文本日志的离线转换工具
+ * @author mafangniu
+ * @date 2025-04-14
+ *
+ * @details
+ * 将插件以二进制格式记录的日志（*.bin + *.idx）转换为与插件文本日志相同的格式（帧标识带微秒），
+ * 可选只转换某个时间范围（利用索引直接定位，不需要扫描全文件）。
+ *
+ * 用法：
+ *   motor_log_convert <输入.bin> [输出.txt] [--from <Unix秒>] [--to <Unix秒>]
+ *   未指定输出文件时写到标准输出。
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "binaryLog.h"
+#include "textLogFormat.h"
+
+static void printUsage(const char *prog)
+{
+  std::cerr << "用法: " << prog << " <输入.bin> [输出.txt] [--from <Unix秒>] [--to <Unix秒>]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string output;
+  double from = -std::numeric_limits<double>::infinity();
+  double to = std::numeric_limits<double>::infinity();
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+    {
+      from = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc)
+    {
+      to = std::atof(argv[++i]);
+    }
+    else if (input.empty())
+    {
+      input = argv[i];
+    }
+    else if (output.empty())
+    {
+      output = argv[i];
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (input.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  BinaryLogReader reader;
+  if (!reader.open(input))
+  {
+    std::cerr << "无法打开或解析二进制日志: " << input << std::endl;
+    return 1;
+  }
+
+  std::ofstream ofs;
+  if (!output.empty())
+  {
+    ofs.open(output);
+    if (!ofs.is_open())
+    {
+      std::cerr << "无法打开文件: " << output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = output.empty() ? std::cout : ofs;
+
+  const uint32_t motor_count = reader.header().motor_count;
+  std::vector<InteractiveMotorData> motors(motor_count);
+
+  uint64_t converted = 0;
+  MotorTextFormatter formatter; // 累积约 1 MiB 后整块写出
+  for (uint64_t r = reader.findRecord(from); r < reader.recordCount(); ++r)
+  {
+    double stamp = 0.0;
+    if (!reader.readRecord(r, stamp, motors.data()))
+    {
+      break;
+    }
+    if (stamp > to)
+    {
+      break;
+    }
+    formatter.appendFrame(motors.data(), static_cast<int>(motor_count), stamp);
+    if (formatter.size() >= (1 << 20))
+    {
+      out.write(formatter.data(), static_cast<std::streamsize>(formatter.size()));
+      formatter.clear();
+    }
+    ++converted;
+  }
+  out.write(formatter.data(), static_cast<std::streamsize>(formatter.size()));
+
+  std::cerr << "✅ 已转换 " << converted << " / " << reader.recordCount() << " 帧" << std::endl;
+  return 0;
+}
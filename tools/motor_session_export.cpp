@@ -0,0 +1,139 @@
+/**
+ * @file motor_session_export.cpp
+ * @brief 二进制电机日志 -> 列式会话文件（Arrow IPC）的离线转换工具，以及异常退出后会话文件的修复
+ * @author mafangniu
+ * @date 2025-05-18
+ *
+ * @details
+ * 插件以列式会话格式记录时直接生成 .arrow 文件；此前以二进制格式记录的日志（*.bin + *.idx）可由本工具转换，
+ * 之后同样用 pandas.read_feather() 读取（可选只转换某个时间范围，利用索引直接定位）。
+ * 插件异常退出时会话文件缺少 Footer（已写入的帧都在文件中），--repair 按文件中的块补写 Footer。
+ *
+ * 用法：
+ *   motor_session_export <输入.bin> <输出.arrow> [--from <Unix秒>] [--to <Unix秒>]
+ *   motor_session_export --repair <会话.arrow>
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "binaryLog.h"
+#include "sessionStore.h"
+
+static void printUsage(const char *prog)
+{
+  std::cerr << "用法: " << prog << " <输入.bin> <输出.arrow> [--from <Unix秒>] [--to <Unix秒>]" << std::endl
+            << "      " << prog << " --repair <会话.arrow>" << std::endl;
+}
+
+static int repairSession(const std::string &filename)
+{
+  SessionStoreFile session;
+  std::string error;
+  if (!session.reopen(filename, &error))
+  {
+    std::cerr << "无法修复会话文件 " << filename << ": " << error << std::endl;
+    return 1;
+  }
+  const uint64_t rows = session.rowCount();
+  const int motors = session.motorCount();
+  session.close(); // 按已有的块重新写入 Footer
+  std::cerr << "✅ 已修复 " << filename << "：" << rows << " 帧，" << motors << " 个电机" << std::endl;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string output;
+  std::string repair;
+  double from = -std::numeric_limits<double>::infinity();
+  double to = std::numeric_limits<double>::infinity();
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+    {
+      from = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc)
+    {
+      to = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--repair") == 0 && i + 1 < argc)
+    {
+      repair = argv[++i];
+    }
+    else if (input.empty())
+    {
+      input = argv[i];
+    }
+    else if (output.empty())
+    {
+      output = argv[i];
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!repair.empty())
+  {
+    return repairSession(repair);
+  }
+  if (input.empty() || output.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  BinaryLogReader reader;
+  if (!reader.open(input))
+  {
+    std::cerr << "无法打开或解析二进制日志: " << input << std::endl;
+    return 1;
+  }
+  const int motor_count = static_cast<int>(reader.header().motor_count);
+  if (motor_count < 1 || motor_count > MAX_MOTOR_COUNT)
+  {
+    std::cerr << "二进制日志的电机数无效: " << motor_count << std::endl;
+    return 1;
+  }
+
+  // 输出文件总是重新创建（open() 遇到同电机数的已有会话文件会续写）
+  std::remove(output.c_str());
+  SessionStoreFile session;
+  if (!session.open(output, motor_count))
+  {
+    std::cerr << "无法创建会话文件: " << output << std::endl;
+    return 1;
+  }
+
+  auto frame = std::make_unique<RawMotorFrame>();
+  frame->motor_count = motor_count;
+  uint64_t converted = 0;
+  for (uint64_t r = reader.findRecord(from); r < reader.recordCount(); ++r)
+  {
+    if (!reader.readRecord(r, frame->stamp, frame->motors))
+    {
+      break;
+    }
+    if (frame->stamp > to)
+    {
+      break;
+    }
+    session.append(*frame);
+    ++converted;
+  }
+  session.close();
+
+  std::cerr << "✅ 已转换 " << converted << " / " << reader.recordCount() << " 帧 -> " << output << std::endl;
+  return 0;
+}
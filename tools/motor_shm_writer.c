@@ -0,0 +1,177 @@
+/**
+ * @file motor_shm_writer.c
+ * @brief 共享内存发送端库实现
+ * @author mafangniu
+ * @date 2025-05-06
+ */
+
+#define _GNU_SOURCE
+
+#include "motor_shm_writer.h"
+#include "motorShmLayout.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+struct MotorShmWriter
+{
+  char name[256];
+  MotorShmHeader *header;
+  MotorShmSlot *slots;
+  size_t mapped_bytes;
+  uint64_t slot_mask;
+  uint64_t write_seq; /* 下一帧的序号（与 header->write_seq 相同，只有本写端修改） */
+};
+
+static __thread char g_last_error[256];
+
+static void setError(const char *what, const char *name)
+{
+  snprintf(g_last_error, sizeof(g_last_error), "%s %s: %s", what, name, strerror(errno));
+}
+
+const char *motor_shm_writer_last_error(void)
+{
+  return g_last_error;
+}
+
+MotorShmWriter *motor_shm_writer_open(const char *name, uint32_t slot_count)
+{
+  if (slot_count == 0)
+  {
+    slot_count = MOTOR_SHM_DEFAULT_SLOTS;
+  }
+  if ((slot_count & (slot_count - 1)) != 0 || strlen(name) >= sizeof(((MotorShmWriter *)0)->name))
+  {
+    errno = EINVAL;
+    setError("无效的槽位数或名称", name);
+    return NULL;
+  }
+
+  const size_t size = sizeof(MotorShmHeader) + (size_t)slot_count * sizeof(MotorShmSlot);
+  const int fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0)
+  {
+    setError("无法创建共享内存", name);
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+  {
+    setError("无法读取共享内存大小", name);
+    close(fd);
+    return NULL;
+  }
+  const int fresh = st.st_size == 0;
+  if (fresh && ftruncate(fd, (off_t)size) < 0)
+  {
+    setError("无法设置共享内存大小", name);
+    close(fd);
+    return NULL;
+  }
+  if (!fresh && (size_t)st.st_size != size)
+  {
+    errno = EEXIST;
+    setError("已存在大小不同的共享内存（请先删除 /dev/shm 下的同名文件）", name);
+    close(fd);
+    return NULL;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    setError("无法映射共享内存", name);
+    return NULL;
+  }
+
+  MotorShmHeader *header = (MotorShmHeader *)base;
+  const int reusable = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == MOTOR_SHM_MAGIC &&
+                       header->version == MOTOR_SHM_VERSION && header->slot_count == slot_count &&
+                       header->slot_bytes == MOTOR_SHM_SLOT_BYTES;
+  if (!reusable)
+  {
+    /* 新建（或上次初始化未完成）：先清零再写布局，最后写 magic */
+    memset(base, 0, size);
+    header->version = MOTOR_SHM_VERSION;
+    header->slot_count = slot_count;
+    header->slot_bytes = MOTOR_SHM_SLOT_BYTES;
+    __atomic_store_n(&header->magic, MOTOR_SHM_MAGIC, __ATOMIC_RELEASE);
+  }
+
+  MotorShmWriter *writer = (MotorShmWriter *)calloc(1, sizeof(MotorShmWriter));
+  if (!writer)
+  {
+    munmap(base, size);
+    setError("内存不足", name);
+    return NULL;
+  }
+  strcpy(writer->name, name);
+  writer->header = header;
+  writer->slots = (MotorShmSlot *)((char *)base + sizeof(MotorShmHeader));
+  writer->mapped_bytes = size;
+  writer->slot_mask = slot_count - 1;
+  /* 复用时从已有序号继续，已连接的读端不会看到序号倒退 */
+  writer->write_seq = __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE);
+  return writer;
+}
+
+int motor_shm_writer_write(MotorShmWriter *writer, const void *packet, uint32_t len)
+{
+  if (len > MOTOR_SHM_SLOT_BYTES)
+  {
+    return -1;
+  }
+
+  const uint64_t k = writer->write_seq;
+  MotorShmSlot *slot = &writer->slots[k & writer->slot_mask];
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  /* seqlock 写：奇数表示写入中，数据写完后置为偶数 */
+  __atomic_store_n(&slot->seq, 2 * k + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(slot->data, packet, len);
+  slot->len = len;
+  slot->publish_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+  __atomic_store_n(&slot->seq, 2 * k + 2, __ATOMIC_RELEASE);
+
+  writer->write_seq = k + 1;
+  __atomic_store_n(&writer->header->write_seq, k + 1, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&writer->header->futex_word, 1u, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&writer->header->reader_waiting, __ATOMIC_SEQ_CST))
+  {
+    /* 只有读端在等待时才进入内核 */
+    syscall(SYS_futex, &writer->header->futex_word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  }
+  return 0;
+}
+
+uint64_t motor_shm_writer_sequence(const MotorShmWriter *writer)
+{
+  return writer->write_seq;
+}
+
+void motor_shm_writer_close(MotorShmWriter *writer, int unlink_shm)
+{
+  if (!writer)
+  {
+    return;
+  }
+  munmap(writer->header, writer->mapped_bytes);
+  if (unlink_shm)
+  {
+    shm_unlink(writer->name);
+  }
+  free(writer);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file motor_shm_writer.h
+ * @brief 共享内存发送端库（C 接口，同机发送时替代 UDP sendto）
+ * @author mafangniu
+ * @date 2025-05-06
+ *
+ * @details
+ * 布局见 motorShmLayout.h。发送端把与 UDP 完全相同的数据报（旧版 / 带包头 / 紧凑格式）写入共享内存环形缓冲，
+ * 插件的数据源列表中填写 shm:<名称>（例如 Sim=shm:/motor_monitor）即可接收，例如：
+ *
+ *     MotorShmWriter *w = motor_shm_writer_open("/motor_monitor", 0);
+ *     motor_shm_writer_write(w, packet, packet_len);   // 每帧调用，不阻塞，不经过内核
+ *     motor_shm_writer_close(w, 0);
+ *
+ * 写端从不等待读端（插件未运行或跟不上时旧帧被覆盖）。同一块共享内存只能有一个写端。
+ * Python 发送端见 motor_shm_writer.py。
+ */
+
+#ifndef MOTOR_SHM_WRITER_H
+#define MOTOR_SHM_WRITER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct MotorShmWriter MotorShmWriter;
+
+/**
+ * @brief 创建（或复用已有的）共享内存环形缓冲
+ * @param name       共享内存名称（如 "/motor_monitor"，对应 /dev/shm/motor_monitor）
+ * @param slot_count 槽位数（2 的幂），0 表示 MOTOR_SHM_DEFAULT_SLOTS；复用已有共享内存时必须与其一致
+ * @return 写端句柄，失败返回 NULL（原因见 motor_shm_writer_last_error()）
+ */
+MotorShmWriter *motor_shm_writer_open(const char *name, uint32_t slot_count);
+
+/**
+ * @brief 发布一个数据报
+ * @param writer 写端句柄
+ * @param packet 数据报内容（与 UDP 数据报格式相同）
+ * @param len    数据报字节数（不超过 MOTOR_SHM_SLOT_BYTES）
+ * @return 成功返回 0，数据报过长返回 -1
+ */
+int motor_shm_writer_write(MotorShmWriter *writer, const void *packet, uint32_t len);
+
+/**
+ * @brief 已发布的帧数
+ */
+uint64_t motor_shm_writer_sequence(const MotorShmWriter *writer);
+
+/**
+ * @brief 关闭写端
+ * @param writer 写端句柄
+ * @param unlink_shm 非 0 时同时删除共享内存（插件会在下次重试时等待新的写端）
+ */
+void motor_shm_writer_close(MotorShmWriter *writer, int unlink_shm);
+
+/**
+ * @brief 最近一次 motor_shm_writer_open() 失败的原因（线程内有效）
+ */
+const char *motor_shm_writer_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_SHM_WRITER_H */
@@ -0,0 +1,80 @@
+"""
+@file motor_shm_writer.py
+@brief 共享内存发送端（Python，基于 ctypes 调用 libmotor_shm_writer.so）
+@author mafangniu
+@date 2025-05-06
+
+同机发送时替代 sock.sendto()：数据报格式与 UDP 完全相同，插件数据源列表中填写 shm:/motor_monitor。
+
+    from motor_shm_writer import MotorShmWriter
+    writer = MotorShmWriter("/motor_monitor")
+    header = struct.pack('<IHHII', 0x4D4D4A50, 1, motor_count, seq, 0)
+    writer.write(header + motors_bytes)
+
+库的查找顺序：环境变量 MOTOR_SHM_WRITER_LIB，本文件所在目录，系统库路径。
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+
+def _load_library():
+    candidates = []
+    if os.environ.get("MOTOR_SHM_WRITER_LIB"):
+        candidates.append(os.environ["MOTOR_SHM_WRITER_LIB"])
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates.append(os.path.join(here, "libmotor_shm_writer.so"))
+    found = ctypes.util.find_library("motor_shm_writer")
+    if found:
+        candidates.append(found)
+    for path in candidates:
+        try:
+            return ctypes.CDLL(path)
+        except OSError:
+            continue
+    raise OSError("找不到 libmotor_shm_writer.so，请设置 MOTOR_SHM_WRITER_LIB")
+
+
+_lib = _load_library()
+_lib.motor_shm_writer_open.argtypes = [ctypes.c_char_p, ctypes.c_uint32]
+_lib.motor_shm_writer_open.restype = ctypes.c_void_p
+_lib.motor_shm_writer_write.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint32]
+_lib.motor_shm_writer_write.restype = ctypes.c_int
+_lib.motor_shm_writer_sequence.argtypes = [ctypes.c_void_p]
+_lib.motor_shm_writer_sequence.restype = ctypes.c_uint64
+_lib.motor_shm_writer_close.argtypes = [ctypes.c_void_p, ctypes.c_int]
+_lib.motor_shm_writer_close.restype = None
+_lib.motor_shm_writer_last_error.argtypes = []
+_lib.motor_shm_writer_last_error.restype = ctypes.c_char_p
+
+
+class MotorShmWriter:
+    """共享内存写端，write() 每次发布一个数据报（bytes）。"""
+
+    def __init__(self, name="/motor_monitor", slot_count=0):
+        self._handle = _lib.motor_shm_writer_open(name.encode(), slot_count)
+        if not self._handle:
+            raise OSError(_lib.motor_shm_writer_last_error().decode(errors="replace"))
+
+    def write(self, packet):
+        if _lib.motor_shm_writer_write(self._handle, packet, len(packet)) != 0:
+            raise ValueError("数据报过长")
+
+    @property
+    def sequence(self):
+        return _lib.motor_shm_writer_sequence(self._handle)
+
+    def close(self, unlink=False):
+        if self._handle:
+            _lib.motor_shm_writer_close(self._handle, 1 if unlink else 0)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,336 @@
+/**
+ * @file udpRelay.cpp
+ * @brief UDP 转发配置解析与 sendmmsg 批量转发实现
+ * @author mafangniu
+ * @date 2025-05-16
+ */
+
+#include "udpRelay.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "specTokens.h"
+
+namespace
+{
+const int RELAY_SNDBUF_BYTES = 4 * 1024 * 1024; // 发送缓冲，吸收接收批次带来的突发
+
+bool parseLong(const std::string &text, long min, long max, long &value)
+{
+  char *end = nullptr;
+  value = std::strtol(text.c_str(), &end, 10);
+  return !text.empty() && *end == '\0' && value >= min && value <= max;
+}
+
+std::string formatNumber(double value)
+{
+  char text[32];
+  std::snprintf(text, sizeof(text), "%g", value);
+  return text;
+}
+} // namespace
+
+bool parseUdpRelayConfig(const std::string &spec, UdpRelayConfig &config, std::string *error)
+{
+  UdpRelayConfig parsed;
+  for (const std::string &entry : specTokens(spec))
+  {
+    long value = 0;
+    const size_t eq = entry.find('=');
+    if (eq != std::string::npos)
+    {
+      const std::string key = entry.substr(0, eq);
+      const std::string text = entry.substr(eq + 1);
+      if (key == "format" && (strcasecmp(text.c_str(), "raw") == 0 || strcasecmp(text.c_str(), "compact") == 0))
+      {
+        parsed.format = strcasecmp(text.c_str(), "raw") == 0 ? RelayFormat::Raw : RelayFormat::Compact;
+      }
+      else if (key == "rate")
+      {
+        char *number_end = nullptr;
+        parsed.rate_hz = std::strtod(text.c_str(), &number_end);
+        if (text.empty() || *number_end != '\0' || !(parsed.rate_hz >= 0.0))
+        {
+          setError(error, "无效的转发帧率: " + entry);
+          return false;
+        }
+      }
+      else if (key == "keyframe" && parseLong(text, 1, 100000, value))
+      {
+        parsed.keyframe_interval = static_cast<int>(value);
+      }
+      else if (key == "ttl" && parseLong(text, 1, 255, value))
+      {
+        parsed.multicast_ttl = static_cast<int>(value);
+      }
+      else
+      {
+        setError(error, "无效的转发配置项: " + entry);
+        return false;
+      }
+      continue;
+    }
+
+    // <IPv4 地址>:<端口>
+    const size_t colon = entry.rfind(':');
+    in_addr address{};
+    if (colon == std::string::npos || inet_pton(AF_INET, entry.substr(0, colon).c_str(), &address) != 1 ||
+        !parseLong(entry.substr(colon + 1), 1, 65535, value))
+    {
+      setError(error, "无效的订阅者地址（格式为 IPv4地址:端口）: " + entry);
+      return false;
+    }
+    UdpRelayTarget target;
+    target.address = entry.substr(0, colon);
+    target.port = static_cast<uint16_t>(value);
+    parsed.targets.push_back(target);
+  }
+  config = parsed;
+  return true;
+}
+
+std::string formatUdpRelayConfig(const UdpRelayConfig &config)
+{
+  std::string spec;
+  for (const UdpRelayTarget &target : config.targets)
+  {
+    spec += (spec.empty() ? "" : ",") + target.address + ":" + std::to_string(target.port);
+  }
+  if (spec.empty())
+  {
+    return spec;
+  }
+  if (config.format == RelayFormat::Compact)
+  {
+    spec += ",format=compact,keyframe=" + std::to_string(config.keyframe_interval);
+  }
+  if (config.rate_hz > 0.0)
+  {
+    spec += ",rate=" + formatNumber(config.rate_hz);
+  }
+  if (config.multicast_ttl != 1)
+  {
+    spec += ",ttl=" + std::to_string(config.multicast_ttl);
+  }
+  return spec;
+}
+
+// ============================ UdpRelay ============================
+
+UdpRelay::~UdpRelay()
+{
+  close();
+}
+
+bool UdpRelay::open(const UdpRelayConfig &config, const std::vector<uint16_t> &listen_ports, size_t max_batch, std::string *error)
+{
+  close();
+  if (!config.enabled())
+  {
+    setError(error, "没有订阅者");
+    return false;
+  }
+
+  // 目的地址：第 s 个数据源转发到 端口+s；转发回本机正在监听的端口会形成环路，拒绝
+  const size_t source_count = std::max<size_t>(1, listen_ports.size());
+  std::vector<sockaddr_in> addresses(source_count * config.targets.size());
+  bool multicast = false;
+  for (size_t s = 0; s < source_count; ++s)
+  {
+    for (size_t t = 0; t < config.targets.size(); ++t)
+    {
+      const UdpRelayTarget &target = config.targets[t];
+      const unsigned port = target.port + static_cast<unsigned>(s);
+      if (port > 65535)
+      {
+        setError(error, "转发端口超出范围: " + target.address + ":" + std::to_string(port));
+        return false;
+      }
+      sockaddr_in &addr = addresses[s * config.targets.size() + t];
+      addr = sockaddr_in{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(static_cast<uint16_t>(port));
+      inet_pton(AF_INET, target.address.c_str(), &addr.sin_addr);
+      const uint32_t host = ntohl(addr.sin_addr.s_addr);
+      multicast = multicast || IN_MULTICAST(host);
+      const bool local = (host >> 24) == 127 || host == INADDR_ANY;
+      if (local && std::find(listen_ports.begin(), listen_ports.end(), port) != listen_ports.end())
+      {
+        setError(error, "转发目标是本机正在监听的端口（会形成环路）: " + target.address + ":" + std::to_string(port));
+        return false;
+      }
+    }
+  }
+
+  const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+  {
+    setError(error, "无法创建转发 socket, errno = " + std::to_string(errno));
+    return false;
+  }
+  int sndbuf = RELAY_SNDBUF_BYTES;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)); // 失败时使用系统默认
+  if (multicast)
+  {
+    const unsigned char ttl = static_cast<unsigned char>(config.multicast_ttl);
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+  }
+
+  fd_ = fd;
+  config_ = config;
+  source_count_ = source_count;
+  addresses_ = std::move(addresses);
+  sources_.clear();
+  sources_.resize(source_count);
+  max_batch_ = std::max<size_t>(1, max_batch);
+  scratch_ = std::make_unique<RawMotorFrame>();
+  encoded_.assign(max_batch_ * MAX_MOTOR_PACKET_BYTES, 0);
+  iovecs_.assign(max_batch_, iovec{});
+  msgs_.assign(max_batch_ * config.targets.size(), mmsghdr{});
+  return true;
+}
+
+void UdpRelay::close()
+{
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+void UdpRelay::relay(size_t source, const RawMotorFrame *frames, const struct iovec *datagrams, int count)
+{
+  if (fd_ < 0 || source >= source_count_ || count <= 0)
+  {
+    return;
+  }
+  count = std::min<int>(count, static_cast<int>(max_batch_));
+  SourceState &state = sources_[source];
+  const bool zero_copy = datagrams && config_.format == RelayFormat::Raw && config_.rate_hz <= 0.0;
+  const double period = config_.rate_hz > 0.0 ? 1.0 / config_.rate_hz : 0.0;
+
+  // ---------------- 选帧并准备数据报 ----------------
+  int selected = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    const RawMotorFrame &frame = frames[i];
+    if (period > 0.0)
+    {
+      if (frame.stamp < state.next_stamp && state.next_stamp - frame.stamp <= period)
+      {
+        continue; // 按帧时间抽取（时间戳回退超过一个周期时重新开始）
+      }
+      // 按固定节拍前进，数据中断或时间戳回退后从该帧重新开始
+      const double late = frame.stamp - state.next_stamp;
+      state.next_stamp = (late >= 0.0 && late < period) ? state.next_stamp + period : frame.stamp + period;
+    }
+
+    struct iovec &iov = iovecs_[selected];
+    if (zero_copy)
+    {
+      iov = datagrams[i]; // 直接引用接收缓冲
+    }
+    else
+    {
+      // 重新编码：转发端重新编号，尾部附带选定的帧时间戳
+      RawMotorFrame &copy = *scratch_;
+      copy.stamp = frame.stamp;
+      copy.motor_count = frame.motor_count;
+      copy.sequence = state.sequence++;
+      copy.flags = FRAME_FLAG_SEQUENCE | FRAME_FLAG_SENDER_STAMP;
+      std::copy_n(frame.motors, std::min<int>(frame.motor_count, MAX_MOTOR_COUNT), copy.motors);
+
+      char *out = &encoded_[selected * MAX_MOTOR_PACKET_BYTES];
+      size_t bytes = 0;
+      if (config_.format == RelayFormat::Compact)
+      {
+        const bool force_keyframe = state.since_keyframe == 0;
+        state.since_keyframe = (state.since_keyframe + 1) % config_.keyframe_interval;
+        bytes = encodeCompactMotorPacket(copy, out, MAX_MOTOR_PACKET_BYTES, *state.keyframe, force_keyframe);
+      }
+      else
+      {
+        bytes = encodeMotorPacket(copy, out, MAX_MOTOR_PACKET_BYTES);
+      }
+      if (bytes == 0)
+      {
+        continue;
+      }
+      iov.iov_base = out;
+      iov.iov_len = bytes;
+    }
+    ++selected;
+  }
+  if (selected == 0)
+  {
+    return;
+  }
+
+  // ---------------- 一次 sendmmsg 发出 帧 x 订阅者 ----------------
+  const size_t target_count = config_.targets.size();
+  const sockaddr_in *addresses = &addresses_[source * target_count];
+  int total = 0;
+  for (int f = 0; f < selected; ++f)
+  {
+    for (size_t t = 0; t < target_count; ++t)
+    {
+      msghdr &hdr = msgs_[total++].msg_hdr;
+      hdr = msghdr{};
+      hdr.msg_name = const_cast<sockaddr_in *>(&addresses[t]);
+      hdr.msg_namelen = sizeof(sockaddr_in);
+      hdr.msg_iov = &iovecs_[f];
+      hdr.msg_iovlen = 1;
+    }
+  }
+
+  int offset = 0;
+  while (offset < total)
+  {
+    const int sent = ::sendmmsg(fd_, &msgs_[offset], static_cast<unsigned>(total - offset), MSG_DONTWAIT);
+    if (sent > 0)
+    {
+      sent_.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+      offset += sent;
+      continue;
+    }
+    if (sent < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      // 单个订阅者出错（例如网络不可达）：跳过这一条，其余订阅者照常发送
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      ++offset;
+      continue;
+    }
+    // 发送缓冲满：丢弃剩余数据报，不阻塞接收线程
+    dropped_.fetch_add(static_cast<uint64_t>(total - offset), std::memory_order_relaxed);
+    break;
+  }
+}
+
+std::string UdpRelay::describe() const
+{
+  if (fd_ < 0)
+  {
+    return "未转发";
+  }
+  std::string text = "转发 " + std::to_string(config_.targets.size()) + " 个订阅者 ";
+  text += config_.format == RelayFormat::Compact ? "compact" : "raw";
+  text += config_.rate_hz > 0.0 ? " " + formatNumber(config_.rate_hz) + " Hz" : std::string();
+  if (config_.format == RelayFormat::Raw && config_.rate_hz <= 0.0)
+  {
+    text += " 零拷贝";
+  }
+  return text;
+}
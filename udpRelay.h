@@ -0,0 +1,147 @@
+/**
+ * @file udpRelay.h
+ * @brief UDP 转发（一台监测主机接收机器人的单路数据流，再转发给多台查看端）
+ * @author mafangniu
+ * @date 2025-05-16
+ *
+ * @details
+ * 同一端口只有一个进程能有效接收，多名工程师同时查看同一台机器人时，发送端只能逐个单播，加重机载计算机负担。
+ * 转发模式下接收线程把每个校验通过的帧再发给一组订阅者（单播地址或组播组），机器人只需发送一路数据。
+ * 转发配置用一个字符串描述，条目之间以逗号、分号或空白分隔：
+ *
+ *     <IPv4 地址>:<端口>     一个订阅者（单播地址或组播组，可写多个）
+ *     format=raw|compact    raw：原样转发（默认）；compact：转为紧凑格式（见 motorPacket.h），带宽约减半
+ *     rate=<Hz>             每个数据源最多转发的帧率（按帧时间抽取，0 表示全部转发）
+ *     keyframe=<n>          紧凑格式每 n 帧发送一个关键帧（默认 20，其余为差分帧）
+ *     ttl=<n>               组播 TTL（默认 1，只在本网段内）
+ *
+ * 例如 "192.168.1.20:4015,239.0.0.1:4015,format=compact,rate=200"。多数据源时第 s 个数据源（从 0 开始）
+ * 转发到 端口+s，查看端按同样的顺序监听相邻端口即可区分各数据源。
+ *
+ * raw 且不限帧率时直接用接收缓冲中的原始数据报作为 sendmmsg 的 iovec（零拷贝），包括差分帧、发送端序号和时间戳；
+ * 其他情况（compact、限帧率、共享内存数据源）由解码后的帧重新编码：序号由转发端重新编号（抽取不会被查看端计为丢包），
+ * 数据报尾部附带该帧在监测主机上选定的时间戳，查看端选择"发送端时间戳"即可使用。
+ * 每批帧 x 订阅者只调用一次 sendmmsg，socket 为非阻塞，发送缓冲满时丢弃剩余数据报并计数，不阻塞接收线程。
+ *
+ * @note 只在接收线程中使用（计数器可在其他线程读取）
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "motorPacket.h"
+
+// 转发的数据报格式
+enum class RelayFormat
+{
+  Raw,    // 原样转发（需要重新编码时为带包头的原始格式）
+  Compact // 紧凑格式（关键帧 + 差分帧）
+};
+
+// 单个订阅者
+struct UdpRelayTarget
+{
+  std::string address; // IPv4 地址（单播或组播）
+  uint16_t port = 0;   // 第一个数据源转发到的端口
+};
+
+// 转发配置
+struct UdpRelayConfig
+{
+  std::vector<UdpRelayTarget> targets; // 订阅者列表（为空表示不转发）
+  RelayFormat format = RelayFormat::Raw;
+  double rate_hz = 0.0;       // 每个数据源最多转发的帧率，0 表示全部转发
+  int keyframe_interval = 20; // 紧凑格式的关键帧间隔（帧）
+  int multicast_ttl = 1;      // 组播 TTL
+
+  bool enabled() const { return !targets.empty(); }
+};
+
+/**
+ * @brief 解析转发配置字符串
+ * @param spec 配置字符串，格式见文件说明；空字符串表示不转发
+ * @param config 输出的配置（解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true
+ */
+bool parseUdpRelayConfig(const std::string &spec, UdpRelayConfig &config, std::string *error = nullptr);
+
+/**
+ * @brief 将配置格式化为字符串（parseUdpRelayConfig() 的逆操作）
+ */
+std::string formatUdpRelayConfig(const UdpRelayConfig &config);
+
+/**
+ * @class UdpRelay
+ * @brief 转发 socket、各数据源的抽取 / 紧凑编码状态和预分配的 sendmmsg 缓冲
+ */
+class UdpRelay
+{
+public:
+  UdpRelay() = default;
+  ~UdpRelay();
+  UdpRelay(const UdpRelay &) = delete;
+  UdpRelay &operator=(const UdpRelay &) = delete;
+
+  /**
+   * @brief 创建转发 socket 并分配缓冲
+   * @param config 转发配置（须 enabled()）
+   * @param listen_ports 各数据源的监听端口（共享内存数据源为 0），用于拒绝转发回本机监听端口的环路
+   * @param max_batch 每次 relay() 最多的帧数
+   * @param error 失败时写入错误原因（可为 nullptr）
+   * @return 成功返回 true
+   */
+  bool open(const UdpRelayConfig &config, const std::vector<uint16_t> &listen_ports, size_t max_batch, std::string *error = nullptr);
+
+  void close();
+  bool isOpen() const { return fd_ >= 0; }
+
+  /**
+   * @brief 转发一个数据源的一批校验通过的帧
+   * @param source 数据源序号
+   * @param frames 解码后的帧（时间戳已选定）
+   * @param datagrams 与 frames 一一对应的原始数据报（可零拷贝转发）；共享内存数据源等没有原始数据报时为 nullptr
+   * @param count 帧数（不超过 open() 时的 max_batch）
+   */
+  void relay(size_t source, const RawMotorFrame *frames, const struct iovec *datagrams, int count);
+
+  uint64_t sentDatagrams() const { return sent_.load(std::memory_order_relaxed); }
+  uint64_t droppedDatagrams() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 实际生效的转发设置，例如 "转发 2 个订阅者 raw 零拷贝"（显示在界面上）
+   */
+  std::string describe() const;
+
+private:
+  struct SourceState
+  {
+    double next_stamp = 0.0;    ///< 限帧率时下一帧最早的帧时间
+    uint32_t sequence = 0;      ///< 重新编码时的序号
+    int since_keyframe = 0;     ///< 紧凑格式距上一个关键帧的帧数
+    std::unique_ptr<CompactKeyframe> keyframe = std::make_unique<CompactKeyframe>();
+  };
+
+  int fd_ = -1;
+  UdpRelayConfig config_;
+  size_t source_count_ = 0;
+  std::vector<sockaddr_in> addresses_;  ///< [数据源][订阅者] 目的地址（端口 + 数据源序号）
+  std::vector<SourceState> sources_;
+  std::unique_ptr<RawMotorFrame> scratch_; ///< 重新编码时改写序号、标志的帧副本
+  std::vector<char> encoded_;           ///< 重新编码的数据报（每帧 MAX_MOTOR_PACKET_BYTES）
+  std::vector<struct iovec> iovecs_;    ///< 本批每帧的数据报
+  std::vector<struct mmsghdr> msgs_;    ///< 本批 帧 x 订阅者 的消息
+  size_t max_batch_ = 0;
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,225 @@
+/**
+ * @file udpSources.cpp
+ * @brief UDP 数据源配置解析与 socket 创建实现
+ * @author mafangniu
+ * @date 2025-04-24
+ */
+
+#include "udpSources.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "specTokens.h"
+
+namespace
+{
+/**
+ * @brief 解析单个条目 "[名称=]端口[@组播地址]" 或 "[名称=]shm:<共享内存名称>"
+ */
+bool parseEntry(const std::string &entry, UdpSourceConfig &source, std::string *error)
+{
+  std::string rest = entry;
+  const size_t eq = rest.find('=');
+  if (eq != std::string::npos)
+  {
+    source.name = rest.substr(0, eq);
+    rest = rest.substr(eq + 1);
+    if (source.name.empty() || source.name.find('/') != std::string::npos)
+    {
+      setError(error, "数据源名称为空或包含 '/': " + entry);
+      return false;
+    }
+  }
+
+  static const std::string SHM_PREFIX = "shm:";
+  if (rest.compare(0, SHM_PREFIX.size(), SHM_PREFIX) == 0)
+  {
+    source.shm_name = rest.substr(SHM_PREFIX.size());
+    if (!source.shm_name.empty() && source.shm_name[0] != '/')
+    {
+      source.shm_name = "/" + source.shm_name;
+    }
+    if (source.shm_name.size() < 2 || source.shm_name.find('/', 1) != std::string::npos)
+    {
+      setError(error, "无效的共享内存名称: " + entry);
+      return false;
+    }
+    return true;
+  }
+
+  const size_t at = rest.find('@');
+  if (at != std::string::npos)
+  {
+    source.multicast_group = rest.substr(at + 1);
+    rest = rest.substr(0, at);
+    in_addr group{};
+    if (inet_pton(AF_INET, source.multicast_group.c_str(), &group) != 1 || !IN_MULTICAST(ntohl(group.s_addr)))
+    {
+      setError(error, "无效的组播地址: " + entry);
+      return false;
+    }
+  }
+
+  char *end = nullptr;
+  const long port = std::strtol(rest.c_str(), &end, 10);
+  if (rest.empty() || *end != '\0' || port <= 0 || port > 65535)
+  {
+    setError(error, "无效的端口: " + entry);
+    return false;
+  }
+  source.port = static_cast<uint16_t>(port);
+  return true;
+}
+} // namespace
+
+bool parseUdpSourceList(const std::string &spec, std::vector<UdpSourceConfig> &sources, std::string *error)
+{
+  std::vector<UdpSourceConfig> parsed;
+  for (const std::string &entry : specTokens(spec))
+  {
+    UdpSourceConfig source;
+    if (!parseEntry(entry, source, error))
+    {
+      return false;
+    }
+    parsed.push_back(source);
+  }
+
+  if (parsed.empty())
+  {
+    setError(error, "数据源列表为空");
+    return false;
+  }
+  if (parsed.size() > MAX_UDP_SOURCES)
+  {
+    setError(error, "数据源过多（最多 " + std::to_string(MAX_UDP_SOURCES) + " 个）");
+    return false;
+  }
+
+  // 多个数据源时每个都需要独立的命名空间
+  if (parsed.size() > 1)
+  {
+    for (UdpSourceConfig &source : parsed)
+    {
+      if (source.name.empty())
+      {
+        source.name = source.isShm() ? "Shm" + source.shm_name.substr(1) : "Port" + std::to_string(source.port);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < parsed.size(); ++i)
+  {
+    for (size_t j = i + 1; j < parsed.size(); ++j)
+    {
+      if (parsed[i].name == parsed[j].name)
+      {
+        setError(error, "数据源名称重复: " + parsed[i].name);
+        return false;
+      }
+      if (parsed[i].isShm() != parsed[j].isShm())
+      {
+        continue;
+      }
+      if (parsed[i].isShm() && parsed[i].shm_name == parsed[j].shm_name)
+      {
+        setError(error, "共享内存数据源重复: " + parsed[i].shm_name);
+        return false;
+      }
+      if (!parsed[i].isShm() && parsed[i].port == parsed[j].port && parsed[i].multicast_group == parsed[j].multicast_group)
+      {
+        setError(error, "数据源端口重复: " + std::to_string(parsed[i].port));
+        return false;
+      }
+    }
+  }
+
+  sources = parsed;
+  return true;
+}
+
+std::string formatUdpSourceList(const std::vector<UdpSourceConfig> &sources)
+{
+  std::string spec;
+  for (const UdpSourceConfig &source : sources)
+  {
+    if (!spec.empty())
+    {
+      spec += ",";
+    }
+    if (!source.name.empty())
+    {
+      spec += source.name + "=";
+    }
+    if (source.isShm())
+    {
+      spec += "shm:" + source.shm_name;
+      continue;
+    }
+    spec += std::to_string(source.port);
+    if (!source.multicast_group.empty())
+    {
+      spec += "@" + source.multicast_group;
+    }
+  }
+  return spec;
+}
+
+int openUdpSourceSocket(const UdpSourceConfig &source, std::string *error)
+{
+  int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sock < 0)
+  {
+    setError(error, std::string("无法创建 socket: ") + std::strerror(errno));
+    return -1;
+  }
+
+  int reuse = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(source.port);
+  addr.sin_addr.s_addr = INADDR_ANY;
+  if (bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+  {
+    setError(error, "无法绑定端口 " + std::to_string(source.port) + ": " + std::strerror(errno));
+    close(sock);
+    return -1;
+  }
+
+  if (!source.multicast_group.empty())
+  {
+    ip_mreq mreq{};
+    inet_pton(AF_INET, source.multicast_group.c_str(), &mreq.imr_multiaddr);
+    mreq.imr_interface.s_addr = INADDR_ANY;
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    {
+      setError(error, "无法加入组播组 " + source.multicast_group + ": " + std::strerror(errno));
+      close(sock);
+      return -1;
+    }
+  }
+
+  // 开启内核接收时间戳（SO_TIMESTAMPNS），无论当前选择哪种时间戳来源都开启，便于运行中切换和回退
+  int enable_ts = 1;
+  if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &enable_ts, sizeof(enable_ts)) < 0)
+  {
+    setError(error, "无法开启 SO_TIMESTAMPNS，内核时间戳不可用，将回退为接收时的系统时间");
+  }
+
+  // 开启内核丢包计数（SO_RXQ_OVFL），接收缓冲满时内核丢弃的数据报数随每个数据报一起返回
+  int enable_ovfl = 1;
+  if (setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &enable_ovfl, sizeof(enable_ovfl)) < 0)
+  {
+    setError(error, "无法开启 SO_RXQ_OVFL，内核丢包数不可用");
+  }
+  return sock;
+}
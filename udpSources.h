@@ -0,0 +1,63 @@
+/**
+ * @file udpSources.h
+ * @brief UDP 数据源（端口 / 组播组 / 数据源名称）配置解析与 socket 创建
+ * @author mafangniu
+ * @date 2025-04-24
+ *
+ * @details
+ * 同时监测多台机器人或测试台时，每个数据源占用一个 UDP 端口（可选加入组播组），
+ * 所有数据源由同一个 epoll 接收线程服务。数据源列表用一个字符串描述，条目之间以逗号、分号或空白分隔：
+ *
+ *     [名称=]端口[@组播地址]
+ *     [名称=]shm:<共享内存名称>
+ *
+ * 例如 "RobotA=4015,RobotB=4016@239.0.0.1,TestStand=4017"。
+ * shm: 条目表示同机发送端通过共享内存环形缓冲发送（见 motorShmLayout.h），例如 "Sim=shm:/motor_monitor"。
+ * 名称作为曲线命名空间（RobotA/Motor3/Pos）和日志文件名的一部分；
+ * 只有一个数据源时名称可省略（曲线名保持 Motor3/Pos），多个数据源时省略的名称自动设为 "Port<端口>"
+ * （共享内存数据源为 "Shm<名称>"）。
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static constexpr uint16_t DEFAULT_UDP_PORT = 4015;
+static constexpr size_t MAX_UDP_SOURCES = 32; // 数据源个数上限（RawMotorFrame::source 为 8 位）
+
+// 单个 UDP 数据源配置
+struct UdpSourceConfig
+{
+  std::string name;            // 数据源名称（曲线命名空间），单数据源时可为空
+  uint16_t port = DEFAULT_UDP_PORT; // 监听端口
+  std::string multicast_group; // 组播地址（IPv4），为空表示不加入组播
+  std::string shm_name;        // 共享内存名称（以 '/' 开头），非空表示共享内存数据源，此时 port 和 multicast_group 不使用
+
+  bool isShm() const { return !shm_name.empty(); }
+};
+
+/**
+ * @brief 解析数据源列表字符串
+ * @param spec 数据源列表，格式见文件说明
+ * @param sources 输出的数据源配置（解析失败时不修改）
+ * @param error 解析失败时写入错误原因（可为 nullptr）
+ * @return 解析成功返回 true（至少包含一个数据源）
+ */
+bool parseUdpSourceList(const std::string &spec, std::vector<UdpSourceConfig> &sources, std::string *error = nullptr);
+
+/**
+ * @brief 将数据源配置格式化为列表字符串（parseUdpSourceList() 的逆操作）
+ */
+std::string formatUdpSourceList(const std::vector<UdpSourceConfig> &sources);
+
+/**
+ * @brief 为数据源创建非阻塞 UDP socket：绑定端口、按需加入组播组并开启内核接收时间戳和内核丢包计数
+ * @param source 数据源配置
+ * @param error 失败时写入错误原因（可为 nullptr）
+ * @return socket 文件描述符，失败返回 -1
+ *
+ * 内核接收时间戳（SO_TIMESTAMPNS）和内核丢包计数（SO_RXQ_OVFL）开启失败不视为错误，只写入 error 作为提示。
+ */
+int openUdpSourceSocket(const UdpSourceConfig &source, std::string *error = nullptr);